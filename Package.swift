@@ -48,10 +48,18 @@ let package = Package(
                 "Driver/TouCAN_USB_Driver.c",
                 "Driver/TouCAN_USB_Device.c",
                 "Driver/TouCAN_USB.c",
+                "Driver/TouCAN_Scheduler.c",
+                "Driver/TouCAN_ClockSync.c",
+                "Driver/TouCAN_RxFilter.c",
+                "Driver/TouCAN_Snapshot.c",
+                "Driver/TouCAN_IdStats.c",
+                "Driver/TouCAN_BusLoad.c",
+                "Driver/TouCAN_IdTable.c",
                 "MacCAN/MacCAN_MsgQueue.c",
                 "MacCAN/MacCAN_IOUsbKit.c",
                 "MacCAN/MacCAN_Devices.c",
                 "MacCAN/MacCAN_Debug.c",
+                "MacCAN/MacCAN_Common.c",
                 "CANAPI/can_btr.c",
                 "CANAPI/can_msg.c",
                 "Wrapper/can_api.c"
@@ -0,0 +1,173 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later */
+/*
+ *  TouCAN - macOS User-Space Driver for Rusoku TouCAN USB Interfaces
+ *
+ *  Copyright (C) 2021-2023  Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+ *
+ *  This file is part of MacCAN-TouCAN.
+ *
+ *  MacCAN-TouCAN is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  MacCAN-TouCAN is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with MacCAN-TouCAN.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "TouCAN_BusLoad.h"
+
+#include <string.h>
+#include <assert.h>
+
+/* The bus load is the ratio of the bits on the bus to the bits that can be
+ * transmitted at the nominal bit-rate, measured over a sliding window. The
+ * window is divided into time slots; each of them accumulates the bit lengths
+ * of the CAN frames received or transmitted in its time. A slot is reused
+ * (and cleared) when its time has come again. The slots are updated by the
+ * reception callback and the writer thread, so the time slot and the number
+ * of bits are kept together in one 64-bit word that is updated atomically.
+ *
+ * The bit length of a CAN frame is calculated exactly, with the stuff bits of
+ * its identifier, data and CRC sequence (the CRC is calculated for that).
+ */
+#define NSEC_PER_SLOT  ((UInt64)TOUCAN_BUSLOAD_SLOT * 1000000U)
+#define SLOT(word)  ((UInt32)((word) >> 32))
+#define BITS(word)  ((UInt32)((word) & 0xFFFFFFFFU))
+
+#define CRC15_POLY  0x4599U
+#define FRAME_TAIL  13U  /* CRC delimiter (1), ACK slot and delimiter (2), EOF (7), IFS (3) */
+#define MAX_STUFFED (1U + 29U + 6U + 4U + 64U + 15U)  /* SOF to CRC sequence (29-bit identifier) */
+
+static UInt32 PutBits(UInt8 *bits, UInt32 index, UInt32 value, UInt32 width);
+static UInt16 CalcCrc15(const UInt8 *bits, UInt32 count);
+static UInt32 CountStuffBits(const UInt8 *bits, UInt32 count);
+
+void TouCAN_BusLoadInit(TouCAN_BusLoad_t *load, uint32_t bitrate, uint64_t now) {
+    assert(load);
+
+    for (UInt32 i = 0U; i < TOUCAN_BUSLOAD_BUCKETS; i++)
+        __atomic_store_n(&load->buckets[i], 0U, __ATOMIC_RELAXED);
+    load->start = now;
+    load->bitrate = bitrate;
+}
+
+uint32_t TouCAN_FrameBits(bool xtd, bool rtr, uint32_t id, uint8_t dlc, const uint8_t *data) {
+    UInt8 bits[MAX_STUFFED];
+    UInt32 count = 0U;
+    UInt32 length = (!rtr && data) ? ((dlc < 8U) ? dlc : 8U) : 0U;
+
+    /* arbitration and control field (dominant = 0) */
+    count = PutBits(bits, count, 0U, 1U);  /* SOF */
+    if (!xtd) {
+        count = PutBits(bits, count, id & 0x7FFU, 11U);
+        count = PutBits(bits, count, rtr ? 1U : 0U, 1U);  /* RTR */
+        count = PutBits(bits, count, 0U, 2U);  /* IDE, r0 */
+    } else {
+        count = PutBits(bits, count, (id >> 18) & 0x7FFU, 11U);
+        count = PutBits(bits, count, 3U, 2U);  /* SRR, IDE */
+        count = PutBits(bits, count, id & 0x3FFFFU, 18U);
+        count = PutBits(bits, count, rtr ? 1U : 0U, 1U);  /* RTR */
+        count = PutBits(bits, count, 0U, 2U);  /* r1, r0 */
+    }
+    count = PutBits(bits, count, dlc & 0xFU, 4U);
+    /* data field (none in a remote frame) */
+    for (UInt32 i = 0U; i < length; i++)
+        count = PutBits(bits, count, data[i], 8U);
+    /* CRC sequence (over SOF to data field) */
+    count = PutBits(bits, count, CalcCrc15(bits, count), 15U);
+    /* all fields up to the CRC sequence are bit-stuffed */
+    return count + CountStuffBits(bits, count) + FRAME_TAIL;
+}
+
+void TouCAN_BusLoadAdd(TouCAN_BusLoad_t *load, uint32_t bits, uint64_t now) {
+    UInt32 slot = (UInt32)(now / NSEC_PER_SLOT);
+    UInt64 *bucket;
+    UInt64 word, next;
+
+    assert(load);
+
+    /* add the bits to the time slot, or start the slot again when it is outdated */
+    bucket = &load->buckets[slot % TOUCAN_BUSLOAD_BUCKETS];
+    word = __atomic_load_n(bucket, __ATOMIC_RELAXED);
+    do {
+        if (SLOT(word) == slot)
+            next = word + (UInt64)bits;
+        else
+            next = ((UInt64)slot << 32) | (UInt64)bits;
+    } while (!__atomic_compare_exchange_n(bucket, &word, next, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
+uint16_t TouCAN_BusLoadGet(TouCAN_BusLoad_t *load, uint64_t now) {
+    UInt32 slot = (UInt32)(now / NSEC_PER_SLOT);
+    UInt64 window, bits = 0U;
+    UInt64 word, result;
+
+    assert(load);
+
+    if (!load->bitrate || (now <= load->start))
+        return 0U;
+    /* sum up the bits of the time slots in the window (the current one is in progress) */
+    for (UInt32 i = 0U; i < TOUCAN_BUSLOAD_BUCKETS; i++) {
+        word = __atomic_load_n(&load->buckets[i], __ATOMIC_RELAXED);
+        if ((UInt32)(slot - SLOT(word)) < TOUCAN_BUSLOAD_BUCKETS)
+            bits += (UInt64)BITS(word);
+    }
+    /* length of the window: all past time slots and the elapsed time of the current one,
+     * but not more than the time since the start of the measurement */
+    window = ((UInt64)(TOUCAN_BUSLOAD_BUCKETS - 1U) * NSEC_PER_SLOT) + (now % NSEC_PER_SLOT);
+    if (window > (now - load->start))
+        window = now - load->start;
+    if (window < NSEC_PER_SLOT)  /* note: too short for a meaningful value */
+        window = NSEC_PER_SLOT;
+    /* bus load in [0.01%] = bits * 10000 / (bit-rate * window in [sec]) */
+    result = (bits * 10000U * 1000U) / (((UInt64)load->bitrate * window) / 1000000U);
+    return (UInt16)((result < TOUCAN_BUSLOAD_MAX) ? result : TOUCAN_BUSLOAD_MAX);
+}
+
+static UInt32 PutBits(UInt8 *bits, UInt32 index, UInt32 value, UInt32 width) {
+    /* most significant bit first */
+    while (width > 0U) {
+        width--;
+        bits[index++] = (UInt8)((value >> width) & 1U);
+    }
+    return index;
+}
+
+static UInt16 CalcCrc15(const UInt8 *bits, UInt32 count) {
+    UInt16 crc = 0U;
+
+    for (UInt32 i = 0U; i < count; i++) {
+        bool next = (bits[i] ^ ((crc >> 14) & 1U)) ? true : false;
+        crc = (UInt16)((crc << 1) & 0x7FFFU);
+        if (next)
+            crc ^= CRC15_POLY;
+    }
+    return crc;
+}
+
+static UInt32 CountStuffBits(const UInt8 *bits, UInt32 count) {
+    UInt32 stuffed = 0U;
+    UInt32 run = 1U;
+    UInt8 level = bits[0];
+
+    /* after five bits of the same level a bit of the opposite level is inserted,
+     * which counts for the next sequence */
+    for (UInt32 i = 1U; i < count; i++) {
+        if (bits[i] == level) {
+            if (++run == 5U) {
+                stuffed++;
+                level = !level;
+                run = 1U;
+            }
+        } else {
+            level = bits[i];
+            run = 1U;
+        }
+    }
+    return stuffed;
+}
@@ -0,0 +1,52 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later */
+/*
+ *  TouCAN - macOS User-Space Driver for Rusoku TouCAN USB Interfaces
+ *
+ *  Copyright (C) 2021-2023  Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+ *
+ *  This file is part of MacCAN-TouCAN.
+ *
+ *  MacCAN-TouCAN is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  MacCAN-TouCAN is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with MacCAN-TouCAN.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef TOUCAN_BUSLOAD_H_INCLUDED
+#define TOUCAN_BUSLOAD_H_INCLUDED
+
+#include "TouCAN_USB_Common.h"
+
+#include "MacCAN_IOUsbKit.h"
+
+#define TOUCAN_BUSLOAD_MAX  10000U  /* 100.00% */
+
+typedef struct busload_t_ {             /* bus load measurement: */
+    UInt64 buckets[TOUCAN_BUSLOAD_BUCKETS]; /* - time slot (upper 32 bits) and bits on the bus (lower 32 bits) */
+    UInt64 start;                       /* - start of the measurement (in [nsec]) */
+    UInt32 bitrate;                     /* - nominal bit-rate (in [bit/s], 0 = not set) */
+} TouCAN_BusLoad_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern void TouCAN_BusLoadInit(TouCAN_BusLoad_t *load, uint32_t bitrate, uint64_t now);
+
+extern uint32_t TouCAN_FrameBits(bool xtd, bool rtr, uint32_t id, uint8_t dlc, const uint8_t *data);
+
+extern void TouCAN_BusLoadAdd(TouCAN_BusLoad_t *load, uint32_t bits, uint64_t now);
+extern uint16_t TouCAN_BusLoadGet(TouCAN_BusLoad_t *load, uint64_t now);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TOUCAN_BUSLOAD_H_INCLUDED */
@@ -0,0 +1,261 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later */
+/*
+ *  TouCAN - macOS User-Space Driver for Rusoku TouCAN USB Adapters
+ *
+ *  Copyright (C) 2021-2023  Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+ *
+ *  This file is part of MacCAN-TouCAN.
+ *
+ *  MacCAN-TouCAN is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  MacCAN-TouCAN is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with MacCAN-TouCAN.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "TouCAN_ClockSync.h"
+
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <assert.h>
+
+/* The device time-stamps every CAN frame with a free-running 32-bit microsecond
+ * counter (it wraps around every 1:11:34.967296). The host time is taken once
+ * per USB transfer from the monotonic clock. Host time and device time are
+ * related by an offset (the start of the device) and a drift (the tolerance
+ * of the crystals), plus the latency of the USB transfer which is always
+ * positive. So for each period the sample with the lowest latency is taken,
+ * and offset and drift are estimated by a linear regression over a window of
+ * those samples. The device counter is unwrapped by the device time that is
+ * predicted from the host time elapsed since the latest time-stamp, so it is
+ * monotonic even when there was no traffic for a long time.
+ */
+#define NSEC_PER_USEC  1000.0
+#define WRAP_MASK  0xFFFFFFFFULL
+
+static void StartOver(TouCAN_ClockSync_t *sync, int64_t device);
+static void AddSample(TouCAN_ClockSync_t *sync, int64_t device, uint64_t host);
+static void ClosePeriod(TouCAN_ClockSync_t *sync, int64_t device);
+static void Regression(TouCAN_ClockSync_t *sync);
+static int64_t Round(double value);
+
+void TouCAN_ClockSyncInit(TouCAN_ClockSync_t *sync) {
+    assert(sync);
+
+    memset(sync, 0, sizeof(TouCAN_ClockSync_t));
+    (void)pthread_mutex_init(&sync->mutex, NULL);
+    sync->slope = NSEC_PER_USEC;
+}
+
+void TouCAN_ClockSyncExit(TouCAN_ClockSync_t *sync) {
+    assert(sync);
+
+    (void)pthread_mutex_destroy(&sync->mutex);
+}
+
+uint64_t TouCAN_ClockSyncHostTime(void) {
+    struct timespec ts;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000U) + (uint64_t)ts.tv_nsec;
+}
+
+void TouCAN_ClockSyncBegin(TouCAN_ClockSync_t *sync, uint64_t hostTime) {
+    assert(sync);
+
+    /* note: called once per USB transfer (all frames of a transfer have the same arrival) */
+    sync->hostTime = hostTime;
+    if (sync->synced) {
+        uint64_t elapsed = (hostTime > sync->last.host) ? (hostTime - sync->last.host) : 0U;
+        sync->predicted = sync->last.device + (int64_t)(elapsed / 1000U);
+    }
+}
+
+uint64_t TouCAN_ClockSyncConvert(TouCAN_ClockSync_t *sync, uint32_t deviceTime, bool sample) {
+    int64_t device;
+    int64_t delta;
+    uint64_t host;
+
+    assert(sync);
+
+    if (!sync->synced) {
+        /* note: only time-stamps from the device can start the synchronization */
+        if (!sample)
+            return sync->hostTime;
+        StartOver(sync, (int64_t)deviceTime);
+    }
+    /* unwrap: the nearest value to the predicted device time (with the same lower 32 bits) */
+    device = sync->predicted + (int64_t)(int32_t)(uint32_t)(deviceTime - (uint32_t)((uint64_t)sync->predicted & WRAP_MASK));
+    delta = device - sync->predicted;
+    if (sample && ((delta > (int64_t)TOUCAN_SYNC_RESYNC_USEC) || (delta < -(int64_t)TOUCAN_SYNC_RESYNC_USEC))) {
+        /* the device clock has been reset (e.g. by a power cycle) */
+        sync->quality.resyncs++;
+        StartOver(sync, (int64_t)deviceTime);
+        device = (int64_t)deviceTime;
+    }
+    /* device time to host time by the current model */
+    host = sync->y0 + (uint64_t)Round(sync->slope * (double)(device - sync->x0));
+    if (sample) {
+        AddSample(sync, device, sync->hostTime);
+        /* note: a new model shall not let the host times go backwards */
+        if ((device >= sync->output.device) && (host < sync->output.host))
+            host = sync->output.host;
+        sync->output.device = device;
+        sync->output.host = host;
+    }
+    return host;
+}
+
+uint32_t TouCAN_ClockSyncDeviceTime(TouCAN_ClockSync_t *sync, uint64_t hostTime) {
+    int64_t device;
+
+    assert(sync);
+
+    /* note: the inverse of the model (e.g. for time-stamps made by the host) */
+    (void)pthread_mutex_lock(&sync->mutex);
+    device = sync->x0 + Round((double)(int64_t)(hostTime - sync->y0) / sync->slope);
+    (void)pthread_mutex_unlock(&sync->mutex);
+    return (uint32_t)((uint64_t)device & WRAP_MASK);
+}
+
+void TouCAN_ClockSyncQuality(TouCAN_ClockSync_t *sync, TouCAN_SyncQuality_t *quality) {
+    assert(sync);
+    assert(quality);
+
+    (void)pthread_mutex_lock(&sync->mutex);
+    *quality = sync->quality;
+    (void)pthread_mutex_unlock(&sync->mutex);
+}
+
+static void StartOver(TouCAN_ClockSync_t *sync, int64_t device) {
+    assert(sync);
+
+    sync->synced = true;
+    sync->predicted = device;
+    sync->last.device = device;
+    sync->last.host = sync->hostTime;
+    sync->output.device = device;
+    sync->output.host = sync->hostTime;
+    sync->hasCandidate = false;
+    sync->periodStart = device;
+    sync->head = 0U;
+    sync->count = 0U;
+    /* the first time-stamp is the reference until there are samples */
+    (void)pthread_mutex_lock(&sync->mutex);
+    sync->x0 = device;
+    sync->y0 = sync->hostTime;
+    sync->slope = NSEC_PER_USEC;
+    sync->quality.samples = 0U;
+    sync->quality.span = 0U;
+    sync->quality.drift = 0;
+    sync->quality.residual = 0U;
+    (void)pthread_mutex_unlock(&sync->mutex);
+}
+
+static void AddSample(TouCAN_ClockSync_t *sync, int64_t device, uint64_t host) {
+    assert(sync);
+
+    sync->last.device = device;
+    sync->last.host = host;
+    /* after a pause the first sample shall not end the period (it can have a high latency) */
+    if ((device - sync->periodStart) >= (int64_t)(2U * TOUCAN_SYNC_PERIOD_USEC))
+        ClosePeriod(sync, device);
+    /* keep the sample with the lowest latency (host time minus device time) of the period */
+    if (!sync->hasCandidate ||
+        ((int64_t)(host - sync->candidate.host) < ((device - sync->candidate.device) * 1000))) {
+        sync->candidate.device = device;
+        sync->candidate.host = host;
+        sync->hasCandidate = true;
+    }
+    if ((device - sync->periodStart) >= (int64_t)TOUCAN_SYNC_PERIOD_USEC)
+        ClosePeriod(sync, device);
+}
+
+static void ClosePeriod(TouCAN_ClockSync_t *sync, int64_t device) {
+    assert(sync);
+
+    sync->periodStart = device;
+    if (!sync->hasCandidate)
+        return;
+    /* the candidate goes into the window (the oldest sample drops out) */
+    if (sync->count == TOUCAN_SYNC_WINDOW_SIZE) {
+        sync->head = (sync->head + 1U) % TOUCAN_SYNC_WINDOW_SIZE;
+        sync->count--;
+    }
+    sync->window[(sync->head + sync->count) % TOUCAN_SYNC_WINDOW_SIZE] = sync->candidate;
+    sync->count++;
+    sync->hasCandidate = false;
+    Regression(sync);
+}
+
+static void Regression(TouCAN_ClockSync_t *sync) {
+    const TouCAN_SyncPoint_t *ref;
+    double sumX = 0.0, sumY = 0.0;
+    double sumXX = 0.0, sumXY = 0.0;
+    double n, meanX, meanY;
+    double drift = 0.0;
+    double offset, residual = 0.0;
+    int64_t span;
+
+    assert(sync);
+    assert(sync->count > 0U);
+
+    /* note: y is host time minus nominal device time relative to the oldest sample,
+     *       so it stays in the range of the latency and the drift (numerically stable) */
+    ref = &sync->window[sync->head];
+    for (uint32_t i = 0U; i < sync->count; i++) {
+        const TouCAN_SyncPoint_t *p = &sync->window[(sync->head + i) % TOUCAN_SYNC_WINDOW_SIZE];
+        double x = (double)(p->device - ref->device);
+        double y = (double)(int64_t)(p->host - ref->host) - (x * NSEC_PER_USEC);
+        sumX += x;
+        sumY += y;
+        sumXX += x * x;
+        sumXY += x * y;
+    }
+    n = (double)sync->count;
+    meanX = sumX / n;
+    meanY = sumY / n;
+    span = sync->window[(sync->head + sync->count - 1U) % TOUCAN_SYNC_WINDOW_SIZE].device - ref->device;
+    /* drift (in [nsec/usec]) only from a sufficient time span, and not beyond the crystal tolerance */
+    if ((sync->count >= 2U) && (span >= (int64_t)TOUCAN_SYNC_MIN_SPAN_USEC)) {
+        double sxx = sumXX - (n * meanX * meanX);
+        if (sxx > 0.0)
+            drift = (sumXY - (n * meanX * meanY)) / sxx;
+        if (drift > ((double)TOUCAN_SYNC_MAX_DRIFT_PPM / 1000.0))
+            drift = (double)TOUCAN_SYNC_MAX_DRIFT_PPM / 1000.0;
+        if (drift < -((double)TOUCAN_SYNC_MAX_DRIFT_PPM / 1000.0))
+            drift = -((double)TOUCAN_SYNC_MAX_DRIFT_PPM / 1000.0);
+    }
+    offset = meanY - (drift * meanX);
+    for (uint32_t i = 0U; i < sync->count; i++) {
+        const TouCAN_SyncPoint_t *p = &sync->window[(sync->head + i) % TOUCAN_SYNC_WINDOW_SIZE];
+        double x = (double)(p->device - ref->device);
+        double y = (double)(int64_t)(p->host - ref->host) - (x * NSEC_PER_USEC);
+        double r = y - (offset + (drift * x));
+        if (r < 0.0)
+            r = -r;
+        if (r > residual)
+            residual = r;
+    }
+    /* publish the new model */
+    (void)pthread_mutex_lock(&sync->mutex);
+    sync->x0 = ref->device;
+    sync->y0 = ref->host + (uint64_t)Round(offset);
+    sync->slope = NSEC_PER_USEC + drift;
+    sync->quality.samples = sync->count;
+    sync->quality.span = (uint32_t)(span / 1000);
+    sync->quality.drift = (int32_t)Round(-drift * 1000000.0);  /* note: a fast device clock has a positive drift */
+    sync->quality.residual = (residual < 4294967295.0) ? (uint32_t)residual : 0xFFFFFFFFU;
+    (void)pthread_mutex_unlock(&sync->mutex);
+}
+
+static int64_t Round(double value) {
+    return (int64_t)((value < 0.0) ? (value - 0.5) : (value + 0.5));
+}
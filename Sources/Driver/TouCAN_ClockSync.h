@@ -0,0 +1,84 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later */
+/*
+ *  TouCAN - macOS User-Space Driver for Rusoku TouCAN USB Interfaces
+ *
+ *  Copyright (C) 2021-2023  Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+ *
+ *  This file is part of MacCAN-TouCAN.
+ *
+ *  MacCAN-TouCAN is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  MacCAN-TouCAN is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with MacCAN-TouCAN.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef TOUCAN_CLOCKSYNC_H_INCLUDED
+#define TOUCAN_CLOCKSYNC_H_INCLUDED
+
+#include "TouCAN_USB_Common.h"
+
+#include <pthread.h>
+
+#define TOUCAN_SYNC_WINDOW_SIZE  120U  /* number of samples for the linear regression */
+#define TOUCAN_SYNC_PERIOD_USEC  500000U  /* [usec] one sample (the one with the lowest latency) per period */
+#define TOUCAN_SYNC_MIN_SPAN_USEC  5000000U  /* [usec] shortest time span of the window to estimate the drift */
+#define TOUCAN_SYNC_MAX_DRIFT_PPM  500U  /* [ppm] max. drift of the device clock (crystal tolerance) */
+#define TOUCAN_SYNC_RESYNC_USEC  10000000U  /* [usec] deviation from the predicted device time to start over */
+
+typedef struct clock_sync_point_t_ {    /* sample of the regression: */
+    int64_t device;                     /* - unwrapped device time (in [usec]) */
+    uint64_t host;                      /* - arrival of the USB transfer (in [nsec]) */
+} TouCAN_SyncPoint_t;
+
+typedef struct clock_sync_quality_t_ {  /* quality of the clock synchronization: */
+    uint32_t samples;                   /* - number of samples in the window */
+    uint32_t span;                      /* - time span of the window (in [msec]) */
+    int32_t drift;                      /* - drift of the device clock (in [ppb]) */
+    uint32_t residual;                  /* - largest residual of the regression (in [nsec]) */
+    uint32_t resyncs;                   /* - number of restarts (device clock reset) */
+} TouCAN_SyncQuality_t;
+
+typedef struct clock_sync_t_ {          /* device to host clock synchronization: */
+    bool synced;                        /* - at least one device time-stamp seen */
+    uint64_t hostTime;                  /* - arrival of the current USB transfer (in [nsec]) */
+    int64_t predicted;                  /* - predicted device time of the current USB transfer (in [usec]) */
+    TouCAN_SyncPoint_t last;            /* - latest device time-stamp and its arrival */
+    TouCAN_SyncPoint_t output;          /* - latest conversion (to keep the host times monotonic) */
+    TouCAN_SyncPoint_t candidate;       /* - sample with the lowest latency of the current period */
+    bool hasCandidate;                  /* - to indicate that there is a candidate */
+    int64_t periodStart;                /* - start of the current period (device time in [usec]) */
+    TouCAN_SyncPoint_t window[TOUCAN_SYNC_WINDOW_SIZE]; /* - samples of the linear regression (ring buffer) */
+    uint32_t head;                      /* - index of the oldest sample */
+    uint32_t count;                     /* - number of samples */
+    pthread_mutex_t mutex;              /* - mutex for the model (written by the reception) */
+    int64_t x0;                         /* - model: reference device time (in [usec]) */
+    uint64_t y0;                        /* - model: host time at the reference (in [nsec]) */
+    double slope;                       /* - model: host time per device time (in [nsec/usec]) */
+    TouCAN_SyncQuality_t quality;       /* - quality of the current model */
+} TouCAN_ClockSync_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern void TouCAN_ClockSyncInit(TouCAN_ClockSync_t *sync);
+extern void TouCAN_ClockSyncExit(TouCAN_ClockSync_t *sync);
+
+extern uint64_t TouCAN_ClockSyncHostTime(void);
+extern void TouCAN_ClockSyncBegin(TouCAN_ClockSync_t *sync, uint64_t hostTime);
+extern uint64_t TouCAN_ClockSyncConvert(TouCAN_ClockSync_t *sync, uint32_t deviceTime, bool sample);
+extern uint32_t TouCAN_ClockSyncDeviceTime(TouCAN_ClockSync_t *sync, uint64_t hostTime);
+extern void TouCAN_ClockSyncQuality(TouCAN_ClockSync_t *sync, TouCAN_SyncQuality_t *quality);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TOUCAN_CLOCKSYNC_H_INCLUDED */
@@ -68,12 +68,12 @@ CANUSB_Return_t TouCAN_ProbeChannel(TouCAN_Channel_t channel, TouCAN_OpMode_t mo
     return retVal;
 }
 
-CANUSB_Return_t TouCAN_InitializeChannel(TouCAN_Channel_t channel, TouCAN_OpMode_t mode, TouCAN_Device_t *device) {
+CANUSB_Return_t TouCAN_InitializeChannel(TouCAN_Channel_t channel, TouCAN_OpMode_t mode, uint32_t queueSize, TouCAN_Device_t *device) {
     CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
 
     /* open USB device at given index (channel) and allocate required resources (pipe context) */
     /* note: the device context is preinitialized, but must be confirmed by the CAN channel */
-    retVal = TouCAN_OpenUsbDevice(channel, device);
+    retVal = TouCAN_OpenUsbDevice(channel, queueSize, device);
     if (retVal < 0) {
         return retVal;;
     }
@@ -210,6 +210,42 @@ CANUSB_Return_t TouCAN_WriteMessage(TouCAN_Device_t *device, const TouCAN_CanMes
     return retVal;
 }
 
+CANUSB_Return_t TouCAN_WriteMessageTagged(TouCAN_Device_t *device, const TouCAN_CanMessage_t *message, uint16_t timeout, uint32_t *tag) {
+    CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
+
+    /* sanity check */
+    if (!device)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* send a CAN message (and return its sequence tag) */
+    switch (device->productId) {
+        case TOUCAN_USB_PRODUCT_ID:
+            retVal = TouCAN_USB_WriteMessageTagged(device, message, timeout, tag);
+            break;
+    }
+    return retVal;
+}
+
+CANUSB_Return_t TouCAN_WriteMessages(TouCAN_Device_t *device, const TouCAN_CanMessage_t *messages, uint32_t count, uint32_t *written, uint16_t timeout) {
+    CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
+
+    /* sanity check */
+    if (!device)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* send a batch of CAN messages */
+    switch (device->productId) {
+        case TOUCAN_USB_PRODUCT_ID:
+            retVal = TouCAN_USB_WriteMessages(device, messages, count, written, timeout);
+            break;
+    }
+    return retVal;
+}
+
 CANUSB_Return_t TouCAN_ReadMessage(TouCAN_Device_t *device, TouCAN_CanMessage_t *message, uint16_t timeout) {
     CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
 
@@ -228,6 +264,96 @@ CANUSB_Return_t TouCAN_ReadMessage(TouCAN_Device_t *device, TouCAN_CanMessage_t
     return retVal;
 }
 
+CANUSB_Return_t TouCAN_ReadMessageTagged(TouCAN_Device_t *device, TouCAN_CanMessage_t *message, uint32_t *tag, uint16_t timeout) {
+    CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
+
+    /* sanity check */
+    if (!device)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* read a CAN message from message queue, if any (and the sequence tag of a TX echo) */
+    switch (device->productId) {
+        case TOUCAN_USB_PRODUCT_ID:
+            retVal = TouCAN_USB_ReadMessageTagged(device, message, tag, timeout);
+            break;
+    }
+    return retVal;
+}
+
+CANUSB_Return_t TouCAN_ReadMessageUs(TouCAN_Device_t *device, TouCAN_CanMessage_t *message, uint32_t timeout) {
+    CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
+
+    /* sanity check */
+    if (!device)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* read a CAN message from message queue, if any (time-out in [usec]) */
+    switch (device->productId) {
+        case TOUCAN_USB_PRODUCT_ID:
+            retVal = TouCAN_USB_ReadMessageUs(device, message, timeout);
+            break;
+    }
+    return retVal;
+}
+
+CANUSB_Return_t TouCAN_ReadMessages(TouCAN_Device_t *device, TouCAN_CanMessage_t *messages, uint32_t max, uint32_t *count, uint16_t timeout) {
+    CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
+
+    /* sanity check */
+    if (!device)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* read up to 'max' CAN messages from message queue, if any */
+    switch (device->productId) {
+        case TOUCAN_USB_PRODUCT_ID:
+            retVal = TouCAN_USB_ReadMessages(device, messages, max, count, timeout);
+            break;
+    }
+    return retVal;
+}
+
+CANUSB_Return_t TouCAN_PeekMessages(TouCAN_Device_t *device, const TouCAN_CanMessage_t **messages, uint32_t *count, uint16_t timeout) {
+    CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
+
+    /* sanity check */
+    if (!device)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* borrow CAN messages from message queue, if any */
+    switch (device->productId) {
+        case TOUCAN_USB_PRODUCT_ID:
+            retVal = TouCAN_USB_PeekMessages(device, messages, count, timeout);
+            break;
+    }
+    return retVal;
+}
+
+CANUSB_Return_t TouCAN_CommitMessages(TouCAN_Device_t *device, uint32_t count) {
+    CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
+
+    /* sanity check */
+    if (!device)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* release borrowed CAN messages to message queue */
+    switch (device->productId) {
+        case TOUCAN_USB_PRODUCT_ID:
+            retVal = TouCAN_USB_CommitMessages(device, count);
+            break;
+    }
+    return retVal;
+}
+
 CANUSB_Return_t TouCAN_GetBusStatus(TouCAN_Device_t *device, TouCAN_Status_t *status) {
     CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
 
@@ -246,6 +372,172 @@ CANUSB_Return_t TouCAN_GetBusStatus(TouCAN_Device_t *device, TouCAN_Status_t *st
     return retVal;
 }
 
+CANUSB_Return_t TouCAN_GetBusLoad(TouCAN_Device_t *device, uint16_t *load) {
+    CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
+
+    /* sanity check */
+    if (!device || !load)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* get bus load (0..10000 = 0.00%..100.00%) */
+    switch (device->productId) {
+        case TOUCAN_USB_PRODUCT_ID:
+            retVal = TouCAN_USB_GetBusLoad(device, load);
+            break;
+    }
+    return retVal;
+}
+
+CANUSB_Return_t TouCAN_SetFilter(TouCAN_Device_t *device, bool xtd, uint32_t code, uint32_t mask) {
+    CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
+
+    /* sanity check */
+    if (!device)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* set acceptance code and mask */
+    switch (device->productId) {
+        case TOUCAN_USB_PRODUCT_ID:
+            retVal = TouCAN_USB_SetFilter(device, xtd, code, mask);
+            break;
+    }
+    return retVal;
+}
+
+CANUSB_Return_t TouCAN_SetFilterList(TouCAN_Device_t *device, bool xtd, const uint32_t *ids, uint32_t count) {
+    CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
+
+    /* sanity check */
+    if (!device)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* set a list of acceptable identifiers */
+    switch (device->productId) {
+        case TOUCAN_USB_PRODUCT_ID:
+            retVal = TouCAN_USB_SetFilterList(device, xtd, ids, count);
+            break;
+    }
+    return retVal;
+}
+
+CANUSB_Return_t TouCAN_GetFilter(TouCAN_Device_t *device, bool xtd, uint32_t *code, uint32_t *mask) {
+    CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
+
+    /* sanity check */
+    if (!device)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* get acceptance code and mask */
+    switch (device->productId) {
+        case TOUCAN_USB_PRODUCT_ID:
+            retVal = TouCAN_USB_GetFilter(device, xtd, code, mask);
+            break;
+    }
+    return retVal;
+}
+
+CANUSB_Return_t TouCAN_SetRxFilter(TouCAN_Device_t *device, TouCAN_RxFilter_t filter) {
+    CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
+
+    /* sanity check */
+    if (!device)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* replace the filter rules */
+    switch (device->productId) {
+        case TOUCAN_USB_PRODUCT_ID:
+            retVal = TouCAN_USB_SetRxFilter(device, filter);
+            break;
+    }
+    return retVal;
+}
+
+CANUSB_Return_t TouCAN_SetRxCallback(TouCAN_Device_t *device, TouCAN_RxCallback_t callback, void *context) {
+    CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
+
+    /* sanity check */
+    if (!device)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* set or remove the receive callback */
+    switch (device->productId) {
+        case TOUCAN_USB_PRODUCT_ID:
+            retVal = TouCAN_USB_SetRxCallback(device, callback, context);
+            break;
+    }
+    return retVal;
+}
+
+CANUSB_Return_t TouCAN_SetSnapshot(TouCAN_Device_t *device, TouCAN_Snapshot_t snapshot) {
+    CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
+
+    /* sanity check */
+    if (!device)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* replace the snapshot table */
+    switch (device->productId) {
+        case TOUCAN_USB_PRODUCT_ID:
+            retVal = TouCAN_USB_SetSnapshot(device, snapshot);
+            break;
+    }
+    return retVal;
+}
+
+CANUSB_Return_t TouCAN_SetIdStats(TouCAN_Device_t *device, TouCAN_IdStats_t stats) {
+    CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
+
+    /* sanity check */
+    if (!device)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* replace the statistics table */
+    switch (device->productId) {
+        case TOUCAN_USB_PRODUCT_ID:
+            retVal = TouCAN_USB_SetIdStats(device, stats);
+            break;
+    }
+    return retVal;
+}
+
+void TouCAN_EnterTables(TouCAN_Device_t *device) {
+    assert(device);
+
+    /* the snapshot and statistics tables are in use */
+    switch (device->productId) {
+        case TOUCAN_USB_PRODUCT_ID:
+            TouCAN_USB_EnterTables(device);
+            break;
+    }
+}
+
+void TouCAN_LeaveTables(TouCAN_Device_t *device) {
+    assert(device);
+
+    /* the snapshot and statistics tables are no longer in use */
+    switch (device->productId) {
+        case TOUCAN_USB_PRODUCT_ID:
+            TouCAN_USB_LeaveTables(device);
+            break;
+    }
+}
+
 bool TouCAN_Index2Bitrate(TouCAN_Device_t *device, int32_t index, TouCAN_Bitrate_t *bitrate) {
     bool retVal = false;
 
@@ -36,7 +36,7 @@ extern CANUSB_Return_t TouCAN_InitializeDriver(void);
 extern CANUSB_Return_t TouCAN_TeardownDriver(void);
 
 extern CANUSB_Return_t TouCAN_ProbeChannel(TouCAN_Channel_t channel, TouCAN_OpMode_t mode, int *state);
-extern CANUSB_Return_t TouCAN_InitializeChannel(TouCAN_Channel_t channel, TouCAN_OpMode_t opMode, TouCAN_Device_t *device);
+extern CANUSB_Return_t TouCAN_InitializeChannel(TouCAN_Channel_t channel, TouCAN_OpMode_t opMode, uint32_t queueSize, TouCAN_Device_t *device);
 extern CANUSB_Return_t TouCAN_TeardownChannel(TouCAN_Device_t *device);
 extern CANUSB_Return_t TouCAN_SignalChannel(TouCAN_Device_t *device);
 
@@ -45,8 +45,26 @@ extern CANUSB_Return_t TouCAN_StartCan(TouCAN_Device_t *device);
 extern CANUSB_Return_t TouCAN_StopCan(TouCAN_Device_t *device);
 
 extern CANUSB_Return_t TouCAN_WriteMessage(TouCAN_Device_t *device, const TouCAN_CanMessage_t *message, uint16_t timeout);
+extern CANUSB_Return_t TouCAN_WriteMessageTagged(TouCAN_Device_t *device, const TouCAN_CanMessage_t *message, uint16_t timeout, uint32_t *tag);
+extern CANUSB_Return_t TouCAN_WriteMessages(TouCAN_Device_t *device, const TouCAN_CanMessage_t *messages, uint32_t count, uint32_t *written, uint16_t timeout);
 extern CANUSB_Return_t TouCAN_ReadMessage(TouCAN_Device_t *device, TouCAN_CanMessage_t *message, uint16_t timeout);
+extern CANUSB_Return_t TouCAN_ReadMessageTagged(TouCAN_Device_t *device, TouCAN_CanMessage_t *message, uint32_t *tag, uint16_t timeout);
+extern CANUSB_Return_t TouCAN_ReadMessageUs(TouCAN_Device_t *device, TouCAN_CanMessage_t *message, uint32_t timeout);
+extern CANUSB_Return_t TouCAN_ReadMessages(TouCAN_Device_t *device, TouCAN_CanMessage_t *messages, uint32_t max, uint32_t *count, uint16_t timeout);
+extern CANUSB_Return_t TouCAN_PeekMessages(TouCAN_Device_t *device, const TouCAN_CanMessage_t **messages, uint32_t *count, uint16_t timeout);
+extern CANUSB_Return_t TouCAN_CommitMessages(TouCAN_Device_t *device, uint32_t count);
 extern CANUSB_Return_t TouCAN_GetBusStatus(TouCAN_Device_t *device, TouCAN_Status_t *status);
+extern CANUSB_Return_t TouCAN_GetBusLoad(TouCAN_Device_t *device, uint16_t *load);
+
+extern CANUSB_Return_t TouCAN_SetFilter(TouCAN_Device_t *device, bool xtd, uint32_t code, uint32_t mask);
+extern CANUSB_Return_t TouCAN_SetFilterList(TouCAN_Device_t *device, bool xtd, const uint32_t *ids, uint32_t count);
+extern CANUSB_Return_t TouCAN_GetFilter(TouCAN_Device_t *device, bool xtd, uint32_t *code, uint32_t *mask);
+extern CANUSB_Return_t TouCAN_SetRxFilter(TouCAN_Device_t *device, TouCAN_RxFilter_t filter);
+extern CANUSB_Return_t TouCAN_SetRxCallback(TouCAN_Device_t *device, TouCAN_RxCallback_t callback, void *context);
+extern CANUSB_Return_t TouCAN_SetSnapshot(TouCAN_Device_t *device, TouCAN_Snapshot_t snapshot);
+extern CANUSB_Return_t TouCAN_SetIdStats(TouCAN_Device_t *device, TouCAN_IdStats_t stats);
+extern void TouCAN_EnterTables(TouCAN_Device_t *device);
+extern void TouCAN_LeaveTables(TouCAN_Device_t *device);
 
 extern bool TouCAN_Index2Bitrate(TouCAN_Device_t *device, int32_t index, TouCAN_Bitrate_t *bitrate);
 
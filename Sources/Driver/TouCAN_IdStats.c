@@ -0,0 +1,161 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later */
+/*
+ *  TouCAN - macOS User-Space Driver for Rusoku TouCAN USB Interfaces
+ *
+ *  Copyright (C) 2021-2023  Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+ *
+ *  This file is part of MacCAN-TouCAN.
+ *
+ *  MacCAN-TouCAN is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  MacCAN-TouCAN is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with MacCAN-TouCAN.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "TouCAN_IdStats.h"
+#include "TouCAN_IdTable.h"
+
+#include <stdlib.h>
+#include <math.h>
+#include <assert.h>
+
+/* The statistics table keeps traffic statistics of each identifier in an
+ * identifier table (see TouCAN_IdTable.c). It is updated by the reception
+ * callback (the only writer) in constant time and without allocation; all
+ * entries are allocated when the table is created.
+ * The mean and the variance of the inter-arrival time are accumulated by the
+ * method of Welford (numerically stable, no sums of squares that overflow).
+ */
+typedef struct idstats_entry_t_ {       /* entry of the statistics table: */
+    TouCAN_IdTableEntry_t header;       /* - sequence lock and 29-bit identifier */
+    UInt8 dlc;                          /* - data length code of the latest CAN frame */
+    UInt64 frames;                      /* - number of received CAN frames */
+    UInt64 dlcChanges;                  /* - number of changes of the data length code */
+    UInt64 first;                       /* - time-stamp of the first CAN frame (in [nsec]) */
+    UInt64 last;                        /* - time-stamp of the latest CAN frame (in [nsec]) */
+    UInt64 gapMin;                      /* - shortest inter-arrival time (in [nsec]) */
+    UInt64 gapMax;                      /* - longest inter-arrival time (in [nsec]) */
+    double gapMean;                     /* - running mean of the inter-arrival time */
+    double gapM2;                       /* - running sum of squared deviations */
+} IdStatsEntry_t;
+
+struct idstats_tag {                    /* statistics table: */
+    TouCAN_IdTable_t table;             /* - 11-bit and 29-bit identifiers */
+    UInt32 identifiers;                 /* - number of identifiers in the table */
+};
+
+static bool ConvertEntry(const void *copy, void *value, uint32_t id, bool xtd);
+
+CANUSB_Return_t TouCAN_CreateIdStats(uint32_t xtdIds, TouCAN_IdStats_t *stats) {
+    TouCAN_IdStats_t object = NULL;
+    CANUSB_Return_t retVal;
+
+    if (!stats)
+        return CANUSB_ERROR_NULLPTR;
+    if (xtdIds > TOUCAN_IDSTATS_MAX_XTD_IDS)
+        return CANUSB_ERROR_ILLPARA;
+
+    if ((object = (TouCAN_IdStats_t)calloc(1U, sizeof(struct idstats_tag))) == NULL)
+        return CANUSB_ERROR_RESOURCE;
+    if ((retVal = TouCAN_InitIdTable(&object->table, sizeof(IdStatsEntry_t), xtdIds)) != CANUSB_SUCCESS) {
+        free(object);
+        return retVal;
+    }
+    *stats = object;
+    return CANUSB_SUCCESS;
+}
+
+void TouCAN_DestroyIdStats(TouCAN_IdStats_t stats) {
+    if (stats) {
+        TouCAN_FreeIdTable(&stats->table);
+        free(stats);
+    }
+}
+
+void TouCAN_IdStatsUpdate(TouCAN_IdStats_t stats, const TouCAN_CanMessage_t *message) {
+    IdStatsEntry_t *entry = NULL;
+    UInt64 now, gap;
+    double delta;
+
+    assert(stats);
+    assert(message);
+
+    if ((entry = (IdStatsEntry_t*)TouCAN_IdTableBeginUpdate(&stats->table, message)) == NULL)
+        return;
+    now = ((UInt64)message->timestamp.tv_sec * 1000000000U) + (UInt64)message->timestamp.tv_nsec;
+    if (!entry->frames) {
+        entry->first = now;
+        entry->dlc = message->dlc;
+    } else {
+        /* note: the time-stamps can step back when the clock was re-synchronized */
+        gap = (now > entry->last) ? (now - entry->last) : 0U;
+        if ((entry->frames == 1U) || (gap < entry->gapMin))
+            entry->gapMin = gap;
+        if (gap > entry->gapMax)
+            entry->gapMax = gap;
+        delta = (double)gap - entry->gapMean;
+        entry->gapMean += delta / (double)entry->frames;
+        entry->gapM2 += delta * ((double)gap - entry->gapMean);
+        if (message->dlc != entry->dlc) {
+            entry->dlcChanges++;
+            entry->dlc = message->dlc;
+        }
+    }
+    entry->last = now;
+    entry->frames++;
+    TouCAN_IdTableEndUpdate(&stats->table, entry, message);
+    /* a new identifier is counted after its first update */
+    if (entry->frames == 1U)
+        __atomic_store_n(&stats->identifiers, stats->identifiers + 1U, __ATOMIC_RELAXED);
+}
+
+CANUSB_Return_t TouCAN_IdStatsReadAll(TouCAN_IdStats_t stats, TouCAN_IdStatsValue_t *values, uint32_t max, uint32_t *count) {
+    IdStatsEntry_t copy;
+
+    if (!stats || !count || (!values && max))
+        return CANUSB_ERROR_NULLPTR;
+
+    *count = TouCAN_IdTableReadAll(&stats->table, &copy, ConvertEntry, values, sizeof(TouCAN_IdStatsValue_t), max);
+    return CANUSB_SUCCESS;
+}
+
+uint32_t TouCAN_IdStatsIdentifiers(TouCAN_IdStats_t stats) {
+    return stats ? __atomic_load_n(&stats->identifiers, __ATOMIC_RELAXED) : 0U;
+}
+
+uint32_t TouCAN_IdStatsCapacity(TouCAN_IdStats_t stats) {
+    return stats ? TouCAN_IdTableCapacity(&stats->table) : 0U;
+}
+
+uint64_t TouCAN_IdStatsDropped(TouCAN_IdStats_t stats) {
+    return stats ? TouCAN_IdTableDropped(&stats->table) : 0U;
+}
+
+static bool ConvertEntry(const void *copy, void *value, uint32_t id, bool xtd) {
+    const IdStatsEntry_t *entry = (const IdStatsEntry_t*)copy;
+    TouCAN_IdStatsValue_t *result = (TouCAN_IdStatsValue_t*)value;
+
+    /* note: the sequence can wrap around, an entry without CAN frames is unused */
+    if (!entry->frames)
+        return false;
+
+    result->id = id;
+    result->xtd = xtd;
+    result->dlc = entry->dlc;
+    result->frames = entry->frames;
+    result->dlcChanges = entry->dlcChanges;
+    result->first = entry->first;
+    result->last = entry->last;
+    result->gapMin = entry->gapMin;
+    result->gapMax = entry->gapMax;
+    result->gapMean = (UInt64)(entry->gapMean + 0.5);
+    result->jitter = (entry->frames > 2U) ? (UInt64)(sqrt(entry->gapM2 / (double)(entry->frames - 2U)) + 0.5) : 0U;
+    return true;
+}
@@ -0,0 +1,66 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later */
+/*
+ *  TouCAN - macOS User-Space Driver for Rusoku TouCAN USB Interfaces
+ *
+ *  Copyright (C) 2021-2023  Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+ *
+ *  This file is part of MacCAN-TouCAN.
+ *
+ *  MacCAN-TouCAN is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  MacCAN-TouCAN is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with MacCAN-TouCAN.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef TOUCAN_IDSTATS_H_INCLUDED
+#define TOUCAN_IDSTATS_H_INCLUDED
+
+#include "TouCAN_USB_Common.h"
+
+#include "MacCAN_IOUsbKit.h"
+
+#define TOUCAN_IDSTATS_MAX_XTD_IDS  65536U  /* max. number of 29-bit identifiers in the table */
+
+typedef struct idstats_tag *TouCAN_IdStats_t;
+
+typedef struct idstats_value_t_ {       /* traffic statistics of an identifier: */
+    UInt32 id;                          /* - CAN identifier */
+    bool xtd;                           /* - 29-bit identifier */
+    UInt8 dlc;                          /* - data length code of the latest CAN frame */
+    UInt64 frames;                      /* - number of received CAN frames */
+    UInt64 dlcChanges;                  /* - number of changes of the data length code */
+    UInt64 first;                       /* - time-stamp of the first CAN frame (in [nsec]) */
+    UInt64 last;                        /* - time-stamp of the latest CAN frame (in [nsec]) */
+    UInt64 gapMin;                      /* - shortest inter-arrival time (in [nsec]) */
+    UInt64 gapMax;                      /* - longest inter-arrival time (in [nsec]) */
+    UInt64 gapMean;                     /* - average inter-arrival time (in [nsec]) */
+    UInt64 jitter;                      /* - standard deviation of the inter-arrival time (in [nsec]) */
+} TouCAN_IdStatsValue_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern CANUSB_Return_t TouCAN_CreateIdStats(uint32_t xtdIds, TouCAN_IdStats_t *stats);
+extern void TouCAN_DestroyIdStats(TouCAN_IdStats_t stats);
+
+extern void TouCAN_IdStatsUpdate(TouCAN_IdStats_t stats, const TouCAN_CanMessage_t *message);
+
+extern CANUSB_Return_t TouCAN_IdStatsReadAll(TouCAN_IdStats_t stats, TouCAN_IdStatsValue_t *values, uint32_t max, uint32_t *count);
+
+extern uint32_t TouCAN_IdStatsIdentifiers(TouCAN_IdStats_t stats);
+extern uint32_t TouCAN_IdStatsCapacity(TouCAN_IdStats_t stats);
+extern uint64_t TouCAN_IdStatsDropped(TouCAN_IdStats_t stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TOUCAN_IDSTATS_H_INCLUDED */
@@ -0,0 +1,211 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later */
+/*
+ *  TouCAN - macOS User-Space Driver for Rusoku TouCAN USB Interfaces
+ *
+ *  Copyright (C) 2021-2023  Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+ *
+ *  This file is part of MacCAN-TouCAN.
+ *
+ *  MacCAN-TouCAN is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  MacCAN-TouCAN is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with MacCAN-TouCAN.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "TouCAN_IdTable.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+/* The identifier table keeps one entry of a fixed size for each identifier
+ * (the entry begins with a TouCAN_IdTableEntry_t). It is updated by the
+ * reception callback (the only writer) and can be read from any thread while
+ * the reception continues, without taking a lock:
+ * - 11-bit identifiers: a dense array of 2048 entries (indexed by identifier)
+ * - 29-bit identifiers: a hash table with linear probing; an entry is never
+ *   removed, so a reader can stop probing at the first free entry
+ * Each entry is protected by a sequence lock: the writer makes the sequence
+ * odd before and even after an update, and a reader retries when it saw an
+ * odd sequence or when the sequence changed while it was copying the entry.
+ */
+#define STD_ENTRIES  (CAN_MAX_STD_ID + 1U)
+#define HASH_FACTOR  0x9E3779B1U  /* Fibonacci hashing */
+
+#define ENTRY(base,index,size)  ((TouCAN_IdTableEntry_t*)((base) + ((size_t)(index) * (size))))
+
+static TouCAN_IdTableEntry_t *FindEntry(TouCAN_IdTable_t *table, UInt32 id, bool insert);
+static void CopyEntry(const TouCAN_IdTable_t *table, const TouCAN_IdTableEntry_t *entry, void *copy);
+
+CANUSB_Return_t TouCAN_InitIdTable(TouCAN_IdTable_t *table, size_t entrySize, uint32_t xtdIds) {
+    UInt32 size = 2U;
+    UInt32 shift = 31U;
+
+    if (!table)
+        return CANUSB_ERROR_NULLPTR;
+    if ((entrySize < sizeof(TouCAN_IdTableEntry_t)) || (xtdIds > TOUCAN_IDTABLE_MAX_XTD_IDS))
+        return CANUSB_ERROR_ILLPARA;
+
+    /* note: the hash table is at most half full (short probe sequences) */
+    while (size < (2U * xtdIds)) {
+        size <<= 1;
+        shift--;
+    }
+    bzero(table, sizeof(TouCAN_IdTable_t));
+    if ((table->std = (UInt8*)calloc(STD_ENTRIES, entrySize)) == NULL)
+        return CANUSB_ERROR_RESOURCE;
+    if (xtdIds && ((table->xtd = (UInt8*)calloc(size, entrySize)) == NULL)) {
+        free(table->std);
+        table->std = NULL;
+        return CANUSB_ERROR_RESOURCE;
+    }
+    table->entrySize = entrySize;
+    table->xtdSize = xtdIds ? size : 0U;
+    table->xtdShift = shift;
+    table->xtdLimit = xtdIds;
+    return CANUSB_SUCCESS;
+}
+
+void TouCAN_FreeIdTable(TouCAN_IdTable_t *table) {
+    if (table) {
+        if (table->xtd)
+            free(table->xtd);
+        if (table->std)
+            free(table->std);
+        bzero(table, sizeof(TouCAN_IdTable_t));
+    }
+}
+
+void *TouCAN_IdTableBeginUpdate(TouCAN_IdTable_t *table, const TouCAN_CanMessage_t *message) {
+    TouCAN_IdTableEntry_t *entry = NULL;
+
+    assert(table);
+    assert(message);
+
+    if (message->sts)  /* note: status messages have no identifier */
+        return NULL;
+    if (!message->xtd) {
+        if (message->id < STD_ENTRIES)
+            entry = ENTRY(table->std, message->id, table->entrySize);
+    } else {
+        entry = FindEntry(table, message->id, true);
+    }
+    if (!entry) {
+        table->dropped++;
+        return NULL;
+    }
+    /* sequence lock: odd while the entry is updated */
+    __atomic_store_n(&entry->sequence, entry->sequence + 1U, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    return (void*)entry;
+}
+
+void TouCAN_IdTableEndUpdate(TouCAN_IdTable_t *table, void *entry, const TouCAN_CanMessage_t *message) {
+    TouCAN_IdTableEntry_t *header = (TouCAN_IdTableEntry_t*)entry;
+
+    assert(table);
+    assert(header);
+    assert(message);
+    (void)table;
+
+    __atomic_store_n(&header->sequence, header->sequence + 1U, __ATOMIC_RELEASE);
+    /* a new 29-bit entry becomes visible to the readers after its first update */
+    if (message->xtd && !header->key)
+        __atomic_store_n(&header->key, message->id + 1U, __ATOMIC_RELEASE);
+}
+
+bool TouCAN_IdTableRead(TouCAN_IdTable_t *table, uint32_t id, bool xtd, void *copy) {
+    const TouCAN_IdTableEntry_t *entry = NULL;
+
+    assert(table);
+    assert(copy);
+
+    /* look up the identifier (not received yet: false) */
+    if (!xtd)
+        entry = (id < STD_ENTRIES) ? ENTRY(table->std, id, table->entrySize) : NULL;
+    else
+        entry = FindEntry(table, id, false);
+    if (!entry)
+        return false;
+    CopyEntry(table, entry, copy);
+    return true;
+}
+
+uint32_t TouCAN_IdTableReadAll(TouCAN_IdTable_t *table, void *copy, TouCAN_IdTableConvert_t convert,
+                               void *values, size_t valueSize, uint32_t max) {
+    UInt32 n = 0U;
+
+    assert(table);
+    assert(copy);
+    assert(convert);
+
+    /* 11-bit identifiers in ascending order, then 29-bit identifiers (in no particular order) */
+    for (UInt32 i = 0U; (i < STD_ENTRIES) && (n < max); i++) {
+        CopyEntry(table, ENTRY(table->std, i, table->entrySize), copy);
+        if (convert(copy, (UInt8*)values + ((size_t)n * valueSize), i, false))
+            n++;
+    }
+    for (UInt32 i = 0U; (i < table->xtdSize) && (n < max); i++) {
+        const TouCAN_IdTableEntry_t *entry = ENTRY(table->xtd, i, table->entrySize);
+        UInt32 key = __atomic_load_n(&entry->key, __ATOMIC_ACQUIRE);
+        if (!key)
+            continue;
+        CopyEntry(table, entry, copy);
+        if (convert(copy, (UInt8*)values + ((size_t)n * valueSize), key - 1U, true))
+            n++;
+    }
+    return n;
+}
+
+uint32_t TouCAN_IdTableCapacity(const TouCAN_IdTable_t *table) {
+    return table ? (STD_ENTRIES + table->xtdLimit) : 0U;
+}
+
+uint64_t TouCAN_IdTableDropped(const TouCAN_IdTable_t *table) {
+    return table ? table->dropped : 0U;
+}
+
+static TouCAN_IdTableEntry_t *FindEntry(TouCAN_IdTable_t *table, UInt32 id, bool insert) {
+    UInt32 index, key;
+
+    assert(table);
+
+    if (!table->xtdSize)
+        return NULL;
+    /* linear probing from the hash value of the identifier */
+    index = (id * HASH_FACTOR) >> table->xtdShift;
+    for (UInt32 i = 0U; i < table->xtdSize; i++) {
+        TouCAN_IdTableEntry_t *entry = ENTRY(table->xtd, index, table->entrySize);
+        key = __atomic_load_n(&entry->key, __ATOMIC_ACQUIRE);
+        if (key == (id + 1U))
+            return entry;
+        if (!key) {
+            /* note: only the writer inserts, the key is published after the first update */
+            if (!insert || (table->xtdCount >= table->xtdLimit))
+                return NULL;
+            table->xtdCount++;
+            return entry;
+        }
+        index = (index + 1U) & (table->xtdSize - 1U);
+    }
+    return NULL;
+}
+
+static void CopyEntry(const TouCAN_IdTable_t *table, const TouCAN_IdTableEntry_t *entry, void *copy) {
+    UInt32 before, after;
+
+    /* sequence lock: retry while the entry is updated */
+    do {
+        before = __atomic_load_n(&entry->sequence, __ATOMIC_ACQUIRE);
+        memcpy(copy, entry, table->entrySize);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        after = __atomic_load_n(&entry->sequence, __ATOMIC_RELAXED);
+    } while ((before & 1U) || (before != after));
+}
@@ -0,0 +1,71 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later */
+/*
+ *  TouCAN - macOS User-Space Driver for Rusoku TouCAN USB Interfaces
+ *
+ *  Copyright (C) 2021-2023  Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+ *
+ *  This file is part of MacCAN-TouCAN.
+ *
+ *  MacCAN-TouCAN is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  MacCAN-TouCAN is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with MacCAN-TouCAN.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef TOUCAN_IDTABLE_H_INCLUDED
+#define TOUCAN_IDTABLE_H_INCLUDED
+
+#include "TouCAN_USB_Common.h"
+
+#include "MacCAN_IOUsbKit.h"
+
+#define TOUCAN_IDTABLE_MAX_XTD_IDS  65536U  /* max. number of 29-bit identifiers in a table */
+
+typedef struct idtable_entry_t_ {       /* header of an entry (first member of the entry): */
+    UInt32 sequence;                    /* - sequence lock (odd while updated) */
+    UInt32 key;                         /* - 29-bit identifier + 1 (0 = free entry) */
+} TouCAN_IdTableEntry_t;
+
+typedef struct idtable_t_ {             /* table of CAN identifiers: */
+    UInt8 *std;                         /* - 11-bit identifiers (dense) */
+    UInt8 *xtd;                         /* - 29-bit identifiers (hash table) */
+    size_t entrySize;                   /* - size of an entry (in [byte]) */
+    UInt32 xtdSize;                     /* - number of entries (power of two) */
+    UInt32 xtdShift;                    /* - shift of the hash value */
+    UInt32 xtdCount;                    /* - number of used entries */
+    UInt32 xtdLimit;                    /* - max. number of used entries */
+    UInt64 dropped;                     /* - CAN frames not stored (table full) */
+} TouCAN_IdTable_t;
+
+/* converts a consistent copy of an entry into a value (false: entry unused) */
+typedef bool (*TouCAN_IdTableConvert_t)(const void *copy, void *value, uint32_t id, bool xtd);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern CANUSB_Return_t TouCAN_InitIdTable(TouCAN_IdTable_t *table, size_t entrySize, uint32_t xtdIds);
+extern void TouCAN_FreeIdTable(TouCAN_IdTable_t *table);
+
+extern void *TouCAN_IdTableBeginUpdate(TouCAN_IdTable_t *table, const TouCAN_CanMessage_t *message);
+extern void TouCAN_IdTableEndUpdate(TouCAN_IdTable_t *table, void *entry, const TouCAN_CanMessage_t *message);
+
+extern bool TouCAN_IdTableRead(TouCAN_IdTable_t *table, uint32_t id, bool xtd, void *copy);
+extern uint32_t TouCAN_IdTableReadAll(TouCAN_IdTable_t *table, void *copy, TouCAN_IdTableConvert_t convert,
+                                      void *values, size_t valueSize, uint32_t max);
+
+extern uint32_t TouCAN_IdTableCapacity(const TouCAN_IdTable_t *table);
+extern uint64_t TouCAN_IdTableDropped(const TouCAN_IdTable_t *table);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TOUCAN_IDTABLE_H_INCLUDED */
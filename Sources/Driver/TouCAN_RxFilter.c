@@ -0,0 +1,219 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later */
+/*
+ *  TouCAN - macOS User-Space Driver for Rusoku TouCAN USB Adapters
+ *
+ *  Copyright (C) 2021-2023  Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+ *
+ *  This file is part of MacCAN-TouCAN.
+ *
+ *  MacCAN-TouCAN is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  MacCAN-TouCAN is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with MacCAN-TouCAN.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "TouCAN_RxFilter.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+/* The filter rules are compiled once into structures for a fast lookup in the
+ * reception callback (i.e. before a CAN frame is put into the receive queue):
+ * - 11-bit identifiers: a bitmap of 2048 bits (one bit per identifier)
+ * - 29-bit identifiers: sorted and disjoint identifier ranges (binary search)
+ * - payload predicates: the rules with data bytes to be matched, sorted by the
+ *   first identifier (11-bit identifiers with a predicate are marked in a 2nd
+ *   bitmap, so that other identifiers are rejected without scanning them)
+ * A CAN frame is accepted when at least one rule matches.
+ */
+#define BITMAP_SIZE  ((CAN_MAX_STD_ID + 1U) / 8U)
+
+#define BIT_SET(map,id)  ((map)[(id) >> 3] |= (UInt8)(1U << ((id) & 7U)))
+#define BIT_TEST(map,id)  (((map)[(id) >> 3] & (UInt8)(1U << ((id) & 7U))) != 0U)
+
+typedef struct rx_filter_range_t_ {     /* range of 29-bit identifiers: */
+    UInt32 first;                       /* - first identifier */
+    UInt32 last;                        /* - last identifier (inclusive) */
+} RxFilterRange_t;
+
+struct rx_filter_tag {                  /* compiled filter rules: */
+    UInt8 bitmap[BITMAP_SIZE];          /* - accepted 11-bit identifiers */
+    UInt8 predicated[BITMAP_SIZE];      /* - 11-bit identifiers with payload predicates */
+    RxFilterRange_t *ranges;            /* - accepted 29-bit identifiers (sorted, disjoint) */
+    UInt32 numRanges;                   /* - number of ranges */
+    TouCAN_RxFilterRule_t *predicates;  /* - rules with payload predicates (sorted by first identifier) */
+    UInt32 numPredicates;               /* - number of rules with payload predicates */
+};
+
+static bool HasPredicate(const TouCAN_RxFilterRule_t *rule);
+static bool MatchPredicate(const TouCAN_RxFilterRule_t *rule, const TouCAN_CanMessage_t *message);
+static int CompareRanges(const void *a, const void *b);
+static int CompareRules(const void *a, const void *b);
+
+CANUSB_Return_t TouCAN_CompileRxFilter(const TouCAN_RxFilterRule_t *rules, uint32_t count, TouCAN_RxFilter_t *filter) {
+    TouCAN_RxFilter_t compiled = NULL;
+    UInt32 numRanges = 0U;
+    UInt32 numPredicates = 0U;
+
+    if (!rules || !filter)
+        return CANUSB_ERROR_NULLPTR;
+    if ((count == 0U) || (count > TOUCAN_RXFLT_MAX_RULES))
+        return CANUSB_ERROR_ILLPARA;
+
+    /* check the rules and count what goes where */
+    for (UInt32 i = 0U; i < count; i++) {
+        if ((rules[i].first > rules[i].last) ||
+            (rules[i].last > (rules[i].xtd ? CAN_MAX_XTD_ID : CAN_MAX_STD_ID)) ||
+            (rules[i].dlc > CAN_MAX_LEN))
+            return CANUSB_ERROR_ILLPARA;
+        if (HasPredicate(&rules[i]))
+            numPredicates++;
+        else if (rules[i].xtd)
+            numRanges++;
+    }
+    if ((compiled = (TouCAN_RxFilter_t)calloc(1U, sizeof(struct rx_filter_tag))) == NULL)
+        return CANUSB_ERROR_RESOURCE;
+    if (numRanges && ((compiled->ranges = (RxFilterRange_t*)calloc(numRanges, sizeof(RxFilterRange_t))) == NULL)) {
+        TouCAN_ReleaseRxFilter(compiled);
+        return CANUSB_ERROR_RESOURCE;
+    }
+    if (numPredicates && ((compiled->predicates = (TouCAN_RxFilterRule_t*)calloc(numPredicates, sizeof(TouCAN_RxFilterRule_t))) == NULL)) {
+        TouCAN_ReleaseRxFilter(compiled);
+        return CANUSB_ERROR_RESOURCE;
+    }
+    /* distribute the rules */
+    for (UInt32 i = 0U; i < count; i++) {
+        if (HasPredicate(&rules[i])) {
+            TouCAN_RxFilterRule_t *rule = &compiled->predicates[compiled->numPredicates++];
+            *rule = rules[i];
+            for (int j = 0; j < CAN_MAX_LEN; j++)
+                rule->code[j] &= rule->mask[j];
+            if (!rule->xtd) {
+                for (UInt32 id = rule->first; id <= rule->last; id++)
+                    BIT_SET(compiled->predicated, id);
+            }
+        } else if (rules[i].xtd) {
+            compiled->ranges[compiled->numRanges].first = rules[i].first;
+            compiled->ranges[compiled->numRanges].last = rules[i].last;
+            compiled->numRanges++;
+        } else {
+            for (UInt32 id = rules[i].first; id <= rules[i].last; id++)
+                BIT_SET(compiled->bitmap, id);
+        }
+    }
+    /* sort the ranges and merge overlapping or adjacent ones */
+    if (compiled->numRanges > 1U) {
+        UInt32 n = 0U;
+        qsort(compiled->ranges, compiled->numRanges, sizeof(RxFilterRange_t), CompareRanges);
+        for (UInt32 i = 1U; i < compiled->numRanges; i++) {
+            if (compiled->ranges[i].first <= (compiled->ranges[n].last + 1U)) {
+                if (compiled->ranges[i].last > compiled->ranges[n].last)
+                    compiled->ranges[n].last = compiled->ranges[i].last;
+            } else
+                compiled->ranges[++n] = compiled->ranges[i];
+        }
+        compiled->numRanges = n + 1U;
+    }
+    /* sort the payload predicates by their first identifier */
+    if (compiled->numPredicates > 1U)
+        qsort(compiled->predicates, compiled->numPredicates, sizeof(TouCAN_RxFilterRule_t), CompareRules);
+    *filter = compiled;
+    return CANUSB_SUCCESS;
+}
+
+void TouCAN_ReleaseRxFilter(TouCAN_RxFilter_t filter) {
+    if (filter) {
+        if (filter->ranges)
+            free(filter->ranges);
+        if (filter->predicates)
+            free(filter->predicates);
+        free(filter);
+    }
+}
+
+bool TouCAN_RxFilterAccept(TouCAN_RxFilter_t filter, const TouCAN_CanMessage_t *message) {
+    assert(filter);
+    assert(message);
+
+    if (!message->xtd) {
+        /* 11-bit identifier: look it up in the bitmaps */
+        if (message->id > CAN_MAX_STD_ID)
+            return false;
+        if (BIT_TEST(filter->bitmap, message->id))
+            return true;
+        if (!BIT_TEST(filter->predicated, message->id))
+            return false;
+    } else {
+        /* 29-bit identifier: binary search for the last range starting at or before it */
+        UInt32 lower = 0U;
+        UInt32 upper = filter->numRanges;
+        while (lower < upper) {
+            UInt32 middle = lower + ((upper - lower) / 2U);
+            if (filter->ranges[middle].first <= message->id)
+                lower = middle + 1U;
+            else
+                upper = middle;
+        }
+        if ((lower > 0U) && (message->id <= filter->ranges[lower - 1U].last))
+            return true;
+    }
+    /* payload predicates (in order of their first identifier) */
+    for (UInt32 i = 0U; i < filter->numPredicates; i++) {
+        const TouCAN_RxFilterRule_t *rule = &filter->predicates[i];
+        if (rule->first > message->id)
+            break;
+        if (MatchPredicate(rule, message))
+            return true;
+    }
+    return false;
+}
+
+static bool HasPredicate(const TouCAN_RxFilterRule_t *rule) {
+    assert(rule);
+
+    if (rule->dlc)
+        return true;
+    for (int i = 0; i < CAN_MAX_LEN; i++) {
+        if (rule->mask[i])
+            return true;
+    }
+    return false;
+}
+
+static bool MatchPredicate(const TouCAN_RxFilterRule_t *rule, const TouCAN_CanMessage_t *message) {
+    assert(rule);
+    assert(message);
+
+    /* note: remote frames have no payload */
+    if ((rule->xtd != (message->xtd ? true : false)) || message->rtr)
+        return false;
+    if ((message->id > rule->last) || (message->dlc < rule->dlc))
+        return false;
+    for (int i = 0; i < CAN_MAX_LEN; i++) {
+        if ((message->data[i] & rule->mask[i]) != rule->code[i])
+            return false;
+    }
+    return true;
+}
+
+static int CompareRanges(const void *a, const void *b) {
+    const RxFilterRange_t *r1 = (const RxFilterRange_t*)a;
+    const RxFilterRange_t *r2 = (const RxFilterRange_t*)b;
+
+    return (r1->first < r2->first) ? -1 : (r1->first > r2->first) ? 1 : 0;
+}
+
+static int CompareRules(const void *a, const void *b) {
+    const TouCAN_RxFilterRule_t *r1 = (const TouCAN_RxFilterRule_t*)a;
+    const TouCAN_RxFilterRule_t *r2 = (const TouCAN_RxFilterRule_t*)b;
+
+    return (r1->first < r2->first) ? -1 : (r1->first > r2->first) ? 1 : 0;
+}
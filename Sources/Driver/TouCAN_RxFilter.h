@@ -0,0 +1,55 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later */
+/*
+ *  TouCAN - macOS User-Space Driver for Rusoku TouCAN USB Interfaces
+ *
+ *  Copyright (C) 2021-2023  Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+ *
+ *  This file is part of MacCAN-TouCAN.
+ *
+ *  MacCAN-TouCAN is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  MacCAN-TouCAN is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with MacCAN-TouCAN.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef TOUCAN_RXFILTER_H_INCLUDED
+#define TOUCAN_RXFILTER_H_INCLUDED
+
+#include "TouCAN_USB_Common.h"
+
+#include "MacCAN_IOUsbKit.h"
+
+#define TOUCAN_RXFLT_MAX_RULES  65536U  /* max. number of filter rules per channel */
+
+typedef struct rx_filter_tag *TouCAN_RxFilter_t;
+
+typedef struct rx_filter_rule_t_ {      /* filter rule (accepts CAN frames): */
+    uint32_t first;                     /* - first identifier of the range */
+    uint32_t last;                      /* - last identifier of the range (inclusive) */
+    bool xtd;                           /* - 29-bit identifiers (otherwise 11-bit) */
+    uint8_t dlc;                        /* - payload predicate: minimal data length code */
+    uint8_t code[8];                    /* - payload predicate: data bytes to be matched */
+    uint8_t mask[8];                    /* - payload predicate: bits to be compared (all zero = none) */
+} TouCAN_RxFilterRule_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern CANUSB_Return_t TouCAN_CompileRxFilter(const TouCAN_RxFilterRule_t *rules, uint32_t count, TouCAN_RxFilter_t *filter);
+extern void TouCAN_ReleaseRxFilter(TouCAN_RxFilter_t filter);
+
+extern bool TouCAN_RxFilterAccept(TouCAN_RxFilter_t filter, const TouCAN_CanMessage_t *message);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TOUCAN_RXFILTER_H_INCLUDED */
@@ -0,0 +1,373 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later */
+/*
+ *  TouCAN - macOS User-Space Driver for Rusoku TouCAN USB Adapters
+ *
+ *  Copyright (C) 2021-2023  Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+ *
+ *  This file is part of MacCAN-TouCAN.
+ *
+ *  MacCAN-TouCAN is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  MacCAN-TouCAN is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with MacCAN-TouCAN.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "TouCAN_Scheduler.h"
+#include "MacCAN_Debug.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <assert.h>
+
+/* note: all deadlines are absolute times of the monotonic clock (in [nsec]) */
+#define TICK_NSEC  ((UInt64)TOUCAN_SCHED_TICK_USEC * 1000U)
+#define WHEEL_MASK  (TOUCAN_SCHED_WHEEL_SIZE - 1U)
+#define NO_ENTRY  (-1)
+
+typedef struct tx_schedule_entry_t_ {   /* cyclic CAN message: */
+    bool used;                          /* - entry in use */
+    UInt32 generation;                  /* - incremented each time the entry is reused */
+    TouCAN_CanMessage_t message;        /* - CAN message to be sent */
+    UInt64 period;                      /* - cycle time (in [nsec]) */
+    UInt64 deadline;                    /* - next release time (in [nsec]) */
+    UInt32 slot;                        /* - slot of the timer wheel */
+    int32_t next;                       /* - next entry in the same slot (or NO_ENTRY) */
+    UInt64 sent;                        /* - number of CAN frames put into the transmit path */
+    UInt64 missed;                      /* - number of deadline misses */
+    UInt64 releases;                    /* - number of releases (for the average) */
+    UInt64 delaySum;                    /* - sum of release delays (in [nsec]) */
+    UInt64 delayMin;                    /* - shortest release delay (in [nsec]) */
+    UInt64 delayMax;                    /* - longest release delay (in [nsec]) */
+} TxScheduleEntry_t;
+
+struct tx_scheduler_tag {               /* cyclic transmit scheduler: */
+    pthread_mutex_t mutex;              /* - mutex for the entries and the wheel */
+    pthread_cond_t cond;                /* - wakes the thread on changes */
+    pthread_t thread;                   /* - scheduler thread */
+    volatile bool running;              /* - to indicate that the thread is running */
+    TouCAN_SchedulerCbk_t callback;     /* - feeds the transmit path */
+    void *context;                      /* - context for the callback */
+    UInt64 epoch;                       /* - time base of the timer wheel (in [nsec]) */
+    UInt64 tick;                        /* - next tick to be processed */
+    UInt32 numEntries;                  /* - number of entries in use */
+    int32_t wheel[TOUCAN_SCHED_WHEEL_SIZE];  /* - first entry of each slot */
+    TxScheduleEntry_t entries[TOUCAN_SCHED_MAX_ENTRIES];  /* - cyclic CAN messages */
+    TouCAN_CanMessage_t batch[TOUCAN_SCHED_MAX_ENTRIES];  /* - CAN messages released at once */
+    int32_t index[TOUCAN_SCHED_MAX_ENTRIES];  /* - their entries */
+    UInt32 generation[TOUCAN_SCHED_MAX_ENTRIES];  /* - and the generation of the entries */
+};
+
+static void *SchedulerThread(void *arg);
+static UInt64 ReleaseEntries(TouCAN_Scheduler_t scheduler, UInt64 now, UInt32 *count);
+static UInt64 NextDeadline(TouCAN_Scheduler_t scheduler);
+static void InsertEntry(TouCAN_Scheduler_t scheduler, int32_t index);
+static void UnlinkEntry(TouCAN_Scheduler_t scheduler, int32_t index);
+
+TouCAN_Scheduler_t TouCAN_CreateScheduler(TouCAN_SchedulerCbk_t callback, void *context) {
+    TouCAN_Scheduler_t scheduler = NULL;
+
+    if (!callback)
+        return NULL;
+    if ((scheduler = (TouCAN_Scheduler_t)calloc(1U, sizeof(struct tx_scheduler_tag))) == NULL) {
+        MACCAN_DEBUG_ERROR("+++ Unable to create transmit scheduler (NULL pointer)\n");
+        return NULL;
+    }
+    for (UInt32 i = 0U; i < TOUCAN_SCHED_WHEEL_SIZE; i++)
+        scheduler->wheel[i] = NO_ENTRY;
+    scheduler->callback = callback;
+    scheduler->context = context;
+    scheduler->epoch = MacCAN_GetTime();
+    scheduler->tick = 0U;
+    if ((pthread_mutex_init(&scheduler->mutex, NULL) != 0) ||
+        (MacCAN_InitCondition(&scheduler->cond) != 0)) {
+        MACCAN_DEBUG_ERROR("+++ Unable to create transmit scheduler (mutex)\n");
+        free(scheduler);
+        return NULL;
+    }
+    scheduler->running = true;
+    if (pthread_create(&scheduler->thread, NULL, SchedulerThread, (void*)scheduler) != 0) {
+        MACCAN_DEBUG_ERROR("+++ Unable to create transmit scheduler (thread)\n");
+        (void)pthread_cond_destroy(&scheduler->cond);
+        (void)pthread_mutex_destroy(&scheduler->mutex);
+        free(scheduler);
+        return NULL;
+    }
+    return scheduler;
+}
+
+CANUSB_Return_t TouCAN_DestroyScheduler(TouCAN_Scheduler_t scheduler) {
+    if (!scheduler)
+        return CANUSB_ERROR_NULLPTR;
+
+    /* stop the scheduler thread */
+    (void)pthread_mutex_lock(&scheduler->mutex);
+    scheduler->running = false;
+    (void)pthread_cond_signal(&scheduler->cond);
+    (void)pthread_mutex_unlock(&scheduler->mutex);
+    (void)pthread_join(scheduler->thread, NULL);
+    /* release all resources */
+    (void)pthread_cond_destroy(&scheduler->cond);
+    (void)pthread_mutex_destroy(&scheduler->mutex);
+    free(scheduler);
+    return CANUSB_SUCCESS;
+}
+
+CANUSB_Return_t TouCAN_ScheduleAdd(TouCAN_Scheduler_t scheduler, const TouCAN_CanMessage_t *message, uint32_t period, uint32_t phase, int32_t *entry) {
+    CANUSB_Return_t retVal = CANUSB_ERROR_RESOURCE;
+
+    if (!scheduler || !message || !entry)
+        return CANUSB_ERROR_NULLPTR;
+    if (period < TOUCAN_SCHED_MIN_PERIOD)
+        return CANUSB_ERROR_ILLPARA;
+
+    (void)pthread_mutex_lock(&scheduler->mutex);
+    for (int32_t i = 0; i < (int32_t)TOUCAN_SCHED_MAX_ENTRIES; i++) {
+        TxScheduleEntry_t *e = &scheduler->entries[i];
+        if (!e->used) {
+            UInt32 generation = e->generation + 1U;
+            bzero(e, sizeof(TxScheduleEntry_t));
+            e->used = true;
+            e->generation = generation;
+            memcpy(&e->message, message, sizeof(TouCAN_CanMessage_t));
+            e->period = (UInt64)period * 1000U;
+            /* note: the first release is 'phase' after now, then every 'period' */
+            e->deadline = MacCAN_GetTime() + ((UInt64)phase * 1000U);
+            e->delayMin = (UInt64)-1;
+            InsertEntry(scheduler, i);
+            scheduler->numEntries++;
+            /* note: the scheduler thread has to recalculate its wake-up time */
+            (void)pthread_cond_signal(&scheduler->cond);
+            *entry = i;
+            retVal = CANUSB_SUCCESS;
+            break;
+        }
+    }
+    (void)pthread_mutex_unlock(&scheduler->mutex);
+    return retVal;
+}
+
+CANUSB_Return_t TouCAN_ScheduleRemove(TouCAN_Scheduler_t scheduler, int32_t entry) {
+    CANUSB_Return_t retVal = CANUSB_ERROR_ILLPARA;
+
+    if (!scheduler)
+        return CANUSB_ERROR_NULLPTR;
+    if ((entry < 0) || ((int32_t)TOUCAN_SCHED_MAX_ENTRIES <= entry))
+        return CANUSB_ERROR_ILLPARA;
+
+    (void)pthread_mutex_lock(&scheduler->mutex);
+    if (scheduler->entries[entry].used) {
+        UnlinkEntry(scheduler, entry);
+        scheduler->entries[entry].used = false;
+        scheduler->numEntries--;
+        retVal = CANUSB_SUCCESS;
+    }
+    (void)pthread_mutex_unlock(&scheduler->mutex);
+    return retVal;
+}
+
+CANUSB_Return_t TouCAN_ScheduleUpdate(TouCAN_Scheduler_t scheduler, int32_t entry, const uint8_t *data, uint8_t dlc) {
+    CANUSB_Return_t retVal = CANUSB_ERROR_ILLPARA;
+
+    if (!scheduler || (!data && dlc))
+        return CANUSB_ERROR_NULLPTR;
+    if ((entry < 0) || ((int32_t)TOUCAN_SCHED_MAX_ENTRIES <= entry) || (dlc > CAN_MAX_LEN))
+        return CANUSB_ERROR_ILLPARA;
+
+    /* note: the new payload is sent with the next release (the deadline is kept) */
+    (void)pthread_mutex_lock(&scheduler->mutex);
+    if (scheduler->entries[entry].used) {
+        TouCAN_CanMessage_t *message = &scheduler->entries[entry].message;
+        message->dlc = dlc;
+        bzero(message->data, sizeof(message->data));
+        if (dlc)
+            memcpy(message->data, data, (size_t)dlc);
+        retVal = CANUSB_SUCCESS;
+    }
+    (void)pthread_mutex_unlock(&scheduler->mutex);
+    return retVal;
+}
+
+CANUSB_Return_t TouCAN_ScheduleStatistics(TouCAN_Scheduler_t scheduler, int32_t entry, TouCAN_ScheduleStats_t *stats) {
+    CANUSB_Return_t retVal = CANUSB_ERROR_ILLPARA;
+
+    if (!scheduler || !stats)
+        return CANUSB_ERROR_NULLPTR;
+    if ((entry < 0) || ((int32_t)TOUCAN_SCHED_MAX_ENTRIES <= entry))
+        return CANUSB_ERROR_ILLPARA;
+
+    /* note: the statistics of a removed entry are kept until the entry is reused */
+    (void)pthread_mutex_lock(&scheduler->mutex);
+    if (scheduler->entries[entry].generation) {
+        const TxScheduleEntry_t *e = &scheduler->entries[entry];
+        stats->sent = (uint64_t)e->sent;
+        stats->missed = (uint64_t)e->missed;
+        stats->jitterMin = e->releases ? (uint32_t)(e->delayMin / 1000U) : 0U;
+        stats->jitterMax = e->releases ? (uint32_t)(e->delayMax / 1000U) : 0U;
+        stats->jitterAvg = e->releases ? (uint32_t)((e->delaySum / e->releases) / 1000U) : 0U;
+        retVal = CANUSB_SUCCESS;
+    }
+    (void)pthread_mutex_unlock(&scheduler->mutex);
+    return retVal;
+}
+
+uint32_t TouCAN_ScheduleEntries(TouCAN_Scheduler_t scheduler) {
+    uint32_t count = 0U;
+
+    if (scheduler) {
+        (void)pthread_mutex_lock(&scheduler->mutex);
+        count = (uint32_t)scheduler->numEntries;
+        (void)pthread_mutex_unlock(&scheduler->mutex);
+    }
+    return count;
+}
+
+static void *SchedulerThread(void *arg) {
+    TouCAN_Scheduler_t scheduler = (TouCAN_Scheduler_t)arg;
+    CANUSB_Return_t retVal;
+    UInt32 count = 0U;
+    uint32_t written = 0U;
+    UInt64 deadline;
+
+    assert(scheduler);
+
+    (void)pthread_mutex_lock(&scheduler->mutex);
+    while (scheduler->running) {
+        /* release all CAN messages whose deadline has passed */
+        deadline = ReleaseEntries(scheduler, MacCAN_GetTime(), &count);
+        if (count) {
+            /* feed the transmit path w/o holding the lock */
+            (void)pthread_mutex_unlock(&scheduler->mutex);
+            written = 0U;
+            retVal = scheduler->callback(scheduler->context, scheduler->batch, (uint32_t)count, &written);
+            (void)pthread_mutex_lock(&scheduler->mutex);
+            /* note: an entry could have been removed (or reused) in the meantime */
+            for (UInt32 i = 0U; i < count; i++) {
+                TxScheduleEntry_t *e = &scheduler->entries[scheduler->index[i]];
+                if (!e->used || (e->generation != scheduler->generation[i]))
+                    continue;
+                if (i < (UInt32)written)
+                    e->sent++;
+                else if (retVal == CANUSB_ERROR_BUSY)
+                    e->missed++;  /* transmitter busy */
+            }
+            /* note: the deadlines have moved on, look again */
+            continue;
+        }
+        /* sleep until the next deadline, or until an entry has been added */
+        if (deadline)
+            (void)MacCAN_TimedWaitUntil(&scheduler->cond, &scheduler->mutex, deadline);
+        else
+            (void)pthread_cond_wait(&scheduler->cond, &scheduler->mutex);
+    }
+    (void)pthread_mutex_unlock(&scheduler->mutex);
+    return NULL;
+}
+
+static UInt64 ReleaseEntries(TouCAN_Scheduler_t scheduler, UInt64 now, UInt32 *count) {
+    UInt64 nowTick = (now - scheduler->epoch) / TICK_NSEC;
+    UInt64 numTicks = (nowTick - scheduler->tick) + 1U;
+    UInt64 delay, skipped;
+    int32_t i, next;
+
+    assert(scheduler);
+    assert(count);
+
+    /* note: at most one revolution of the wheel has to be processed, even after a long sleep */
+    if (numTicks > TOUCAN_SCHED_WHEEL_SIZE)
+        numTicks = TOUCAN_SCHED_WHEEL_SIZE;
+    *count = 0U;
+    for (UInt64 t = 0U; t < numTicks; t++) {
+        UInt32 slot = (UInt32)((scheduler->tick + t) & WHEEL_MASK);
+        for (i = scheduler->wheel[slot]; i != NO_ENTRY; i = next) {
+            TxScheduleEntry_t *e = &scheduler->entries[i];
+            next = e->next;
+            /* note: entries of a later revolution stay in the slot */
+            if (e->deadline > now)
+                continue;
+            UnlinkEntry(scheduler, i);
+            /* the release delay is the jitter, whole periods behind are misses */
+            delay = now - e->deadline;
+            if (delay >= e->period) {
+                skipped = delay / e->period;
+                e->missed += skipped;
+                e->deadline += skipped * e->period;
+                delay -= skipped * e->period;
+            }
+            e->releases++;
+            e->delaySum += delay;
+            if (e->delayMin > delay)
+                e->delayMin = delay;
+            if (e->delayMax < delay)
+                e->delayMax = delay;
+            /* copy the CAN message into the batch and schedule the next release */
+            memcpy(&scheduler->batch[*count], &e->message, sizeof(TouCAN_CanMessage_t));
+            scheduler->index[*count] = i;
+            scheduler->generation[*count] = e->generation;
+            *count += 1U;
+            e->deadline += e->period;
+            InsertEntry(scheduler, i);
+        }
+    }
+    /* note: the current tick is processed again (entries later in this tick) */
+    scheduler->tick = nowTick;
+    return NextDeadline(scheduler);
+}
+
+static UInt64 NextDeadline(TouCAN_Scheduler_t scheduler) {
+    UInt64 deadline = 0U;
+    int32_t i;
+
+    assert(scheduler);
+
+    if (!scheduler->numEntries)
+        return 0U;
+    /* the first slot with an entry of this revolution holds the earliest deadline */
+    for (UInt64 t = scheduler->tick; t < (scheduler->tick + TOUCAN_SCHED_WHEEL_SIZE); t++) {
+        for (i = scheduler->wheel[t & WHEEL_MASK]; i != NO_ENTRY; i = scheduler->entries[i].next) {
+            if (((scheduler->entries[i].deadline - scheduler->epoch) / TICK_NSEC) <= t) {
+                if (!deadline || (scheduler->entries[i].deadline < deadline))
+                    deadline = scheduler->entries[i].deadline;
+            }
+        }
+        if (deadline)
+            return deadline;
+    }
+    /* note: nothing within one revolution, wake up after one revolution */
+    return scheduler->epoch + ((scheduler->tick + TOUCAN_SCHED_WHEEL_SIZE) * TICK_NSEC);
+}
+
+static void InsertEntry(TouCAN_Scheduler_t scheduler, int32_t index) {
+    TxScheduleEntry_t *e = &scheduler->entries[index];
+    UInt64 tick = (e->deadline > scheduler->epoch) ? ((e->deadline - scheduler->epoch) / TICK_NSEC) : 0U;
+
+    /* note: an entry due in the past goes into the slot processed next */
+    if (tick < scheduler->tick)
+        tick = scheduler->tick;
+    e->slot = (UInt32)(tick & WHEEL_MASK);
+    e->next = scheduler->wheel[e->slot];
+    scheduler->wheel[e->slot] = index;
+}
+
+static void UnlinkEntry(TouCAN_Scheduler_t scheduler, int32_t index) {
+    int32_t *link = &scheduler->wheel[scheduler->entries[index].slot];
+
+    while (*link != NO_ENTRY) {
+        if (*link == index) {
+            *link = scheduler->entries[index].next;
+            break;
+        }
+        link = &scheduler->entries[*link].next;
+    }
+    scheduler->entries[index].next = NO_ENTRY;
+}
@@ -0,0 +1,63 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later */
+/*
+ *  TouCAN - macOS User-Space Driver for Rusoku TouCAN USB Interfaces
+ *
+ *  Copyright (C) 2021-2023  Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+ *
+ *  This file is part of MacCAN-TouCAN.
+ *
+ *  MacCAN-TouCAN is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  MacCAN-TouCAN is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with MacCAN-TouCAN.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef TOUCAN_SCHEDULER_H_INCLUDED
+#define TOUCAN_SCHEDULER_H_INCLUDED
+
+#include "TouCAN_USB_Common.h"
+
+#include "MacCAN_IOUsbKit.h"
+
+#define TOUCAN_SCHED_MAX_ENTRIES  512U  /* max. number of cyclic CAN messages per channel */
+#define TOUCAN_SCHED_WHEEL_SIZE  1024U  /* number of slots of the timer wheel (power of two) */
+#define TOUCAN_SCHED_TICK_USEC  100U  /* [usec] resolution of the timer wheel */
+#define TOUCAN_SCHED_MIN_PERIOD  TOUCAN_SCHED_TICK_USEC  /* [usec] shortest cycle time */
+
+typedef struct tx_scheduler_tag *TouCAN_Scheduler_t;
+
+typedef CANUSB_Return_t (*TouCAN_SchedulerCbk_t)(void *context, const TouCAN_CanMessage_t *messages, uint32_t count, uint32_t *written);
+
+typedef struct tx_schedule_stats_t_ {   /* statistics of a cyclic CAN message: */
+    uint64_t sent;                      /* - number of CAN frames put into the transmit path */
+    uint64_t missed;                    /* - number of deadline misses (skipped or not sent) */
+    uint32_t jitterMin;                 /* - shortest release delay (in [usec]) */
+    uint32_t jitterMax;                 /* - longest release delay (in [usec]) */
+    uint32_t jitterAvg;                 /* - average release delay (in [usec]) */
+} TouCAN_ScheduleStats_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern TouCAN_Scheduler_t TouCAN_CreateScheduler(TouCAN_SchedulerCbk_t callback, void *context);
+extern CANUSB_Return_t TouCAN_DestroyScheduler(TouCAN_Scheduler_t scheduler);
+
+extern CANUSB_Return_t TouCAN_ScheduleAdd(TouCAN_Scheduler_t scheduler, const TouCAN_CanMessage_t *message, uint32_t period, uint32_t phase, int32_t *entry);
+extern CANUSB_Return_t TouCAN_ScheduleRemove(TouCAN_Scheduler_t scheduler, int32_t entry);
+extern CANUSB_Return_t TouCAN_ScheduleUpdate(TouCAN_Scheduler_t scheduler, int32_t entry, const uint8_t *data, uint8_t dlc);
+extern CANUSB_Return_t TouCAN_ScheduleStatistics(TouCAN_Scheduler_t scheduler, int32_t entry, TouCAN_ScheduleStats_t *stats);
+extern uint32_t TouCAN_ScheduleEntries(TouCAN_Scheduler_t scheduler);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TOUCAN_SCHEDULER_H_INCLUDED */
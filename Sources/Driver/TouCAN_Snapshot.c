@@ -0,0 +1,142 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later */
+/*
+ *  TouCAN - macOS User-Space Driver for Rusoku TouCAN USB Interfaces
+ *
+ *  Copyright (C) 2021-2023  Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+ *
+ *  This file is part of MacCAN-TouCAN.
+ *
+ *  MacCAN-TouCAN is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  MacCAN-TouCAN is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with MacCAN-TouCAN.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "TouCAN_Snapshot.h"
+#include "TouCAN_IdTable.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+/* The snapshot table keeps the latest CAN frame of each identifier in an
+ * identifier table (see TouCAN_IdTable.c), i.e. it is updated by the reception
+ * callback (the only writer) and can be read from any thread while the
+ * reception continues, without taking a lock.
+ */
+typedef struct snapshot_entry_t_ {      /* entry of the snapshot table: */
+    TouCAN_IdTableEntry_t header;       /* - sequence lock and 29-bit identifier */
+    UInt8 flags;                        /* - RTR frame */
+    UInt8 dlc;                          /* - data length code (0..8) */
+    UInt8 data[CAN_MAX_LEN];            /* - payload (CAN 2.0) */
+    UInt64 timestamp;                   /* - time-stamp (in [nsec]) */
+    UInt64 counter;                     /* - number of received CAN frames */
+} SnapshotEntry_t;
+
+struct snapshot_tag {                   /* snapshot table: */
+    TouCAN_IdTable_t table;             /* - 11-bit and 29-bit identifiers */
+};
+
+static bool ConvertEntry(const void *copy, void *value, uint32_t id, bool xtd);
+
+CANUSB_Return_t TouCAN_CreateSnapshot(uint32_t xtdIds, TouCAN_Snapshot_t *snapshot) {
+    TouCAN_Snapshot_t object = NULL;
+    CANUSB_Return_t retVal;
+
+    if (!snapshot)
+        return CANUSB_ERROR_NULLPTR;
+    if (xtdIds > TOUCAN_SNAPSHOT_MAX_XTD_IDS)
+        return CANUSB_ERROR_ILLPARA;
+
+    if ((object = (TouCAN_Snapshot_t)calloc(1U, sizeof(struct snapshot_tag))) == NULL)
+        return CANUSB_ERROR_RESOURCE;
+    if ((retVal = TouCAN_InitIdTable(&object->table, sizeof(SnapshotEntry_t), xtdIds)) != CANUSB_SUCCESS) {
+        free(object);
+        return retVal;
+    }
+    *snapshot = object;
+    return CANUSB_SUCCESS;
+}
+
+void TouCAN_DestroySnapshot(TouCAN_Snapshot_t snapshot) {
+    if (snapshot) {
+        TouCAN_FreeIdTable(&snapshot->table);
+        free(snapshot);
+    }
+}
+
+void TouCAN_SnapshotUpdate(TouCAN_Snapshot_t snapshot, const TouCAN_CanMessage_t *message) {
+    SnapshotEntry_t *entry = NULL;
+
+    assert(snapshot);
+    assert(message);
+
+    if ((entry = (SnapshotEntry_t*)TouCAN_IdTableBeginUpdate(&snapshot->table, message)) == NULL)
+        return;
+    entry->flags = message->rtr ? 0x01U : 0x00U;
+    entry->dlc = (message->dlc <= CAN_MAX_LEN) ? message->dlc : CAN_MAX_LEN;
+    memcpy(entry->data, message->data, CAN_MAX_LEN);
+    entry->timestamp = ((UInt64)message->timestamp.tv_sec * 1000000000U)
+                     + (UInt64)message->timestamp.tv_nsec;
+    entry->counter++;
+    TouCAN_IdTableEndUpdate(&snapshot->table, entry, message);
+}
+
+CANUSB_Return_t TouCAN_SnapshotRead(TouCAN_Snapshot_t snapshot, uint32_t id, bool xtd, TouCAN_SnapshotValue_t *value) {
+    SnapshotEntry_t copy;
+
+    if (!snapshot || !value)
+        return CANUSB_ERROR_NULLPTR;
+    if (id > (xtd ? CAN_MAX_XTD_ID : CAN_MAX_STD_ID))
+        return CANUSB_ERROR_ILLPARA;
+
+    /* look up the identifier (not received yet: empty) */
+    if (!TouCAN_IdTableRead(&snapshot->table, id, xtd, &copy) || !ConvertEntry(&copy, value, id, xtd))
+        return CANUSB_ERROR_EMPTY;
+    return CANUSB_SUCCESS;
+}
+
+CANUSB_Return_t TouCAN_SnapshotReadAll(TouCAN_Snapshot_t snapshot, TouCAN_SnapshotValue_t *values, uint32_t max, uint32_t *count) {
+    SnapshotEntry_t copy;
+
+    if (!snapshot || !count || (!values && max))
+        return CANUSB_ERROR_NULLPTR;
+
+    *count = TouCAN_IdTableReadAll(&snapshot->table, &copy, ConvertEntry, values, sizeof(TouCAN_SnapshotValue_t), max);
+    return CANUSB_SUCCESS;
+}
+
+uint32_t TouCAN_SnapshotCapacity(TouCAN_Snapshot_t snapshot) {
+    return snapshot ? TouCAN_IdTableCapacity(&snapshot->table) : 0U;
+}
+
+uint64_t TouCAN_SnapshotDropped(TouCAN_Snapshot_t snapshot) {
+    return snapshot ? TouCAN_IdTableDropped(&snapshot->table) : 0U;
+}
+
+static bool ConvertEntry(const void *copy, void *value, uint32_t id, bool xtd) {
+    const SnapshotEntry_t *entry = (const SnapshotEntry_t*)copy;
+    TouCAN_SnapshotValue_t *result = (TouCAN_SnapshotValue_t*)value;
+
+    /* note: the sequence can wrap around, an entry without CAN frames is unused */
+    if (!entry->counter)
+        return false;
+
+    bzero(&result->message, sizeof(TouCAN_CanMessage_t));
+    result->message.id = id;
+    result->message.xtd = xtd ? 1 : 0;
+    result->message.rtr = (entry->flags & 0x01U) ? 1 : 0;
+    result->message.dlc = entry->dlc;
+    memcpy(result->message.data, entry->data, CAN_MAX_LEN);
+    result->message.timestamp.tv_sec = (time_t)(entry->timestamp / 1000000000U);
+    result->message.timestamp.tv_nsec = (long)(entry->timestamp % 1000000000U);
+    result->counter = entry->counter;
+    return true;
+}
@@ -0,0 +1,57 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later */
+/*
+ *  TouCAN - macOS User-Space Driver for Rusoku TouCAN USB Interfaces
+ *
+ *  Copyright (C) 2021-2023  Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+ *
+ *  This file is part of MacCAN-TouCAN.
+ *
+ *  MacCAN-TouCAN is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  MacCAN-TouCAN is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with MacCAN-TouCAN.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef TOUCAN_SNAPSHOT_H_INCLUDED
+#define TOUCAN_SNAPSHOT_H_INCLUDED
+
+#include "TouCAN_USB_Common.h"
+
+#include "MacCAN_IOUsbKit.h"
+
+#define TOUCAN_SNAPSHOT_MAX_XTD_IDS  65536U  /* max. number of 29-bit identifiers in the table */
+
+typedef struct snapshot_tag *TouCAN_Snapshot_t;
+
+typedef struct snapshot_value_t_ {      /* latest CAN frame of an identifier: */
+    TouCAN_CanMessage_t message;        /* - the CAN frame (with time-stamp) */
+    uint64_t counter;                   /* - number of CAN frames received with this identifier */
+} TouCAN_SnapshotValue_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern CANUSB_Return_t TouCAN_CreateSnapshot(uint32_t xtdIds, TouCAN_Snapshot_t *snapshot);
+extern void TouCAN_DestroySnapshot(TouCAN_Snapshot_t snapshot);
+
+extern void TouCAN_SnapshotUpdate(TouCAN_Snapshot_t snapshot, const TouCAN_CanMessage_t *message);
+
+extern CANUSB_Return_t TouCAN_SnapshotRead(TouCAN_Snapshot_t snapshot, uint32_t id, bool xtd, TouCAN_SnapshotValue_t *value);
+extern CANUSB_Return_t TouCAN_SnapshotReadAll(TouCAN_Snapshot_t snapshot, TouCAN_SnapshotValue_t *values, uint32_t max, uint32_t *count);
+
+extern uint32_t TouCAN_SnapshotCapacity(TouCAN_Snapshot_t snapshot);
+extern uint64_t TouCAN_SnapshotDropped(TouCAN_Snapshot_t snapshot);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TOUCAN_SNAPSHOT_H_INCLUDED */
@@ -588,11 +588,92 @@ int TouCAN_get_vendor(CANUSB_Handle_t handle, unsigned int size, char *str) {
 //    return (int)TOUCAN_ERROR_OFFSET;
 //}
 
-///////////////////////////////////////// LIST, MASK ////////////////////////////////////////////
-//int TouCAN_set_filter_std_list_mask(CANUSB_Handle_t handle, Filter_Type_TypeDef type, UInt32 list, UInt32 mask) {
-//    return (int)TOUCAN_ERROR_OFFSET;
-//}
+//////////////////////////////////////////////////////////////////////
+// TouCAN set filter 11-bit identifier
+//
 
-//int TouCAN_set_filter_ext_list_mask(CANUSB_Handle_t handle, Filter_Type_TypeDef type, UInt32 list, UInt32 mask) {
-//    return (int)TOUCAN_ERROR_OFFSET;
-//}
+int TouCAN_set_filter_std_list_mask(CANUSB_Handle_t handle, Filter_Type_TypeDef type, UInt32 list, UInt32 mask) {
+    CANUSB_SetupPacket_t SetupPacket;
+    CANUSB_Return_t retVal;
+    UInt8 res;
+    UInt8 data[9];
+    bzero(data, 9);
+
+    SetupPacket.RequestType = USB_HOST_TO_DEVICE | USB_REQ_TYPE_CLASS | USB_REQ_RECIPIENT_INTERFACE;
+    SetupPacket.Request = TouCAN_SET_FILTER_STD_LIST_MASK;
+    SetupPacket.Value = 0;
+    SetupPacket.Index = 0;
+    SetupPacket.Length = 9;
+
+    // filter type
+    data[0] = (UInt8)type;
+    // list (acceptance code)
+    data[1] = (UInt8) ((list >> 24) & 0xFF);
+    data[2] = (UInt8) ((list >> 16) & 0xFF);
+    data[3] = (UInt8) ((list >> 8) & 0xFF);
+    data[4] = (UInt8)  (list & 0xFF);
+    // mask (acceptance mask)
+    data[5] = (UInt8) ((mask >> 24) & 0xFF);
+    data[6] = (UInt8) ((mask >> 16) & 0xFF);
+    data[7] = (UInt8) ((mask >> 8) & 0xFF);
+    data[8] = (UInt8)  (mask & 0xFF);
+
+    // TouCAN_SET_FILTER_STD_LIST_MASK
+    retVal = CANUSB_DeviceRequest(handle, SetupPacket, (void *)data, 9, NULL);
+    if (retVal < 0)
+        return (int)retVal;
+
+    retVal = TouCAN_get_last_error_code(handle, &res);
+    if (retVal < 0)
+        return (int)retVal;
+
+    if (res != TouCAN_RETVAL_OK)
+        return (int)TOUCAN_ERROR_OFFSET - (int)res;
+
+    return (int)TOUCAN_ERROR_SUCCESS;
+}
+
+//////////////////////////////////////////////////////////////////////
+// TouCAN set filter 29-bit identifier
+//
+
+int TouCAN_set_filter_ext_list_mask(CANUSB_Handle_t handle, Filter_Type_TypeDef type, UInt32 list, UInt32 mask) {
+    CANUSB_SetupPacket_t SetupPacket;
+    CANUSB_Return_t retVal;
+    UInt8 res;
+    UInt8 data[9];
+    bzero(data, 9);
+
+    SetupPacket.RequestType = USB_HOST_TO_DEVICE | USB_REQ_TYPE_CLASS | USB_REQ_RECIPIENT_INTERFACE;
+    SetupPacket.Request = TouCAN_SET_FILTER_EXT_LIST_MASK;
+    SetupPacket.Value = 0;
+    SetupPacket.Index = 0;
+    SetupPacket.Length = 9;
+
+    // filter type
+    data[0] = (UInt8)type;
+    // list (acceptance code)
+    data[1] = (UInt8) ((list >> 24) & 0xFF);
+    data[2] = (UInt8) ((list >> 16) & 0xFF);
+    data[3] = (UInt8) ((list >> 8) & 0xFF);
+    data[4] = (UInt8)  (list & 0xFF);
+    // mask (acceptance mask)
+    data[5] = (UInt8) ((mask >> 24) & 0xFF);
+    data[6] = (UInt8) ((mask >> 16) & 0xFF);
+    data[7] = (UInt8) ((mask >> 8) & 0xFF);
+    data[8] = (UInt8)  (mask & 0xFF);
+
+    // TouCAN_SET_FILTER_EXT_LIST_MASK
+    retVal = CANUSB_DeviceRequest(handle, SetupPacket, (void *)data, 9, NULL);
+    if (retVal < 0)
+        return (int)retVal;
+
+    retVal = TouCAN_get_last_error_code(handle, &res);
+    if (retVal < 0)
+        return (int)retVal;
+
+    if (res != TouCAN_RETVAL_OK)
+        return (int)TOUCAN_ERROR_OFFSET - (int)res;
+
+    return (int)TOUCAN_ERROR_SUCCESS;
+}
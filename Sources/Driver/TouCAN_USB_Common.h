@@ -42,8 +42,52 @@
 #define TOUCAN_USB_RX_DATA_FRAME_CNT  (TOUCAN_USB_RX_DATA_PIPE_SIZE / TOUCAN_USB_RX_DATA_FRAME_SIZE)
 // TODO: end!
 
-#define TOUCAN_RCV_QUEUE_SIZE  65536
+#define TOUCAN_MSG_STD_FRAME  (UInt8)0x00  // CANAL_IDFLAG_STANDARD
+#define TOUCAN_MSG_XTD_FRAME  (UInt8)0x01  // CANAL_IDFLAG_EXTENDED
+#define TOUCAN_MSG_RTR_FRAME  (UInt8)0x02  // CANAL_IDFLAG_RTR
+#define TOUCAN_MSG_STS_FRAME  (UInt8)0x04  // CANAL_IDFLAG_STATUS
+
+#define TOUCAN_STS_OK         (UInt8)0x00  // CANAL_STATUSMSG_OK
+#define TOUCAN_STS_OVERRUN    (UInt8)0x01  // CANAL_STATUSMSG_OVERRUN
+#define TOUCAN_STS_BUSLIGHT   (UInt8)0x02  // CANAL_STATUSMSG_BUSLIGHT
+#define TOUCAN_STS_BUSHEAVY   (UInt8)0x03  // CANAL_STATUSMSG_BUSHEAVY
+#define TOUCAN_STS_BUSOFF     (UInt8)0x04  // CANAL_STATUSMSG_BUSOFF
+#define TOUCAN_STS_STUFF      (UInt8)0x20  // CANAL_STATUSMSG_STUFF
+#define TOUCAN_STS_FORM       (UInt8)0x21  // CANAL_STATUSMSG_FORM
+#define TOUCAN_STS_ACK        (UInt8)0x23  // CANAL_STATUSMSG_ACK
+#define TOUCAN_STS_BIT1       (UInt8)0x24  // CANAL_STATUSMSG_BIT1
+#define TOUCAN_STS_BIT0       (UInt8)0x25  // CANAL_STATUSMSG_BIT0
+#define TOUCAN_STS_CRC        (UInt8)0x27  // CANAL_STATUSMSG_CRC
+
+#define TOUCAN_RCV_QUEUE_SIZE  65536  /* default (can be overridden on initialization) */
+#define TOUCAN_RCV_QUEUE_MIN  16
+#define TOUCAN_RCV_QUEUE_MAX  1048576
+#define TOUCAN_RCV_VIEW_SIZE  64  /* max. number of borrowed CAN messages */
+#define TOUCAN_RCV_QUEUE_MODE  CANQUE_MODE_LOCKFREE  /* note: one reader per channel */
+#ifndef TOUCAN_RCV_PIPE_DEPTH
+#define TOUCAN_RCV_PIPE_DEPTH  4U  /* number of IN transfers submitted at once (1..CANUSB_MAX_PIPE_DEPTH) */
+#endif
+#ifndef TOUCAN_RCV_XFER_PACKETS
+#define TOUCAN_RCV_XFER_PACKETS  4U  /* max. number of USB packets per IN transfer */
+#endif
+#define TOUCAN_RCV_XFER_SIZE  (TOUCAN_RCV_XFER_PACKETS * TOUCAN_USB_RX_DATA_PIPE_SIZE)
+#define TOUCAN_RCV_XFER_FRAMES  (TOUCAN_RCV_XFER_PACKETS * TOUCAN_USB_RX_DATA_FRAME_CNT)
 #define TOUCAN_TRM_QUEUE_SIZE  256
+#define TOUCAN_TRM_QUEUE_MODE  CANQUE_MODE_MUTEX  /* note: several writers per channel */
+#define TOUCAN_TRM_THREAD_POLL  100U  /* [ms] the writer thread checks for termination */
+#define TOUCAN_TRM_XFER_PACKETS  4U  /* max. number of USB packets per OUT transfer */
+#define TOUCAN_TRM_XFER_FRAMES  (TOUCAN_TRM_XFER_PACKETS * TOUCAN_USB_TX_DATA_FRAME_CNT)
+#define TOUCAN_TRM_ECHO_TAG  14U  /* offset of the sequence tag in an encoded frame (not sent to the device) */
+#define TOUCAN_FILTER_LIST_SIZE  64U  /* max. number of identifiers in an acceptance filter list */
+#ifndef TOUCAN_STS_REFRESH_INTERVAL
+#define TOUCAN_STS_REFRESH_INTERVAL  1000U  /* [ms] min. time between two reads of the interface error code */
+#endif
+#ifndef TOUCAN_BUSLOAD_BUCKETS
+#define TOUCAN_BUSLOAD_BUCKETS  10U  /* number of time slots of the bus load window */
+#endif
+#ifndef TOUCAN_BUSLOAD_SLOT
+#define TOUCAN_BUSLOAD_SLOT  100U  /* [ms] duration of a time slot (window = buckets * slot) */
+#endif
 
 #define TOUCAN_MAX_NAME_LENGTH  256
 #define TOUCAN_MAX_STRING_LENGTH  80
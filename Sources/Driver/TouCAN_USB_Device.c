@@ -20,6 +20,7 @@
  *  along with MacCAN-TouCAN.  If not, see <https://www.gnu.org/licenses/>.
  */
 #include "TouCAN_USB_Device.h"
+#include "TouCAN_USB.h"
 #include "MacCAN_Debug.h"
 
 #include <stdio.h>
@@ -27,6 +28,12 @@
 #include <unistd.h>
 #include <assert.h>
 
+static void *TransmissionThread(void *arg);
+static CANUSB_Return_t DequeueByPriority(TouCAN_TransmitData_t *sendData, UInt8 *buffer, UInt32 maxElem, UInt32 *numElem);
+static void AccountBusLoad(TouCAN_Device_t *device, const UInt8 *frames, UInt32 count);
+static void RefreshErrorCode(TouCAN_Device_t *device);
+static void EchoFrames(TouCAN_Device_t *device, const UInt8 *frames, UInt32 count);
+
 static CANUSB_Return_t GetUsbConfiguration(CANUSB_Handle_t handle, TouCAN_Device_t *device) {
     CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
 //    uint8_t dir, type;
@@ -117,7 +124,7 @@ CANUSB_Return_t TouCAN_ProbeUsbDevice(CANUSB_Index_t channel, uint16_t *productI
     return retVal;
 }
 
-CANUSB_Return_t TouCAN_OpenUsbDevice(CANUSB_Index_t channel, TouCAN_Device_t *device) {
+CANUSB_Return_t TouCAN_OpenUsbDevice(CANUSB_Index_t channel, uint32_t queueSize, TouCAN_Device_t *device) {
     CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
     CANUSB_Handle_t handle = CANUSB_INVALID_HANDLE;
     CANUSB_Index_t index = channel;
@@ -127,6 +134,11 @@ CANUSB_Return_t TouCAN_OpenUsbDevice(CANUSB_Index_t channel, TouCAN_Device_t *de
         return CANUSB_ERROR_NULLPTR;
     if (device->configured)
         return CANUSB_ERROR_YETINIT;
+    /* note: a queue size of zero means the default size */
+    if (queueSize == 0U)
+        queueSize = TOUCAN_RCV_QUEUE_SIZE;
+    if ((queueSize < TOUCAN_RCV_QUEUE_MIN) || (TOUCAN_RCV_QUEUE_MAX < queueSize))
+        return CANUSB_ERROR_ILLPARA;
 
     /* open the USB device at index, if and only if the vendor ID matches */
     handle = CANUSB_OpenDevice(index, TOUCAN_VENDOR_ID, CANUSB_ANY_PRODUCT_ID);
@@ -141,13 +153,30 @@ CANUSB_Return_t TouCAN_OpenUsbDevice(CANUSB_Index_t channel, TouCAN_Device_t *de
         (void)CANUSB_CloseDevice(handle);
         return retVal;
     }
-    /* create a message queue for received CAN frames */
-    device->recvData.msgQueue = CANQUE_Create(TOUCAN_RCV_QUEUE_SIZE, sizeof(TouCAN_CanMessage_t));
+    /* create a message queue for received CAN frames (packed CAN 2.0 records) */
+    device->recvData.msgQueue = CANQUE_CreateEx(queueSize, sizeof(TouCAN_RcvSlot_t), TOUCAN_RCV_QUEUE_MODE);
     if (device->recvData.msgQueue == NULL) {
 //        MACCAN_DEBUG_ERROR("+++ %s CAN%u: message queue could not be created (NULL)\n", device->name, device->channelNo+1);
         (void)CANUSB_CloseDevice(handle);
         return retVal;;
     }
+    /* create a message queue for CAN frames to be sent (encoded USB frames) */
+    device->sendData.msgQueue = CANQUE_CreateEx(TOUCAN_TRM_QUEUE_SIZE, TOUCAN_USB_TX_DATA_FRAME_SIZE, TOUCAN_TRM_QUEUE_MODE);
+    if (device->sendData.msgQueue == NULL) {
+        (void)CANQUE_Destroy(device->recvData.msgQueue);
+        (void)CANUSB_CloseDevice(handle);
+        return CANUSB_ERROR_RESOURCE;
+    }
+    /* note: CAN frames are sent in FIFO order by default */
+    device->sendData.prioMode = false;
+    device->sendData.prioCount = 0U;
+    /* note: transmitted CAN frames are not echoed by default */
+    device->recvData.msgParam.txEcho = false;
+    device->recvData.echoHead = 0U;
+    device->recvData.echoCount = 0U;
+    (void)pthread_mutex_init(&device->recvData.echoMutex, NULL);
+    /* note: the time synchronization starts with the first received CAN frame */
+    TouCAN_ClockSyncInit(&device->recvData.msgParam.clockSync);
     /* create a pipe context for the selected CAN channel on the device */
 #if (0)
     uint8_t pipeRef = device->endpoints.bulkIn.pipeRef;
@@ -155,10 +184,12 @@ CANUSB_Return_t TouCAN_OpenUsbDevice(CANUSB_Index_t channel, TouCAN_Device_t *de
     device->recvPipe = CANUSB_CreatePipeAsync(device->handle, pipeRef, bufSize);
     // TODO: realize general MacCAN endpoint module
 #else
-    device->recvPipe = CANUSB_CreatePipeAsync(device->handle, TOUCAN_USB_RX_DATA_PIPE_REF, TOUCAN_USB_RX_DATA_PIPE_SIZE);
+    /* note: several reads are submitted at once, each of them can span several USB packets */
+    device->recvPipe = CANUSB_CreatePipeAsyncEx(device->handle, TOUCAN_USB_RX_DATA_PIPE_REF, TOUCAN_RCV_XFER_SIZE, TOUCAN_RCV_PIPE_DEPTH);
 #endif
     if (device->recvPipe == NULL) {
 //        MACCAN_DEBUG_ERROR("+++ %s CAN%u: asynchronous pipe context could not be created (NULL)\n", device->name, device->channelNo+1);
+        (void)CANQUE_Destroy(device->sendData.msgQueue);
         (void)CANQUE_Destroy(device->recvData.msgQueue);
         (void)CANUSB_CloseDevice(handle);
         return CANUSB_ERROR_RESOURCE;
@@ -175,6 +206,8 @@ CANUSB_Return_t TouCAN_CloseUsbDevice(TouCAN_Device_t *device) {
 //    if (!device->configured)
 //        return CANUSB_ERROR_NOTINIT;
 
+    /* stop the writer thread (if not already done) */
+    (void)TouCAN_AbortTransmission(device);
     /* abort asynchronous pipe */
     /*retVal =*/ CANUSB_AbortPipeAsync(device->recvPipe);
 //    if (retVal < 0)
@@ -191,9 +224,13 @@ CANUSB_Return_t TouCAN_CloseUsbDevice(TouCAN_Device_t *device) {
     /*retVal =*/ CANQUE_Destroy(device->recvData.msgQueue);
 //    if (retVal < 0)
 //        MACCAN_DEBUG_ERROR("+++ %s CAN%u: message queue could not be released (%i)\n", device->name, device->channelNo+1, retVal);
+    /*retVal =*/ CANQUE_Destroy(device->sendData.msgQueue);
+    (void)pthread_mutex_destroy(&device->recvData.echoMutex);
+    TouCAN_ClockSyncExit(&device->recvData.msgParam.clockSync);
     /* Live long and prosper! */
     device->handle = CANUSB_INVALID_HANDLE;
     device->recvData.msgQueue = NULL;
+    device->sendData.msgQueue = NULL;
     device->recvPipe = NULL;
     device->configured = false;
 
@@ -233,3 +270,279 @@ CANUSB_Return_t TouCAN_AbortReception(TouCAN_Device_t *device) {
 
     return retVal;
 }
+
+CANUSB_Return_t TouCAN_StartTransmission(TouCAN_Device_t *device, CANUSB_AsyncPipeCbk_t callback) {
+    CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
+
+    /* sanity check */
+    if (!device)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+    if (device->sendData.isRunning)
+        return CANUSB_SUCCESS;
+
+    /* start the writer thread (it drains the transmit queue)
+     * note: TX echoes are passed to the callback function (in the format of received frames) */
+    device->sendData.echoCallback = callback;
+    device->sendData.prioCount = 0U;
+    device->sendData.isBusy = false;
+    device->sendData.stsRequest = false;
+    device->sendData.stsErrorCode = 0U;
+    device->sendData.stsRefresh = 0U;
+    device->sendData.isRunning = true;
+    if (pthread_create(&device->sendData.thread, NULL, TransmissionThread, (void*)device) != 0) {
+        device->sendData.isRunning = false;
+        retVal = CANUSB_ERROR_RESOURCE;
+    } else
+        retVal = CANUSB_SUCCESS;
+//    if (retVal < 0)
+//        MACCAN_DEBUG_ERROR("+++ %s #%u: transmission loop could not be started (%i)\n", device->name, device->channelNo, retVal);
+
+    return retVal;
+}
+
+CANUSB_Return_t TouCAN_AbortTransmission(TouCAN_Device_t *device) {
+    /* sanity check */
+    if (!device)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+    if (!device->sendData.isRunning)
+        return CANUSB_SUCCESS;
+
+    /* stop the writer thread and discard pending frames */
+    device->sendData.isRunning = false;
+    (void)CANQUE_Signal(device->sendData.msgQueue);
+    (void)pthread_join(device->sendData.thread, NULL);
+    (void)CANQUE_Reset(device->sendData.msgQueue);
+    device->sendData.prioCount = 0U;
+    device->sendData.isBusy = false;
+
+    return CANUSB_SUCCESS;
+}
+
+static void *TransmissionThread(void *arg) {
+    TouCAN_Device_t *device = (TouCAN_Device_t *)arg;
+    UInt8 frames[TOUCAN_TRM_XFER_FRAMES * TOUCAN_USB_TX_DATA_FRAME_SIZE];
+    UInt8 buffer[TOUCAN_TRM_XFER_PACKETS * TOUCAN_USB_TX_DATA_PIPE_SIZE];
+    CANUSB_Return_t retVal;
+    UInt32 count = 0U;
+    UInt32 size = 0U;
+    UInt32 reset = 0U;
+
+    assert(device);
+
+    reset = device->sendData.resetCounter;
+    while (device->sendData.isRunning) {
+        /* discard pending frames when the transmit queue has been reset */
+        if (reset != device->sendData.resetCounter) {
+            reset = device->sendData.resetCounter;
+            device->sendData.prioCount = 0U;
+        }
+        /* refresh the interface error code, when requested (rate-limited) */
+        if (device->sendData.stsRequest)
+            RefreshErrorCode(device);
+        /* wait for the next encoded frame(s) (or a wake-up to terminate) */
+        if (!device->sendData.prioMode && !device->sendData.prioCount)
+            retVal = CANQUE_DequeueMany(device->sendData.msgQueue, (void*)frames, TOUCAN_TRM_XFER_FRAMES, &count, TOUCAN_TRM_THREAD_POLL);
+        else
+            retVal = DequeueByPriority(&device->sendData, frames, TOUCAN_TRM_XFER_FRAMES, &count);
+        if ((retVal != CANUSB_SUCCESS) || (count == 0U))
+            continue;
+        /* pack up to three frames into one USB packet (the rest of a full packet is padding)
+         * note: the packets are sent back-to-back in one transfer, it ends with the last frame */
+        bzero(buffer, sizeof(buffer));
+        for (UInt32 i = 0U; i < count; i++) {
+            size = ((i / TOUCAN_USB_TX_DATA_FRAME_CNT) * TOUCAN_USB_TX_DATA_PIPE_SIZE)
+                 + ((i % TOUCAN_USB_TX_DATA_FRAME_CNT) * TOUCAN_USB_TX_DATA_FRAME_SIZE);
+            /* note: the sequence tag is not sent (the rest of the frame is zero) */
+            memcpy(&buffer[size], &frames[i * TOUCAN_USB_TX_DATA_FRAME_SIZE], TOUCAN_TRM_ECHO_TAG);
+            size += TOUCAN_USB_TX_DATA_FRAME_SIZE;
+        }
+        /* write the transfer to the endpoint (w/o achknowledge) */
+        device->sendData.isBusy = true;
+        MACCAN_LOG_WRITE(buffer, size, ">");
+        retVal = CANUSB_WritePipe(device->handle, TOUCAN_USB_TX_DATA_PIPE_REF, buffer, size, 0U);
+        device->sendData.isBusy = false;
+        /* counting */
+        if (retVal == CANUSB_SUCCESS) {
+            device->sendData.msgCounter += (uint64_t)count;
+            device->sendData.xferCounter++;
+            AccountBusLoad(device, frames, count);
+        } else
+            device->sendData.errCounter++;
+        /* echo the transmitted frames (if requested) */
+        if ((retVal == CANUSB_SUCCESS) && device->recvData.msgParam.txEcho)
+            EchoFrames(device, frames, count);
+    }
+    return NULL;
+}
+
+static void RefreshErrorCode(TouCAN_Device_t *device) {
+    UInt64 now = TouCAN_ClockSyncHostTime();
+    UInt32 errorCode = 0U;
+
+    /* note: reading and clearing the error code are control transfers (each with a
+     *       request for the last error code), so they are made at most once in
+     *       the interval and only when the bus status has been asked for */
+    if ((now - device->sendData.stsRefresh) < ((UInt64)TOUCAN_STS_REFRESH_INTERVAL * 1000000U))
+        return;
+    device->sendData.stsRefresh = now;
+    device->sendData.stsRequest = false;
+    if (TouCAN_get_interface_error_code(device->handle, &errorCode) == CANUSB_SUCCESS)
+        device->sendData.stsErrorCode = errorCode;
+    (void)TouCAN_clear_interface_error_code(device->handle);
+    device->sendData.stsCounter++;
+}
+
+static void AccountBusLoad(TouCAN_Device_t *device, const UInt8 *frames, UInt32 count) {
+    UInt64 now = TouCAN_ClockSyncHostTime();
+
+    /* bit lengths of the transmitted frames (encoded: flags, identifier, DLC, payload) */
+    for (UInt32 i = 0U; i < count; i++) {
+        const UInt8 *frame = &frames[i * TOUCAN_USB_TX_DATA_FRAME_SIZE];
+        UInt32 id = ((UInt32)frame[1] << 24) | ((UInt32)frame[2] << 16) | ((UInt32)frame[3] << 8) | (UInt32)frame[4];
+        TouCAN_BusLoadAdd(&device->recvData.busLoad, TouCAN_FrameBits((frame[0] & TOUCAN_MSG_XTD_FRAME) ? true : false,
+                          (frame[0] & TOUCAN_MSG_RTR_FRAME) ? true : false, id, frame[5], &frame[6]), now);
+    }
+}
+
+/* the device does not report the completion of a transmission, so the echo is made
+ * when the OUT transfer has been completed. The echo records have the same format
+ * as the frames received from the device (w/o any additional flag), with the OUT-
+ * completion time as time-stamp: the system time when the OUT transfer was completed,
+ * mapped to the device clock by the inverse of the time synchronization. It is neither
+ * taken by the device nor the time of the transmission on the bus. The records are
+ * passed to the echo callback (not to the one of the read pipe), which marks them as
+ * TX echoes and takes the sequence tags in FIFO order.
+ */
+static void EchoFrames(TouCAN_Device_t *device, const UInt8 *frames, UInt32 count) {
+    TouCAN_ReceiveData_t *recvData = &device->recvData;
+    UInt8 buffer[TOUCAN_USB_RX_DATA_FRAME_CNT * TOUCAN_USB_RX_DATA_FRAME_SIZE];
+    UInt32 index = 0U;
+    UInt32 n = 0U;
+    UInt32 out_usec = 0U;
+
+    assert(device);
+    assert(frames);
+
+    if (!device->sendData.echoCallback)
+        return;
+    /* OUT-completion time: system time mapped to device time by the time synchronization */
+    out_usec = TouCAN_ClockSyncDeviceTime(&recvData->msgParam.clockSync, TouCAN_ClockSyncHostTime());
+    /* remember the sequence tags of the frames (drop the oldest ones on overflow) */
+    (void)pthread_mutex_lock(&recvData->echoMutex);
+    for (UInt32 i = 0U; i < count; i++) {
+        const UInt8 *tag = &frames[(i * TOUCAN_USB_TX_DATA_FRAME_SIZE) + TOUCAN_TRM_ECHO_TAG];
+        if (recvData->echoCount == TOUCAN_TRM_QUEUE_SIZE) {
+            recvData->echoHead = (recvData->echoHead + 1U) % TOUCAN_TRM_QUEUE_SIZE;
+            recvData->echoCount--;
+        }
+        recvData->echoTags[(recvData->echoHead + recvData->echoCount) % TOUCAN_TRM_QUEUE_SIZE] =
+            ((UInt32)tag[0] << 24) | ((UInt32)tag[1] << 16) | ((UInt32)tag[2] << 8) | (UInt32)tag[3];
+        recvData->echoCount++;
+    }
+    (void)pthread_mutex_unlock(&recvData->echoMutex);
+    /* pass the echo records to the callback function (at most one USB packet at once) */
+    for (UInt32 i = 0U; i < count; i++) {
+        memcpy(&buffer[index], &frames[i * TOUCAN_USB_TX_DATA_FRAME_SIZE], TOUCAN_TRM_ECHO_TAG);
+        buffer[index + TOUCAN_TRM_ECHO_TAG + 0U] = (UInt8)(out_usec >> 24);
+        buffer[index + TOUCAN_TRM_ECHO_TAG + 1U] = (UInt8)(out_usec >> 16);
+        buffer[index + TOUCAN_TRM_ECHO_TAG + 2U] = (UInt8)(out_usec >> 8);
+        buffer[index + TOUCAN_TRM_ECHO_TAG + 3U] = (UInt8)out_usec;
+        index += TOUCAN_USB_RX_DATA_FRAME_SIZE;
+        if ((++n == TOUCAN_USB_RX_DATA_FRAME_CNT) || ((i + 1U) == count)) {
+            device->sendData.echoCallback((void*)recvData, buffer, index);
+            index = 0U;
+            n = 0U;
+        }
+    }
+}
+
+/* arbitration field of an encoded frame as it goes out on the bus:
+ * - standard: ID[10:0], RTR, IDE=0
+ * - extended: ID[28:18], SRR=1, IDE=1, ID[17:0], RTR
+ * note: a lower value wins the arbitration
+ */
+static UInt32 ArbitrationKey(const UInt8 *frame) {
+    UInt32 id = ((UInt32)frame[1] << 24) | ((UInt32)frame[2] << 16)
+              | ((UInt32)frame[3] << 8)  |  (UInt32)frame[4];
+    UInt32 rtr = (frame[0] & TOUCAN_MSG_RTR_FRAME) ? 1U : 0U;
+
+    if (frame[0] & TOUCAN_MSG_XTD_FRAME)
+        return (((id >> 18) & 0x7FFU) << 21) | (1U << 20) | (1U << 19) | ((id & 0x3FFFFU) << 1) | rtr;
+    else
+        return ((id & 0x7FFU) << 21) | (rtr << 20);
+}
+
+static inline bool Precedes(const TouCAN_TrmSlot_t *a, const TouCAN_TrmSlot_t *b) {
+    /* note: same identifier in FIFO order (sequence no. with wrap-around) */
+    if (a->key != b->key)
+        return (a->key < b->key) ? true : false;
+    return ((SInt32)(a->seqNo - b->seqNo) < 0) ? true : false;
+}
+
+static void PushPending(TouCAN_TransmitData_t *sendData, const UInt8 *frame) {
+    TouCAN_TrmSlot_t *heap = sendData->prioHeap;
+    TouCAN_TrmSlot_t slot;
+    UInt32 i = sendData->prioCount++;
+
+    slot.key = ArbitrationKey(frame);
+    slot.seqNo = sendData->prioSeqNo++;
+    memcpy(slot.frame, frame, TOUCAN_USB_TX_DATA_FRAME_SIZE);
+    /* sift up */
+    while ((i > 0U) && Precedes(&slot, &heap[(i - 1U) / 2U])) {
+        heap[i] = heap[(i - 1U) / 2U];
+        i = (i - 1U) / 2U;
+    }
+    heap[i] = slot;
+}
+
+static void PopPending(TouCAN_TransmitData_t *sendData, UInt8 *frame) {
+    TouCAN_TrmSlot_t *heap = sendData->prioHeap;
+    TouCAN_TrmSlot_t last;
+    UInt32 n = --sendData->prioCount;
+    UInt32 i = 0U, child;
+
+    memcpy(frame, heap[0].frame, TOUCAN_USB_TX_DATA_FRAME_SIZE);
+    last = heap[n];
+    /* sift down */
+    while ((child = (2U * i) + 1U) < n) {
+        if (((child + 1U) < n) && Precedes(&heap[child + 1U], &heap[child]))
+            child++;
+        if (!Precedes(&heap[child], &last))
+            break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = last;
+}
+
+static CANUSB_Return_t DequeueByPriority(TouCAN_TransmitData_t *sendData, UInt8 *buffer, UInt32 maxElem, UInt32 *numElem) {
+    UInt8 frames[TOUCAN_TRM_XFER_FRAMES * TOUCAN_USB_TX_DATA_FRAME_SIZE];
+    UInt16 timeout = sendData->prioCount ? 0U : TOUCAN_TRM_THREAD_POLL;
+    UInt32 count = 0U;
+    UInt32 room = 0U;
+
+    assert(sendData);
+    assert(buffer);
+    assert(numElem);
+
+    /* move the frames from the transmit queue into the heap (as long as there is room)
+     * note: only wait for frames when there is nothing pending */
+    while (sendData->prioCount < TOUCAN_TRM_QUEUE_SIZE) {
+        room = TOUCAN_TRM_QUEUE_SIZE - sendData->prioCount;
+        room = (room < TOUCAN_TRM_XFER_FRAMES) ? room : TOUCAN_TRM_XFER_FRAMES;
+        if ((CANQUE_DequeueMany(sendData->msgQueue, (void*)frames, room, &count, timeout) != CANUSB_SUCCESS) || (count == 0U))
+            break;
+        for (UInt32 i = 0U; i < count; i++)
+            PushPending(sendData, &frames[i * TOUCAN_USB_TX_DATA_FRAME_SIZE]);
+        timeout = 0U;
+    }
+    /* take the frames with the highest priority, i.e. the lowest arbitration field */
+    for (count = 0U; (count < maxElem) && sendData->prioCount; count++)
+        PopPending(sendData, &buffer[count * TOUCAN_USB_TX_DATA_FRAME_SIZE]);
+    *numElem = count;
+    return count ? CANUSB_SUCCESS : CANUSB_ERROR_EMPTY;
+}
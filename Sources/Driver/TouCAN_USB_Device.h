@@ -23,10 +23,17 @@
 #define TOUCAN_USB_DEVICE_H_INCLUDED
 
 #include "TouCAN_USB_Common.h"
+#include "TouCAN_ClockSync.h"
+#include "TouCAN_RxFilter.h"
+#include "TouCAN_Snapshot.h"
+#include "TouCAN_IdStats.h"
+#include "TouCAN_BusLoad.h"
 
 #include "MacCAN_IOUsbKit.h"
 #include "MacCAN_MsgQueue.h"
 
+#include <pthread.h>
+
 typedef struct toucan_bitrate_t {       /* bit-rate settings: */
     uint16_t brp;                       /* - bit-rate prescaler */
     uint8_t tseg1;                      /* - TSEG1 segment */
@@ -40,8 +47,16 @@ typedef uint8_t TouCAN_OpMode_t;        /* operation mode (CAN API V1 compatible
 
 typedef uint8_t TouCAN_Status_t;        /* bus status (CAN API V1 compatible) */
 
+typedef struct acceptance_filter_t {    /* acceptance filter (11-bit or 29-bit identifier): */
+    uint8_t type;                       /* - accept all, reject all or by value (Filter_Type_TypeDef) */
+    uint32_t code;                      /* - acceptance code */
+    uint32_t mask;                      /* - acceptance mask (bits set are compared) */
+    uint32_t count;                     /* - number of identifiers in the list (0 = by code and mask) */
+    uint32_t list[TOUCAN_FILTER_LIST_SIZE]; /* - identifiers of the list (in ascending order) */
+} TouCAN_Filter_t;
+
 typedef struct receive_param_t {        /* additional reception data: */
-    uint64_t startTime;                 /* - time synchronization */
+    TouCAN_ClockSync_t clockSync;       /* - time synchronization */
     uint8_t busStatus;                  /* - bus status from devive */
     uint8_t rxErrors;                   /* - receive error counter */
     uint8_t txErrors;                   /* - transmit error counter */
@@ -49,23 +64,75 @@ typedef struct receive_param_t {        /* additional reception data: */
     bool suppressXtd;                   /* - suppress extended CAN frames */
     bool suppressRtr;                   /* - suppress remote CAN frames */
     bool suppressSts;                   /* - suppress error frames */
+    TouCAN_Filter_t filter11;           /* - acceptance filter for 11-bit identifiers */
+    TouCAN_Filter_t filter29;           /* - acceptance filter for 29-bit identifiers */
+    TouCAN_RxFilter_t rxFilter;         /* - filter rules (compiled) or NULL */
+    volatile bool txEcho;               /* - echo transmitted CAN frames */
 } TouCAN_MsgParam_t;
 
+#define TOUCAN_RCV_SLOT_XTD  0x01U       /* flag: extended format */
+#define TOUCAN_RCV_SLOT_RTR  0x02U       /* flag: remote frame */
+#define TOUCAN_RCV_SLOT_ECHO  0x04U      /* flag: TX echo */
+#define TOUCAN_RCV_SLOT_STS  0x80U       /* flag: status message */
+
+typedef struct receive_slot_t {         /* packed CAN 2.0 message (receive queue): */
+    uint32_t id;                        /* - CAN identifier */
+    uint8_t flags;                      /* - flags: XTD, RTR and STS */
+    uint8_t dlc;                        /* - data length code (0..8) */
+    uint8_t data[8];                    /* - payload (CAN 2.0) */
+    uint32_t tag;                       /* - sequence tag (TX echo only) */
+    uint64_t timestamp;                 /* - time-stamp (in [nsec]) */
+} TouCAN_RcvSlot_t;
+
+typedef void (*TouCAN_RxCallback_t)(void *context, const TouCAN_CanMessage_t *messages, uint32_t count);
+
 typedef struct receive_data_t {         /* USB read pipe context: */
-    CANQUE_MsgQueue_t msgQueue;         /* - message queue for received CAN frames */
+    CANQUE_MsgQueue_t msgQueue;         /* - message queue for received CAN frames (packed) */
+    TouCAN_CanMessage_t msgView[TOUCAN_RCV_VIEW_SIZE]; /* - borrowed CAN frames (expanded) */
     TouCAN_MsgParam_t msgParam;         /* - additional data on/for reception */
+    TouCAN_RxCallback_t rxCallback;     /* - callback for received CAN frames (NULL = message queue) */
+    void *rxContext;                    /* - context for the callback function */
+    TouCAN_Snapshot_t snapshot;         /* - latest CAN frame of each identifier (or NULL) */
+    TouCAN_IdStats_t idStats;           /* - traffic statistics of each identifier (or NULL) */
+    uint32_t tableReaders;              /* - number of readers of the tables above (and the filter rules) */
+    TouCAN_BusLoad_t busLoad;           /* - bus load (received and transmitted frames) */
     uint64_t msgCounter;                /* - number of received CAN frames */
     uint64_t stsCounter;                /* - number of received status frames */
+    uint64_t xferCounter;               /* - number of received USB transfers */
+    uint64_t fltCounter;                /* - number of CAN frames rejected by the filters */
 //    uint64_t errCounter;                /* - number of received error frames */
+    uint64_t echoCounter;               /* - number of received TX echoes */
+    pthread_mutex_t echoMutex;          /* - to serialize TX echoes and received frames */
+    uint32_t echoTags[TOUCAN_TRM_QUEUE_SIZE]; /* - sequence tags of pending TX echoes */
+    uint32_t echoHead;                  /* - index of the oldest pending TX echo */
+    uint32_t echoCount;                 /* - number of pending TX echoes */
 } TouCAN_ReceiveData_t;
 
+typedef struct transmit_slot_t {        /* pending CAN frame (priority mode): */
+    uint32_t key;                       /* - arbitration field (lower value wins) */
+    uint32_t seqNo;                     /* - sequence no. (FIFO order per identifier) */
+    uint8_t frame[TOUCAN_USB_TX_DATA_FRAME_SIZE]; /* - the encoded CAN frame */
+} TouCAN_TrmSlot_t;
+
 typedef struct transmit_context_t_ {    /* USB write pipe context: */
-#if (0)
-    CANQUE_MsgQueue_t msgQueue;         /* - message queue for CAN frames to be sent */
-    bool isBusy;                        /* - to indicate a transmission in progress */
-#endif
+    CANQUE_MsgQueue_t msgQueue;         /* - message queue for CAN frames to be sent (encoded) */
+    TouCAN_TrmSlot_t prioHeap[TOUCAN_TRM_QUEUE_SIZE]; /* - pending CAN frames ordered by identifier */
+    uint32_t prioCount;                 /* - number of pending CAN frames in the heap */
+    uint32_t prioSeqNo;                 /* - sequence no. of the next CAN frame in the heap */
+    volatile bool prioMode;             /* - to send pending CAN frames in identifier order */
+    volatile uint32_t resetCounter;     /* - to discard pending CAN frames (on stop) */
+    uint32_t tagCounter;                /* - sequence tag of the last CAN frame */
+    CANUSB_AsyncPipeCbk_t echoCallback; /* - callback function for TX echoes */
+    pthread_t thread;                   /* - writer thread (drains the message queue) */
+    volatile bool isRunning;            /* - to indicate that the writer thread is running */
+    volatile bool isBusy;               /* - to indicate a transmission in progress */
     uint64_t msgCounter;                /* - number of written CAN frames */
+    uint64_t xferCounter;               /* - number of USB transfers written */
     uint64_t errCounter;                /* - number of write pipe errors */
+    volatile bool stsRequest;           /* - to request a refresh of the interface error code */
+    volatile uint32_t stsErrorCode;     /* - interface error code (refreshed by the writer thread) */
+    uint64_t stsRefresh;                /* - time of the last refresh (in [nsec]) */
+    uint64_t stsCounter;                /* - number of refreshes (control transfers) */
 } TouCAN_TransmitData_t;
 
 typedef struct device_info_t {          /* device information: */
@@ -85,10 +152,11 @@ typedef struct toucan_device_t_ {       /* TouCAN device: */
     CANUSB_Handle_t handle;             /* - USB device hanlde */
     CANUSB_AsyncPipe_t recvPipe;        /* - USB receive pipe */
     TouCAN_ReceiveData_t recvData;      /* - CAN receive data (queue) */
-    TouCAN_TransmitData_t sendData;     /* - CAN transmit data (no queue) */
+    TouCAN_TransmitData_t sendData;     /* - CAN transmit data (queue) */
     TouCAN_OpMode_t opCapa;             /* - CAN operation mode capability */
     TouCAN_OpMode_t opMode;             /* - CAN operation mode (demanded) */
     TouCAN_Bitrate_t bitRate;           /* - CAN bit-rate settings (demanded) */
+    bool deviceFilter;                  /* - acceptance filters are applied by the device */
     TouCAN_CanClock_t canClock;         /* - CAN clock (in [Hz]) = CPU frequency */
     TouCAN_DeviceInfo_t deviceInfo;     /* - device information (hw, sw, etc.) */
     char name[TOUCAN_MAX_NAME_LENGTH+1];     /* - device name (zero-terminated string) */
@@ -102,12 +170,15 @@ extern "C" {
 #endif
 
 extern CANUSB_Return_t TouCAN_ProbeUsbDevice(CANUSB_Index_t channel, uint16_t *productId);
-extern CANUSB_Return_t TouCAN_OpenUsbDevice(CANUSB_Index_t channel, TouCAN_Device_t *device);
+extern CANUSB_Return_t TouCAN_OpenUsbDevice(CANUSB_Index_t channel, uint32_t queueSize, TouCAN_Device_t *device);
 extern CANUSB_Return_t TouCAN_CloseUsbDevice(TouCAN_Device_t *device);
 
 extern CANUSB_Return_t TouCAN_StartReception(TouCAN_Device_t *device, CANUSB_AsyncPipeCbk_t callback);
 extern CANUSB_Return_t TouCAN_AbortReception(TouCAN_Device_t *device);
 
+extern CANUSB_Return_t TouCAN_StartTransmission(TouCAN_Device_t *device, CANUSB_AsyncPipeCbk_t callback);
+extern CANUSB_Return_t TouCAN_AbortTransmission(TouCAN_Device_t *device);
+
 #ifdef __cplusplus
 }
 #endif
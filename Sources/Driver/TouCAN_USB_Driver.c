@@ -26,6 +26,7 @@
 #include <string.h>
 #include <unistd.h>
 #include <time.h>
+#include <sched.h>
 #include <sys/time.h>
 #include <sys/select.h>
 #include <assert.h>
@@ -33,27 +34,25 @@
 #include "MacCAN_Debug.h"
 #include <inttypes.h>
 
-#define TOUCAN_MSG_STD_FRAME  (UInt8)0x00  // CANAL_IDFLAG_STANDARD
-#define TOUCAN_MSG_XTD_FRAME  (UInt8)0x01  // CANAL_IDFLAG_EXTENDED
-#define TOUCAN_MSG_RTR_FRAME  (UInt8)0x02  // CANAL_IDFLAG_RTR
-#define TOUCAN_MSG_STS_FRAME  (UInt8)0x04  // CANAL_IDFLAG_STATUS
-
-#define TOUCAN_STS_OK         (UInt8)0x00  // CANAL_STATUSMSG_OK
-#define TOUCAN_STS_OVERRUN    (UInt8)0x01  // CANAL_STATUSMSG_OVERRUN
-#define TOUCAN_STS_BUSLIGHT   (UInt8)0x02  // CANAL_STATUSMSG_BUSLIGHT
-#define TOUCAN_STS_BUSHEAVY   (UInt8)0x03  // CANAL_STATUSMSG_BUSHEAVY
-#define TOUCAN_STS_BUSOFF     (UInt8)0x04  // CANAL_STATUSMSG_BUSOFF
-#define TOUCAN_STS_STUFF      (UInt8)0x20  // CANAL_STATUSMSG_STUFF
-#define TOUCAN_STS_FORM       (UInt8)0x21  // CANAL_STATUSMSG_FORM
-#define TOUCAN_STS_ACK        (UInt8)0x23  // CANAL_STATUSMSG_ACK
-#define TOUCAN_STS_BIT1       (UInt8)0x24  // CANAL_STATUSMSG_BIT1
-#define TOUCAN_STS_BIT0       (UInt8)0x25  // CANAL_STATUSMSG_BIT0
-#define TOUCAN_STS_CRC        (UInt8)0x27  // CANAL_STATUSMSG_CRC
-
 static void ReceptionCallback(void *refCon, UInt8 *buffer, UInt32 length);
-static int TouCAN_EncodeMessage(UInt8 *buffer, const TouCAN_CanMessage_t *message);
-static int TouCAN_DecodeMessage(TouCAN_CanMessage_t *message, const UInt8 *buffer, TouCAN_MsgParam_t *param);
+static void EchoCallback(void *refCon, UInt8 *buffer, UInt32 length);
+static void ReceiveFrames(TouCAN_ReceiveData_t *context, UInt8 *buffer, UInt32 length, bool txEcho);
+static void WaitForTableReaders(TouCAN_ReceiveData_t *context);
+static void DeliverMessages(TouCAN_ReceiveData_t *context, TouCAN_CanMessage_t *messages, const UInt32 *tags, UInt32 count);
+static void EnqueueMessages(TouCAN_ReceiveData_t *context, const TouCAN_CanMessage_t *messages, const UInt32 *tags, UInt32 count);
+static void PackMessage(TouCAN_RcvSlot_t *slot, const TouCAN_CanMessage_t *message, UInt32 tag);
+static void ExpandMessage(TouCAN_CanMessage_t *message, const TouCAN_RcvSlot_t *slot);
+static uint16_t RemainingTime(UInt64 start, uint16_t timeout);
+static uint32_t RemainingTimeUs(UInt64 start, uint32_t timeout);
+static bool IsRefused(const TouCAN_Device_t *device, const TouCAN_CanMessage_t *message);
+static UInt32 NextSequenceTag(TouCAN_Device_t *device);
+static int TouCAN_EncodeMessage(UInt8 *buffer, const TouCAN_CanMessage_t *message, UInt32 tag);
+static int TouCAN_DecodeMessage(TouCAN_CanMessage_t *message, const UInt8 *buffer, TouCAN_MsgParam_t *param, bool txEcho);
 static int TouCAN_ResetDevice(CANUSB_Handle_t handle);
+static bool ProgramFilters(TouCAN_Device_t *device);
+static void ResetFilter(TouCAN_Filter_t *filter);
+static bool IsAccepted(const TouCAN_MsgParam_t *param, const TouCAN_CanMessage_t *message);
+static UInt32 NominalBitrate(TouCAN_CanClock_t canClock, const TouCAN_Bitrate_t *bitrate);
 
 void TouCAN_USB_GetOperationCapability(TouCAN_OpMode_t *capability) {
     if (capability) {
@@ -121,6 +120,12 @@ CANUSB_Return_t TouCAN_USB_InitializeChannel(TouCAN_Device_t *device, TouCAN_OpM
         MACCAN_DEBUG_ERROR("+++ %s (device #%u): reception loop could not be started (%i)\n", device->name, device->handle, retVal);
         goto end_init;
     }
+    /* start the transmission loop */
+    retVal = TouCAN_StartTransmission(device, EchoCallback);
+    if (retVal < 0) {
+        MACCAN_DEBUG_ERROR("+++ %s (device #%u): transmission loop could not be started (%i)\n", device->name, device->handle, retVal);
+        goto err_init;
+    }
     /* get device information (don't care about the result) */
     retVal = TouCAN_get_hardware_version(device->handle, &device->deviceInfo.hardware);
     if (retVal < 0) {
@@ -158,11 +163,22 @@ CANUSB_Return_t TouCAN_USB_InitializeChannel(TouCAN_Device_t *device, TouCAN_OpM
     device->recvData.msgParam.suppressXtd = (mode & CANMODE_NXTD) ? true : false;
     device->recvData.msgParam.suppressRtr = (mode & CANMODE_NRTR) ? true : false;
     device->recvData.msgParam.suppressSts = (mode & CANMODE_ERR) ? false : true;
+    /* note: all CAN frames are accepted by default */
+    ResetFilter(&device->recvData.msgParam.filter11);
+    ResetFilter(&device->recvData.msgParam.filter29);
+    device->recvData.msgParam.rxFilter = NULL;
+    device->recvData.rxCallback = NULL;
+    device->recvData.rxContext = NULL;
+    device->recvData.snapshot = NULL;
+    device->recvData.idStats = NULL;
+    TouCAN_BusLoadInit(&device->recvData.busLoad, 0U, 0U);
+    device->deviceFilter = false;
     device->opMode = mode;
     retVal = CANUSB_SUCCESS;
 end_init:
     return retVal;
 err_init:
+    (void)TouCAN_AbortTransmission(device);
     (void)TouCAN_AbortReception(device);
     return retVal;
 }
@@ -184,22 +200,42 @@ CANUSB_Return_t TouCAN_USB_TeardownChannel(TouCAN_Device_t *device) {
         //goto end_exit;
     }
 //end_exit:
+    /* stop the transmission loop (pending frames are discarded) */
+    (void)TouCAN_AbortTransmission(device);
     /* stop the reception loop */
     retVal = TouCAN_AbortReception(device);
     if (retVal < 0) {
         MACCAN_DEBUG_ERROR("+++ %s (device #%u): reception loop could not be aborted (%i)\n", device->name, device->handle, retVal);
         return retVal;
     }
+    /* release the filter rules (the reception loop is stopped) */
+    TouCAN_ReleaseRxFilter(device->recvData.msgParam.rxFilter);
+    device->recvData.msgParam.rxFilter = NULL;
+    /* release the snapshot table (note: there must be no reader anymore) */
+    TouCAN_DestroySnapshot(device->recvData.snapshot);
+    device->recvData.snapshot = NULL;
+    TouCAN_DestroyIdStats(device->recvData.idStats);
+    device->recvData.idStats = NULL;
     /* now we are off :( */
     MACCAN_DEBUG_DRIVER("Statistical data:\n");
     MACCAN_DEBUG_DRIVER("%8"PRIu64" CAN frame(s) written to endpoint\n", device->sendData.msgCounter);
     MACCAN_DEBUG_DRIVER("%8"PRIu64" error(s) while writing to endpoint\n", device->sendData.errCounter);
+    MACCAN_DEBUG_DRIVER("%8"PRIu64" interface error code(s) read from device\n", device->sendData.stsCounter);
+    MACCAN_DEBUG_DRIVER("%8"PRIu64" USB transfer(s) written to endpoint\n", device->sendData.xferCounter);
+    MACCAN_DEBUG_DRIVER("%10.1f%% highest level of the transmit queue\n", ((float)CANQUE_QueueHigh(device->sendData.msgQueue) * 100.0) \
+                                                                        /  (float)CANQUE_QueueSize(device->sendData.msgQueue));
     MACCAN_DEBUG_DRIVER("%8"PRIu64" CAN frame(s) received and enqueued\n", device->recvData.msgCounter);
     MACCAN_DEBUG_DRIVER("%8"PRIu64" status frame(s) received and enqueued\n", device->recvData.stsCounter);
+    MACCAN_DEBUG_DRIVER("%8"PRIu64" CAN frame(s) rejected by the filters\n", device->recvData.fltCounter);
     //MACCAN_DEBUG_DRIVER("%8"PRIu64" error frame(s) received  and enqueued\n", device->recvData.errCounter);
     MACCAN_DEBUG_DRIVER("%10.1f%% highest level of the receive queue\n", ((float)CANQUE_QueueHigh(device->recvData.msgQueue) * 100.0) \
                                                                        /  (float)CANQUE_QueueSize(device->recvData.msgQueue));
     MACCAN_DEBUG_DRIVER("%8"PRIu64" overrun event(s) of the receive queue\n", CANQUE_OverflowCounter(device->recvData.msgQueue));
+    MACCAN_DEBUG_DRIVER("%8"PRIu64" USB transfer(s) received from endpoint\n", device->recvData.xferCounter);
+    MACCAN_DEBUG_DRIVER("%8"PRIu64" wake-up(s) of the reader\n", CANQUE_WakeupCounter(device->recvData.msgQueue));
+    MACCAN_DEBUG_DRIVER("%10.1f frame(s) per wake-up\n", CANQUE_WakeupCounter(device->recvData.msgQueue) ? \
+                                                       ((float)(device->recvData.msgCounter + device->recvData.stsCounter) \
+                                                     /  (float)CANQUE_WakeupCounter(device->recvData.msgQueue)) : 0.0);
     return retVal;
 }
 
@@ -215,7 +251,14 @@ CANUSB_Return_t TouCAN_USB_SetBitrate(TouCAN_Device_t *device, const TouCAN_Bitr
 
     /* set mode flags depending on the operation mode */
     modeFlags |= (device->opMode & CANMODE_MON) ? TouCAN_ENABLE_SILENT_MODE : 0x00000000U;
-    modeFlags |= (device->opMode & CANMODE_ERR) ? TouCAN_ENABLE_STATUS_MESSAGES : 0x00000000U;
+    /* note: status frames are always enabled, the bus status is taken from them
+     *       (they are suppressed by the reception callback w/o mode ERR) */
+    modeFlags |= TouCAN_ENABLE_STATUS_MESSAGES;
+    /* note: flag TX_FIFO_PRIORITY (bxCAN TXFP) sends the transmit mailboxes in chronological order,
+     *       without it the device sends them by CAN identifier. So the FIFO order of the host is
+     *       kept by setting it, whereas in priority order the device may arbitrate by identifier
+     *       as the host does (the host has sorted the frames already) */
+    modeFlags |= (!device->sendData.prioMode) ? TouCAN_ENABLE_TX_FIFO_PRIORITY : 0x00000000U;
 
     /* reset device state and pending errors */
     retVal = TouCAN_ResetDevice(device->handle);
@@ -234,9 +277,14 @@ CANUSB_Return_t TouCAN_USB_SetBitrate(TouCAN_Device_t *device, const TouCAN_Bitr
         MACCAN_DEBUG_ERROR("+++ %s (device #%u): device could not be re-initialized (%i)\n", device->name, device->handle, retVal);
         goto end_set;
     }
+    /* program the acceptance filters into the device (if any) */
+    /* note: the reception callback filters anyway, e.g. when the firmware refuses it */
+    device->deviceFilter = ProgramFilters(device);
     /* store demanded CAN bit-rate settings */
     /* note: they cannot be read from device */
     memcpy(&device->bitRate, bitrate, sizeof(TouCAN_Bitrate_t));
+    /* restart the bus load measurement with the nominal bit-rate */
+    TouCAN_BusLoadInit(&device->recvData.busLoad, NominalBitrate(device->canClock, bitrate), TouCAN_ClockSyncHostTime());
 end_set:
     return retVal;
 }
@@ -252,6 +300,8 @@ CANUSB_Return_t TouCAN_USB_StartCan(TouCAN_Device_t *device) {
 
     /* enter LISTENING state */
     retVal = TouCAN_start(device->handle);
+    /* note: the errors collected before the start are not reported */
+    device->sendData.stsErrorCode = 0U;
 
     return retVal;
 }
@@ -267,14 +317,23 @@ CANUSB_Return_t TouCAN_USB_StopCan(TouCAN_Device_t *device) {
 
     /* enter READY state again */
     retVal = TouCAN_stop(device->handle);
+    /* discard CAN frames not yet sent */
+    (void)CANQUE_Reset(device->sendData.msgQueue);
+    device->sendData.resetCounter++;
 
     return retVal;
 }
 
 CANUSB_Return_t TouCAN_USB_WriteMessage(TouCAN_Device_t *device, const TouCAN_CanMessage_t *message, uint16_t timeout) {
+    /* send the CAN message w/o returning its sequence tag */
+    return TouCAN_USB_WriteMessageTagged(device, message, timeout, NULL);
+}
+
+CANUSB_Return_t TouCAN_USB_WriteMessageTagged(TouCAN_Device_t *device, const TouCAN_CanMessage_t *message, uint16_t timeout, uint32_t *tag) {
     CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
-    UInt8 buffer[TOUCAN_USB_TX_DATA_PIPE_SIZE];
-    bzero(buffer, TOUCAN_USB_TX_DATA_PIPE_SIZE);
+    UInt8 buffer[TOUCAN_USB_TX_DATA_FRAME_SIZE];
+    UInt32 seqNo = 0U;
+    bzero(buffer, TOUCAN_USB_TX_DATA_FRAME_SIZE);
 
     /* sanity check */
     if (!device || !message)
@@ -283,26 +342,51 @@ CANUSB_Return_t TouCAN_USB_WriteMessage(TouCAN_Device_t *device, const TouCAN_Ca
         return CANUSB_ERROR_NOTINIT;
 
     /* refuse certain CAN messages depending on the operation mode */
-    if (message->xtd && (device->opMode & CANMODE_NXTD))
-        return CANUSB_ERROR_ILLPARA;
-    if (message->rtr && (device->opMode & CANMODE_NRTR))
-        return CANUSB_ERROR_ILLPARA;
-    if (message->sts)  /* note: error frames cannot be sent */
+    if (IsRefused(device, message))
         return CANUSB_ERROR_ILLPARA;
 
-    /* encode and send the message (w/o achknowledge) */
-    int size = TouCAN_EncodeMessage(buffer, message);
-    MACCAN_LOG_WRITE(buffer, (UInt32)size, ">");
-    retVal = CANUSB_WritePipe(device->handle, TOUCAN_USB_TX_DATA_PIPE_REF, buffer, (UInt32)size, 0U);  // FIXME: time-out
+    /* encode the message and put it into the transmit queue */
+    /* note: the writer thread sends it to the endpoint (w/o achknowledge) */
+    seqNo = NextSequenceTag(device);
+    (void)TouCAN_EncodeMessage(buffer, message, seqNo);
+    /* note: when the transmit queue is full, the caller waits for room up to the time-out */
+    retVal = CANQUE_EnqueueWait(device->sendData.msgQueue, (void*)buffer, timeout);
+    if ((retVal == CANUSB_SUCCESS) && tag)
+        *tag = (uint32_t)seqNo;
+    return retVal;
+}
 
-    // TODO: implement a transmit queue to speed up sending
-    (void) timeout;
+CANUSB_Return_t TouCAN_USB_WriteMessages(TouCAN_Device_t *device, const TouCAN_CanMessage_t *messages, uint32_t count, uint32_t *written, uint16_t timeout) {
+    CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
+    UInt8 buffer[TOUCAN_TRM_XFER_FRAMES * TOUCAN_USB_TX_DATA_FRAME_SIZE];
+    UInt32 chunk = 0U;
+    UInt32 n = 0U;
 
-    /* counting */
-    if (retVal == CANUSB_SUCCESS)
-        device->sendData.msgCounter++;
-    else
-        device->sendData.errCounter++;
+    if (written)
+        *written = 0U;
+    /* sanity check */
+    if (!device || !messages)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* refuse the whole batch if one of the CAN messages is refused */
+    for (uint32_t i = 0U; i < count; i++) {
+        if (IsRefused(device, &messages[i]))
+            return CANUSB_ERROR_ILLPARA;
+    }
+    /* encode the messages chunk by chunk and put them into the transmit queue */
+    /* note: the writer thread packs up to three frames into one USB packet */
+    retVal = CANUSB_SUCCESS;
+    for (uint32_t i = 0U; (i < count) && (retVal == CANUSB_SUCCESS); i += n) {
+        chunk = ((count - i) < TOUCAN_TRM_XFER_FRAMES) ? (count - i) : TOUCAN_TRM_XFER_FRAMES;
+        for (UInt32 j = 0U; j < chunk; j++)
+            (void)TouCAN_EncodeMessage(&buffer[j * TOUCAN_USB_TX_DATA_FRAME_SIZE], &messages[i + j], NextSequenceTag(device));
+        /* note: when the transmit queue is full, the caller waits for room up to the time-out */
+        retVal = CANQUE_EnqueueManyWait(device->sendData.msgQueue, (void*)buffer, chunk, &n, timeout);
+        if (written)
+            *written += (uint32_t)n;
+    }
     return retVal;
 }
 
@@ -315,14 +399,151 @@ CANUSB_Return_t TouCAN_USB_ReadMessage(TouCAN_Device_t *device, TouCAN_CanMessag
     if (!device->configured)
         return CANUSB_ERROR_NOTINIT;
 
-    /* read one CAN message from message queue, if any */
-    retVal = CANQUE_Dequeue(device->recvData.msgQueue, (void*)message, timeout);
+    /* read one CAN message from message queue, if any (w/o TX echoes) */
+    TouCAN_RcvSlot_t slot;
+    UInt64 start = device->recvData.msgParam.txEcho ? TouCAN_ClockSyncHostTime() : 0U;
+    do {
+        retVal = CANQUE_Dequeue(device->recvData.msgQueue, (void*)&slot, RemainingTime(start, timeout));
+    } while ((retVal == CANUSB_SUCCESS) && (slot.flags & TOUCAN_RCV_SLOT_ECHO));
+    if (retVal == CANUSB_SUCCESS)
+        ExpandMessage(message, &slot);
 
     return retVal;
 }
 
-CANUSB_Return_t TouCAN_USB_GetBusStatus(TouCAN_Device_t *device, TouCAN_Status_t *status) {
+CANUSB_Return_t TouCAN_USB_ReadMessageTagged(TouCAN_Device_t *device, TouCAN_CanMessage_t *message, uint32_t *tag, uint16_t timeout) {
+    CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
+
+    /* sanity check */
+    if (!device || !message || !tag)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* read one CAN message from message queue, if any (with the sequence tag of a TX echo) */
+    TouCAN_RcvSlot_t slot;
+    retVal = CANQUE_Dequeue(device->recvData.msgQueue, (void*)&slot, timeout);
+    if (retVal == CANUSB_SUCCESS) {
+        ExpandMessage(message, &slot);
+        *tag = (slot.flags & TOUCAN_RCV_SLOT_ECHO) ? (uint32_t)slot.tag : 0U;
+    }
+    return retVal;
+}
+
+CANUSB_Return_t TouCAN_USB_ReadMessageUs(TouCAN_Device_t *device, TouCAN_CanMessage_t *message, uint32_t timeout) {
+    CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
+
+    /* sanity check */
+    if (!device || !message)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* read one CAN message from message queue, if any (time-out in [usec], w/o TX echoes) */
+    TouCAN_RcvSlot_t slot;
+    UInt64 start = device->recvData.msgParam.txEcho ? TouCAN_ClockSyncHostTime() : 0U;
+    do {
+        retVal = CANQUE_DequeueUs(device->recvData.msgQueue, (void*)&slot, (UInt32)RemainingTimeUs(start, timeout));
+    } while ((retVal == CANUSB_SUCCESS) && (slot.flags & TOUCAN_RCV_SLOT_ECHO));
+    if (retVal == CANUSB_SUCCESS)
+        ExpandMessage(message, &slot);
+
+    return retVal;
+}
+
+CANUSB_Return_t TouCAN_USB_ReadMessages(TouCAN_Device_t *device, TouCAN_CanMessage_t *messages, uint32_t max, uint32_t *count, uint16_t timeout) {
+    CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
+
+    /* sanity check */
+    if (!device || !messages)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* read up to 'max' CAN messages from message queue, if any (w/o TX echoes) */
+    TouCAN_RcvSlot_t slot;
+    UInt64 start = device->recvData.msgParam.txEcho ? TouCAN_ClockSyncHostTime() : 0U;
+    assert(sizeof(TouCAN_RcvSlot_t) <= sizeof(TouCAN_CanMessage_t));
+    do {
+        retVal = CANQUE_DequeueMany(device->recvData.msgQueue, (void*)messages, (UInt32)max, (UInt32*)count, RemainingTime(start, timeout));
+        if (retVal != CANUSB_SUCCESS)
+            break;
+        /* note: the TX echoes are removed from the packed records first (moving them forward) */
+        uint32_t n = 0U;
+        for (uint32_t i = 0U; i < *count; i++) {
+            memcpy(&slot, (UInt8*)messages + (i * sizeof(TouCAN_RcvSlot_t)), sizeof(TouCAN_RcvSlot_t));
+            if (slot.flags & TOUCAN_RCV_SLOT_ECHO)
+                continue;
+            if (n != i)
+                memcpy((UInt8*)messages + (n * sizeof(TouCAN_RcvSlot_t)), &slot, sizeof(TouCAN_RcvSlot_t));
+            n++;
+        }
+        *count = n;
+    } while (*count == 0U);
+    if (retVal == CANUSB_SUCCESS) {
+        /* note: the packed records are expanded in place, starting with the last one,
+         *       so that no record is overwritten before it has been expanded */
+        for (uint32_t i = *count; i > 0U; i--) {
+            memcpy(&slot, (UInt8*)messages + ((i - 1U) * sizeof(TouCAN_RcvSlot_t)), sizeof(TouCAN_RcvSlot_t));
+            ExpandMessage(&messages[i - 1U], &slot);
+        }
+    }
+    return retVal;
+}
+
+CANUSB_Return_t TouCAN_USB_PeekMessages(TouCAN_Device_t *device, const TouCAN_CanMessage_t **messages, uint32_t *count, uint16_t timeout) {
+    CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
+
+    /* sanity check */
+    if (!device || !messages || !count)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* borrow the received CAN messages in the message queue, if any */
+    /* note: the packed records are expanded into the view buffer of the device */
+    const TouCAN_RcvSlot_t *slots = NULL;
+    UInt64 start = device->recvData.msgParam.txEcho ? TouCAN_ClockSyncHostTime() : 0U;
+    UInt32 n = 0U, e = 0U;
+    do {
+        retVal = CANQUE_Peek(device->recvData.msgQueue, (const void**)&slots, &n, RemainingTime(start, timeout));
+        if (retVal != CANUSB_SUCCESS)
+            break;
+        /* note: leading TX echoes are released at once (they are dropped) */
+        for (e = 0U; (e < n) && (slots[e].flags & TOUCAN_RCV_SLOT_ECHO); e++) { }
+        if (e != 0U)
+            (void)CANQUE_Commit(device->recvData.msgQueue, e);
+    } while (e != 0U);
+    if (retVal == CANUSB_SUCCESS) {
+        /* note: the view ends before the next TX echo (so that the count can be committed) */
+        for (e = 0U; (e < n) && !(slots[e].flags & TOUCAN_RCV_SLOT_ECHO); e++) { }
+        n = e;
+        if (n > TOUCAN_RCV_VIEW_SIZE)
+            n = TOUCAN_RCV_VIEW_SIZE;
+        for (UInt32 i = 0U; i < n; i++)
+            ExpandMessage(&device->recvData.msgView[i], &slots[i]);
+        *messages = device->recvData.msgView;
+    }
+    *count = (uint32_t)n;
+    return retVal;
+}
+
+CANUSB_Return_t TouCAN_USB_CommitMessages(TouCAN_Device_t *device, uint32_t count) {
     CANUSB_Return_t retVal = CANUSB_ERROR_FATAL;
+
+    /* sanity check */
+    if (!device)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* release 'count' borrowed CAN messages to the message queue */
+    retVal = CANQUE_Commit(device->recvData.msgQueue, (UInt32)count);
+
+    return retVal;
+}
+
+CANUSB_Return_t TouCAN_USB_GetBusStatus(TouCAN_Device_t *device, TouCAN_Status_t *status) {
     TouCAN_Status_t tmpStatus = 0x00U;
     UInt32 errorCode;
 
@@ -333,38 +554,213 @@ CANUSB_Return_t TouCAN_USB_GetBusStatus(TouCAN_Device_t *device, TouCAN_Status_t
         return CANUSB_ERROR_NOTINIT;
 
     /* get status from received status frames */
-    tmpStatus = device->recvData.msgParam.statusByte;
-    
-    /* get (and clear) interface error code */
-    retVal = TouCAN_get_interface_error_code(device->handle, &errorCode);
-    if (retVal == CANUSB_SUCCESS) {
-        // FIXME: error code is always 0 even when there are errors on the bus
-#if (0)
-        tmpStatus |= (errorCode & (HAL_CAN_ERROR_EWG |
-                                   HAL_CAN_ERROR_EPV)) ? CANSTAT_EWRN : 0;
-        tmpStatus |= (errorCode & (HAL_CAN_ERROR_BOF)) ? CANSTAT_BOFF : 0;
-        tmpStatus |= (errorCode & (HAL_CAN_ERROR_STF |
-                                   HAL_CAN_ERROR_FOR |
-                                   HAL_CAN_ERROR_ACK |
-                                   HAL_CAN_ERROR_BR  |
-                                   HAL_CAN_ERROR_BD  |
-                                   HAL_CAN_ERROR_CRC)) ? CANSTAT_BERR : 0;
-        tmpStatus |= (errorCode & (HAL_CAN_ERROR_RX_FOV0 |
-                                   HAL_CAN_ERROR_RX_FOV1)) ? CANSTAT_MSG_LST : 0;
-        tmpStatus |= (errorCode & (HAL_CAN_ERROR_TX_ALST0 |
-                                   HAL_CAN_ERROR_TX_TERR0 |
-                                   HAL_CAN_ERROR_TX_ALST1 |
-                                   HAL_CAN_ERROR_TX_TERR1 |
-                                   HAL_CAN_ERROR_TX_ALST2 |
-                                   HAL_CAN_ERROR_TX_TERR2)) ? CANSTAT_TX_BUSY :0;
-#endif
-    }
-    (void)TouCAN_clear_interface_error_code(device->handle);
-    
+    /* note: the device sends them in any operation mode, they are suppressed w/o mode ERR */
+    tmpStatus = __atomic_load_n(&device->recvData.msgParam.statusByte, __ATOMIC_RELAXED);
+
+    /* get interface error code (refreshed by the writer thread, w/o waiting for it) */
+    errorCode = device->sendData.stsErrorCode;
+    device->sendData.stsRequest = true;
+    /* note: the error code collects the errors since its last refresh (up to one interval ago),
+     *       so only the error events are taken from it, whereas the bus state (warning level
+     *       and bus-off) is taken from the status frames, which report its changes at once */
+    // FIXME: error code is always 0 even when there are errors on the bus (firmware)
+    tmpStatus |= (errorCode & (HAL_CAN_ERROR_STF |
+                               HAL_CAN_ERROR_FOR |
+                               HAL_CAN_ERROR_ACK |
+                               HAL_CAN_ERROR_BR  |
+                               HAL_CAN_ERROR_BD  |
+                               HAL_CAN_ERROR_CRC)) ? CANSTAT_BERR : 0;
+    tmpStatus |= (errorCode & (HAL_CAN_ERROR_RX_FOV0 |
+                               HAL_CAN_ERROR_RX_FOV1)) ? CANSTAT_MSG_LST : 0;
     /* return updated status register */
     if (status)
         *status = tmpStatus;
-    return retVal;
+    return CANUSB_SUCCESS;
+}
+
+CANUSB_Return_t TouCAN_USB_GetBusLoad(TouCAN_Device_t *device, uint16_t *load) {
+    /* sanity check */
+    if (!device || !load)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* bus load over the sliding window (0..10000 = 0.00%..100.00%)
+     * note: the device does not measure it, it is calculated from the CAN frames
+     *       received and transmitted (w/o those rejected by the device filters) */
+    *load = TouCAN_BusLoadGet(&device->recvData.busLoad, TouCAN_ClockSyncHostTime());
+    return CANUSB_SUCCESS;
+}
+
+CANUSB_Return_t TouCAN_USB_SetFilter(TouCAN_Device_t *device, bool xtd, uint32_t code, uint32_t mask) {
+    TouCAN_Filter_t *filter;
+
+    /* sanity check */
+    if (!device)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+    if ((code > (xtd ? CAN_MAX_XTD_ID : CAN_MAX_STD_ID)) ||
+        (mask > (xtd ? CAN_MAX_XTD_ID : CAN_MAX_STD_ID)))
+        return CANUSB_ERROR_ILLPARA;
+
+    /* acceptance code and mask (a mask of zero accepts all) */
+    /* note: it takes effect when the CAN controller is started */
+    filter = xtd ? &device->recvData.msgParam.filter29 : &device->recvData.msgParam.filter11;
+    filter->type = (mask != 0U) ? (uint8_t)FILTER_VALUE : (uint8_t)FILTER_ACCEPT_ALL;
+    filter->code = code & mask;
+    filter->mask = mask;
+    filter->count = 0U;
+    return CANUSB_SUCCESS;
+}
+
+CANUSB_Return_t TouCAN_USB_SetFilterList(TouCAN_Device_t *device, bool xtd, const uint32_t *ids, uint32_t count) {
+    TouCAN_Filter_t *filter;
+    uint32_t maxId = xtd ? CAN_MAX_XTD_ID : CAN_MAX_STD_ID;
+    uint32_t common;
+    uint32_t n = 0U;
+
+    /* sanity check */
+    if (!device)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+    if (!ids && count)
+        return CANUSB_ERROR_NULLPTR;
+    if (count > TOUCAN_FILTER_LIST_SIZE)
+        return CANUSB_ERROR_ILLPARA;
+    for (uint32_t i = 0U; i < count; i++) {
+        if (ids[i] > maxId)
+            return CANUSB_ERROR_ILLPARA;
+    }
+    filter = xtd ? &device->recvData.msgParam.filter29 : &device->recvData.msgParam.filter11;
+    /* an empty list rejects all */
+    if (count == 0U) {
+        filter->type = (uint8_t)FILTER_REJECT_ALL;
+        filter->code = 0U;
+        filter->mask = maxId;
+        filter->count = 0U;
+        return CANUSB_SUCCESS;
+    }
+    /* sort the identifiers (insertion sort, w/o duplicates) */
+    for (uint32_t i = 0U; i < count; i++) {
+        uint32_t j = n;
+        while ((j > 0U) && (filter->list[j - 1U] > ids[i]))
+            j--;
+        if ((j > 0U) && (filter->list[j - 1U] == ids[i]))
+            continue;
+        memmove(&filter->list[j + 1U], &filter->list[j], (n - j) * sizeof(uint32_t));
+        filter->list[j] = ids[i];
+        n++;
+    }
+    /* the device gets code and mask covering all identifiers of the list (the bits they have in common) */
+    common = maxId;
+    for (uint32_t i = 1U; i < n; i++)
+        common &= ~(filter->list[i] ^ filter->list[0]);
+    filter->type = (uint8_t)FILTER_VALUE;
+    filter->code = filter->list[0] & common;
+    filter->mask = common;
+    filter->count = n;
+    return CANUSB_SUCCESS;
+}
+
+CANUSB_Return_t TouCAN_USB_GetFilter(TouCAN_Device_t *device, bool xtd, uint32_t *code, uint32_t *mask) {
+    const TouCAN_Filter_t *filter;
+
+    /* sanity check */
+    if (!device)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* acceptance code and mask (as programmed into the device) */
+    filter = xtd ? &device->recvData.msgParam.filter29 : &device->recvData.msgParam.filter11;
+    if (code)
+        *code = (filter->type == (uint8_t)FILTER_ACCEPT_ALL) ? 0U : filter->code;
+    if (mask)
+        *mask = (filter->type == (uint8_t)FILTER_ACCEPT_ALL) ? 0U : filter->mask;
+    return CANUSB_SUCCESS;
+}
+
+CANUSB_Return_t TouCAN_USB_SetRxFilter(TouCAN_Device_t *device, TouCAN_RxFilter_t filter) {
+    TouCAN_RxFilter_t previous;
+
+    /* sanity check */
+    if (!device)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* replace the filter rules (NULL accepts all) */
+    /* note: the old rules are released when no transfer is being filtered anymore */
+    previous = device->recvData.msgParam.rxFilter;
+    __atomic_store_n(&device->recvData.msgParam.rxFilter, filter, __ATOMIC_SEQ_CST);
+    WaitForTableReaders(&device->recvData);
+    TouCAN_ReleaseRxFilter(previous);
+    return CANUSB_SUCCESS;
+}
+
+CANUSB_Return_t TouCAN_USB_SetRxCallback(TouCAN_Device_t *device, TouCAN_RxCallback_t callback, void *context) {
+    /* sanity check */
+    if (!device)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* deliver received CAN frames by callback (or by the message queue if NULL) */
+    /* note: only when the CAN controller is stopped, so no CAN frame is being delivered */
+    device->recvData.rxContext = context;
+    __atomic_store_n(&device->recvData.rxCallback, callback, __ATOMIC_RELEASE);
+    return CANUSB_SUCCESS;
+}
+
+CANUSB_Return_t TouCAN_USB_SetSnapshot(TouCAN_Device_t *device, TouCAN_Snapshot_t snapshot) {
+    TouCAN_Snapshot_t previous;
+
+    /* sanity check */
+    if (!device)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* replace the snapshot table (NULL disables it) */
+    /* note: the old table is destroyed when no reader uses it anymore */
+    previous = device->recvData.snapshot;
+    __atomic_store_n(&device->recvData.snapshot, snapshot, __ATOMIC_SEQ_CST);
+    WaitForTableReaders(&device->recvData);
+    TouCAN_DestroySnapshot(previous);
+    return CANUSB_SUCCESS;
+}
+
+CANUSB_Return_t TouCAN_USB_SetIdStats(TouCAN_Device_t *device, TouCAN_IdStats_t stats) {
+    TouCAN_IdStats_t previous;
+
+    /* sanity check */
+    if (!device)
+        return CANUSB_ERROR_NULLPTR;
+    if (!device->configured)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* replace the statistics table (NULL disables it) */
+    /* note: the old table is destroyed when no reader uses it anymore */
+    previous = device->recvData.idStats;
+    __atomic_store_n(&device->recvData.idStats, stats, __ATOMIC_SEQ_CST);
+    WaitForTableReaders(&device->recvData);
+    TouCAN_DestroyIdStats(previous);
+    return CANUSB_SUCCESS;
+}
+
+void TouCAN_USB_EnterTables(TouCAN_Device_t *device) {
+    assert(device);
+
+    /* note: a reader is counted before it loads a table, so it is never destroyed under its feet */
+    (void)__atomic_add_fetch(&device->recvData.tableReaders, 1U, __ATOMIC_SEQ_CST);
+}
+
+void TouCAN_USB_LeaveTables(TouCAN_Device_t *device) {
+    assert(device);
+
+    (void)__atomic_sub_fetch(&device->recvData.tableReaders, 1U, __ATOMIC_RELEASE);
 }
 
 bool TouCAN_USB_Index2Bitrate(int32_t index, TouCAN_Bitrate_t *bitrate) {
@@ -493,36 +889,327 @@ static int TouCAN_ResetDevice(CANUSB_Handle_t handle) {
 }
 
 static void ReceptionCallback(void *refCon, UInt8 *buffer, UInt32 length) {
-    TouCAN_ReceiveData_t *context = (TouCAN_ReceiveData_t *)refCon;
-    TouCAN_CanMessage_t message;
-    UInt32 index = 0;
+    assert(refCon);
 
+    /* CAN frames received from the device (IN transfer) */
+    ReceiveFrames((TouCAN_ReceiveData_t *)refCon, buffer, length, false);
+}
+
+static void EchoCallback(void *refCon, UInt8 *buffer, UInt32 length) {
     assert(refCon);
+
+    /* TX echoes made by the writer thread (in the format of the received frames) */
+    ReceiveFrames((TouCAN_ReceiveData_t *)refCon, buffer, length, true);
+}
+
+static void ReceiveFrames(TouCAN_ReceiveData_t *context, UInt8 *buffer, UInt32 length, bool txEcho) {
+    TouCAN_CanMessage_t batch[TOUCAN_RCV_XFER_FRAMES];
+    UInt32 tags[TOUCAN_RCV_XFER_FRAMES];
+    TouCAN_Snapshot_t snapshot;
+    TouCAN_IdStats_t idStats;
+    UInt32 count = 0U;
+    UInt32 index = 0U;
+    UInt64 now = 0U;
+    bool locked = false;
+
+    assert(context);
     assert(buffer);
 
-    MACCAN_LOG_WRITE(buffer, length, "<");
+    /* note: with TX echo the writer thread is a second producer of the receive queue */
+    if ((locked = context->msgParam.txEcho))
+        (void)pthread_mutex_lock(&context->echoMutex);
+    /* note: the tables and filter rules are used below, they must not be replaced in the meantime */
+    (void)__atomic_add_fetch(&context->tableReaders, 1U, __ATOMIC_SEQ_CST);
+    /* system time of the USB transfer (for all its frames) */
+    now = TouCAN_ClockSyncHostTime();
+    TouCAN_ClockSyncBegin(&context->msgParam.clockSync, now);
+    if (!txEcho) {
+        MACCAN_LOG_WRITE(buffer, length, "<");
+        context->xferCounter++;
+    }
+    /* decode all frames of the transfer into a local batch, packet by packet
+     * note: a transfer can span several USB packets, each of them with up to
+     *       three frames (the rest of a full packet is padding) */
     while (length >= TOUCAN_USB_RX_DATA_FRAME_SIZE) {
-        bzero(&message, sizeof(TouCAN_CanMessage_t));
-        (void)TouCAN_DecodeMessage(&message, &buffer[index], &context->msgParam);
-        if ((message.xtd && context->msgParam.suppressXtd) ||
-            (message.rtr && context->msgParam.suppressRtr) ||
-            (message.sts && context->msgParam.suppressSts) ||
-            (message.sts && !message.timestamp.tv_sec && !message.timestamp.tv_nsec)) {
-            /* suppress certain CAN messages depending on the operation mode*/
-        } else {
-            if (CANQUE_Enqueue(context->msgQueue, &message) == CANUSB_SUCCESS) {
-                if (!message.sts)
-                    context->msgCounter++;
-                else
-                    context->stsCounter++;
+        UInt32 packet = (length < TOUCAN_USB_RX_DATA_PIPE_SIZE) ? length : TOUCAN_USB_RX_DATA_PIPE_SIZE;
+        for (UInt32 offset = 0U; (offset + TOUCAN_USB_RX_DATA_FRAME_SIZE) <= packet; offset += TOUCAN_USB_RX_DATA_FRAME_SIZE) {
+            TouCAN_CanMessage_t *message = &batch[count];
+            /* note: only a transfer longer than requested from the pipe does not fit into the batch */
+            if (count == TOUCAN_RCV_XFER_FRAMES) {
+                DeliverMessages(context, batch, tags, count);
+                message = &batch[count = 0U];
             }
+            (void)TouCAN_DecodeMessage(message, &buffer[index + offset], &context->msgParam, txEcho);
+            /* bus load: all CAN frames on the bus, also those filtered out by the host
+             * note: transmitted frames are accounted by the writer thread, not by their echo */
+            if (!message->sts && !txEcho)
+                TouCAN_BusLoadAdd(&context->busLoad, TouCAN_FrameBits(message->xtd, message->rtr,
+                                  message->id, message->dlc, message->data), now);
+            /* TX echo: take the sequence tag of the oldest pending echo */
+            tags[count] = 0U;
+            if (txEcho && (context->echoCount > 0U)) {
+                tags[count] = context->echoTags[context->echoHead];
+                context->echoHead = (context->echoHead + 1U) % TOUCAN_TRM_QUEUE_SIZE;
+                context->echoCount--;
+            }
+            if ((message->xtd && context->msgParam.suppressXtd) ||
+                (message->rtr && context->msgParam.suppressRtr) ||
+                (message->sts && context->msgParam.suppressSts) ||
+                (message->sts && !message->timestamp.tv_sec && !message->timestamp.tv_nsec)) {
+                /* suppress certain CAN messages depending on the operation mode*/
+            } else if (!tags[count] && !IsAccepted(&context->msgParam, message)) {
+                /* rejected by the filters (before it is put into the receive queue) */
+                context->fltCounter++;
+            } else {
+                /* latest CAN frame and traffic statistics of each identifier (w/o TX echoes) */
+                if (!tags[count]) {
+                    if ((snapshot = __atomic_load_n(&context->snapshot, __ATOMIC_ACQUIRE)) != NULL)
+                        TouCAN_SnapshotUpdate(snapshot, message);
+                    if ((idStats = __atomic_load_n(&context->idStats, __ATOMIC_ACQUIRE)) != NULL)
+                        TouCAN_IdStatsUpdate(idStats, message);
+                }
+                count++;
+            }
+        }
+        index += packet;
+        length -= packet;
+    }
+    (void)__atomic_sub_fetch(&context->tableReaders, 1U, __ATOMIC_RELEASE);
+    /* the whole transfer is delivered at once (one lock and one wake-up of the reader) */
+    DeliverMessages(context, batch, tags, count);
+    if (locked)
+        (void)pthread_mutex_unlock(&context->echoMutex);
+}
+
+static void WaitForTableReaders(TouCAN_ReceiveData_t *context) {
+    assert(context);
+
+    /* note: a reader counted after the replacement takes the new table, so the counter drains */
+    while (__atomic_load_n(&context->tableReaders, __ATOMIC_SEQ_CST) != 0U)
+        (void)sched_yield();
+}
+
+static void DeliverMessages(TouCAN_ReceiveData_t *context, TouCAN_CanMessage_t *messages, const UInt32 *tags, UInt32 count) {
+    TouCAN_CanMessage_t echoes[TOUCAN_RCV_XFER_FRAMES];
+    UInt32 echoTags[TOUCAN_RCV_XFER_FRAMES];
+    UInt32 received = 0U;
+    UInt32 echoed = 0U;
+
+    assert(count <= TOUCAN_RCV_XFER_FRAMES);
+
+    if (!context->rxCallback) {
+        EnqueueMessages(context, messages, tags, count);
+        return;
+    }
+    /* callback: the received CAN frames are passed directly (in the USB completion context), */
+    /* whereas TX echoes are still put into the message queue (to be read with their tags) */
+    for (UInt32 i = 0U; i < count; i++) {
+        if (tags[i]) {
+            echoes[echoed] = messages[i];
+            echoTags[echoed++] = tags[i];
+        } else {
+            if (received != i)
+                messages[received] = messages[i];
+            if (!messages[received].sts)
+                context->msgCounter++;
+            else
+                context->stsCounter++;
+            received++;
+        }
+    }
+    if (received)
+        context->rxCallback(context->rxContext, messages, received);
+    if (echoed)
+        EnqueueMessages(context, echoes, echoTags, echoed);
+}
+
+static void EnqueueMessages(TouCAN_ReceiveData_t *context, const TouCAN_CanMessage_t *messages, const UInt32 *tags, UInt32 count) {
+    TouCAN_RcvSlot_t slots[TOUCAN_RCV_XFER_FRAMES];
+    UInt32 enqueued = 0U;
+
+    assert(count <= TOUCAN_RCV_XFER_FRAMES);
+
+    if (count == 0U)
+        return;
+    /* pack the CAN messages into CAN 2.0 records */
+    for (UInt32 i = 0U; i < count; i++)
+        PackMessage(&slots[i], &messages[i], tags[i]);
+    /* commit the batch under one lock with one wake-up (drop the rest on overrun) */
+    (void)CANQUE_EnqueueMany(context->msgQueue, slots, count, &enqueued);
+    for (UInt32 i = 0U; i < enqueued; i++) {
+        if (slots[i].flags & TOUCAN_RCV_SLOT_ECHO)
+            context->echoCounter++;
+        else if (!messages[i].sts)
+            context->msgCounter++;
+        else
+            context->stsCounter++;
+    }
+}
+
+static void PackMessage(TouCAN_RcvSlot_t *slot, const TouCAN_CanMessage_t *message, UInt32 tag) {
+    assert(slot);
+    assert(message);
+
+    slot->id = message->id;
+    slot->flags = (message->xtd ? TOUCAN_RCV_SLOT_XTD : 0x00U)
+                | (message->rtr ? TOUCAN_RCV_SLOT_RTR : 0x00U)
+                | (message->sts ? TOUCAN_RCV_SLOT_STS : 0x00U)
+                | (tag ? TOUCAN_RCV_SLOT_ECHO : 0x00U);
+    slot->tag = tag;
+    slot->dlc = (message->dlc <= TOUCAN_USB_MAX_FRAME_LEN) ? message->dlc : TOUCAN_USB_MAX_FRAME_LEN;
+    memcpy(slot->data, message->data, TOUCAN_USB_MAX_FRAME_LEN);
+    slot->timestamp = ((UInt64)message->timestamp.tv_sec * 1000000000U)
+                    + (UInt64)message->timestamp.tv_nsec;
+}
+
+static void ExpandMessage(TouCAN_CanMessage_t *message, const TouCAN_RcvSlot_t *slot) {
+    assert(message);
+    assert(slot);
+
+    bzero(message, sizeof(TouCAN_CanMessage_t));
+    message->id = slot->id;
+    message->xtd = (slot->flags & TOUCAN_RCV_SLOT_XTD) ? 1 : 0;
+    message->rtr = (slot->flags & TOUCAN_RCV_SLOT_RTR) ? 1 : 0;
+    message->sts = (slot->flags & TOUCAN_RCV_SLOT_STS) ? 1 : 0;
+    message->dlc = slot->dlc;
+    memcpy(message->data, slot->data, TOUCAN_USB_MAX_FRAME_LEN);
+    message->timestamp.tv_sec = (time_t)(slot->timestamp / 1000000000U);
+    message->timestamp.tv_nsec = (long)(slot->timestamp % 1000000000U);
+}
+
+/* TX echoes are only returned by the tagged read (a CAN message has no flag for them),
+ * the other reads drop them and wait for the rest of their time-out
+ * note: the start time is only taken when the TX echo is switched on (otherwise 0)
+ */
+static uint16_t RemainingTime(UInt64 start, uint16_t timeout) {
+    UInt64 elapsed;
+
+    if (!start || (timeout == 0U) || (timeout == CANUSB_INFINITE))
+        return timeout;
+    elapsed = (TouCAN_ClockSyncHostTime() - start) / 1000000U;
+    return (elapsed < (UInt64)timeout) ? (uint16_t)(timeout - (uint16_t)elapsed) : 0U;
+}
+
+static uint32_t RemainingTimeUs(UInt64 start, uint32_t timeout) {
+    UInt64 elapsed;
+
+    if (!start || (timeout == 0U) || (timeout == CANQUE_INFINITE_USEC))
+        return timeout;
+    elapsed = (TouCAN_ClockSyncHostTime() - start) / 1000U;
+    return (elapsed < (UInt64)timeout) ? (uint32_t)(timeout - (uint32_t)elapsed) : 0U;
+}
+
+static bool IsRefused(const TouCAN_Device_t *device, const TouCAN_CanMessage_t *message) {
+    assert(device);
+    assert(message);
+
+    if (message->xtd && (device->opMode & CANMODE_NXTD))
+        return true;
+    if (message->rtr && (device->opMode & CANMODE_NRTR))
+        return true;
+    if (message->sts)  /* note: error frames cannot be sent */
+        return true;
+    return false;
+}
+
+static bool IsAccepted(const TouCAN_MsgParam_t *param, const TouCAN_CanMessage_t *message) {
+    const TouCAN_Filter_t *filter;
+    TouCAN_RxFilter_t rules;
+    uint32_t lower, upper;
+
+    assert(param);
+    assert(message);
+
+    if (message->sts)  /* note: error frames are not filtered */
+        return true;
+    /* 2nd stage: filter rules (if any) */
+    rules = __atomic_load_n(&param->rxFilter, __ATOMIC_ACQUIRE);
+    if (rules && !TouCAN_RxFilterAccept(rules, message))
+        return false;
+    /* 1st stage: acceptance filter (already applied by the device, if possible) */
+    filter = message->xtd ? &param->filter29 : &param->filter11;
+    switch (filter->type) {
+    case FILTER_ACCEPT_ALL:
+        return true;
+    case FILTER_REJECT_ALL:
+        return false;
+    default:
+        if ((message->id & filter->mask) != filter->code)
+            return false;
+        if (filter->count == 0U)
+            return true;
+        /* binary search in the list of identifiers */
+        lower = 0U;
+        upper = filter->count;
+        while (lower < upper) {
+            uint32_t middle = lower + ((upper - lower) / 2U);
+            if (filter->list[middle] == message->id)
+                return true;
+            if (filter->list[middle] < message->id)
+                lower = middle + 1U;
+            else
+                upper = middle;
         }
-        index += TOUCAN_USB_RX_DATA_FRAME_SIZE;
-        length -= TOUCAN_USB_RX_DATA_FRAME_SIZE;
+        return false;
     }
 }
 
-static int TouCAN_EncodeMessage(UInt8 *buffer, const TouCAN_CanMessage_t *message) {
+static void ResetFilter(TouCAN_Filter_t *filter) {
+    assert(filter);
+
+    filter->type = (uint8_t)FILTER_ACCEPT_ALL;
+    filter->code = 0U;
+    filter->mask = 0U;
+    filter->count = 0U;
+}
+
+static bool ProgramFilters(TouCAN_Device_t *device) {
+    const TouCAN_Filter_t *filter11;
+    const TouCAN_Filter_t *filter29;
+    int retVal;
+
+    assert(device);
+
+    filter11 = &device->recvData.msgParam.filter11;
+    filter29 = &device->recvData.msgParam.filter29;
+    /* note: the device accepts all CAN frames after its initialization */
+    if ((filter11->type == (uint8_t)FILTER_ACCEPT_ALL) && (filter29->type == (uint8_t)FILTER_ACCEPT_ALL))
+        return false;
+    retVal = TouCAN_set_filter_std_list_mask(device->handle, (Filter_Type_TypeDef)filter11->type, filter11->code, filter11->mask);
+    if (retVal < 0) {
+        MACCAN_DEBUG_ERROR("+++ %s (device #%u): 11-bit acceptance filter could not be set (%i)\n", device->name, device->handle, retVal);
+        return false;
+    }
+    retVal = TouCAN_set_filter_ext_list_mask(device->handle, (Filter_Type_TypeDef)filter29->type, filter29->code, filter29->mask);
+    if (retVal < 0) {
+        MACCAN_DEBUG_ERROR("+++ %s (device #%u): 29-bit acceptance filter could not be set (%i)\n", device->name, device->handle, retVal);
+        return false;
+    }
+    return true;
+}
+
+static UInt32 NominalBitrate(TouCAN_CanClock_t canClock, const TouCAN_Bitrate_t *bitrate) {
+    UInt32 quanta = 1U + (UInt32)bitrate->tseg1 + (UInt32)bitrate->tseg2;
+
+    /* bit-rate = CAN clock / (prescaler * time quanta per bit) */
+    if ((canClock <= 0) || !bitrate->brp)
+        return 0U;
+    return (UInt32)canClock / ((UInt32)bitrate->brp * quanta);
+}
+
+static UInt32 NextSequenceTag(TouCAN_Device_t *device) {
+    UInt32 tag;
+
+    assert(device);
+
+    /* note: several writers per channel, and zero is not a sequence tag */
+    do {
+        tag = __atomic_add_fetch(&device->sendData.tagCounter, 1U, __ATOMIC_RELAXED);
+    } while (tag == 0U);
+    return tag;
+}
+
+static int TouCAN_EncodeMessage(UInt8 *buffer, const TouCAN_CanMessage_t *message, UInt32 tag) {
     int index = 0;
     
     assert(buffer);
@@ -541,30 +1228,24 @@ static int TouCAN_EncodeMessage(UInt8 *buffer, const TouCAN_CanMessage_t *messag
     /* byte 6 - 13: payload (8 bytes) */
     for (int i = 0; i < TOUCAN_USB_MAX_FRAME_LEN; i++)
         buffer[index++] = message->data[i];
-    /* byte 14 - 17: timestamp? (big endian) */
-    buffer[index++] = 0x00U;
-    buffer[index++] = 0x00U;
-    buffer[index++] = 0x00U;
-    buffer[index++] = 0x00U;
+    /* byte 14 - 17: sequence tag (big endian, not sent to the device) */
+    buffer[index++] = (UInt8)(tag >> 24);
+    buffer[index++] = (UInt8)(tag >> 16);
+    buffer[index++] = (UInt8)(tag >> 8);
+    buffer[index++] = (UInt8)tag;
     
     return index;
 }
 
-static int TouCAN_DecodeMessage(TouCAN_CanMessage_t *message, const UInt8 *buffer, TouCAN_MsgParam_t *param) {
+static int TouCAN_DecodeMessage(TouCAN_CanMessage_t *message, const UInt8 *buffer, TouCAN_MsgParam_t *param, bool txEcho) {
     int index = 0;
-    UInt64 hw_usec = 0U;
-    UInt64 sw_usec = 0U;
-    struct timespec ts;
+    UInt32 hw_usec = 0U;
+    UInt64 ts_nsec = 0U;
     
     assert(buffer);
     assert(message);
     bzero(message, sizeof(TouCAN_CanMessage_t));
     
-    /* get system time (in [usec]) */
-    (void) clock_gettime(CLOCK_MONOTONIC, &ts);
-    sw_usec = ((UInt64)ts.tv_sec * 1000000U)
-            + ((UInt64)ts.tv_nsec / 1000U);
-    
     /* byte 0: transmission flags */
     message->xtd = (buffer[index] & TOUCAN_MSG_XTD_FRAME) ? 1 : 0;
     message->rtr = (buffer[index] & TOUCAN_MSG_RTR_FRAME) ? 1 : 0;
@@ -580,26 +1261,21 @@ static int TouCAN_DecodeMessage(TouCAN_CanMessage_t *message, const UInt8 *buffe
     for (int i = 0; i < TOUCAN_USB_MAX_FRAME_LEN; i++)
         message->data[i] = buffer[index++];
     /* byte 14 - 17: timestamp (big endian) */
-    hw_usec |= (UInt64)buffer[index++] << 24;
-    hw_usec |= (UInt64)buffer[index++] << 16;
-    hw_usec |= (UInt64)buffer[index++] << 8;
-    hw_usec |= (UInt64)buffer[index++];
+    hw_usec |= (UInt32)buffer[index++] << 24;
+    hw_usec |= (UInt32)buffer[index++] << 16;
+    hw_usec |= (UInt32)buffer[index++] << 8;
+    hw_usec |= (UInt32)buffer[index++];
     
-    /* overflow handling (2^32 - 1 = 1:11:34.962296) */
+    /* device time to system time (cf. TouCAN_ClockSyncBegin for the USB transfer) */
     if (param) {
-        if (param->startTime == 0) {
-            param->startTime = sw_usec - hw_usec;
-        }
-        UInt64 diff_time = sw_usec - param->startTime;
-        hw_usec += ((diff_time / 0x100000000U) * 0x100000000U);  // FIXME: Don't understand!
-    }
+        /* note: status frames without time-stamp are suppressed, TX echoes carry their OUT-completion time */
+        if (!message->sts || hw_usec)
+            ts_nsec = TouCAN_ClockSyncConvert(&param->clockSync, hw_usec, !txEcho);
+    } else
+        ts_nsec = (UInt64)hw_usec * 1000U;
     /* timestamp as struct timespec (fraction in [nsec]) */
-    message->timestamp.tv_sec = (time_t)(hw_usec / 1000000U);
-    message->timestamp.tv_nsec =  (long)(hw_usec % 1000000U) * (long)1000;
-    if (message->timestamp.tv_nsec >= (long)1000000000) {  // FIXME:  Condition 'message->timestamp.tv_nsec>=(long)1000000000' is always false
-        message->timestamp.tv_nsec %= (long)1000000000;
-        message->timestamp.tv_sec += (time_t)1;
-    }
+    message->timestamp.tv_sec = (time_t)(ts_nsec / 1000000000U);
+    message->timestamp.tv_nsec = (long)(ts_nsec % 1000000000U);
     /* status frame: data[0...] (bus status in byte 0) */
     if (message->sts && message->dlc && param) {
 #if (1)
@@ -68,8 +68,26 @@ extern CANUSB_Return_t TouCAN_USB_StartCan(TouCAN_Device_t *device);
 extern CANUSB_Return_t TouCAN_USB_StopCan(TouCAN_Device_t *device);
 
 extern CANUSB_Return_t TouCAN_USB_WriteMessage(TouCAN_Device_t *device, const TouCAN_CanMessage_t *message, uint16_t timeout);
+extern CANUSB_Return_t TouCAN_USB_WriteMessageTagged(TouCAN_Device_t *device, const TouCAN_CanMessage_t *message, uint16_t timeout, uint32_t *tag);
+extern CANUSB_Return_t TouCAN_USB_WriteMessages(TouCAN_Device_t *device, const TouCAN_CanMessage_t *messages, uint32_t count, uint32_t *written, uint16_t timeout);
 extern CANUSB_Return_t TouCAN_USB_ReadMessage(TouCAN_Device_t *device, TouCAN_CanMessage_t *message, uint16_t timeout);
+extern CANUSB_Return_t TouCAN_USB_ReadMessageTagged(TouCAN_Device_t *device, TouCAN_CanMessage_t *message, uint32_t *tag, uint16_t timeout);
+extern CANUSB_Return_t TouCAN_USB_ReadMessageUs(TouCAN_Device_t *device, TouCAN_CanMessage_t *message, uint32_t timeout);
+extern CANUSB_Return_t TouCAN_USB_ReadMessages(TouCAN_Device_t *device, TouCAN_CanMessage_t *messages, uint32_t max, uint32_t *count, uint16_t timeout);
+extern CANUSB_Return_t TouCAN_USB_PeekMessages(TouCAN_Device_t *device, const TouCAN_CanMessage_t **messages, uint32_t *count, uint16_t timeout);
+extern CANUSB_Return_t TouCAN_USB_CommitMessages(TouCAN_Device_t *device, uint32_t count);
 extern CANUSB_Return_t TouCAN_USB_GetBusStatus(TouCAN_Device_t *device, TouCAN_Status_t *status);
+extern CANUSB_Return_t TouCAN_USB_GetBusLoad(TouCAN_Device_t *device, uint16_t *load);
+
+extern CANUSB_Return_t TouCAN_USB_SetFilter(TouCAN_Device_t *device, bool xtd, uint32_t code, uint32_t mask);
+extern CANUSB_Return_t TouCAN_USB_SetFilterList(TouCAN_Device_t *device, bool xtd, const uint32_t *ids, uint32_t count);
+extern CANUSB_Return_t TouCAN_USB_GetFilter(TouCAN_Device_t *device, bool xtd, uint32_t *code, uint32_t *mask);
+extern CANUSB_Return_t TouCAN_USB_SetRxFilter(TouCAN_Device_t *device, TouCAN_RxFilter_t filter);
+extern CANUSB_Return_t TouCAN_USB_SetRxCallback(TouCAN_Device_t *device, TouCAN_RxCallback_t callback, void *context);
+extern CANUSB_Return_t TouCAN_USB_SetSnapshot(TouCAN_Device_t *device, TouCAN_Snapshot_t snapshot);
+extern CANUSB_Return_t TouCAN_USB_SetIdStats(TouCAN_Device_t *device, TouCAN_IdStats_t stats);
+extern void TouCAN_USB_EnterTables(TouCAN_Device_t *device);
+extern void TouCAN_USB_LeaveTables(TouCAN_Device_t *device);
 
 extern bool TouCAN_USB_Index2Bitrate(int32_t index, TouCAN_Bitrate_t *bitrate);
 
@@ -0,0 +1,1630 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later */
+/*
+ *  TouCAN - macOS User-Space Driver for Rusoku TouCAN USB Interfaces
+ *
+ *  Copyright (C) 2021-2023  Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+ *
+ *  This file is part of MacCAN-TouCAN.
+ *
+ *  MacCAN-TouCAN is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  MacCAN-TouCAN is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with MacCAN-TouCAN.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "TouCAN_USB_Simulator.h"
+#include "TouCAN_USB_Driver.h"
+#include "TouCAN_BusLoad.h"
+#include "MacCAN_Debug.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+/* The simulator replaces the USB kit (MacCAN_IOUsbKit.c) when it is linked
+ * instead of it: it implements the CANUSB_xxx() functions with TouCAN devices
+ * in software, so that the driver can be built and run without the hardware
+ * (and without IOKit). Each simulated device answers the vendor requests of
+ * the TouCAN firmware (a bxCAN controller driven by the STM32 HAL), takes the
+ * CAN frames from its OUT pipe and delivers CAN frames on its IN pipe in the
+ * 18-byte frame format of the firmware.
+ *
+ * The devices are connected to virtual buses. A CAN frame sent by a device is
+ * received by all started devices on the same bus with the same bit-rate; it
+ * is acknowledged by them (unless they are in silent mode) or by a traffic
+ * generator on that bus. A CAN frame without acknowledge counts as an error
+ * (the transmit error counter is incremented and status frames are reported
+ * like the firmware does); it stays in a transmit mailbox of the device and
+ * is retransmitted until another node acknowledges it, e.g. when a device on
+ * the bus is started later (a CAN frame that finds all transmit mailboxes
+ * occupied is dropped). A CAN frame sent while a started device on the bus
+ * has another bit-rate is destroyed (a bit error, up to bus-off). Traffic
+ * generators are nodes on a virtual bus that send bursts of CAN frames
+ * periodically, with up-counting identifiers and an up-counting number in the
+ * payload (in little-endian byte order).
+ *
+ * In real-time mode (the default) each bus is occupied for the duration of
+ * its CAN frames (from their exact bit length at the bit-rate) and a CAN frame
+ * is delivered at the end of its transmission; a writer is held back while the
+ * bus is occupied for more than the transmit mailboxes of the device can take
+ * (like a USB device that does not accept OUT packets). Without real-time mode
+ * all CAN frames are delivered immediately, as fast as the host can take them.
+ *
+ * All devices, buses and pipes are guarded by one mutex. The bus thread runs
+ * the traffic generators and completes the reads of the IN pipes; it calls the
+ * callbacks of the pipes w/o holding the mutex (one callback after the other,
+ * like the run loop of the USB kit does).
+ *
+ * The environment variables TOUCAN_SIM_DEVICES (number of devices on bus 0),
+ * TOUCAN_SIM_REALTIME (0 = off) and TOUCAN_SIM_TRAFFIC (traffic generator on
+ * bus 0: <period>[:<burst>[:<id>[:<range>[:<dlc>[:<xtd>]]]]]) are taken into
+ * account on initialization.
+ */
+#define VERSION_MAJOR     0
+#define VERSION_MINOR     1
+#define VERSION_PATCH     0
+
+#define SIM_DEVICE_NAME  TOUCAN_USB_DEVICE_NAME " (simulated)"
+#define SIM_VENDOR_NAME  "TouCAN simulation"
+#define SIM_RELEASE_NO  0x0100U
+#define SIM_HARDWARE_VERSION  0x01000000U
+#define SIM_FIRMWARE_VERSION  0x01000000U
+#define SIM_BOOTLOADER_VERSION  0x01000000U
+#define SIM_SERIAL_NUMBER  0x51A00000U  /* plus index of the device */
+#define SIM_DEVICE_ID  0x00000001U
+#define SIM_CLOCK_SKEW  0x0D15EA5EU  /* [usec] offset of the device clocks (plus index of the device) */
+
+#define SIM_FRAME_SIZE  TOUCAN_USB_RX_DATA_FRAME_SIZE
+#define SIM_PACKET_SIZE  TOUCAN_USB_RX_DATA_PIPE_SIZE
+#define SIM_PACKET_FRAMES  TOUCAN_USB_RX_DATA_FRAME_CNT
+#define SIM_TIMESTAMP  14U  /* offset of the time-stamp in an encoded frame */
+#define SIM_TX_MAILBOXES  3U  /* transmit mailboxes of the CAN controller */
+#define SIM_MAX_SLEEP  10000000U  /* [nsec] max. sleep time of the bus thread */
+#define SIM_MAX_LATENESS  100000000U  /* [nsec] a traffic generator that falls behind skips its bursts */
+#define SIM_POLLING  1000U  /* [usec] polling interval of the synchronous read */
+
+#define IS_INDEX_VALID(idx)  ((0 <= (idx)) && ((idx) < CANUSB_MAX_DEVICES))
+#define IS_HANDLE_VALID(hnd)  IS_INDEX_VALID(hnd)
+#define IS_BUS_VALID(bus)  ((bus) < TOUCAN_SIM_MAX_BUSES)
+
+#define ENTER_CRITICAL_SECTION()  (void)pthread_mutex_lock(&usbDriver.ptMutex)
+#define LEAVE_CRITICAL_SECTION()  (void)pthread_mutex_unlock(&usbDriver.ptMutex)
+
+struct usb_async_pipe_tag {             /* asynchronous pipe: */
+    UInt8 pipeRef;                      /* - pipe number (endpoint) */
+    CANUSB_Handle_t handle;             /* - device handle */
+    struct {                            /* - ring of read buffers: */
+        UInt8 **data;                   /*   - pointer to data buffers */
+        UInt32 depth;                   /*   - number of data buffers */
+        UInt32 index;                   /*   - index of the oldest submitted buffer */
+        UInt32 pending;                 /*   - number of submitted buffers */
+        UInt32 size;                    /*   - size of each buffer (in byte) */
+    } buffer;
+    CANUSB_AsyncPipeCbk_t callback;     /* - callback for completed reads */
+    CANUSB_Context_t context;           /* - pointer to user context for callback */
+    Boolean running;                    /* - flag to indicate the pipe state */
+    Boolean inCallback;                 /* - the bus thread is in the callback */
+    UInt64 xferCounter;                 /* - number of completed transfers */
+    UInt64 dryCounter;                  /* - number of times no read was submitted */
+    UInt64 errCounter;                  /* - number of failed (re-)submissions */
+};
+
+typedef struct sim_frame_t_ {           /* CAN frame held by a device: */
+    UInt64 due;                         /* - end of its transmission (in [nsec]) */
+    UInt8 data[SIM_FRAME_SIZE];         /* - encoded frame (with time-stamp) */
+} SimFrame_t;
+
+typedef struct sim_filter_t_ {          /* acceptance filter of the firmware: */
+    UInt8 type;                         /* - FILTER_xxx */
+    UInt32 code;                        /* - acceptance code */
+    UInt32 mask;                        /* - acceptance mask */
+} SimFilter_t;
+
+typedef struct sim_controller_t_ {      /* CAN controller (firmware): */
+    UInt8 state;                        /* - interface state (HAL_CAN_STATE_xxx) */
+    UInt8 lastError;                    /* - result of the last request (HAL_xxx) */
+    UInt32 errorCode;                   /* - interface error code (HAL_CAN_ERROR_xxx) */
+    UInt32 flags;                       /* - operation mode (TouCAN_ENABLE_xxx) */
+    UInt32 bitrate;                     /* - nominal bit-rate (in [bit/s]) */
+    UInt32 delay;                       /* - interface delay (not used) */
+    UInt8 txErrors;                     /* - transmit error counter */
+    UInt8 rxErrors;                     /* - receive error counter */
+    UInt8 busStatus;                    /* - last reported bus status (TOUCAN_STS_xxx) */
+    Boolean busOff;                     /* - bus-off state (until re-initialized) */
+    SimFilter_t filter11;               /* - filter for 11-bit identifier */
+    SimFilter_t filter29;               /* - filter for 29-bit identifier */
+    UInt8 mailbox[SIM_TX_MAILBOXES][SIM_FRAME_SIZE];  /* - CAN frames w/o acknowledge */
+    UInt8 pending;                      /* - number of occupied transmit mailboxes */
+    UInt32 starts;                      /* - number of starts (to discard stale OUT transfers) */
+} SimController_t;
+
+typedef struct usb_device_tag {         /* simulated USB device: */
+    Boolean fPresent;                   /* - device is present */
+    Boolean fOpened;                    /* - device is opened */
+    char szName[TOUCAN_MAX_NAME_LENGTH];  /* - device name */
+    UInt16 u16VendorId;                 /* - vendor ID (16-bit) */
+    UInt16 u16ProductId;                /* - product ID (16-bit) */
+    UInt16 u16ReleaseNo;                /* - release no. (16-bit) */
+    UInt8 nCanChannels;                 /* - number of CAN channels */
+    UInt32 u32Location;                 /* - unique location ID (32-bit) */
+    UInt16 u16Address;                  /* - device address (16-bit) */
+    UInt8 bus;                          /* - virtual bus of the device */
+    UInt32 clockOffset;                 /* - offset of the device clock (in [usec]) */
+    SimController_t can;                /* - CAN controller */
+    SimFrame_t *fifo;                   /* - CAN frames for the host */
+    UInt32 fifoHead;                    /* - oldest CAN frame */
+    UInt32 fifoCount;                   /* - number of CAN frames */
+    CANUSB_AsyncPipe_t recvPipe;        /* - asynchronous read of the IN pipe */
+} USBDevice_t;
+
+typedef struct sim_generator_t_ {       /* traffic generator: */
+    TouCAN_SimTraffic_t traffic;        /* - its configuration */
+    UInt64 nextTime;                    /* - time of the next burst (in [nsec]) */
+    UInt64 counter;                     /* - number of generated CAN frames */
+} SimGenerator_t;
+
+typedef struct sim_bus_t_ {             /* virtual CAN bus: */
+    Boolean realTime;                   /* - CAN frames take their time */
+    UInt64 busyUntil;                   /* - end of the last CAN frame (in [nsec]) */
+    SimGenerator_t generator[TOUCAN_SIM_MAX_TRAFFIC];  /* - traffic generators */
+    TouCAN_SimStatistics_t stats;       /* - statistics */
+} SimBus_t;
+
+typedef struct usb_driver_tag {         /* USB driver (simulation): */
+    Boolean fRunning;                   /* - flag: bus thread running */
+    pthread_t ptThread;                 /* - bus thread */
+    pthread_mutex_t ptMutex;            /* - mutex for devices, buses and pipes */
+    pthread_cond_t ptCond;              /* - wakes the bus thread on changes */
+    UInt64 epoch;                       /* - start of the simulation (in [nsec]) */
+} USBDriver_t;
+
+static void *BusThread(void *arg);
+static CANUSB_Index_t AttachDevice(UInt8 bus);
+static void DetachDevice(CANUSB_Index_t index);
+static void ConfigureFromEnvironment(void);
+static CANUSB_Return_t SetTraffic(UInt8 bus, UInt8 slot, const TouCAN_SimTraffic_t *traffic);
+static CANUSB_Return_t ProcessRequest(USBDevice_t *device, const CANUSB_SetupPacket_t *setup, UInt8 *data, UInt16 size, UInt32 *transferred);
+static CANUSB_Return_t TransmitFrame(CANUSB_Index_t index, const UInt8 *frame);
+static Boolean SendFrame(CANUSB_Index_t index, const UInt8 *frame, UInt64 due);
+static void RetransmitFrames(UInt8 bus, UInt64 due);
+static UInt32 Broadcast(UInt8 bus, CANUSB_Index_t sender, const UInt8 *frame, UInt32 bitrate, UInt64 due);
+static Boolean IsDisturbed(UInt8 bus, CANUSB_Index_t sender, UInt32 bitrate);
+static UInt64 GenerateTraffic(UInt8 bus, UInt64 now);
+static UInt64 OccupyBus(UInt8 bus, const UInt8 *frame, UInt32 bitrate, UInt64 start);
+static UInt32 FillTransfer(USBDevice_t *device, UInt8 *buffer, UInt32 size, UInt64 now);
+static void PutFrame(USBDevice_t *device, const UInt8 *frame, UInt64 due);
+static void UpdateBusStatus(USBDevice_t *device, UInt64 due);
+static Boolean IsAccepted(const SimController_t *can, const UInt8 *frame);
+static void WaitForCallback(CANUSB_AsyncPipe_t asyncPipe);
+static void PutUInt32(UInt8 *data, UInt32 value);
+static UInt32 GetUInt32(const UInt8 *data);
+
+static USBDriver_t usbDriver;
+static USBDevice_t usbDevice[CANUSB_MAX_DEVICES];
+static SimBus_t simBus[TOUCAN_SIM_MAX_BUSES];
+static CANUSB_Index_t idxDevice = 0;
+static Boolean fInitialized = false;
+
+CANUSB_Return_t CANUSB_Initialize(void) {
+    UInt8 bus;
+
+    /* must not be initialized */
+    if (fInitialized)
+        return CANUSB_ERROR_YETINIT;
+
+    /* initialize the driver, its devices and the virtual buses */
+    memset(&usbDriver, 0, sizeof(USBDriver_t));
+    memset(usbDevice, 0, sizeof(usbDevice));
+    memset(simBus, 0, sizeof(simBus));
+    for (bus = 0U; bus < TOUCAN_SIM_MAX_BUSES; bus++)
+        simBus[bus].realTime = true;
+    usbDriver.epoch = MacCAN_GetTime();
+    if (pthread_mutex_init(&usbDriver.ptMutex, NULL) != 0)
+        return CANUSB_ERROR_NOTINIT;
+    if (MacCAN_InitCondition(&usbDriver.ptCond) != 0) {
+        (void)pthread_mutex_destroy(&usbDriver.ptMutex);
+        return CANUSB_ERROR_NOTINIT;
+    }
+    MACCAN_DEBUG_INFO("    Loading the TouCAN simulation (v%u.%u.%u)\n", VERSION_MAJOR, VERSION_MINOR, VERSION_PATCH);
+    ConfigureFromEnvironment();
+
+    /* start the bus thread */
+    usbDriver.fRunning = true;
+    if (pthread_create(&usbDriver.ptThread, NULL, BusThread, NULL) != 0) {
+        MACCAN_DEBUG_ERROR("+++ Unable to start the TouCAN simulation (thread)\n");
+        for (CANUSB_Index_t index = 0; index < CANUSB_MAX_DEVICES; index++)
+            DetachDevice(index);
+        (void)pthread_cond_destroy(&usbDriver.ptCond);
+        (void)pthread_mutex_destroy(&usbDriver.ptMutex);
+        return CANUSB_ERROR_NOTINIT;
+    }
+    fInitialized = true;
+    return CANUSB_SUCCESS;
+}
+
+CANUSB_Return_t CANUSB_Teardown(void) {
+    CANUSB_Index_t index;
+
+    /* must be initialized */
+    if (!fInitialized)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* stop the bus thread */
+    MACCAN_DEBUG_INFO("    Release the TouCAN simulation (v%u.%u.%u)\n", VERSION_MAJOR, VERSION_MINOR, VERSION_PATCH);
+    ENTER_CRITICAL_SECTION();
+    usbDriver.fRunning = false;
+    (void)pthread_cond_signal(&usbDriver.ptCond);
+    LEAVE_CRITICAL_SECTION();
+    (void)pthread_join(usbDriver.ptThread, NULL);
+
+    /* remove all devices */
+    ENTER_CRITICAL_SECTION();
+    for (index = 0; index < CANUSB_MAX_DEVICES; index++)
+        DetachDevice(index);
+    LEAVE_CRITICAL_SECTION();
+    (void)pthread_cond_destroy(&usbDriver.ptCond);
+    (void)pthread_mutex_destroy(&usbDriver.ptMutex);
+    fInitialized = false;
+    return CANUSB_SUCCESS;
+}
+
+CANUSB_Return_t CANUSB_DeviceRequest(CANUSB_Index_t index, CANUSB_SetupPacket_t setupPacket, void *buffer, UInt16 size, UInt32 *transferred) {
+    UInt32 length = 0U;
+    int ret = 0;
+
+    /* must be initialized */
+    if (!fInitialized)
+        return CANUSB_ERROR_NOTINIT;
+    /* must be a valid index */
+    if (!IS_INDEX_VALID(index))
+        return CANUSB_ERROR_HANDLE;
+    /* check for NULL pointer */
+    if (!buffer && setupPacket.Length)
+        return CANUSB_ERROR_NULLPTR;
+
+    ENTER_CRITICAL_SECTION();
+    if (usbDevice[index].fPresent) {
+        ret = ProcessRequest(&usbDevice[index], &setupPacket, (UInt8*)buffer, size, &length);
+        if (ret < 0)
+            MACCAN_DEBUG_ERROR("+++ Control transfer failed (request %02x stalled)\n", setupPacket.Request);
+        else if (transferred)
+            *transferred = length;
+        /* note: a started device can receive retransmitted CAN frames */
+        (void)pthread_cond_signal(&usbDriver.ptCond);
+    } else {
+        MACCAN_DEBUG_ERROR("+++ Sorry, device #%i is not available\n", index);
+        ret = CANUSB_ERROR_HANDLE;
+    }
+    LEAVE_CRITICAL_SECTION();
+    return ret;
+}
+
+CANUSB_Handle_t CANUSB_OpenDevice(CANUSB_Index_t index, UInt16 vendorId, UInt16 productId) {
+    CANUSB_Handle_t handle = CANUSB_INVALID_HANDLE;
+
+    /* must be initialized */
+    if (!fInitialized)
+        return CANUSB_INVALID_HANDLE;
+    /* must be a valid index */
+    if (!IS_INDEX_VALID(index))
+        return CANUSB_INVALID_HANDLE;
+    /* vendor id. required when a product id. is given */
+    if ((vendorId == CANUSB_ANY_VENDOR_ID) && (productId != CANUSB_ANY_PRODUCT_ID))
+        return CANUSB_INVALID_HANDLE;
+
+    /* open the USB device (for exclusive access) */
+    ENTER_CRITICAL_SECTION();
+    if (usbDevice[index].fPresent && !usbDevice[index].fOpened) {
+        if (((vendorId == CANUSB_ANY_VENDOR_ID) || (vendorId == usbDevice[index].u16VendorId)) &&
+            ((productId == CANUSB_ANY_PRODUCT_ID) || (productId == usbDevice[index].u16ProductId))) {
+            usbDevice[index].fOpened = true;
+            handle = (CANUSB_Handle_t)index;
+        } else {
+            MACCAN_DEBUG_ERROR("+++ Device #%i doesn't match (vendor = %03x, product = %03x)\n", index, vendorId, productId);
+        }
+    } else if (!usbDevice[index].fPresent) {
+        MACCAN_DEBUG_ERROR("+++ Unable to open device #%i (device not present)\n", index);
+    }
+    LEAVE_CRITICAL_SECTION();
+    return handle;
+}
+
+CANUSB_Return_t CANUSB_CloseDevice(CANUSB_Handle_t handle) {
+    int ret = 0;
+
+    /* must be initialized */
+    if (!fInitialized)
+        return CANUSB_ERROR_NOTINIT;
+    /* must be a valid handle */
+    if (!IS_HANDLE_VALID(handle))
+        return CANUSB_ERROR_HANDLE;
+
+    ENTER_CRITICAL_SECTION();
+    if (usbDevice[handle].fPresent && usbDevice[handle].fOpened) {
+        /* note: a read still running is stopped (w/o notification) */
+        if (usbDevice[handle].recvPipe) {
+            usbDevice[handle].recvPipe->running = false;
+            usbDevice[handle].recvPipe = NULL;
+        }
+        usbDevice[handle].fOpened = false;
+    } else {
+        ret = !usbDevice[handle].fPresent ? CANUSB_ERROR_HANDLE : CANUSB_ERROR_NOTINIT;
+    }
+    LEAVE_CRITICAL_SECTION();
+    return ret;
+}
+
+CANUSB_Return_t CANUSB_ReadPipe(CANUSB_Handle_t handle, UInt8 pipeRef, void *buffer, UInt32 *size, UInt16 timeout) {
+    UInt64 start = MacCAN_GetTime();
+    int ret = CANUSB_ERROR_TIMEOUT;
+
+    /* must be initialized */
+    if (!fInitialized)
+        return CANUSB_ERROR_NOTINIT;
+    /* must be a valid handle */
+    if (!IS_HANDLE_VALID(handle))
+        return CANUSB_ERROR_HANDLE;
+    /* check for NULL pointer */
+    if (!buffer || !size)
+        return CANUSB_ERROR_NULLPTR;
+    /* the device has only one IN pipe */
+    if (pipeRef != TOUCAN_USB_RX_DATA_PIPE_REF)
+        return CANUSB_ERROR_RESOURCE;
+
+    /* note: the device time-stamps are from its CAN frames, the time-out is polled */
+    ENTER_CRITICAL_SECTION();
+    while (usbDevice[handle].fPresent && usbDevice[handle].fOpened) {
+        if (usbDevice[handle].recvPipe) {
+            ret = CANUSB_ERROR_RESOURCE;  /* asynchronous read running */
+            break;
+        }
+        if (usbDevice[handle].fifoCount &&
+            (usbDevice[handle].fifo[usbDevice[handle].fifoHead].due <= MacCAN_GetTime())) {
+            *size = FillTransfer(&usbDevice[handle], (UInt8*)buffer, *size, MacCAN_GetTime());
+            ret = CANUSB_SUCCESS;
+            break;
+        }
+        if (timeout && ((MacCAN_GetTime() - start) >= ((UInt64)timeout * 1000000U)))
+            break;
+        LEAVE_CRITICAL_SECTION();
+        (void)usleep(SIM_POLLING);
+        ENTER_CRITICAL_SECTION();
+    }
+    if (!usbDevice[handle].fPresent)
+        ret = CANUSB_ERROR_HANDLE;
+    else if (!usbDevice[handle].fOpened)
+        ret = CANUSB_ERROR_NOTINIT;
+    LEAVE_CRITICAL_SECTION();
+    return ret;
+}
+
+CANUSB_Return_t CANUSB_WritePipe(CANUSB_Handle_t handle, UInt8 pipeRef, const void *buffer, UInt32 size, UInt16 timeout) {
+    const UInt8 *data = (const UInt8*)buffer;
+    UInt8 frame[SIM_FRAME_SIZE];
+    UInt32 offset, packet, i, starts;
+    int ret = 0;
+
+    /* must be initialized */
+    if (!fInitialized)
+        return CANUSB_ERROR_NOTINIT;
+    /* must be a valid handle */
+    if (!IS_HANDLE_VALID(handle))
+        return CANUSB_ERROR_HANDLE;
+    /* check for NULL pointer */
+    if (!buffer)
+        return CANUSB_ERROR_NULLPTR;
+    /* the device has only one OUT pipe */
+    if (pipeRef != TOUCAN_USB_TX_DATA_PIPE_REF)
+        return CANUSB_ERROR_RESOURCE;
+    /* note: the device takes its time (flow control), a time-out is not simulated */
+    (void)timeout;
+
+    ENTER_CRITICAL_SECTION();
+    if (usbDevice[handle].fPresent && usbDevice[handle].fOpened) {
+        /* note: the rest of a transfer is discarded when the controller is restarted meanwhile */
+        starts = usbDevice[handle].can.starts;
+        /* each USB packet holds up to 3 CAN frames (the rest of the packet is padding) */
+        for (offset = 0U; (offset < size) && (ret == 0); offset += SIM_PACKET_SIZE) {
+            packet = ((size - offset) < SIM_PACKET_SIZE) ? (size - offset) : SIM_PACKET_SIZE;
+            for (i = 0U; ((i + 1U) * SIM_FRAME_SIZE <= packet) && (ret == 0) &&
+                         (usbDevice[handle].can.starts == starts); i++) {
+                memcpy(frame, &data[offset + (i * SIM_FRAME_SIZE)], SIM_TIMESTAMP);
+                memset(&frame[SIM_TIMESTAMP], 0, SIM_FRAME_SIZE - SIM_TIMESTAMP);
+                if (frame[5] > CAN_MAX_DLC)
+                    frame[5] = CAN_MAX_DLC;
+                ret = TransmitFrame((CANUSB_Index_t)handle, frame);
+            }
+        }
+        (void)pthread_cond_signal(&usbDriver.ptCond);
+    } else {
+        MACCAN_DEBUG_ERROR("+++ Sorry, device #%i is not opened or not available (WritePipe)\n", handle);
+        ret = !usbDevice[handle].fPresent ? CANUSB_ERROR_HANDLE : CANUSB_ERROR_NOTINIT;
+    }
+    LEAVE_CRITICAL_SECTION();
+    return ret;
+}
+
+CANUSB_Return_t CANUSB_ResetPipe(CANUSB_Handle_t handle, UInt8 pipeRef) {
+    int ret = 0;
+
+    /* must be initialized */
+    if (!fInitialized)
+        return CANUSB_ERROR_NOTINIT;
+    /* must be a valid handle */
+    if (!IS_HANDLE_VALID(handle))
+        return CANUSB_ERROR_HANDLE;
+    /* the device has one OUT pipe and one IN pipe */
+    if ((pipeRef != TOUCAN_USB_TX_DATA_PIPE_REF) && (pipeRef != TOUCAN_USB_RX_DATA_PIPE_REF))
+        return CANUSB_ERROR_RESOURCE;
+
+    /* note: a simulated pipe never stalls */
+    ENTER_CRITICAL_SECTION();
+    if (!usbDevice[handle].fPresent || !usbDevice[handle].fOpened)
+        ret = !usbDevice[handle].fPresent ? CANUSB_ERROR_HANDLE : CANUSB_ERROR_NOTINIT;
+    LEAVE_CRITICAL_SECTION();
+    return ret;
+}
+
+CANUSB_AsyncPipe_t CANUSB_CreatePipeAsync(CANUSB_Handle_t handle, UInt8 pipeRef, size_t bufferSize) {
+    /* note: two buffers for compatibility reasons (both are submitted) */
+    return CANUSB_CreatePipeAsyncEx(handle, pipeRef, bufferSize, 2U);
+}
+
+CANUSB_AsyncPipe_t CANUSB_CreatePipeAsyncEx(CANUSB_Handle_t handle, UInt8 pipeRef, size_t bufferSize, UInt32 depth) {
+    CANUSB_AsyncPipe_t asyncPipe = NULL;
+    UInt32 i;
+
+    /* must be initialized */
+    if (!fInitialized)
+        return NULL;
+    /* must be a valid handle */
+    if (!IS_HANDLE_VALID(handle))
+        return NULL;
+    /* check for valid parameters */
+    if (!bufferSize || (depth < 1U) || (depth > CANUSB_MAX_PIPE_DEPTH))
+        return NULL;
+
+    /* create asynchronous pipe context with a ring of buffers */
+    if ((asyncPipe = (CANUSB_AsyncPipe_t)calloc(1U, sizeof(struct usb_async_pipe_tag))) == NULL) {
+        MACCAN_DEBUG_ERROR("+++ Unable to create asynchronous pipe context for endpoint #%u\n", pipeRef);
+        return NULL;
+    }
+    if ((asyncPipe->buffer.data = (UInt8**)calloc(depth, sizeof(UInt8*))) != NULL) {
+        for (i = 0U; i < depth; i++) {
+            if ((asyncPipe->buffer.data[i] = malloc(bufferSize)) == NULL)
+                break;
+        }
+        asyncPipe->buffer.depth = i;
+    }
+    if (asyncPipe->buffer.data && (asyncPipe->buffer.depth == depth)) {
+        asyncPipe->buffer.size = (UInt32)bufferSize;
+        asyncPipe->pipeRef = pipeRef;
+        asyncPipe->handle = handle;
+    } else {
+        MACCAN_DEBUG_ERROR("+++ Unable to create %u buffer(s) (%zu bytes each) for endpoint #%u\n", depth, bufferSize, pipeRef);
+        if (asyncPipe->buffer.data) {
+            for (i = 0U; i < asyncPipe->buffer.depth; i++)
+                free(asyncPipe->buffer.data[i]);
+            free(asyncPipe->buffer.data);
+        }
+        free(asyncPipe);
+        asyncPipe = NULL;
+    }
+    return asyncPipe;
+}
+
+CANUSB_Return_t CANUSB_DestroyPipeAsync(CANUSB_AsyncPipe_t asyncPipe) {
+    UInt32 i;
+
+    /* must be initialized */
+    if (!fInitialized)
+        return CANUSB_ERROR_NOTINIT;
+    /* check for NULL pointer */
+    if (!asyncPipe)
+        return CANUSB_ERROR_NULLPTR;
+    /* must be a valid handle */
+    if (!IS_HANDLE_VALID(asyncPipe->handle))
+        return CANUSB_ERROR_HANDLE;
+
+    /* stop the read, if running, and wait for the callback, if any */
+    ENTER_CRITICAL_SECTION();
+    asyncPipe->running = false;
+    if (usbDevice[asyncPipe->handle].recvPipe == asyncPipe)
+        usbDevice[asyncPipe->handle].recvPipe = NULL;
+    WaitForCallback(asyncPipe);
+    LEAVE_CRITICAL_SECTION();
+
+    /* free the ring of buffers and asynchronous pipe context */
+    if (asyncPipe->buffer.data) {
+        for (i = 0U; i < asyncPipe->buffer.depth; i++)
+            free(asyncPipe->buffer.data[i]);
+        free(asyncPipe->buffer.data);
+    }
+    free(asyncPipe);
+    return CANUSB_SUCCESS;
+}
+
+CANUSB_Return_t CANUSB_ReadPipeAsync(CANUSB_AsyncPipe_t asyncPipe, CANUSB_AsyncPipeCbk_t callback, CANUSB_Context_t context) {
+    USBDevice_t *device;
+    int ret = 0;
+
+    /* must be initialized */
+    if (!fInitialized)
+        return CANUSB_ERROR_NOTINIT;
+    /* check for NULL pointer */
+    if (!asyncPipe ||
+        !asyncPipe->buffer.data)
+        return CANUSB_ERROR_NULLPTR;
+    /* must be a valid handle */
+    if (!IS_HANDLE_VALID(asyncPipe->handle))
+        return CANUSB_ERROR_HANDLE;
+    /* the device has only one IN pipe */
+    if (asyncPipe->pipeRef != TOUCAN_USB_RX_DATA_PIPE_REF)
+        return CANUSB_ERROR_RESOURCE;
+
+    ENTER_CRITICAL_SECTION();
+    device = &usbDevice[asyncPipe->handle];
+    if (asyncPipe->running || asyncPipe->inCallback || (device->recvPipe && (device->recvPipe != asyncPipe))) {
+        MACCAN_DEBUG_ERROR("+++ Async read of pipe #%d already started\n", asyncPipe->pipeRef);
+        ret = CANUSB_ERROR_RESOURCE;
+    } else if (device->fPresent && device->fOpened) {
+        /* all buffers are submitted at once (the bus thread completes them one after the other) */
+        asyncPipe->callback = callback;
+        asyncPipe->context = context;
+        asyncPipe->buffer.index = 0U;
+        asyncPipe->buffer.pending = asyncPipe->buffer.depth;
+        asyncPipe->running = true;
+        device->recvPipe = asyncPipe;
+        (void)pthread_cond_signal(&usbDriver.ptCond);
+    } else {
+        MACCAN_DEBUG_ERROR("+++ Sorry, device #%i is not opened or not available (ReadPipeAsync)\n", asyncPipe->handle);
+        ret = !device->fPresent ? CANUSB_ERROR_HANDLE : CANUSB_ERROR_NOTINIT;
+    }
+    LEAVE_CRITICAL_SECTION();
+    return ret;
+}
+
+CANUSB_Return_t CANUSB_AbortPipeAsync(CANUSB_AsyncPipe_t asyncPipe) {
+    int ret = 0;
+
+    /* must be initialized */
+    if (!fInitialized)
+        return CANUSB_ERROR_NOTINIT;
+    /* check for NULL pointer */
+    if (!asyncPipe)
+        return CANUSB_ERROR_NULLPTR;
+    /* must be a valid handle */
+    if (!IS_HANDLE_VALID(asyncPipe->handle))
+        return CANUSB_ERROR_HANDLE;
+
+    /* note: the read is stopped even if the device has gone in the meantime */
+    ENTER_CRITICAL_SECTION();
+    asyncPipe->running = false;
+    asyncPipe->buffer.pending = 0U;
+    if (usbDevice[asyncPipe->handle].recvPipe == asyncPipe)
+        usbDevice[asyncPipe->handle].recvPipe = NULL;
+    WaitForCallback(asyncPipe);
+    if (!usbDevice[asyncPipe->handle].fPresent || !usbDevice[asyncPipe->handle].fOpened)
+        ret = !usbDevice[asyncPipe->handle].fPresent ? CANUSB_ERROR_HANDLE : CANUSB_ERROR_NOTINIT;
+    LEAVE_CRITICAL_SECTION();
+    return ret;
+}
+
+Boolean CANUSB_IsPipeAsyncRunning(CANUSB_AsyncPipe_t asyncPipe) {
+    Boolean running = false;
+
+    /* must be initialized */
+    if (!fInitialized)
+        return false;
+    /* check for NULL pointer */
+    if (!asyncPipe)
+        return false;
+    /* must be a valid handle */
+    if (!IS_HANDLE_VALID(asyncPipe->handle))
+        return false;
+
+    /* return true if asynchronous operation is running, false otherwise */
+    ENTER_CRITICAL_SECTION();
+    running = asyncPipe->running;
+    LEAVE_CRITICAL_SECTION();
+    return running;
+}
+
+CANUSB_Return_t CANUSB_GetPipeAsyncStats(CANUSB_AsyncPipe_t asyncPipe, CANUSB_PipeStats_t *stats) {
+
+    /* must be initialized */
+    if (!fInitialized)
+        return CANUSB_ERROR_NOTINIT;
+    /* check for NULL pointer */
+    if (!asyncPipe || !stats)
+        return CANUSB_ERROR_NULLPTR;
+    /* must be a valid handle */
+    if (!IS_HANDLE_VALID(asyncPipe->handle))
+        return CANUSB_ERROR_HANDLE;
+
+    ENTER_CRITICAL_SECTION();
+    stats->depth = asyncPipe->buffer.depth;
+    stats->size = asyncPipe->buffer.size;
+    stats->pending = asyncPipe->buffer.pending;
+    stats->transfers = asyncPipe->xferCounter;
+    stats->dryRuns = asyncPipe->dryCounter;
+    stats->errors = asyncPipe->errCounter;
+    LEAVE_CRITICAL_SECTION();
+    return CANUSB_SUCCESS;
+}
+
+CANUSB_Index_t CANUSB_GetFirstDevice(void) {
+    /* must be initialized */
+    if (!fInitialized)
+        return CANUSB_INVALID_INDEX;
+
+    /* get the first registered device, if any */
+    idxDevice = -1;
+    return CANUSB_GetNextDevice();
+}
+
+CANUSB_Index_t CANUSB_GetNextDevice(void) {
+    CANUSB_Index_t index = CANUSB_INVALID_INDEX;
+
+    /* must be initialized */
+    if (!fInitialized)
+        return CANUSB_INVALID_INDEX;
+
+    /* get the next registered device, if any */
+    ENTER_CRITICAL_SECTION();
+    if (idxDevice < CANUSB_MAX_DEVICES)
+        idxDevice += 1;
+    while (idxDevice < CANUSB_MAX_DEVICES) {
+        if (usbDevice[idxDevice].fPresent) {
+            index = idxDevice;
+            break;
+        }
+        idxDevice++;
+    }
+    LEAVE_CRITICAL_SECTION();
+    return index;
+}
+
+Boolean CANUSB_IsDevicePresent(CANUSB_Index_t index) {
+    Boolean ret = false;
+
+    /* must be initialized */
+    if (!fInitialized)
+        return false;
+    /* must be a valid index */
+    if (!IS_INDEX_VALID(index))
+        return false;
+
+    ENTER_CRITICAL_SECTION();
+    ret = usbDevice[index].fPresent;
+    LEAVE_CRITICAL_SECTION();
+    return ret;
+}
+
+Boolean CANUSB_IsDeviceInUse(CANUSB_Index_t index) {
+    /* note: the simulated devices are not shared with other processes */
+    return CANUSB_IsDeviceOpened(index);
+}
+
+Boolean CANUSB_IsDeviceOpened(CANUSB_Index_t index) {
+    Boolean ret = false;
+
+    /* must be initialized */
+    if (!fInitialized)
+        return false;
+    /* must be a valid index */
+    if (!IS_INDEX_VALID(index))
+        return false;
+
+    ENTER_CRITICAL_SECTION();
+    ret = (usbDevice[index].fPresent && usbDevice[index].fOpened) ? true : false;
+    LEAVE_CRITICAL_SECTION();
+    return ret;
+}
+
+/* note: the device properties are read like in the USB kit (from a present device) */
+#define GET_DEVICE_PROPERTY(index, expr)  do { \
+    int ret = 0; \
+    if (!fInitialized) \
+        return CANUSB_ERROR_NOTINIT; \
+    if (!IS_INDEX_VALID(index)) \
+        return CANUSB_ERROR_HANDLE; \
+    if (!value) \
+        return CANUSB_ERROR_NULLPTR; \
+    ENTER_CRITICAL_SECTION(); \
+    if (usbDevice[index].fPresent) \
+        expr; \
+    else \
+        ret = CANUSB_ERROR_HANDLE; \
+    LEAVE_CRITICAL_SECTION(); \
+    return ret; \
+} while (0)
+
+/* note: the interface properties are read from an opened device */
+#define GET_INTERFACE_PROPERTY(handle, expr)  do { \
+    int ret = 0; \
+    if (!fInitialized) \
+        return CANUSB_ERROR_NOTINIT; \
+    if (!IS_HANDLE_VALID(handle)) \
+        return CANUSB_ERROR_HANDLE; \
+    if (!value) \
+        return CANUSB_ERROR_NULLPTR; \
+    ENTER_CRITICAL_SECTION(); \
+    if (usbDevice[handle].fPresent && usbDevice[handle].fOpened) \
+        expr; \
+    else \
+        ret = !usbDevice[handle].fPresent ? CANUSB_ERROR_HANDLE : CANUSB_ERROR_NOTINIT; \
+    LEAVE_CRITICAL_SECTION(); \
+    return ret; \
+} while (0)
+
+CANUSB_Return_t CANUSB_GetDeviceUsbName(CANUSB_Index_t index, char *buffer, size_t n) {
+    char *value = buffer;
+
+    if (!n)
+        return CANUSB_ERROR_ILLPARA;
+    GET_DEVICE_PROPERTY(index, (void)snprintf(value, n, "%s", usbDevice[index].szName));
+}
+
+CANUSB_Return_t CANUSB_GetDeviceVendorId(CANUSB_Index_t index, UInt16 *value) {
+    GET_DEVICE_PROPERTY(index, *value = usbDevice[index].u16VendorId);
+}
+
+CANUSB_Return_t CANUSB_GetDeviceProductId(CANUSB_Index_t index, UInt16 *value) {
+    GET_DEVICE_PROPERTY(index, *value = usbDevice[index].u16ProductId);
+}
+
+CANUSB_Return_t CANUSB_GetDeviceReleaseNo(CANUSB_Index_t index, UInt16 *value) {
+    GET_DEVICE_PROPERTY(index, *value = usbDevice[index].u16ReleaseNo);
+}
+
+CANUSB_Return_t CANUSB_GetDeviceLocation(CANUSB_Index_t index, UInt32 *value) {
+    GET_DEVICE_PROPERTY(index, *value = usbDevice[index].u32Location);
+}
+
+CANUSB_Return_t CANUSB_GetDeviceAddress(CANUSB_Index_t index, UInt16 *value) {
+    GET_DEVICE_PROPERTY(index, *value = usbDevice[index].u16Address);
+}
+
+CANUSB_Return_t CANUSB_GetDeviceNumCanChannels(CANUSB_Index_t index, UInt8 *value) {
+    GET_DEVICE_PROPERTY(index, *value = usbDevice[index].nCanChannels);
+}
+
+CANUSB_Return_t CANUSB_GetDeviceCanChannelsOpened(CANUSB_Index_t index, UInt8 *value) {
+    GET_DEVICE_PROPERTY(index, *value = usbDevice[index].fOpened ? 1U : 0U);
+}
+
+CANUSB_Return_t CANUSB_GetInterfaceClass(CANUSB_Handle_t handle, UInt8 *value) {
+    GET_INTERFACE_PROPERTY(handle, *value = 0xFFU);  /* vendor specific */
+}
+
+CANUSB_Return_t CANUSB_GetInterfaceSubClass(CANUSB_Handle_t handle, UInt8 *value) {
+    GET_INTERFACE_PROPERTY(handle, *value = 0x00U);
+}
+
+CANUSB_Return_t CANUSB_GetInterfaceProtocol(CANUSB_Handle_t handle, UInt8 *value) {
+    GET_INTERFACE_PROPERTY(handle, *value = 0x00U);
+}
+
+CANUSB_Return_t CANUSB_GetInterfaceNumEndpoints(CANUSB_Handle_t handle, UInt8 *value) {
+    GET_INTERFACE_PROPERTY(handle, *value = TOUCAN_USB_NUM_ENDPOINTS);
+}
+
+CANUSB_Return_t CANUSB_GetInterfaceEndpointDirection(CANUSB_Handle_t handle, UInt8 index, UInt8 *value) {
+    if ((index != TOUCAN_USB_TX_DATA_PIPE_REF) && (index != TOUCAN_USB_RX_DATA_PIPE_REF))
+        return CANUSB_ERROR_RESOURCE;
+    GET_INTERFACE_PROPERTY(handle, *value = (index == TOUCAN_USB_RX_DATA_PIPE_REF) ? USBPIPE_DIR_IN : USBPIPE_DIR_OUT);
+}
+
+CANUSB_Return_t CANUSB_GetInterfaceEndpointTransferType(CANUSB_Handle_t handle, UInt8 index, UInt8 *value) {
+    if ((index != TOUCAN_USB_TX_DATA_PIPE_REF) && (index != TOUCAN_USB_RX_DATA_PIPE_REF))
+        return CANUSB_ERROR_RESOURCE;
+    GET_INTERFACE_PROPERTY(handle, *value = USBPIPE_TYPE_BULK);
+}
+
+CANUSB_Return_t CANUSB_GetInterfaceEndpointMaxPacketSize(CANUSB_Handle_t handle, UInt8 index, UInt16 *value) {
+    if ((index != TOUCAN_USB_TX_DATA_PIPE_REF) && (index != TOUCAN_USB_RX_DATA_PIPE_REF))
+        return CANUSB_ERROR_RESOURCE;
+    GET_INTERFACE_PROPERTY(handle, *value = (index == TOUCAN_USB_RX_DATA_PIPE_REF) ? TOUCAN_USB_RX_DATA_PIPE_SIZE : TOUCAN_USB_TX_DATA_PIPE_SIZE);
+}
+
+UInt32 CANUSB_GetVersion(void) {
+    return ((UInt32)VERSION_MAJOR << 24) |
+           ((UInt32)VERSION_MINOR << 16) |
+           ((UInt32)VERSION_PATCH << 8);
+}
+
+UInt32 CANUSB_GetRevision(void) {
+    return 0U;
+}
+
+CANUSB_Index_t TouCAN_SimAttachDevice(UInt8 bus) {
+    CANUSB_Index_t index;
+
+    if (!fInitialized)
+        return CANUSB_INVALID_INDEX;
+    if (!IS_BUS_VALID(bus))
+        return CANUSB_INVALID_INDEX;
+
+    ENTER_CRITICAL_SECTION();
+    index = AttachDevice(bus);
+    LEAVE_CRITICAL_SECTION();
+    return index;
+}
+
+CANUSB_Return_t TouCAN_SimDetachDevice(CANUSB_Index_t index) {
+    int ret = 0;
+
+    if (!fInitialized)
+        return CANUSB_ERROR_NOTINIT;
+    if (!IS_INDEX_VALID(index))
+        return CANUSB_ERROR_HANDLE;
+
+    /* note: the driver sees the device gone with its next request */
+    ENTER_CRITICAL_SECTION();
+    if (usbDevice[index].fPresent)
+        DetachDevice(index);
+    else
+        ret = CANUSB_ERROR_HANDLE;
+    LEAVE_CRITICAL_SECTION();
+    return ret;
+}
+
+CANUSB_Return_t TouCAN_SimSetTraffic(UInt8 bus, UInt8 slot, const TouCAN_SimTraffic_t *traffic) {
+    int ret;
+
+    if (!fInitialized)
+        return CANUSB_ERROR_NOTINIT;
+
+    ENTER_CRITICAL_SECTION();
+    ret = SetTraffic(bus, slot, traffic);
+    (void)pthread_cond_signal(&usbDriver.ptCond);
+    LEAVE_CRITICAL_SECTION();
+    return ret;
+}
+
+CANUSB_Return_t TouCAN_SimSetRealTime(UInt8 bus, Boolean realTime) {
+    if (!fInitialized)
+        return CANUSB_ERROR_NOTINIT;
+    if (!IS_BUS_VALID(bus))
+        return CANUSB_ERROR_ILLPARA;
+
+    ENTER_CRITICAL_SECTION();
+    simBus[bus].realTime = realTime;
+    simBus[bus].busyUntil = 0U;
+    LEAVE_CRITICAL_SECTION();
+    return CANUSB_SUCCESS;
+}
+
+CANUSB_Return_t TouCAN_SimGetStatistics(UInt8 bus, TouCAN_SimStatistics_t *statistics) {
+    if (!fInitialized)
+        return CANUSB_ERROR_NOTINIT;
+    if (!IS_BUS_VALID(bus))
+        return CANUSB_ERROR_ILLPARA;
+    if (!statistics)
+        return CANUSB_ERROR_NULLPTR;
+
+    ENTER_CRITICAL_SECTION();
+    *statistics = simBus[bus].stats;
+    LEAVE_CRITICAL_SECTION();
+    return CANUSB_SUCCESS;
+}
+
+/*  ---  bus thread  -------------------------------------------------------
+ */
+static void *BusThread(void *arg) {
+    CANUSB_AsyncPipe_t pipes[CANUSB_MAX_DEVICES];
+    UInt8 *buffers[CANUSB_MAX_DEVICES];
+    UInt32 lengths[CANUSB_MAX_DEVICES];
+    UInt32 count, i;
+    UInt64 now, next, due;
+    CANUSB_Index_t index;
+    CANUSB_AsyncPipe_t pipe;
+    USBDevice_t *device;
+    UInt8 bus;
+
+    (void)arg;
+    ENTER_CRITICAL_SECTION();
+    while (usbDriver.fRunning) {
+        now = MacCAN_GetTime();
+        next = now + SIM_MAX_SLEEP;
+        /* the traffic generators send their bursts when their time has come */
+        for (bus = 0U; bus < TOUCAN_SIM_MAX_BUSES; bus++) {
+            due = GenerateTraffic(bus, now);
+            if (due < next)
+                next = due;
+        }
+        /* a submitted read is completed with the CAN frames whose transmission has ended */
+        count = 0U;
+        for (index = 0; index < CANUSB_MAX_DEVICES; index++) {
+            device = &usbDevice[index];
+            pipe = device->recvPipe;
+            if (!device->fPresent || !pipe || !pipe->running || pipe->inCallback || !device->fifoCount)
+                continue;
+            due = device->fifo[device->fifoHead].due;
+            if (due > now) {
+                if (due < next)
+                    next = due;
+                continue;
+            }
+            buffers[count] = pipe->buffer.data[pipe->buffer.index];
+            lengths[count] = FillTransfer(device, buffers[count], pipe->buffer.size, now);
+            pipe->buffer.index = (pipe->buffer.index + 1U) % pipe->buffer.depth;
+            if (--pipe->buffer.pending == 0U)
+                pipe->dryCounter++;
+            pipe->xferCounter++;
+            pipe->inCallback = true;
+            pipes[count++] = pipe;
+        }
+        if (count) {
+            /* call the callbacks w/o holding the lock (one after the other) */
+            LEAVE_CRITICAL_SECTION();
+            for (i = 0U; i < count; i++) {
+                if (pipes[i]->callback && lengths[i])
+                    pipes[i]->callback(pipes[i]->context, buffers[i], lengths[i]);
+            }
+            ENTER_CRITICAL_SECTION();
+            /* the buffers are resubmitted, unless the read was aborted in the meantime */
+            for (i = 0U; i < count; i++) {
+                pipes[i]->inCallback = false;
+                if (pipes[i]->running)
+                    pipes[i]->buffer.pending++;
+            }
+            /* note: more CAN frames could be due, look again */
+            continue;
+        }
+        /* sleep until the next CAN frame is due, or until something has changed */
+        (void)MacCAN_TimedWaitUntil(&usbDriver.ptCond, &usbDriver.ptMutex, next);
+    }
+    LEAVE_CRITICAL_SECTION();
+    return NULL;
+}
+
+/*  ---  devices and buses (the mutex is held)  ---------------------------
+ */
+static CANUSB_Index_t AttachDevice(UInt8 bus) {
+    CANUSB_Index_t index;
+    USBDevice_t *device;
+    SimFrame_t *fifo;
+
+    for (index = 0; index < CANUSB_MAX_DEVICES; index++) {
+        if (usbDevice[index].fPresent)
+            continue;
+        if ((fifo = (SimFrame_t*)calloc(TOUCAN_SIM_RCV_FIFO_SIZE, sizeof(SimFrame_t))) == NULL) {
+            MACCAN_DEBUG_ERROR("+++ Unable to attach a simulated device (NULL pointer)\n");
+            return CANUSB_INVALID_INDEX;
+        }
+        device = &usbDevice[index];
+        memset(device, 0, sizeof(USBDevice_t));
+        (void)snprintf(device->szName, TOUCAN_MAX_NAME_LENGTH, "%s", SIM_DEVICE_NAME);
+        device->u16VendorId = TOUCAN_VENDOR_ID;
+        device->u16ProductId = TOUCAN_USB_ID;
+        device->u16ReleaseNo = SIM_RELEASE_NO;
+        device->nCanChannels = TOUCAN_USB_NUM_CHANNELS;
+        device->u32Location = ((UInt32)bus << 24) | (UInt32)(index + 1);
+        device->u16Address = (UInt16)(index + 1);
+        device->bus = bus;
+        device->clockOffset = SIM_CLOCK_SKEW + (UInt32)index;
+        device->can.state = HAL_CAN_STATE_RESET;
+        device->can.lastError = HAL_OK;
+        device->can.filter11.type = FILTER_ACCEPT_ALL;
+        device->can.filter29.type = FILTER_ACCEPT_ALL;
+        device->fifo = fifo;
+        device->fPresent = true;
+        MACCAN_DEBUG_CORE("      - Device #%i: %s (bus %u)\n", index, device->szName, bus);
+        return index;
+    }
+    return CANUSB_INVALID_INDEX;
+}
+
+static void DetachDevice(CANUSB_Index_t index) {
+    USBDevice_t *device = &usbDevice[index];
+
+    if (!device->fPresent)
+        return;
+    /* note: the pipe belongs to the driver, it is only stopped */
+    if (device->recvPipe) {
+        device->recvPipe->running = false;
+        device->recvPipe = NULL;
+    }
+    free(device->fifo);
+    device->fifo = NULL;
+    device->fifoCount = 0U;
+    device->fOpened = false;
+    device->fPresent = false;
+}
+
+static void ConfigureFromEnvironment(void) {
+    TouCAN_SimTraffic_t traffic;
+    unsigned int period = 0U, burst = 1U, range = 1U, dlc = 8U, xtd = 0U;
+    unsigned long devices = TOUCAN_SIM_DEVICES;
+    int canId = 0x100;
+    const char *value;
+    UInt8 bus;
+
+    if ((value = getenv("TOUCAN_SIM_DEVICES")) != NULL)
+        devices = strtoul(value, NULL, 0);
+    for (unsigned long i = 0U; (i < devices) && (i < CANUSB_MAX_DEVICES); i++)
+        (void)AttachDevice(0U);
+    if ((value = getenv("TOUCAN_SIM_REALTIME")) != NULL) {
+        for (bus = 0U; bus < TOUCAN_SIM_MAX_BUSES; bus++)
+            simBus[bus].realTime = (strtol(value, NULL, 0) != 0) ? true : false;
+    }
+    if ((value = getenv("TOUCAN_SIM_TRAFFIC")) != NULL) {
+        /* <period>[:<burst>[:<id>[:<range>[:<dlc>[:<xtd>]]]]] */
+        if (sscanf(value, "%u:%u:%i:%u:%u:%u", &period, &burst, &canId, &range, &dlc, &xtd) >= 1) {
+            traffic.period = (UInt32)period;
+            traffic.burst = (UInt32)burst;
+            traffic.canId = (UInt32)canId;
+            traffic.idRange = (UInt32)range;
+            traffic.dlc = (UInt8)dlc;
+            traffic.xtd = xtd ? true : false;
+            if (SetTraffic(0U, 0U, &traffic) != CANUSB_SUCCESS)
+                MACCAN_DEBUG_ERROR("+++ Invalid traffic generator (TOUCAN_SIM_TRAFFIC=%s)\n", value);
+        }
+    }
+}
+
+static CANUSB_Return_t SetTraffic(UInt8 bus, UInt8 slot, const TouCAN_SimTraffic_t *traffic) {
+    SimGenerator_t *generator;
+
+    if (!IS_BUS_VALID(bus) || (slot >= TOUCAN_SIM_MAX_TRAFFIC))
+        return CANUSB_ERROR_ILLPARA;
+    generator = &simBus[bus].generator[slot];
+    /* a NULL pointer (or a period of zero) switches the generator off */
+    if (!traffic || !traffic->period) {
+        memset(generator, 0, sizeof(SimGenerator_t));
+        return CANUSB_SUCCESS;
+    }
+    if (!traffic->burst || (traffic->dlc > CAN_MAX_DLC))
+        return CANUSB_ERROR_ILLPARA;
+    if (traffic->canId > (traffic->xtd ? CAN_MAX_XTD_ID : CAN_MAX_STD_ID))
+        return CANUSB_ERROR_ILLPARA;
+    generator->traffic = *traffic;
+    if (!generator->traffic.idRange)
+        generator->traffic.idRange = 1U;
+    generator->nextTime = MacCAN_GetTime();
+    generator->counter = 0U;
+    /* a traffic generator acknowledges the pending CAN frames */
+    RetransmitFrames(bus, generator->nextTime);
+    return CANUSB_SUCCESS;
+}
+
+static CANUSB_Return_t ProcessRequest(USBDevice_t *device, const CANUSB_SetupPacket_t *setup, UInt8 *data, UInt16 size, UInt32 *transferred) {
+    SimController_t *can = &device->can;
+    UInt8 reply[32];
+    UInt32 length = 0U;
+    UInt16 request = setup->Length < size ? setup->Length : size;
+    Boolean input = (setup->RequestType & USBREQ_DEVICE_TO_HOST) ? true : false;
+    UInt8 result = HAL_OK;
+    UInt32 tseg1, tseg2, sjw, brp;
+    SimFilter_t *filter;
+
+    memset(reply, 0, sizeof(reply));
+    switch (setup->Request) {
+    case TouCAN_RESET:
+        can->state = HAL_CAN_STATE_RESET;
+        can->errorCode = HAL_CAN_ERROR_NONE;
+        can->pending = 0U;
+        device->fifoCount = 0U;
+        break;
+    case TouCAN_CAN_INTERFACE_INIT:
+        if ((request < 9U) || !data) {
+            result = HAL_ERROR;
+            can->errorCode |= HAL_CAN_ERROR_PARAM;
+            break;
+        }
+        if (can->state == HAL_CAN_STATE_LISTENING) {
+            result = HAL_ERROR;
+            can->errorCode |= HAL_CAN_ERROR_NOT_READY;
+            break;
+        }
+        tseg1 = data[0];
+        tseg2 = data[1];
+        sjw = data[2];
+        brp = ((UInt32)data[3] << 8) | (UInt32)data[4];
+        if ((brp < 1U) || (brp > 1024U) || (tseg1 < 1U) || (tseg1 > 16U) ||
+            (tseg2 < 1U) || (tseg2 > 8U) || (sjw < 1U) || (sjw > 4U)) {
+            result = HAL_ERROR;
+            can->errorCode |= HAL_CAN_ERROR_PARAM;
+            break;
+        }
+        /* note: the device accepts all CAN frames after its initialization */
+        can->flags = GetUInt32(&data[5]);
+        can->bitrate = (TOUCAN_USB_CPU_FREQUENCY * 1000000U) / (brp * (1U + tseg1 + tseg2));
+        can->txErrors = 0U;
+        can->rxErrors = 0U;
+        can->busStatus = TOUCAN_STS_OK;
+        can->busOff = false;
+        can->errorCode = HAL_CAN_ERROR_NONE;
+        can->filter11.type = FILTER_ACCEPT_ALL;
+        can->filter29.type = FILTER_ACCEPT_ALL;
+        can->pending = 0U;
+        can->state = HAL_CAN_STATE_READY;
+        break;
+    case TouCAN_CAN_INTERFACE_DEINIT:
+        can->state = HAL_CAN_STATE_RESET;
+        can->errorCode = HAL_CAN_ERROR_NONE;
+        can->pending = 0U;
+        break;
+    case TouCAN_CAN_INTERFACE_START:
+        if (can->state != HAL_CAN_STATE_READY) {
+            result = HAL_ERROR;
+            can->errorCode |= HAL_CAN_ERROR_NOT_READY;
+            break;
+        }
+        can->state = HAL_CAN_STATE_LISTENING;
+        can->starts++;
+        /* the CAN frames w/o acknowledge of the other devices are retransmitted */
+        RetransmitFrames(device->bus, MacCAN_GetTime());
+        break;
+    case TouCAN_CAN_INTERFACE_STOP:
+        if (can->state != HAL_CAN_STATE_LISTENING) {
+            result = HAL_ERROR;
+            can->errorCode |= HAL_CAN_ERROR_NOT_STARTED;
+            break;
+        }
+        /* note: the transmit mailboxes are aborted */
+        can->pending = 0U;
+        can->state = HAL_CAN_STATE_READY;
+        break;
+    case TouCAN_FILTER_STD_ACCEPT_ALL:
+        can->filter11.type = FILTER_ACCEPT_ALL;
+        break;
+    case TouCAN_FILTER_STD_REJECT_ALL:
+        can->filter11.type = FILTER_REJECT_ALL;
+        break;
+    case TouCAN_FILTER_EXT_ACCEPT_ALL:
+        can->filter29.type = FILTER_ACCEPT_ALL;
+        break;
+    case TouCAN_FILTER_EXT_REJECT_ALL:
+        can->filter29.type = FILTER_REJECT_ALL;
+        break;
+    case TouCAN_SET_FILTER_STD_LIST_MASK:
+    case TouCAN_SET_FILTER_EXT_LIST_MASK:
+        filter = (setup->Request == TouCAN_SET_FILTER_STD_LIST_MASK) ? &can->filter11 : &can->filter29;
+        if ((request < 9U) || !data || (data[0] > FILTER_VALUE)) {
+            result = HAL_ERROR;
+            can->errorCode |= HAL_CAN_ERROR_PARAM;
+            break;
+        }
+        filter->type = data[0];
+        filter->code = GetUInt32(&data[1]);
+        filter->mask = GetUInt32(&data[5]);
+        break;
+    case TouCAN_GET_FILTER_STD_LIST_MASK:
+    case TouCAN_GET_FILTER_EXT_LIST_MASK:
+        filter = (setup->Request == TouCAN_GET_FILTER_STD_LIST_MASK) ? &can->filter11 : &can->filter29;
+        reply[0] = filter->type;
+        PutUInt32(&reply[1], filter->code);
+        PutUInt32(&reply[5], filter->mask);
+        length = 9U;
+        break;
+    case TouCAN_GET_CAN_ERROR_STATUS:
+        if (!input) {  /* TouCAN_CLEAR_CAN_ERROR_STATUS */
+            result = HAL_ERROR;
+            break;
+        }
+        /* like the error status register of the bxCAN (REC, TEC, BOFF, EPVF, EWGF) */
+        PutUInt32(reply, ((UInt32)can->rxErrors << 24) | ((UInt32)can->txErrors << 16) |
+                         (can->busOff ? 0x04U : 0x00U) |
+                         ((can->txErrors >= 128U) || (can->rxErrors >= 128U) ? 0x02U : 0x00U) |
+                         ((can->txErrors >= 96U) || (can->rxErrors >= 96U) ? 0x01U : 0x00U));
+        length = 4U;
+        break;
+    case TouCAN_GET_HARDWARE_VERSION:
+        PutUInt32(reply, SIM_HARDWARE_VERSION);
+        length = 4U;
+        break;
+    case TouCAN_GET_FIRMWARE_VERSION:
+        PutUInt32(reply, SIM_FIRMWARE_VERSION);
+        length = 4U;
+        break;
+    case TouCAN_GET_BOOTLOADER_VERSION:
+        PutUInt32(reply, SIM_BOOTLOADER_VERSION);
+        length = 4U;
+        break;
+    case TouCAN_GET_SERIAL_NUMBER:
+        PutUInt32(reply, SIM_SERIAL_NUMBER + (UInt32)(device - usbDevice));
+        length = 4U;
+        break;
+    case TouCAN_GET_VID_PID:
+        PutUInt32(reply, ((UInt32)device->u16VendorId << 16) | (UInt32)device->u16ProductId);
+        length = 4U;
+        break;
+    case TouCAN_GET_DEVICE_ID:
+        PutUInt32(reply, SIM_DEVICE_ID);
+        length = 4U;
+        break;
+    case TouCAN_GET_VENDOR:
+        (void)snprintf((char*)reply, sizeof(reply), "%s", SIM_VENDOR_NAME);
+        length = 32U;
+        break;
+    case TouCAN_GET_LAST_ERROR_CODE:
+        reply[0] = can->lastError;
+        if (transferred)
+            *transferred = (request < 1U) ? request : 1U;
+        if (data && request)
+            data[0] = reply[0];
+        /* note: the result of the last request is not overwritten by this one */
+        return CANUSB_SUCCESS;
+    case TouCAN_CLEAR_LAST_ERROR_CODE:
+        break;
+    case TouCAN_GET_CAN_INTERFACE_STATE:
+        reply[0] = can->state;
+        length = 1U;
+        break;
+    case TouCAN_GET_CAN_INTERFACE_ERROR_CODE:
+        PutUInt32(reply, can->errorCode);
+        length = 4U;
+        break;
+    case TouCAN_CLEAR_CAN_INTERFACE_ERROR_CODE:
+        if ((can->state != HAL_CAN_STATE_READY) && (can->state != HAL_CAN_STATE_LISTENING)) {
+            result = HAL_ERROR;
+            can->errorCode |= HAL_CAN_ERROR_NOT_INITIALIZED;
+            break;
+        }
+        can->errorCode = HAL_CAN_ERROR_NONE;
+        break;
+    case TouCAN_SET_CAN_INTERFACE_DELAY:
+        if ((request < 4U) || !data) {
+            result = HAL_ERROR;
+            break;
+        }
+        can->delay = GetUInt32(data);
+        break;
+    case TouCAN_GET_CAN_INTERFACE_DELAY:
+        PutUInt32(reply, can->delay);
+        length = 4U;
+        break;
+    default:
+        /* note: the statistics and the clear-state request are not supported by the firmware either */
+        if ((setup->Request == TouCAN_GET_STATISTICS) || (setup->Request == TouCAN_CLEAR_STATISTICS) ||
+            (setup->Request == TouCAN_CLEAR_CAN_INTERFACE_STATE)) {
+            result = HAL_ERROR;
+            break;
+        }
+        return CANUSB_ERROR_RESOURCE;  /* stalled */
+    }
+    can->lastError = result;
+    if (input && length && data) {
+        length = (length < request) ? length : request;
+        memcpy(data, reply, length);
+    } else if (!input) {
+        length = request;
+    }
+    if (transferred)
+        *transferred = length;
+    return CANUSB_SUCCESS;
+}
+
+static CANUSB_Return_t TransmitFrame(CANUSB_Index_t index, const UInt8 *frame) {
+    USBDevice_t *device = &usbDevice[index];
+    SimController_t *can = &device->can;
+    SimBus_t *bus = &simBus[device->bus];
+    Boolean silent = (can->flags & TouCAN_ENABLE_SILENT_MODE) ? true : false;
+    Boolean loopback = (can->flags & TouCAN_ENABLE_LOOPBACK_MODE) ? true : false;
+    UInt64 now = MacCAN_GetTime();
+    UInt64 duration, due;
+    UInt32 starts = can->starts;
+
+    if (can->state != HAL_CAN_STATE_LISTENING) {
+        can->errorCode |= HAL_CAN_ERROR_NOT_STARTED;
+        return CANUSB_SUCCESS;  /* note: the device drops the CAN frame */
+    }
+    if (can->busOff)
+        return CANUSB_SUCCESS;  /* note: the device drops the CAN frame */
+    /* in silent mode nothing is sent to the bus (in loop-back mode it is received internally) */
+    if (silent && !loopback)
+        return CANUSB_SUCCESS;
+    due = now;
+    if (bus->realTime && !silent) {
+        /* flow control: the device takes a CAN frame when a transmit mailbox is free */
+        duration = ((UInt64)TouCAN_FrameBits((frame[0] & TOUCAN_MSG_XTD_FRAME) ? true : false,
+                                             (frame[0] & TOUCAN_MSG_RTR_FRAME) ? true : false,
+                                             GetUInt32(&frame[1]), frame[5], &frame[6]) * 1000000000U) / can->bitrate;
+        while (bus->busyUntil > (now + (SIM_TX_MAILBOXES * duration))) {
+            LEAVE_CRITICAL_SECTION();
+            (void)usleep((useconds_t)((bus->busyUntil - (now + (SIM_TX_MAILBOXES * duration))) / 1000U) + 1U);
+            ENTER_CRITICAL_SECTION();
+            if (!device->fPresent || !device->fOpened)
+                return CANUSB_ERROR_HANDLE;
+            if ((can->state != HAL_CAN_STATE_LISTENING) || (can->starts != starts))
+                return CANUSB_SUCCESS;  /* note: the device drops the CAN frame */
+            now = MacCAN_GetTime();
+        }
+        due = OccupyBus(device->bus, frame, can->bitrate, now);
+    }
+    /* the pending CAN frames go first, a CAN frame w/o acknowledge takes a transmit mailbox */
+    if (can->pending)
+        RetransmitFrames(device->bus, due);
+    if (can->pending || !SendFrame(index, frame, due)) {
+        if (can->pending < SIM_TX_MAILBOXES) {
+            memcpy(can->mailbox[can->pending], frame, SIM_FRAME_SIZE);
+            can->errorCode |= HAL_CAN_ERROR_TX_TERR0 << (2U * can->pending);
+            can->pending++;
+        } else
+            bus->stats.dropped++;
+    }
+    UpdateBusStatus(device, due);
+    return CANUSB_SUCCESS;
+}
+
+static Boolean SendFrame(CANUSB_Index_t index, const UInt8 *frame, UInt64 due) {
+    USBDevice_t *device = &usbDevice[index];
+    SimController_t *can = &device->can;
+    Boolean silent = (can->flags & TouCAN_ENABLE_SILENT_MODE) ? true : false;
+    Boolean loopback = (can->flags & TouCAN_ENABLE_LOOPBACK_MODE) ? true : false;
+    UInt32 acks = 0U;
+
+    /* bit error (a node with another bit-rate destroys the CAN frame), up to bus-off */
+    if (!silent && IsDisturbed(device->bus, index, can->bitrate)) {
+        can->errorCode |= HAL_CAN_ERROR_BD;
+        simBus[device->bus].stats.errors++;
+        if (can->txErrors < 248U)
+            can->txErrors += 8U;
+        else {
+            can->txErrors = 255U;
+            can->busOff = true;
+            can->pending = 0U;
+        }
+        return false;
+    }
+    if (!silent)
+        acks = Broadcast(device->bus, index, frame, can->bitrate, due);
+    if (loopback && IsAccepted(can, frame))
+        PutFrame(device, frame, due);
+    if (acks || loopback) {
+        if (can->txErrors)
+            can->txErrors--;
+        return true;
+    }
+    /* acknowledge error (no other node on the bus), not counted when error passive */
+    can->errorCode |= HAL_CAN_ERROR_ACK;
+    simBus[device->bus].stats.errors++;
+    if (can->txErrors < 128U)
+        can->txErrors += 8U;
+    return false;
+}
+
+static void RetransmitFrames(UInt8 bus, UInt64 due) {
+    USBDevice_t *device;
+    SimController_t *can;
+
+    for (CANUSB_Index_t index = 0; index < CANUSB_MAX_DEVICES; index++) {
+        device = &usbDevice[index];
+        can = &device->can;
+        if (!device->fPresent || (device->bus != bus) ||
+            (can->state != HAL_CAN_STATE_LISTENING) || can->busOff || !can->pending)
+            continue;
+        /* the transmit mailboxes are sent in order, until one is not acknowledged */
+        while (can->pending && SendFrame(index, can->mailbox[0], due)) {
+            memmove(can->mailbox[0], can->mailbox[1], (size_t)(can->pending - 1U) * SIM_FRAME_SIZE);
+            can->pending--;
+        }
+        UpdateBusStatus(device, due);
+    }
+}
+
+static UInt32 Broadcast(UInt8 bus, CANUSB_Index_t sender, const UInt8 *frame, UInt32 bitrate, UInt64 due) {
+    USBDevice_t *device;
+    UInt32 acks = 0U;
+    UInt8 slot;
+
+    for (CANUSB_Index_t index = 0; index < CANUSB_MAX_DEVICES; index++) {
+        device = &usbDevice[index];
+        if (!device->fPresent || (device->bus != bus) || (index == sender) || device->can.busOff ||
+            (device->can.state != HAL_CAN_STATE_LISTENING) || (device->can.bitrate != bitrate))
+            continue;
+        /* note: a CAN frame is acknowledged even when it is filtered out */
+        if (IsAccepted(&device->can, frame))
+            PutFrame(device, frame, due);
+        if (!(device->can.flags & TouCAN_ENABLE_SILENT_MODE))
+            acks++;
+    }
+    /* a traffic generator is an active node on the bus */
+    for (slot = 0U; slot < TOUCAN_SIM_MAX_TRAFFIC; slot++) {
+        if (simBus[bus].generator[slot].traffic.period)
+            acks++;
+    }
+    simBus[bus].stats.frames++;
+    return acks;
+}
+
+static Boolean IsDisturbed(UInt8 bus, CANUSB_Index_t sender, UInt32 bitrate) {
+    USBDevice_t *device;
+
+    for (CANUSB_Index_t index = 0; index < CANUSB_MAX_DEVICES; index++) {
+        device = &usbDevice[index];
+        /* note: a node in silent mode does not send error frames */
+        if (device->fPresent && (device->bus == bus) && (index != sender) && !device->can.busOff &&
+            (device->can.state == HAL_CAN_STATE_LISTENING) && (device->can.bitrate != bitrate) &&
+            !(device->can.flags & TouCAN_ENABLE_SILENT_MODE))
+            return true;
+    }
+    return false;
+}
+
+static UInt64 GenerateTraffic(UInt8 bus, UInt64 now) {
+    SimBus_t *sim = &simBus[bus];
+    SimGenerator_t *generator;
+    UInt8 frame[SIM_FRAME_SIZE];
+    UInt64 next = (UInt64)-1;
+    UInt32 bitrate = 0U, n, id;
+    UInt8 slot, i;
+
+    /* the generators send with the bit-rate of the started devices (the first one) */
+    for (CANUSB_Index_t index = 0; index < CANUSB_MAX_DEVICES; index++) {
+        if (usbDevice[index].fPresent && (usbDevice[index].bus == bus) &&
+            (usbDevice[index].can.state == HAL_CAN_STATE_LISTENING)) {
+            bitrate = usbDevice[index].can.bitrate;
+            break;
+        }
+    }
+    /* note: the generators are silent as long as nobody listens */
+    if (!bitrate)
+        return next;
+    for (slot = 0U; slot < TOUCAN_SIM_MAX_TRAFFIC; slot++) {
+        generator = &sim->generator[slot];
+        if (!generator->traffic.period)
+            continue;
+        /* note: a generator that has fallen behind (e.g. on a busy bus) does not catch up */
+        if ((generator->nextTime + SIM_MAX_LATENESS) < now)
+            generator->nextTime = now;
+        for (n = 0U; (generator->nextTime <= now) && (n < TOUCAN_SIM_RCV_FIFO_SIZE); n += generator->traffic.burst) {
+            for (i = 0U; i < generator->traffic.burst; i++) {
+                id = generator->traffic.canId + (UInt32)(generator->counter % generator->traffic.idRange);
+                memset(frame, 0, SIM_FRAME_SIZE);
+                frame[0] = generator->traffic.xtd ? TOUCAN_MSG_XTD_FRAME : TOUCAN_MSG_STD_FRAME;
+                PutUInt32(&frame[1], id & (generator->traffic.xtd ? CAN_MAX_XTD_ID : CAN_MAX_STD_ID));
+                frame[5] = generator->traffic.dlc;
+                for (UInt8 j = 0U; j < generator->traffic.dlc; j++)
+                    frame[6 + j] = (UInt8)(generator->counter >> (8U * j));
+                generator->counter++;
+                sim->stats.generated++;
+                (void)Broadcast(bus, CANUSB_INVALID_INDEX, frame, bitrate,
+                                sim->realTime ? OccupyBus(bus, frame, bitrate, generator->nextTime) : generator->nextTime);
+            }
+            generator->nextTime += (UInt64)generator->traffic.period * 1000U;
+        }
+        if (generator->nextTime < next)
+            next = generator->nextTime;
+    }
+    return next;
+}
+
+static UInt64 OccupyBus(UInt8 bus, const UInt8 *frame, UInt32 bitrate, UInt64 start) {
+    SimBus_t *sim = &simBus[bus];
+    UInt64 duration;
+
+    duration = ((UInt64)TouCAN_FrameBits((frame[0] & TOUCAN_MSG_XTD_FRAME) ? true : false,
+                                         (frame[0] & TOUCAN_MSG_RTR_FRAME) ? true : false,
+                                         GetUInt32(&frame[1]), frame[5], &frame[6]) * 1000000000U) / bitrate;
+    if (sim->busyUntil > start)
+        start = sim->busyUntil;
+    sim->busyUntil = start + duration;
+    return sim->busyUntil;
+}
+
+static UInt32 FillTransfer(USBDevice_t *device, UInt8 *buffer, UInt32 size, UInt64 now) {
+    UInt32 packets = size / SIM_PACKET_SIZE;
+    UInt32 capacity = packets ? SIM_PACKET_FRAMES : (size / SIM_FRAME_SIZE);
+    UInt32 length = 0U, offset, n, p;
+
+    /* a USB packet holds up to 3 CAN frames, a short packet ends the transfer */
+    for (p = 0U; p < (packets ? packets : 1U); p++) {
+        offset = p * SIM_PACKET_SIZE;
+        for (n = 0U; (n < capacity) && device->fifoCount &&
+                     (device->fifo[device->fifoHead].due <= now); n++) {
+            memcpy(&buffer[offset + (n * SIM_FRAME_SIZE)], device->fifo[device->fifoHead].data, SIM_FRAME_SIZE);
+            device->fifoHead = (device->fifoHead + 1U) % TOUCAN_SIM_RCV_FIFO_SIZE;
+            device->fifoCount--;
+        }
+        if (n < SIM_PACKET_FRAMES) {
+            length = offset + (n * SIM_FRAME_SIZE);
+            break;
+        }
+        memset(&buffer[offset + (n * SIM_FRAME_SIZE)], 0, SIM_PACKET_SIZE - (n * SIM_FRAME_SIZE));
+        length = offset + SIM_PACKET_SIZE;
+    }
+    return length;
+}
+
+static void PutFrame(USBDevice_t *device, const UInt8 *frame, UInt64 due) {
+    SimFrame_t *entry;
+    UInt32 timestamp;
+
+    if (!device->fifo)
+        return;
+    if (device->fifoCount >= TOUCAN_SIM_RCV_FIFO_SIZE) {
+        device->can.errorCode |= HAL_CAN_ERROR_RX_FOV0;
+        simBus[device->bus].stats.dropped++;
+        return;
+    }
+    entry = &device->fifo[(device->fifoHead + device->fifoCount) % TOUCAN_SIM_RCV_FIFO_SIZE];
+    memcpy(entry->data, frame, SIM_TIMESTAMP);
+    /* the device time-stamps its CAN frames with a free-running microsecond counter */
+    timestamp = (UInt32)((due - usbDriver.epoch) / 1000U) + device->clockOffset;
+    if (!timestamp && (frame[0] & TOUCAN_MSG_STS_FRAME))
+        timestamp = 1U;  /* note: a status frame w/o time-stamp would be taken as a bus error */
+    PutUInt32(&entry->data[SIM_TIMESTAMP], timestamp);
+    entry->due = due;
+    device->fifoCount++;
+}
+
+static void UpdateBusStatus(USBDevice_t *device, UInt64 due) {
+    SimController_t *can = &device->can;
+    UInt8 counter = (can->txErrors > can->rxErrors) ? can->txErrors : can->rxErrors;
+    UInt8 status = TOUCAN_STS_OK;
+    UInt8 frame[SIM_FRAME_SIZE];
+
+    if (can->busOff) {
+        can->errorCode |= HAL_CAN_ERROR_BOF | HAL_CAN_ERROR_EPV | HAL_CAN_ERROR_EWG;
+        status = TOUCAN_STS_BUSOFF;
+    } else if (counter >= 128U) {
+        can->errorCode |= HAL_CAN_ERROR_EPV | HAL_CAN_ERROR_EWG;
+        status = TOUCAN_STS_BUSHEAVY;
+    } else if (counter >= 96U) {
+        can->errorCode |= HAL_CAN_ERROR_EWG;
+        status = TOUCAN_STS_BUSLIGHT;
+    }
+    if (status == can->busStatus)
+        return;
+    can->busStatus = status;
+    /* status frames are reported on changes (when enabled) */
+    if (can->flags & TouCAN_ENABLE_STATUS_MESSAGES) {
+        memset(frame, 0, SIM_FRAME_SIZE);
+        frame[0] = TOUCAN_MSG_STS_FRAME;
+        frame[5] = 3U;
+        frame[6] = status;
+        frame[7] = can->rxErrors;
+        frame[8] = can->txErrors;
+        PutFrame(device, frame, due);
+    }
+}
+
+static Boolean IsAccepted(const SimController_t *can, const UInt8 *frame) {
+    const SimFilter_t *filter = (frame[0] & TOUCAN_MSG_XTD_FRAME) ? &can->filter29 : &can->filter11;
+    UInt32 id = GetUInt32(&frame[1]);
+
+    switch (filter->type) {
+    case FILTER_ACCEPT_ALL:
+        return true;
+    case FILTER_REJECT_ALL:
+        return false;
+    default:
+        return (((id ^ filter->code) & filter->mask) == 0U) ? true : false;
+    }
+}
+
+static void WaitForCallback(CANUSB_AsyncPipe_t asyncPipe) {
+    /* note: a callback that aborts its own read must not wait for itself */
+    while (asyncPipe->inCallback && !pthread_equal(pthread_self(), usbDriver.ptThread)) {
+        LEAVE_CRITICAL_SECTION();
+        (void)usleep(100U);
+        ENTER_CRITICAL_SECTION();
+    }
+}
+
+static void PutUInt32(UInt8 *data, UInt32 value) {
+    data[0] = (UInt8)(value >> 24);
+    data[1] = (UInt8)(value >> 16);
+    data[2] = (UInt8)(value >> 8);
+    data[3] = (UInt8)value;
+}
+
+static UInt32 GetUInt32(const UInt8 *data) {
+    return ((UInt32)data[0] << 24) | ((UInt32)data[1] << 16) |
+           ((UInt32)data[2] << 8) | (UInt32)data[3];
+}
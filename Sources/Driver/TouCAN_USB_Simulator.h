@@ -0,0 +1,70 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later */
+/*
+ *  TouCAN - macOS User-Space Driver for Rusoku TouCAN USB Interfaces
+ *
+ *  Copyright (C) 2021-2023  Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+ *
+ *  This file is part of MacCAN-TouCAN.
+ *
+ *  MacCAN-TouCAN is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  MacCAN-TouCAN is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with MacCAN-TouCAN.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef TOUCAN_USB_SIMULATOR_H_INCLUDED
+#define TOUCAN_USB_SIMULATOR_H_INCLUDED
+
+#include "TouCAN_USB_Common.h"
+
+#include "MacCAN_IOUsbKit.h"
+
+#define TOUCAN_SIM_MAX_BUSES  4U  /* number of virtual CAN buses */
+#define TOUCAN_SIM_MAX_TRAFFIC  8U  /* number of traffic generators per virtual CAN bus */
+#ifndef TOUCAN_SIM_DEVICES
+#define TOUCAN_SIM_DEVICES  2U  /* simulated devices on bus 0 (can be overridden by the environment) */
+#endif
+#ifndef TOUCAN_SIM_RCV_FIFO_SIZE
+#define TOUCAN_SIM_RCV_FIFO_SIZE  4096U  /* number of CAN frames the device holds for the host */
+#endif
+
+typedef struct sim_traffic_t_ {         /* traffic generator (a node on the virtual bus): */
+    UInt32 period;                      /* - interval between two bursts (in [usec], 0 = off) */
+    UInt32 burst;                       /* - number of CAN frames per burst */
+    UInt32 canId;                       /* - CAN identifier of the first CAN frame */
+    UInt32 idRange;                     /* - number of CAN identifiers (counted up from canId) */
+    UInt8 dlc;                          /* - data length code (0..8, up-counting number in the payload) */
+    Boolean xtd;                        /* - extended frame format (29-bit identifier) */
+} TouCAN_SimTraffic_t;
+
+typedef struct sim_statistics_t_ {      /* statistics of a virtual bus: */
+    UInt64 frames;                      /* - number of CAN frames on the bus */
+    UInt64 generated;                   /* - number of CAN frames from the traffic generators */
+    UInt64 errors;                      /* - number of CAN frames not acknowledged */
+    UInt64 dropped;                     /* - number of CAN frames lost in a full FIFO of a device */
+} TouCAN_SimStatistics_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern CANUSB_Index_t TouCAN_SimAttachDevice(UInt8 bus);
+extern CANUSB_Return_t TouCAN_SimDetachDevice(CANUSB_Index_t index);
+
+extern CANUSB_Return_t TouCAN_SimSetTraffic(UInt8 bus, UInt8 slot, const TouCAN_SimTraffic_t *traffic);
+extern CANUSB_Return_t TouCAN_SimSetRealTime(UInt8 bus, Boolean realTime);
+
+extern CANUSB_Return_t TouCAN_SimGetStatistics(UInt8 bus, TouCAN_SimStatistics_t *statistics);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TOUCAN_USB_SIMULATOR_H_INCLUDED */
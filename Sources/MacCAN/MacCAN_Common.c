@@ -0,0 +1,107 @@
+/*  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later */
+/*
+ *  MacCAN - macOS User-Space Driver for USB-to-CAN Interfaces
+ *
+ *  Copyright (c) 2012-2023 Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+ *  All rights reserved.
+ *
+ *  This file is part of MacCAN-Core.
+ *
+ *  MacCAN-Core is dual-licensed under the BSD 2-Clause "Simplified" License and
+ *  under the GNU General Public License v3.0 (or any later version).
+ *  You can choose between one of them if you use this file.
+ *
+ *  BSD 2-Clause "Simplified" License:
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright notice, this
+ *     list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ *  MacCAN-Core IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF MacCAN-Core, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  GNU General Public License v3.0 or later:
+ *  MacCAN-Core is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  MacCAN-Core is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with MacCAN-Core.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "MacCAN_Common.h"
+
+#include <errno.h>
+
+/*  ---  monotonic clock  ---
+ *
+ *  The condition variables are bound to CLOCK_MONOTONIC where the Posix
+ *  attribute is available. macOS does not provide pthread_condattr_setclock,
+ *  there the remaining time to the monotonic deadline is waited relative.
+ */
+UInt64 MacCAN_GetTime(void) {
+    struct timespec ts;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((UInt64)ts.tv_sec * 1000000000U) + (UInt64)ts.tv_nsec;
+}
+
+int MacCAN_InitCondition(pthread_cond_t *cond) {
+#if defined(__APPLE__)
+    return pthread_cond_init(cond, NULL);
+#else
+    pthread_condattr_t attr;
+    int res;
+
+    if ((res = pthread_condattr_init(&attr)) != 0)
+        return res;
+    if ((res = pthread_condattr_setclock(&attr, CLOCK_MONOTONIC)) == 0)
+        res = pthread_cond_init(cond, &attr);
+    (void)pthread_condattr_destroy(&attr);
+    return res;
+#endif
+}
+
+int MacCAN_TimedWait(pthread_cond_t *cond, pthread_mutex_t *mutex, const struct timespec *absTime) {
+#if defined(__APPLE__)
+    struct timespec now, relTime;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    relTime.tv_sec = absTime->tv_sec - now.tv_sec;
+    relTime.tv_nsec = absTime->tv_nsec - now.tv_nsec;
+    if (relTime.tv_nsec < 0) {
+        relTime.tv_nsec += (long)1000000000;
+        relTime.tv_sec -= (time_t)1;
+    }
+    if (relTime.tv_sec < 0)
+        return ETIMEDOUT;
+    return pthread_cond_timedwait_relative_np(cond, mutex, &relTime);
+#else
+    return pthread_cond_timedwait(cond, mutex, absTime);
+#endif
+}
+
+int MacCAN_TimedWaitUntil(pthread_cond_t *cond, pthread_mutex_t *mutex, UInt64 deadline) {
+    struct timespec absTime;
+
+    /* note: the deadline is a time of the monotonic clock in [nsec] (cf. MacCAN_GetTime) */
+    absTime.tv_sec = (time_t)(deadline / 1000000000U);
+    absTime.tv_nsec = (long)(deadline % 1000000000U);
+    return MacCAN_TimedWait(cond, mutex, &absTime);
+}
@@ -48,7 +48,24 @@
 #ifndef MACCAN_COMMAN_H_INCLUDED
 #define MACCAN_COMMAN_H_INCLUDED
 
+#if defined(__APPLE__)
 #include <MacTypes.h>
+#else
+/* note: other platforms (e.g. Linux with the simulated device) get the Mac types from here */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef uint8_t   UInt8;
+typedef int8_t    SInt8;
+typedef uint16_t  UInt16;
+typedef int16_t   SInt16;
+typedef uint32_t  UInt32;
+typedef int32_t   SInt32;
+typedef uint64_t  UInt64;
+typedef int64_t   SInt64;
+typedef unsigned char  Boolean;
+#endif
 
 /* CAN API V3 compatible error codes */
 #define CANUSB_ERROR_FATAL     (-99)
@@ -79,10 +96,19 @@
 /* CAN API V3 compatible time-out value */
 #define CANUSB_INFINITE  (65535U)
 
+#include <pthread.h>
+#include <time.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/* monotonic clock and condition variables bound to it */
+extern UInt64 MacCAN_GetTime(void);
+extern int MacCAN_InitCondition(pthread_cond_t *cond);
+extern int MacCAN_TimedWait(pthread_cond_t *cond, pthread_mutex_t *mutex, const struct timespec *absTime);
+extern int MacCAN_TimedWaitUntil(pthread_cond_t *cond, pthread_mutex_t *mutex, UInt64 deadline);
+
 #ifdef __cplusplus
 }
 #endif
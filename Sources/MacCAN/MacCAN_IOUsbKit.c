@@ -115,19 +115,29 @@ static IOReturn ConfigureDevice(IOUSBDeviceInterface **dev);
 static IOReturn FindInterface(IOUSBDeviceInterface **device, int index);
 static void* WorkerThread(void* arg);
 
-typedef struct usb_buffer_tag {             /* Double buffer: */
-    UInt8 *data[2];                         /*   pointer to data buffers */
-    UInt8 index;                            /*   index to active data buffer */
+typedef struct usb_read_tag {               /* Submitted read: */
+    CANUSB_AsyncPipe_t pipe;                /*   asynchronous pipe */
+    UInt8 *data;                            /*   its data buffer */
+} CANUSB_Read_t;
+
+typedef struct usb_buffer_tag {             /* Ring of read buffers: */
+    UInt8 **data;                           /*   pointer to data buffers */
+    CANUSB_Read_t *read;                    /*   one reference per buffer (refCon) */
+    UInt32 depth;                           /*   number of data buffers */
+    UInt32 pending;                         /*   number of submitted buffers */
     UInt32 size;                            /*   size of each buffer (in byte) */
 } CANUSB_Buffer_t;
 
 typedef struct usb_async_pipe_tag {         /* Asynchrounous pipe: */
     UInt8 pipeRef;                          /*   pipe number (endpoint) */
     CANUSB_Handle_t handle;                 /*   device handle */
-    CANUSB_Buffer_t buffer;                 /*   double buffer */
+    CANUSB_Buffer_t buffer;                 /*   ring of read buffers */
     CANUSB_AsyncPipeCbk_t callback;         /*   callback from notification function */
     CANUSB_Context_t context;               /*   pointer to user context for callback */
     Boolean running;                        /*   flag to indicate the pipe state */
+    UInt64 xferCounter;                     /*   number of completed transfers */
+    UInt64 dryCounter;                      /*   number of times no read was submitted */
+    UInt64 errCounter;                      /*   number of failed (re-)submissions */
 } *CANUSB_AsyncPipe_t;                      /*   note: forward declaration requires C11 */
 
 typedef struct usb_interface_tag {          /* USB interface: */
@@ -648,7 +658,13 @@ CANUSB_Return_t CANUSB_ResetPipe(CANUSB_Handle_t handle, UInt8 pipeRef) {
 }
 
 CANUSB_AsyncPipe_t CANUSB_CreatePipeAsync(CANUSB_Handle_t handle, UInt8 pipeRef, size_t bufferSize) {
+    /* note: two buffers for compatibility reasons (both are submitted) */
+    return CANUSB_CreatePipeAsyncEx(handle, pipeRef, bufferSize, 2U);
+}
+
+CANUSB_AsyncPipe_t CANUSB_CreatePipeAsyncEx(CANUSB_Handle_t handle, UInt8 pipeRef, size_t bufferSize, UInt32 depth) {
     CANUSB_AsyncPipe_t asyncPipe = NULL;
+    UInt32 i;
 
     /* must be initialized */
     if (!fInitialized)
@@ -656,6 +672,9 @@ CANUSB_AsyncPipe_t CANUSB_CreatePipeAsync(CANUSB_Handle_t handle, UInt8 pipeRef,
     /* must be a valid handle */
     if (!IS_HANDLE_VALID(handle))
         return NULL;
+    /* check for valid parameters */
+    if (!bufferSize || (depth < 1U) || (depth > CANUSB_MAX_PIPE_DEPTH))
+        return NULL;
 
     /* create asynchronous pipe context */
     if ((asyncPipe = (CANUSB_AsyncPipe_t)malloc(sizeof(struct usb_async_pipe_tag))) == NULL) {
@@ -664,17 +683,35 @@ CANUSB_AsyncPipe_t CANUSB_CreatePipeAsync(CANUSB_Handle_t handle, UInt8 pipeRef,
     }
     bzero(asyncPipe, sizeof(struct usb_async_pipe_tag));
     asyncPipe->handle = CANUSB_INVALID_HANDLE;
-    /* create a double buffer for USB data transfer */
-    MACCAN_DEBUG_CORE("        - Double buffer each of size %u bytes for endpoint #%u\n", bufferSize, pipeRef);
-    if ((asyncPipe->buffer.data[0] = malloc(bufferSize)) &&
-        (asyncPipe->buffer.data[1] = malloc(bufferSize))) {
+    /* create a ring of buffers for USB data transfer (each of them with a reference for its read) */
+    MACCAN_DEBUG_CORE("        - %u buffer(s) each of size %u bytes for endpoint #%u\n", depth, bufferSize, pipeRef);
+    if (((asyncPipe->buffer.data = (UInt8**)calloc(depth, sizeof(UInt8*))) != NULL) &&
+        ((asyncPipe->buffer.read = (CANUSB_Read_t*)calloc(depth, sizeof(CANUSB_Read_t))) != NULL)) {
+        for (i = 0U; i < depth; i++) {
+            if ((asyncPipe->buffer.data[i] = malloc(bufferSize)) == NULL)
+                break;
+            /* note: each read is submitted with a reference to its own buffer */
+            asyncPipe->buffer.read[i].pipe = asyncPipe;
+            asyncPipe->buffer.read[i].data = asyncPipe->buffer.data[i];
+        }
+        asyncPipe->buffer.depth = i;
+    }
+    if (asyncPipe->buffer.data && asyncPipe->buffer.read && (asyncPipe->buffer.depth == depth)) {
         asyncPipe->buffer.size = (UInt32)bufferSize;
+        asyncPipe->buffer.pending = 0U;
         asyncPipe->callback = NULL;
         asyncPipe->context = NULL;
         asyncPipe->pipeRef = pipeRef;
         asyncPipe->handle = handle;
     } else {
-        MACCAN_DEBUG_ERROR("+++ Unable to create double buffer (2 * %u bytes) for endpoint #%u\n", bufferSize, pipeRef);
+        MACCAN_DEBUG_ERROR("+++ Unable to create %u buffer(s) (%u bytes each) for endpoint #%u\n", depth, bufferSize, pipeRef);
+        if (asyncPipe->buffer.data) {
+            for (i = 0U; i < asyncPipe->buffer.depth; i++)
+                free(asyncPipe->buffer.data[i]);
+            free(asyncPipe->buffer.data);
+        }
+        if (asyncPipe->buffer.read)
+            free(asyncPipe->buffer.read);
         free(asyncPipe);
         asyncPipe = NULL;
     }
@@ -682,6 +719,7 @@ CANUSB_AsyncPipe_t CANUSB_CreatePipeAsync(CANUSB_Handle_t handle, UInt8 pipeRef,
 }
 
 CANUSB_Return_t CANUSB_DestroyPipeAsync(CANUSB_AsyncPipe_t asyncPipe) {
+    UInt32 i;
 
     /* must be initialized */
     if (!fInitialized)
@@ -696,22 +734,32 @@ CANUSB_Return_t CANUSB_DestroyPipeAsync(CANUSB_AsyncPipe_t asyncPipe) {
     if (asyncPipe->running)
         (void)CANUSB_AbortPipeAsync(asyncPipe);
 
-    /* free double buffer and asynchronous pipe context */
-    if (asyncPipe->buffer.data[1])
-        free(asyncPipe->buffer.data[1]);
-    if (asyncPipe->buffer.data[0])
-        free(asyncPipe->buffer.data[0]);
+    /* free the ring of buffers and asynchronous pipe context */
+    if (asyncPipe->buffer.data) {
+        for (i = 0U; i < asyncPipe->buffer.depth; i++) {
+            if (asyncPipe->buffer.data[i])
+                free(asyncPipe->buffer.data[i]);
+        }
+        free(asyncPipe->buffer.data);
+    }
+    if (asyncPipe->buffer.read)
+        free(asyncPipe->buffer.read);
     free(asyncPipe);
 
     return CANUSB_SUCCESS;
 }
 
 static void ReadPipeCallback(void *refCon, IOReturn result, void *arg0) {
-    CANUSB_AsyncPipe_t asyncPipe = (CANUSB_AsyncPipe_t)refCon;
-    UInt8 *buffer, index;
+    CANUSB_Read_t *read = (CANUSB_Read_t*)refCon;
+    CANUSB_AsyncPipe_t asyncPipe = read ? read->pipe : NULL;
+    UInt8 *buffer;
     UInt64 length = (UInt64)arg0;
     IOReturn kr;
 
+    /* note: the completed buffer is taken from the reference of its read (not from the order of submission) */
+    if (asyncPipe && (asyncPipe->buffer.pending > 0U)) {
+        (void)__atomic_sub_fetch(&asyncPipe->buffer.pending, 1U, __ATOMIC_RELAXED);
+    }
     switch (result)
     {
     case kIOReturnSuccess:
@@ -720,30 +768,35 @@ static void ReadPipeCallback(void *refCon, IOReturn result, void *arg0) {
                 return;
             if (!usbDevice[asyncPipe->handle].usbInterface.ioInterface)
                 return;
-            if (!asyncPipe->buffer.data[0] || !asyncPipe->buffer.data[1])
-                return;
-            if (asyncPipe->buffer.index >= 2)
+            if (!read->data)
                 return;
-            /* double-buffer strategy */
-            index = asyncPipe->buffer.index;
-            buffer = asyncPipe->buffer.data[index];
-            asyncPipe->buffer.index = index ? 0 : 1;
-            /* preparation of the next asynchronous pipe read event (with our pipe context as reference, 6th argument) */
-            kr = (*usbDevice[asyncPipe->handle].usbInterface.ioInterface)->ReadPipeAsync(usbDevice[asyncPipe->handle].usbInterface.ioInterface,
-                                                                                         asyncPipe->pipeRef,
-                                                                                         asyncPipe->buffer.data[asyncPipe->buffer.index],
-                                                                                         asyncPipe->buffer.size,
-                                                                                         ReadPipeCallback,
-                                                                                         (void *)asyncPipe);
-            if (kIOReturnSuccess != kr) {
-                MACCAN_DEBUG_ERROR("+++ Unable to read async pipe #%d of device #%d (%08x)\n", asyncPipe->pipeRef, asyncPipe->handle, kr);
-                /* error: pipe is boken */
-                asyncPipe->running = false;
-            }
+            buffer = read->data;
+            asyncPipe->xferCounter++;
+            /* the pipeline ran dry when no other read is submitted (the device cannot send) */
+            if (asyncPipe->buffer.pending == 0U)
+                asyncPipe->dryCounter++;
             /* call the CALLBACK routine with the referenced pipe context */
             if (asyncPipe->callback && length) {
                 asyncPipe->callback(asyncPipe->context, buffer, (UInt32)length);
             }
+            /* re-submission of the buffer (with the reference of its read as context, 6th argument) */
+            if (asyncPipe->running) {
+                kr = (*usbDevice[asyncPipe->handle].usbInterface.ioInterface)->ReadPipeAsync(usbDevice[asyncPipe->handle].usbInterface.ioInterface,
+                                                                                             asyncPipe->pipeRef,
+                                                                                             buffer,
+                                                                                             asyncPipe->buffer.size,
+                                                                                             ReadPipeCallback,
+                                                                                             (void *)read);
+                if (kIOReturnSuccess != kr) {
+                    MACCAN_DEBUG_ERROR("+++ Unable to read async pipe #%d of device #%d (%08x)\n", asyncPipe->pipeRef, asyncPipe->handle, kr);
+                    asyncPipe->errCounter++;
+                    /* error: pipe is boken (when no read is submitted anymore) */
+                    if (asyncPipe->buffer.pending == 0U)
+                        asyncPipe->running = false;
+                } else {
+                    (void)__atomic_add_fetch(&asyncPipe->buffer.pending, 1U, __ATOMIC_RELAXED);
+                }
+            }
         }
         break;
     case kIOReturnAborted:
@@ -767,7 +820,8 @@ static void ReadPipeCallback(void *refCon, IOReturn result, void *arg0) {
 }
 
 CANUSB_Return_t CANUSB_ReadPipeAsync(CANUSB_AsyncPipe_t asyncPipe, CANUSB_AsyncPipeCbk_t callback, CANUSB_Context_t context) {
-    IOReturn kr;
+    IOReturn kr = kIOReturnSuccess;
+    UInt32 i;
     int ret = 0;
 
     /* must be initialized */
@@ -775,8 +829,7 @@ CANUSB_Return_t CANUSB_ReadPipeAsync(CANUSB_AsyncPipe_t asyncPipe, CANUSB_AsyncP
         return CANUSB_ERROR_NOTINIT;
     /* check for NULL pointer */
     if (!asyncPipe ||
-        !asyncPipe->buffer.data[0] ||
-        !asyncPipe->buffer.data[1])
+        !asyncPipe->buffer.data)
         return CANUSB_ERROR_NULLPTR;
     /* must be a valid handle */
     if (!IS_HANDLE_VALID(asyncPipe->handle))
@@ -796,21 +849,35 @@ CANUSB_Return_t CANUSB_ReadPipeAsync(CANUSB_AsyncPipe_t asyncPipe, CANUSB_AsyncP
         /* register the callback function and the reception data context */
         asyncPipe->callback = callback;
         asyncPipe->context = context;
-        /* preparation of the first asynchronous pipe read event (with our pipe context as reference, 6th argument) */
-        kr = (*usbDevice[asyncPipe->handle].usbInterface.ioInterface)->ReadPipeAsync(usbDevice[asyncPipe->handle].usbInterface.ioInterface,
-                                                                                     asyncPipe->pipeRef,
-                                                                                     asyncPipe->buffer.data[asyncPipe->buffer.index],
-                                                                                     asyncPipe->buffer.size,
-                                                                                     ReadPipeCallback,
-                                                                                     (void*)asyncPipe);
-        if (kIOReturnSuccess != kr) {
+        /* preparation of the asynchronous pipe read events, one per buffer (with the reference of the read as context, 6th argument) */
+        /* note: the first reads can be completed before the last one is submitted (by the run loop of the driver) */
+        asyncPipe->buffer.pending = 0U;
+        asyncPipe->running = true;
+        for (i = 0U; i < asyncPipe->buffer.depth; i++) {
+            (void)__atomic_add_fetch(&asyncPipe->buffer.pending, 1U, __ATOMIC_RELAXED);
+            kr = (*usbDevice[asyncPipe->handle].usbInterface.ioInterface)->ReadPipeAsync(usbDevice[asyncPipe->handle].usbInterface.ioInterface,
+                                                                                         asyncPipe->pipeRef,
+                                                                                         asyncPipe->buffer.data[i],
+                                                                                         asyncPipe->buffer.size,
+                                                                                         ReadPipeCallback,
+                                                                                         (void*)&asyncPipe->buffer.read[i]);
+            if (kIOReturnSuccess != kr) {
+                (void)__atomic_sub_fetch(&asyncPipe->buffer.pending, 1U, __ATOMIC_RELAXED);
+                break;
+            }
+        }
+        if (i == 0U) {
             MACCAN_DEBUG_ERROR("+++ Unable to start async read pipe #%d of device #%d (%08x)\n", asyncPipe->pipeRef, asyncPipe->handle, kr);
+            asyncPipe->running = false;
             LEAVE_CRITICAL_SECTION(asyncPipe->handle);
             MACCAN_DEBUG_FUNC("unlocked\n");
             return CANUSB_ERROR_RESOURCE;
         }
-        /* asynchronous pipe read event armed */
-        asyncPipe->running = true;
+        if (i < asyncPipe->buffer.depth) {
+            MACCAN_DEBUG_ERROR("+++ Only %u of %u read(s) submitted to async pipe #%d of device #%d (%08x)\n", i, asyncPipe->buffer.depth, asyncPipe->pipeRef, asyncPipe->handle, kr);
+            asyncPipe->errCounter++;
+        }
+        /* asynchronous pipe read events armed */
     } else {
         MACCAN_DEBUG_ERROR("+++ Sorry, device #%i is not opened or not available (ReadPipeAsync)\n", asyncPipe->handle);
         ret = !usbDevice[asyncPipe->handle].fPresent ? CANUSB_ERROR_HANDLE : CANUSB_ERROR_NOTINIT;
@@ -878,6 +945,28 @@ Boolean CANUSB_IsPipeAsyncRunning(CANUSB_AsyncPipe_t asyncPipe) {
     return running;
 }
 
+CANUSB_Return_t CANUSB_GetPipeAsyncStats(CANUSB_AsyncPipe_t asyncPipe, CANUSB_PipeStats_t *stats) {
+
+    /* must be initialized */
+    if (!fInitialized)
+        return CANUSB_ERROR_NOTINIT;
+    /* check for NULL pointer */
+    if (!asyncPipe || !stats)
+        return CANUSB_ERROR_NULLPTR;
+    /* must be a valid handle */
+    if (!IS_HANDLE_VALID(asyncPipe->handle))
+        return CANUSB_ERROR_HANDLE;
+
+    /* note: the counters are updated by the run loop of the driver (w/o lock) */
+    stats->depth = asyncPipe->buffer.depth;
+    stats->size = asyncPipe->buffer.size;
+    stats->pending = asyncPipe->buffer.pending;
+    stats->transfers = asyncPipe->xferCounter;
+    stats->dryRuns = asyncPipe->dryCounter;
+    stats->errors = asyncPipe->errCounter;
+    return CANUSB_SUCCESS;
+}
+
 CANUSB_Index_t CANUSB_GetFirstDevice(void) {
     CANUSB_Index_t index = CANUSB_INVALID_INDEX;
 
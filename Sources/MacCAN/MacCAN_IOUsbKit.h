@@ -55,6 +55,7 @@
 #endif
 #define CANUSB_INVALID_INDEX  (-1)
 #define CANUSB_INVALID_HANDLE  (-1)
+#define CANUSB_MAX_PIPE_DEPTH  32U
 
 #define CANUSB_ANY_VENDOR_ID  0xFFFFU
 #define CANUSB_ANY_PRODUCT_ID  0xFFFFU
@@ -101,6 +102,15 @@ typedef void (*CANUSB_AsyncPipeCbk_t)(CANUSB_Context_t refCon, UInt8 *buffer, UI
 
 typedef struct usb_async_pipe_tag *CANUSB_AsyncPipe_t;
 
+typedef struct usb_pipe_stats_tag {     /* statistics of an asynchronous pipe: */
+    UInt32 depth;                       /*   number of read buffers (submitted at once) */
+    UInt32 size;                        /*   size of each buffer (in byte) */
+    UInt32 pending;                     /*   number of currently submitted reads */
+    UInt64 transfers;                   /*   number of completed transfers */
+    UInt64 dryRuns;                     /*   number of times no read was submitted */
+    UInt64 errors;                      /*   number of failed (re-)submissions */
+} CANUSB_PipeStats_t;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -123,6 +133,8 @@ extern CANUSB_Return_t CANUSB_ResetPipe(CANUSB_Handle_t handle, UInt8 pipeRef);
 
 extern CANUSB_AsyncPipe_t CANUSB_CreatePipeAsync(CANUSB_Handle_t handle, UInt8 pipeRef, size_t bufferSize);
 
+extern CANUSB_AsyncPipe_t CANUSB_CreatePipeAsyncEx(CANUSB_Handle_t handle, UInt8 pipeRef, size_t bufferSize, UInt32 depth);
+
 extern CANUSB_Return_t CANUSB_DestroyPipeAsync(CANUSB_AsyncPipe_t asyncPipe);
 
 extern CANUSB_Return_t CANUSB_AbortPipeAsync(CANUSB_AsyncPipe_t asyncPipe);
@@ -131,6 +143,8 @@ extern CANUSB_Return_t CANUSB_ReadPipeAsync(CANUSB_AsyncPipe_t asyncPipe, CANUSB
 
 extern Boolean CANUSB_IsPipeAsyncRunning(CANUSB_AsyncPipe_t asyncPipe);
 
+extern CANUSB_Return_t CANUSB_GetPipeAsyncStats(CANUSB_AsyncPipe_t asyncPipe, CANUSB_PipeStats_t *stats);
+
 extern CANUSB_Index_t CANUSB_GetFirstDevice(void);
 
 extern CANUSB_Index_t CANUSB_GetNextDevice(void);
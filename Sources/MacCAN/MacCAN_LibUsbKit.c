@@ -0,0 +1,1428 @@
+/*  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later */
+/*
+ *  MacCAN - macOS User-Space Driver for USB-to-CAN Interfaces
+ *
+ *  Copyright (c) 2012-2023 Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+ *  All rights reserved.
+ *
+ *  This file is part of MacCAN-Core.
+ *
+ *  MacCAN-Core is dual-licensed under the BSD 2-Clause "Simplified" License and
+ *  under the GNU General Public License v3.0 (or any later version).
+ *  You can choose between one of them if you use this file.
+ *
+ *  BSD 2-Clause "Simplified" License:
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright notice, this
+ *     list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ *  MacCAN-Core IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF MacCAN-Core, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  GNU General Public License v3.0 or later:
+ *  MacCAN-Core is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  MacCAN-Core is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with MacCAN-Core.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+ * Counterpart of MacCAN_IOUsbKit.c for Linux (and other platforms supported
+ * by libusb-1.0): it implements the interface of MacCAN_IOUsbKit.h, so that
+ * the USB driver above it can be used unchanged.
+ *
+ * All transfers are handled by a dedicated event thread that calls
+ * libusb_handle_events_timeout_completed() in a loop (like the run loop of
+ * the IOUsbKit). The read of an asynchronous pipe submits one bulk transfer
+ * per buffer of its ring, so that several transfers are in flight at once;
+ * each completed transfer is passed to the callback of the pipe and then it
+ * is re-submitted (from the event thread).
+ *
+ * Devices are registered and unregistered by a hotplug callback. Because the
+ * callback must not make any synchronous call nor wait for a device mutex
+ * (a synchronous transfer holding that mutex may need the event thread to
+ * complete), the events are queued and processed by the event thread after
+ * libusb_handle_events_timeout_completed() has returned. Without hotplug
+ * support of the platform the devices are enumerated once on initialization.
+ */
+#include "MacCAN_IOUsbKit.h"
+#include "MacCAN_Devices.h"
+#include "MacCAN_Debug.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/time.h>
+
+#include <libusb.h>
+
+#define VERSION_MAJOR     0
+#define VERSION_MINOR     1
+#define VERSION_PATCH     0
+
+/*#define OPTION_MACCAN_MULTICHANNEL  0  !* set globally: 0 = only one channel on multi-channel devices */
+
+#if (OPTION_MACCAN_MULTICHANNEL != 0)
+#error multi-channel feature not supported
+#endif
+#define MAX_STRING_LENGTH  256
+#define MAX_ENDPOINTS  32
+#define HOTPLUG_QUEUE_SIZE  64
+#define EVENT_TIMEOUT  100000  /* [usec] */
+#define ABORT_TIMEOUT  1000  /* [msec] */
+#define CONTROL_TIMEOUT  1000  /* [msec] */
+
+#define IS_INDEX_VALID(idx)  ((0 <= (idx)) && ((idx) < CANUSB_MAX_DEVICES))
+#define IS_HANDLE_VALID(hnd)  IS_INDEX_VALID(hnd)
+
+#define ENTER_CRITICAL_SECTION(idx)  (void)pthread_mutex_lock(&usbDevice[idx].ptMutex)
+#define LEAVE_CRITICAL_SECTION(idx)  (void)pthread_mutex_unlock(&usbDevice[idx].ptMutex)
+
+static void LIBUSB_CALL ReadPipeCallback(struct libusb_transfer *transfer);
+static int LIBUSB_CALL HotplugCallback(libusb_context *ctx, libusb_device *device, libusb_hotplug_event event, void *user_data);
+static void ProcessHotplugEvents(void);
+static void EnumerateDevices(void);
+static void DeviceAdded(libusb_device *device);
+static void DeviceRemoved(libusb_device *device);
+static int OpenInterface(CANUSB_Index_t index);
+static void CloseInterface(CANUSB_Index_t index);
+static Boolean WaitForPendingTransfers(CANUSB_AsyncPipe_t asyncPipe);
+static int MapError(int rc);
+static void* EventThread(void* arg);
+
+typedef struct usb_buffer_tag {             /* Ring of read buffers: */
+    UInt8 **data;                           /*   pointer to data buffers */
+    UInt32 depth;                           /*   number of data buffers */
+    UInt32 index;                           /*   index of the oldest submitted buffer */
+    UInt32 pending;                         /*   number of submitted buffers */
+    UInt32 size;                            /*   size of each buffer (in byte) */
+} CANUSB_Buffer_t;
+
+typedef struct usb_async_pipe_tag {         /* Asynchrounous pipe: */
+    UInt8 pipeRef;                          /*   pipe number (endpoint) */
+    CANUSB_Handle_t handle;                 /*   device handle */
+    CANUSB_Buffer_t buffer;                 /*   ring of read buffers */
+    struct libusb_transfer **transfer;      /*   one transfer per buffer */
+    pthread_mutex_t ptMutex;                /*   guards the (re-)submission */
+    CANUSB_AsyncPipeCbk_t callback;         /*   callback from notification function */
+    CANUSB_Context_t context;               /*   pointer to user context for callback */
+    Boolean running;                        /*   flag to indicate the pipe state */
+    UInt64 xferCounter;                     /*   number of completed transfers */
+    UInt64 dryCounter;                      /*   number of times no read was submitted */
+    UInt64 errCounter;                      /*   number of failed (re-)submissions */
+} *CANUSB_AsyncPipe_t;                      /*   note: forward declaration requires C11 */
+
+typedef struct usb_endpoint_tag {           /* USB endpoint: */
+    UInt8 u8Address;                        /*   endpoint address (bit 7 = direction) */
+    UInt8 u8Attributes;                     /*   attributes (bit 0..1 = transfer type) */
+    UInt16 u16MaxPacketSize;                /*   max. packet size (16-bit) */
+} USBEndpoint_t;
+
+typedef struct usb_interface_tag {          /* USB interface: */
+    Boolean fOpened;                        /*   interface is opened (claimed) */
+    UInt8 u8Number;                         /*   number of the interface (8-bit) */
+    UInt8 u8Class;                          /*   class of the interface (8-bit) */
+    UInt8 u8SubClass;                       /*   subclass of the interface (8-bit) */
+    UInt8 u8Protocol;                       /*   protocol of the interface (8-bit) */
+    UInt8 u8NumEndpoints;                   /*   number of endpoints of the interface */
+    USBEndpoint_t endpoint[MAX_ENDPOINTS];  /*   endpoints (pipe #1 is endpoint[0]) */
+} USBInterface_t;
+
+typedef struct usb_device_tag {             /* USB device: */
+    Boolean fPresent;                       /*   device is present */
+    char szName[MAX_STRING_LENGTH];         /*   device name */
+    UInt16 u16VendorId;                     /*   vendor ID (16-bit) */
+    UInt16 u16ProductId;                    /*   product ID (16-bit) */
+    UInt16 u16ReleaseNo;                    /*   release no. (16-bit) */
+    UInt8 nCanChannels;                     /*   "number of CAN channels" */
+    UInt32 u32Location;                     /*   unique location ID (32-bit) */
+    UInt16 u16Address;                      /*   device address (16-bit?) */
+    libusb_device *ioDevice;                /*   device (referenced) */
+    libusb_device_handle *ioHandle;         /*   device handle (when opened) */
+    USBInterface_t usbInterface/*[x]*/;     /*   interface (only first one supported) */
+    pthread_mutex_t ptMutex;                /*   pthread mutex for mutual exclusion */
+} USBDevice_t;
+
+typedef struct usb_hotplug_tag {            /* Hotplug event: */
+    libusb_device *device;                  /*   device (referenced) */
+    libusb_hotplug_event event;             /*   arrived or left */
+} USBHotplug_t;
+
+typedef struct usb_driver_tag {             /* USB driver: */
+    Boolean fRunning;                       /*   flag: driver running */
+    pthread_t ptThread;                     /*   pthread of the driver (event thread) */
+    pthread_mutex_t ptMutex;                /*   pthread mutex for the hotplug queue */
+    libusb_context *ioContext;              /*   libusb context of the driver */
+    Boolean fHotplug;                       /*   flag: hotplug callback registered */
+    libusb_hotplug_callback_handle hotplugHandle;  /* handle of the hotplug callback */
+    USBHotplug_t hotplugQueue[HOTPLUG_QUEUE_SIZE];  /* queue of hotplug events */
+    UInt32 hotplugHead;                     /*   index of the oldest hotplug event */
+    UInt32 hotplugCount;                    /*   number of queued hotplug events */
+} USBDriver_t;
+
+static USBDriver_t usbDriver;
+static USBDevice_t usbDevice[CANUSB_MAX_DEVICES];
+static CANUSB_Index_t idxDevice = 0;
+static Boolean fInitialized = false;
+
+CANUSB_Return_t CANUSB_Initialize(void) {
+    const struct libusb_version *version;
+    int index, rc;
+
+    /* must not be initialized */
+    if (fInitialized)
+        return CANUSB_ERROR_YETINIT;
+
+    /* initialize the driver and its devices */
+    memset(&usbDriver, 0, sizeof(USBDriver_t));
+    usbDriver.fRunning = false;
+    for (index = 0; index < CANUSB_MAX_DEVICES; index++) {
+        memset(&usbDevice[index], 0, sizeof(USBDevice_t));
+        usbDevice[index].fPresent = false;
+        /* create a mutex for each device */
+        if (pthread_mutex_init(&usbDevice[index].ptMutex, NULL) != 0)
+            goto error_initialize;
+    }
+    /* create a mutex for the hotplug queue */
+    if (pthread_mutex_init(&usbDriver.ptMutex, NULL) != 0)
+        goto error_initialize;
+    /* create a libusb context for the driver */
+    if ((rc = libusb_init(&usbDriver.ioContext)) != LIBUSB_SUCCESS) {
+        MACCAN_DEBUG_ERROR("+++ Unable to initialize libusb (%s)\n", libusb_error_name(rc));
+        goto error_libusb;
+    }
+    version = libusb_get_version();
+    MACCAN_DEBUG_INFO("    Loading the MacCAN driver (v%u.%u.%u) with libusb %u.%u.%u\n", VERSION_MAJOR, VERSION_MINOR, VERSION_PATCH,
+                      version->major, version->minor, version->micro);
+    (void)version;
+    fInitialized = true;
+
+    /* register the devices already attached (and the ones to come, if supported) */
+    if (libusb_has_capability(LIBUSB_CAP_HAS_HOTPLUG)) {
+        /* note: the callback is called for each attached device before it returns */
+        rc = libusb_hotplug_register_callback(usbDriver.ioContext,
+                                              LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED | LIBUSB_HOTPLUG_EVENT_DEVICE_LEFT,
+                                              LIBUSB_HOTPLUG_ENUMERATE,
+                                              LIBUSB_HOTPLUG_MATCH_ANY, LIBUSB_HOTPLUG_MATCH_ANY, LIBUSB_HOTPLUG_MATCH_ANY,
+                                              HotplugCallback, NULL, &usbDriver.hotplugHandle);
+        if (rc != LIBUSB_SUCCESS) {
+            MACCAN_DEBUG_ERROR("+++ Unable to register hotplug callback (%s)\n", libusb_error_name(rc));
+            goto error_hotplug;
+        }
+        usbDriver.fHotplug = true;
+        ProcessHotplugEvents();
+    } else {
+        MACCAN_DEBUG_CORE("    - No hotplug support (devices are enumerated once)\n");
+        EnumerateDevices();
+    }
+    /* start the event thread for all transfers (and hotplug events) */
+    usbDriver.fRunning = true;
+    if (pthread_create(&usbDriver.ptThread, NULL, EventThread, NULL) != 0) {
+        usbDriver.fRunning = false;
+        goto error_thread;
+    }
+    /* the driver is now loaded (notifications will be received) */
+    return CANUSB_SUCCESS;
+
+error_thread:
+    /* on error: unregister all devices! */
+    if (usbDriver.fHotplug)
+        libusb_hotplug_deregister_callback(usbDriver.ioContext, usbDriver.hotplugHandle);
+    for (index = 0; index < CANUSB_MAX_DEVICES; index++) {
+        if (usbDevice[index].ioDevice)
+            libusb_unref_device(usbDevice[index].ioDevice);
+    }
+    index = CANUSB_MAX_DEVICES;
+error_hotplug:
+    libusb_exit(usbDriver.ioContext);
+    usbDriver.ioContext = NULL;
+error_libusb:
+    (void)pthread_mutex_destroy(&usbDriver.ptMutex);
+error_initialize:
+    /* on error: tidy-up! */
+    for (index = index - 1; index >= 0; index--)
+        (void)pthread_mutex_destroy(&usbDevice[index].ptMutex);
+    /* the driver has not been loaded! */
+    fInitialized = false;
+    return CANUSB_ERROR_NOTINIT;
+}
+
+CANUSB_Return_t CANUSB_Teardown(void) {
+    int index;
+
+    /* must be initialized */
+    if (!fInitialized)
+        return CANUSB_ERROR_NOTINIT;
+
+    /* "Mr. Gorbachev, tear down this wall!" */
+    MACCAN_DEBUG_INFO("    Release the MacCAN driver (v%u.%u.%u)\n", VERSION_MAJOR, VERSION_MINOR, VERSION_PATCH);
+    if (usbDriver.fHotplug) {
+        libusb_hotplug_deregister_callback(usbDriver.ioContext, usbDriver.hotplugHandle);
+        usbDriver.fHotplug = false;
+    }
+    /* stop the event thread (at the latest after one event timeout) */
+    __atomic_store_n(&usbDriver.fRunning, false, __ATOMIC_SEQ_CST);
+#if defined(LIBUSB_API_VERSION) && (LIBUSB_API_VERSION >= 0x01000105)
+    libusb_interrupt_event_handler(usbDriver.ioContext);
+#endif
+    (void)pthread_join(usbDriver.ptThread, NULL);
+    /* release the hotplug events not processed */
+    while (usbDriver.hotplugCount > 0U) {
+        libusb_unref_device(usbDriver.hotplugQueue[usbDriver.hotplugHead].device);
+        usbDriver.hotplugHead = (usbDriver.hotplugHead + 1U) % HOTPLUG_QUEUE_SIZE;
+        usbDriver.hotplugCount--;
+    }
+    /* close all USB devices */
+    for (index = 0; index < CANUSB_MAX_DEVICES; index++) {
+        /* release the USB device */
+        ENTER_CRITICAL_SECTION(index);
+        if (usbDevice[index].ioDevice != NULL) {
+            MACCAN_DEBUG_CORE("      - Device #%i: %s", index, usbDevice[index].szName);
+            if (usbDevice[index].ioHandle != NULL) {
+                /* release the interface and close the device */
+                MACCAN_DEBUG_CODE(0, "close device handle\n");
+                CloseInterface(index);
+            }
+            /* rest in pease */
+            MACCAN_DEBUG_CODE(0, "release device\n");
+            libusb_unref_device(usbDevice[index].ioDevice);
+            usbDevice[index].ioDevice = NULL;
+            usbDevice[index].fPresent = false;
+            MACCAN_DEBUG_CORE(" (R.I.P.)\n");
+        }
+        LEAVE_CRITICAL_SECTION(index);
+        (void)pthread_mutex_destroy(&usbDevice[index].ptMutex);
+    }
+    libusb_exit(usbDriver.ioContext);
+    usbDriver.ioContext = NULL;
+    (void)pthread_mutex_destroy(&usbDriver.ptMutex);
+    fInitialized = false;
+    return 0;
+}
+
+CANUSB_Return_t CANUSB_DeviceRequest(CANUSB_Index_t index, CANUSB_SetupPacket_t setupPacket, void *buffer, UInt16 size, UInt32 *transferred) {
+    libusb_device_handle *ioHandle;
+    int rc, ret = 0;
+
+    /* must be initialized */
+    if (!fInitialized)
+        return CANUSB_ERROR_NOTINIT;
+    /* must be a valid index */
+    if (!IS_INDEX_VALID(index))
+        return CANUSB_ERROR_HANDLE;
+    (void)size;
+
+    MACCAN_DEBUG_FUNC("lock #%i\n", index);
+    ENTER_CRITICAL_SECTION(index);
+    if (usbDevice[index].fPresent &&
+        (usbDevice[index].ioDevice != NULL)) {
+        /* note: a device that is not opened is opened for the request only (like the device interface of the IOUsbKit) */
+        if ((ioHandle = usbDevice[index].ioHandle) == NULL) {
+            if ((rc = libusb_open(usbDevice[index].ioDevice, &ioHandle)) != LIBUSB_SUCCESS) {
+                MACCAN_DEBUG_ERROR("+++ Unable to open device #%i (%s)\n", index, libusb_error_name(rc));
+                LEAVE_CRITICAL_SECTION(index);
+                MACCAN_DEBUG_FUNC("unlocked\n");
+                return CANUSB_ERROR_RESOURCE;
+            }
+        }
+        rc = libusb_control_transfer(ioHandle, setupPacket.RequestType, setupPacket.Request,
+                                     setupPacket.Value, setupPacket.Index,
+                                     (unsigned char*)buffer, setupPacket.Length, CONTROL_TIMEOUT);
+        if (ioHandle != usbDevice[index].ioHandle)
+            libusb_close(ioHandle);
+        if (rc < 0) {
+            MACCAN_DEBUG_ERROR("+++ Control transfer failed (%s)\n", libusb_error_name(rc));
+            LEAVE_CRITICAL_SECTION(index);
+            MACCAN_DEBUG_FUNC("unlocked\n");
+            return CANUSB_ERROR_RESOURCE;
+        }
+        if (transferred)
+            *transferred = (UInt32)rc;
+    } else {
+        MACCAN_DEBUG_ERROR("+++ Sorry, device #%i is not available\n", index);
+        ret = CANUSB_ERROR_HANDLE;
+    }
+    LEAVE_CRITICAL_SECTION(index);
+    MACCAN_DEBUG_FUNC("unlocked\n");
+    return ret;
+}
+
+CANUSB_Handle_t CANUSB_OpenDevice(CANUSB_Index_t index, UInt16 vendorId, UInt16 productId) {
+    int rc;
+
+    /* must be initialized */
+    if (!fInitialized)
+        return CANUSB_INVALID_HANDLE;
+    /* must be a valid index */
+    if (!IS_INDEX_VALID(index))
+        return CANUSB_INVALID_HANDLE;
+
+    /* open the USB device */
+    MACCAN_DEBUG_FUNC("lock #%i\n", index);
+    ENTER_CRITICAL_SECTION(index);
+    if (usbDevice[index].fPresent &&
+        (usbDevice[index].ioDevice != NULL)) {
+        if (!usbDevice[index].usbInterface.fOpened) {
+            /* Find matching device by vendor id. and product id. (optional) */
+            if ((vendorId != CANUSB_ANY_VENDOR_ID) && (productId != CANUSB_ANY_PRODUCT_ID)) {
+                /* $1 by both vendor id. and product id. */
+                if ((vendorId != usbDevice[index].u16VendorId) || (productId != usbDevice[index].u16ProductId)) {
+                    MACCAN_DEBUG_ERROR("+++ Device #%i doesn't match (vendor = %03x, product = %03x)\n", index, vendorId, productId);
+                    LEAVE_CRITICAL_SECTION(index);
+                    MACCAN_DEBUG_FUNC("unlocked\n");
+                    return CANUSB_INVALID_HANDLE;
+                }
+            } else if (vendorId != CANUSB_ANY_VENDOR_ID) {
+                /* $2 by vendor id. only */
+                if (vendorId != usbDevice[index].u16VendorId) {
+                    MACCAN_DEBUG_ERROR("+++ Device #%i doesn't match (vendor = %03x)\n", index, vendorId);
+                    LEAVE_CRITICAL_SECTION(index);
+                    MACCAN_DEBUG_FUNC("unlocked\n");
+                    return CANUSB_INVALID_HANDLE;
+                }
+            } else if (productId != CANUSB_ANY_PRODUCT_ID) {
+                /* $3 both id.s don't care */
+                MACCAN_DEBUG_ERROR("+++ Nope: vendor id. required (device #%i, product = %03x)\n", index, productId);
+                LEAVE_CRITICAL_SECTION(index);
+                MACCAN_DEBUG_FUNC("unlocked\n");
+                return CANUSB_INVALID_HANDLE;
+            }
+            /* Open the device, configure it and claim its first interface */
+            if ((rc = OpenInterface(index)) != LIBUSB_SUCCESS) {
+                MACCAN_DEBUG_ERROR("+++ Unable to open device #%i (%s)\n", index, libusb_error_name(rc));
+                LEAVE_CRITICAL_SECTION(index);
+                MACCAN_DEBUG_FUNC("unlocked\n");
+                return CANUSB_INVALID_HANDLE;
+            }
+            /* note: fOpened is true */
+        } else {
+            /* all CAN channels on the USB interface are opened */
+            LEAVE_CRITICAL_SECTION(index);
+            MACCAN_DEBUG_FUNC("unlocked\n");
+            return CANUSB_INVALID_HANDLE;
+        }
+    } else {
+        MACCAN_DEBUG_ERROR("+++ Unable to open device #%i (device not present)\n", index);
+        LEAVE_CRITICAL_SECTION(index);
+        MACCAN_DEBUG_FUNC("unlocked\n");
+        return CANUSB_INVALID_HANDLE;
+    }
+    LEAVE_CRITICAL_SECTION(index);
+    MACCAN_DEBUG_FUNC("unlocked\n");
+
+    /* the index is the handle! */
+    return (CANUSB_Handle_t)index;
+}
+
+CANUSB_Return_t CANUSB_CloseDevice(CANUSB_Handle_t handle) {
+    int ret = 0;
+
+    /* must be initialized */
+    if (!fInitialized)
+        return CANUSB_ERROR_NOTINIT;
+    /* must be a valid handle */
+    if (!IS_HANDLE_VALID(handle))
+        return CANUSB_ERROR_HANDLE;
+
+    /* close the USB device */
+    MACCAN_DEBUG_FUNC("lock #%i\n", handle);
+    ENTER_CRITICAL_SECTION(handle);
+    if (usbDevice[handle].ioHandle != NULL) {
+        /* release the interface and close the device (also when it has been removed meanwhile) */
+        MACCAN_DEBUG_CODE(0, "close device handle\n");
+        CloseInterface(handle);
+        if (!usbDevice[handle].fPresent) {
+            /* the removed device can now be released */
+            libusb_unref_device(usbDevice[handle].ioDevice);
+            usbDevice[handle].ioDevice = NULL;
+            ret = CANUSB_ERROR_HANDLE;
+        }
+    } else if (usbDevice[handle].fPresent) {
+        /* the USB interface is not opened */
+        ret = CANUSB_ERROR_NOTINIT;
+    } else {
+        /* the USB device is not available */
+        ret = CANUSB_ERROR_HANDLE;
+    }
+    LEAVE_CRITICAL_SECTION(handle);
+    MACCAN_DEBUG_FUNC("unlocked\n");
+    return ret;
+}
+
+CANUSB_Return_t CANUSB_ReadPipe(CANUSB_Handle_t handle, UInt8 pipeRef, void *buffer, UInt32 *size, UInt16 timeout) {
+    USBEndpoint_t *endpoint;
+    int rc, length = 0;
+    int ret = 0;
+
+    /* must be initialized */
+    if (!fInitialized)
+        return CANUSB_ERROR_NOTINIT;
+    /* must be a valid handle */
+    if (!IS_HANDLE_VALID(handle))
+        return CANUSB_ERROR_HANDLE;
+    /* check for NULL pointer */
+    if (!buffer || !size)
+        return CANUSB_ERROR_NULLPTR;
+
+    MACCAN_DEBUG_FUNC("lock #%i (%u)\n", handle, pipeRef);
+    ENTER_CRITICAL_SECTION(handle);
+    if (usbDevice[handle].fPresent &&
+        (usbDevice[handle].usbInterface.fOpened) &&
+        (usbDevice[handle].ioHandle != NULL)) {
+        if ((pipeRef < 1U) || (pipeRef > usbDevice[handle].usbInterface.u8NumEndpoints)) {
+            MACCAN_DEBUG_ERROR("+++ Invalid pipe #%d of device #%i (ReadPipe)\n", pipeRef, handle);
+            LEAVE_CRITICAL_SECTION(handle);
+            MACCAN_DEBUG_FUNC("unlocked\n");
+            return CANUSB_ERROR_ILLPARA;
+        }
+        endpoint = &usbDevice[handle].usbInterface.endpoint[pipeRef - 1U];
+        /* note: a timeout of 0 means no timeout (like the IOUsbKit) */
+        if ((endpoint->u8Attributes & LIBUSB_TRANSFER_TYPE_MASK) == LIBUSB_TRANSFER_TYPE_INTERRUPT)
+            rc = libusb_interrupt_transfer(usbDevice[handle].ioHandle, endpoint->u8Address,
+                                           (unsigned char*)buffer, (int)*size, &length, (unsigned int)timeout);
+        else
+            rc = libusb_bulk_transfer(usbDevice[handle].ioHandle, endpoint->u8Address,
+                                      (unsigned char*)buffer, (int)*size, &length, (unsigned int)timeout);
+        if (rc != LIBUSB_SUCCESS) {
+            MACCAN_DEBUG_ERROR("+++ Unable to read pipe #%d (%s)\n", pipeRef, libusb_error_name(rc));
+            LEAVE_CRITICAL_SECTION(handle);
+            MACCAN_DEBUG_FUNC("unlocked\n");
+            return MapError(rc);
+        }
+        *size = (UInt32)length;
+    } else {
+        MACCAN_DEBUG_ERROR("+++ Sorry, device #%i is not opened or not available (ReadPipe)\n", handle);
+        ret = !usbDevice[handle].fPresent ? CANUSB_ERROR_HANDLE : CANUSB_ERROR_NOTINIT;
+    }
+    LEAVE_CRITICAL_SECTION(handle);
+    MACCAN_DEBUG_FUNC("unlocked\n");
+    return ret;
+}
+
+CANUSB_Return_t CANUSB_WritePipe(CANUSB_Handle_t handle, UInt8 pipeRef, const void *buffer, UInt32 size, UInt16 timeout) {
+    USBEndpoint_t *endpoint;
+    int rc, length = 0;
+    int ret = 0;
+
+    /* must be initialized */
+    if (!fInitialized)
+        return CANUSB_ERROR_NOTINIT;
+    /* must be a valid handle */
+    if (!IS_HANDLE_VALID(handle))
+        return CANUSB_ERROR_HANDLE;
+    /* check for NULL pointer */
+    if (!buffer)
+        return CANUSB_ERROR_NULLPTR;
+
+    MACCAN_DEBUG_FUNC("lock #%i (%u)\n", handle, pipeRef);
+    ENTER_CRITICAL_SECTION(handle);
+    if (usbDevice[handle].fPresent &&
+        (usbDevice[handle].usbInterface.fOpened) &&
+        (usbDevice[handle].ioHandle != NULL)) {
+        if ((pipeRef < 1U) || (pipeRef > usbDevice[handle].usbInterface.u8NumEndpoints)) {
+            MACCAN_DEBUG_ERROR("+++ Invalid pipe #%d of device #%i (WritePipe)\n", pipeRef, handle);
+            LEAVE_CRITICAL_SECTION(handle);
+            MACCAN_DEBUG_FUNC("unlocked\n");
+            return CANUSB_ERROR_ILLPARA;
+        }
+        endpoint = &usbDevice[handle].usbInterface.endpoint[pipeRef - 1U];
+        /* note: a synchronous transfer handles the events itself when the event thread is busy */
+        if ((endpoint->u8Attributes & LIBUSB_TRANSFER_TYPE_MASK) == LIBUSB_TRANSFER_TYPE_INTERRUPT)
+            rc = libusb_interrupt_transfer(usbDevice[handle].ioHandle, endpoint->u8Address,
+                                           (unsigned char*)buffer, (int)size, &length, (unsigned int)timeout);
+        else
+            rc = libusb_bulk_transfer(usbDevice[handle].ioHandle, endpoint->u8Address,
+                                      (unsigned char*)buffer, (int)size, &length, (unsigned int)timeout);
+        if (rc != LIBUSB_SUCCESS) {
+            MACCAN_DEBUG_ERROR("+++ Unable to write pipe #%d (%s)\n", pipeRef, libusb_error_name(rc));
+            LEAVE_CRITICAL_SECTION(handle);
+            MACCAN_DEBUG_FUNC("unlocked\n");
+            return MapError(rc);
+        }
+    } else {
+        MACCAN_DEBUG_ERROR("+++ Sorry, device #%i is not opened or not available (WritePipe)\n", handle);
+        ret = !usbDevice[handle].fPresent ? CANUSB_ERROR_HANDLE : CANUSB_ERROR_NOTINIT;
+    }
+    LEAVE_CRITICAL_SECTION(handle);
+    MACCAN_DEBUG_FUNC("unlocked\n");
+    return ret;
+}
+
+CANUSB_Return_t CANUSB_ResetPipe(CANUSB_Handle_t handle, UInt8 pipeRef) {
+    int rc, ret = 0;
+
+    /* must be initialized */
+    if (!fInitialized)
+        return CANUSB_ERROR_NOTINIT;
+    /* must be a valid handle */
+    if (!IS_HANDLE_VALID(handle))
+        return CANUSB_ERROR_HANDLE;
+
+    MACCAN_DEBUG_FUNC("lock #%i (%u)\n", handle, pipeRef);
+    ENTER_CRITICAL_SECTION(handle);
+    if (usbDevice[handle].fPresent &&
+        (usbDevice[handle].usbInterface.fOpened) &&
+        (usbDevice[handle].ioHandle != NULL)) {
+        if ((pipeRef < 1U) || (pipeRef > usbDevice[handle].usbInterface.u8NumEndpoints)) {
+            MACCAN_DEBUG_ERROR("+++ Invalid pipe #%d of device #%i (ResetPipe)\n", pipeRef, handle);
+            LEAVE_CRITICAL_SECTION(handle);
+            MACCAN_DEBUG_FUNC("unlocked\n");
+            return CANUSB_ERROR_ILLPARA;
+        }
+        /* note: clears the halt condition on both ends (host and device) */
+        rc = libusb_clear_halt(usbDevice[handle].ioHandle, usbDevice[handle].usbInterface.endpoint[pipeRef - 1U].u8Address);
+        if (rc != LIBUSB_SUCCESS) {
+            MACCAN_DEBUG_ERROR("+++ Unable to clear pipe #%d (%s)\n", pipeRef, libusb_error_name(rc));
+            LEAVE_CRITICAL_SECTION(handle);
+            MACCAN_DEBUG_FUNC("unlocked\n");
+            return CANUSB_ERROR_RESOURCE;
+        }
+    } else {
+        MACCAN_DEBUG_ERROR("+++ Sorry, device #%i is not opened or not available (ResetPipe)\n", handle);
+        ret = !usbDevice[handle].fPresent ? CANUSB_ERROR_HANDLE : CANUSB_ERROR_NOTINIT;
+    }
+    LEAVE_CRITICAL_SECTION(handle);
+    MACCAN_DEBUG_FUNC("unlocked\n");
+    return ret;
+}
+
+CANUSB_AsyncPipe_t CANUSB_CreatePipeAsync(CANUSB_Handle_t handle, UInt8 pipeRef, size_t bufferSize) {
+    /* note: two buffers for compatibility reasons (both are submitted) */
+    return CANUSB_CreatePipeAsyncEx(handle, pipeRef, bufferSize, 2U);
+}
+
+CANUSB_AsyncPipe_t CANUSB_CreatePipeAsyncEx(CANUSB_Handle_t handle, UInt8 pipeRef, size_t bufferSize, UInt32 depth) {
+    CANUSB_AsyncPipe_t asyncPipe = NULL;
+    UInt32 i;
+
+    /* must be initialized */
+    if (!fInitialized)
+        return NULL;
+    /* must be a valid handle */
+    if (!IS_HANDLE_VALID(handle))
+        return NULL;
+    /* check for valid parameters */
+    if (!bufferSize || (depth < 1U) || (depth > CANUSB_MAX_PIPE_DEPTH))
+        return NULL;
+
+    /* create asynchronous pipe context */
+    if ((asyncPipe = (CANUSB_AsyncPipe_t)malloc(sizeof(struct usb_async_pipe_tag))) == NULL) {
+        MACCAN_DEBUG_ERROR("+++ Unable to create asynchronous pipe context for endpoint #%u\n", pipeRef);
+        return NULL;
+    }
+    memset(asyncPipe, 0, sizeof(struct usb_async_pipe_tag));
+    asyncPipe->handle = CANUSB_INVALID_HANDLE;
+    if (pthread_mutex_init(&asyncPipe->ptMutex, NULL) != 0) {
+        MACCAN_DEBUG_ERROR("+++ Unable to create mutex for endpoint #%u\n", pipeRef);
+        free(asyncPipe);
+        return NULL;
+    }
+    /* create a ring of buffers for USB data transfer, each with its own transfer (all of them are submitted) */
+    MACCAN_DEBUG_CORE("        - %u buffer(s) each of size %u bytes for endpoint #%u\n", depth, bufferSize, pipeRef);
+    if (((asyncPipe->buffer.data = (UInt8**)calloc(depth, sizeof(UInt8*))) != NULL) &&
+        ((asyncPipe->transfer = (struct libusb_transfer**)calloc(depth, sizeof(struct libusb_transfer*))) != NULL)) {
+        for (i = 0U; i < depth; i++) {
+            if ((asyncPipe->buffer.data[i] = malloc(bufferSize)) == NULL)
+                break;
+            if ((asyncPipe->transfer[i] = libusb_alloc_transfer(0)) == NULL) {
+                free(asyncPipe->buffer.data[i]);
+                break;
+            }
+        }
+        asyncPipe->buffer.depth = i;
+    }
+    if (asyncPipe->buffer.data && asyncPipe->transfer && (asyncPipe->buffer.depth == depth)) {
+        asyncPipe->buffer.size = (UInt32)bufferSize;
+        asyncPipe->buffer.index = 0U;
+        asyncPipe->buffer.pending = 0U;
+        asyncPipe->callback = NULL;
+        asyncPipe->context = NULL;
+        asyncPipe->pipeRef = pipeRef;
+        asyncPipe->handle = handle;
+    } else {
+        MACCAN_DEBUG_ERROR("+++ Unable to create %u buffer(s) (%u bytes each) for endpoint #%u\n", depth, bufferSize, pipeRef);
+        for (i = 0U; i < asyncPipe->buffer.depth; i++) {
+            libusb_free_transfer(asyncPipe->transfer[i]);
+            free(asyncPipe->buffer.data[i]);
+        }
+        free(asyncPipe->transfer);
+        free(asyncPipe->buffer.data);
+        (void)pthread_mutex_destroy(&asyncPipe->ptMutex);
+        free(asyncPipe);
+        asyncPipe = NULL;
+    }
+    return asyncPipe;
+}
+
+CANUSB_Return_t CANUSB_DestroyPipeAsync(CANUSB_AsyncPipe_t asyncPipe) {
+    UInt32 i;
+
+    /* must be initialized */
+    if (!fInitialized)
+        return CANUSB_ERROR_NOTINIT;
+    /* check for NULL pointer */
+    if (!asyncPipe)
+        return CANUSB_ERROR_NULLPTR;
+    /* must be a valid handle */
+    if (!IS_HANDLE_VALID(asyncPipe->handle))
+        return CANUSB_ERROR_HANDLE;
+    /* if running then abort */
+    if (CANUSB_IsPipeAsyncRunning(asyncPipe) || (__atomic_load_n(&asyncPipe->buffer.pending, __ATOMIC_ACQUIRE) > 0U))
+        (void)CANUSB_AbortPipeAsync(asyncPipe);
+    /* the transfers must not be freed while they are in flight */
+    if (!WaitForPendingTransfers(asyncPipe)) {
+        MACCAN_DEBUG_ERROR("+++ Unable to destroy async pipe #%d of device #%d (%u transfer(s) pending)\n",
+                           asyncPipe->pipeRef, asyncPipe->handle, asyncPipe->buffer.pending);
+        return CANUSB_ERROR_BUSY;
+    }
+    /* free the ring of buffers, the transfers and the asynchronous pipe context */
+    for (i = 0U; i < asyncPipe->buffer.depth; i++) {
+        libusb_free_transfer(asyncPipe->transfer[i]);
+        free(asyncPipe->buffer.data[i]);
+    }
+    free(asyncPipe->transfer);
+    free(asyncPipe->buffer.data);
+    (void)pthread_mutex_destroy(&asyncPipe->ptMutex);
+    free(asyncPipe);
+
+    return CANUSB_SUCCESS;
+}
+
+static void LIBUSB_CALL ReadPipeCallback(struct libusb_transfer *transfer) {
+    CANUSB_AsyncPipe_t asyncPipe = (CANUSB_AsyncPipe_t)transfer->user_data;
+    Boolean resubmitted = false;
+    int rc;
+
+    if (!asyncPipe)
+        return;
+    /* note: the submitted reads of a pipe are completed in the order of their submission */
+    switch (transfer->status)
+    {
+    case LIBUSB_TRANSFER_COMPLETED:
+        /* ring-buffer strategy: the oldest submitted buffer has been completed */
+        asyncPipe->buffer.index = (asyncPipe->buffer.index + 1U) % asyncPipe->buffer.depth;
+        asyncPipe->xferCounter++;
+        /* the pipeline ran dry when no other read is submitted (the device cannot send) */
+        if (__atomic_load_n(&asyncPipe->buffer.pending, __ATOMIC_RELAXED) <= 1U)
+            asyncPipe->dryCounter++;
+        /* call the CALLBACK routine with the referenced pipe context */
+        if (asyncPipe->callback && (transfer->actual_length > 0)) {
+            asyncPipe->callback(asyncPipe->context, transfer->buffer, (UInt32)transfer->actual_length);
+        }
+        /* re-submission of the buffer at the end of the ring (unless the pipe has been aborted meanwhile) */
+        (void)pthread_mutex_lock(&asyncPipe->ptMutex);
+        if (asyncPipe->running) {
+            if ((rc = libusb_submit_transfer(transfer)) != LIBUSB_SUCCESS) {
+                MACCAN_DEBUG_ERROR("+++ Unable to read async pipe #%d of device #%d (%s)\n", asyncPipe->pipeRef, asyncPipe->handle, libusb_error_name(rc));
+                asyncPipe->errCounter++;
+                /* error: pipe is boken (when no read is submitted anymore) */
+                if (__atomic_load_n(&asyncPipe->buffer.pending, __ATOMIC_RELAXED) <= 1U)
+                    asyncPipe->running = false;
+            } else {
+                resubmitted = true;
+            }
+        }
+        (void)pthread_mutex_unlock(&asyncPipe->ptMutex);
+        break;
+    case LIBUSB_TRANSFER_CANCELLED:
+        MACCAN_DEBUG_CORE("!!! Aborted: read async pipe #%d of device #%d\n", asyncPipe->pipeRef, asyncPipe->handle);
+        (void)pthread_mutex_lock(&asyncPipe->ptMutex);
+        asyncPipe->running = false;
+        (void)pthread_mutex_unlock(&asyncPipe->ptMutex);
+        break;
+    default:
+        /* note: LIBUSB_TRANSFER_NO_DEVICE when the device has been removed */
+        MACCAN_DEBUG_ERROR("+++ Error: read async pipe #%d of device #%d (status %d)\n", asyncPipe->pipeRef, asyncPipe->handle, transfer->status);
+        (void)pthread_mutex_lock(&asyncPipe->ptMutex);
+        asyncPipe->running = false;
+        (void)pthread_mutex_unlock(&asyncPipe->ptMutex);
+        break;
+    }
+    /* note: the pipe context must not be touched after the last pending read has been counted off (it can be destroyed) */
+    if (!resubmitted)
+        (void)__atomic_sub_fetch(&asyncPipe->buffer.pending, 1U, __ATOMIC_RELEASE);
+    return;
+}
+
+CANUSB_Return_t CANUSB_ReadPipeAsync(CANUSB_AsyncPipe_t asyncPipe, CANUSB_AsyncPipeCbk_t callback, CANUSB_Context_t context) {
+    USBEndpoint_t *endpoint;
+    int rc = LIBUSB_SUCCESS;
+    UInt32 i;
+    int ret = 0;
+
+    /* must be initialized */
+    if (!fInitialized)
+        return CANUSB_ERROR_NOTINIT;
+    /* check for NULL pointer */
+    if (!asyncPipe ||
+        !asyncPipe->buffer.data)
+        return CANUSB_ERROR_NULLPTR;
+    /* must be a valid handle */
+    if (!IS_HANDLE_VALID(asyncPipe->handle))
+        return CANUSB_ERROR_HANDLE;
+
+    MACCAN_DEBUG_FUNC("lock #%i (%u)\n", asyncPipe->handle, asyncPipe->pipeRef);
+    ENTER_CRITICAL_SECTION(asyncPipe->handle);
+    if (CANUSB_IsPipeAsyncRunning(asyncPipe) || (__atomic_load_n(&asyncPipe->buffer.pending, __ATOMIC_ACQUIRE) > 0U)) {
+        MACCAN_DEBUG_ERROR("+++ Async read of pipe #%d already started\n", asyncPipe->pipeRef);
+        LEAVE_CRITICAL_SECTION(asyncPipe->handle);
+        MACCAN_DEBUG_FUNC("unlocked\n");
+        return CANUSB_ERROR_RESOURCE;
+    }
+    if (usbDevice[asyncPipe->handle].fPresent &&
+        (usbDevice[asyncPipe->handle].usbInterface.fOpened) &&
+        (usbDevice[asyncPipe->handle].ioHandle != NULL)) {
+        if ((asyncPipe->pipeRef < 1U) || (asyncPipe->pipeRef > usbDevice[asyncPipe->handle].usbInterface.u8NumEndpoints)) {
+            MACCAN_DEBUG_ERROR("+++ Invalid pipe #%d of device #%i (ReadPipeAsync)\n", asyncPipe->pipeRef, asyncPipe->handle);
+            LEAVE_CRITICAL_SECTION(asyncPipe->handle);
+            MACCAN_DEBUG_FUNC("unlocked\n");
+            return CANUSB_ERROR_ILLPARA;
+        }
+        endpoint = &usbDevice[asyncPipe->handle].usbInterface.endpoint[asyncPipe->pipeRef - 1U];
+        /* register the callback function and the reception data context */
+        asyncPipe->callback = callback;
+        asyncPipe->context = context;
+        /* submission of the asynchronous reads, one per buffer (with our pipe context as user data) */
+        /* note: the first reads can be completed before the last one is submitted (by the event thread of the driver) */
+        (void)pthread_mutex_lock(&asyncPipe->ptMutex);
+        asyncPipe->buffer.index = 0U;
+        asyncPipe->buffer.pending = 0U;
+        asyncPipe->running = true;
+        for (i = 0U; i < asyncPipe->buffer.depth; i++) {
+            if ((endpoint->u8Attributes & LIBUSB_TRANSFER_TYPE_MASK) == LIBUSB_TRANSFER_TYPE_INTERRUPT)
+                libusb_fill_interrupt_transfer(asyncPipe->transfer[i], usbDevice[asyncPipe->handle].ioHandle, endpoint->u8Address,
+                                               asyncPipe->buffer.data[i], (int)asyncPipe->buffer.size,
+                                               ReadPipeCallback, (void*)asyncPipe, 0U);
+            else
+                libusb_fill_bulk_transfer(asyncPipe->transfer[i], usbDevice[asyncPipe->handle].ioHandle, endpoint->u8Address,
+                                          asyncPipe->buffer.data[i], (int)asyncPipe->buffer.size,
+                                          ReadPipeCallback, (void*)asyncPipe, 0U);
+            (void)__atomic_add_fetch(&asyncPipe->buffer.pending, 1U, __ATOMIC_RELAXED);
+            if ((rc = libusb_submit_transfer(asyncPipe->transfer[i])) != LIBUSB_SUCCESS) {
+                (void)__atomic_sub_fetch(&asyncPipe->buffer.pending, 1U, __ATOMIC_RELAXED);
+                break;
+            }
+        }
+        if (i == 0U) {
+            MACCAN_DEBUG_ERROR("+++ Unable to start async read pipe #%d of device #%d (%s)\n", asyncPipe->pipeRef, asyncPipe->handle, libusb_error_name(rc));
+            asyncPipe->running = false;
+            (void)pthread_mutex_unlock(&asyncPipe->ptMutex);
+            LEAVE_CRITICAL_SECTION(asyncPipe->handle);
+            MACCAN_DEBUG_FUNC("unlocked\n");
+            return CANUSB_ERROR_RESOURCE;
+        }
+        if (i < asyncPipe->buffer.depth) {
+            MACCAN_DEBUG_ERROR("+++ Only %u of %u read(s) submitted to async pipe #%d of device #%d (%s)\n", i, asyncPipe->buffer.depth, asyncPipe->pipeRef, asyncPipe->handle, libusb_error_name(rc));
+            asyncPipe->errCounter++;
+        }
+        (void)pthread_mutex_unlock(&asyncPipe->ptMutex);
+        /* asynchronous pipe reads submitted */
+    } else {
+        MACCAN_DEBUG_ERROR("+++ Sorry, device #%i is not opened or not available (ReadPipeAsync)\n", asyncPipe->handle);
+        ret = !usbDevice[asyncPipe->handle].fPresent ? CANUSB_ERROR_HANDLE : CANUSB_ERROR_NOTINIT;
+    }
+    LEAVE_CRITICAL_SECTION(asyncPipe->handle);
+    MACCAN_DEBUG_FUNC("unlocked\n");
+    return ret;
+}
+
+CANUSB_Return_t CANUSB_AbortPipeAsync(CANUSB_AsyncPipe_t asyncPipe) {
+    UInt32 i;
+    int ret = 0;
+
+    /* must be initialized */
+    if (!fInitialized)
+        return CANUSB_ERROR_NOTINIT;
+    /* check for NULL pointer */
+    if (!asyncPipe)
+        return CANUSB_ERROR_NULLPTR;
+    /* must be a valid handle */
+    if (!IS_HANDLE_VALID(asyncPipe->handle))
+        return CANUSB_ERROR_HANDLE;
+
+    MACCAN_DEBUG_FUNC("lock #%i (%u)\n", asyncPipe->handle, asyncPipe->pipeRef);
+    ENTER_CRITICAL_SECTION(asyncPipe->handle);
+    if (usbDevice[asyncPipe->handle].ioHandle != NULL) {
+        /* cancel all submitted reads (no re-submission from now on) */
+        (void)pthread_mutex_lock(&asyncPipe->ptMutex);
+        asyncPipe->running = false;
+        for (i = 0U; i < asyncPipe->buffer.depth; i++)
+            (void)libusb_cancel_transfer(asyncPipe->transfer[i]);  /* note: LIBUSB_ERROR_NOT_FOUND if not submitted */
+        (void)pthread_mutex_unlock(&asyncPipe->ptMutex);
+        if (!usbDevice[asyncPipe->handle].fPresent)
+            ret = CANUSB_ERROR_HANDLE;
+    } else {
+        MACCAN_DEBUG_ERROR("+++ Sorry, device #%i is not opened or not available (AbortPipeAsync)\n", asyncPipe->handle);
+        ret = !usbDevice[asyncPipe->handle].fPresent ? CANUSB_ERROR_HANDLE : CANUSB_ERROR_NOTINIT;
+    }
+    LEAVE_CRITICAL_SECTION(asyncPipe->handle);
+    MACCAN_DEBUG_FUNC("unlocked\n");
+
+    /* wait until the cancelled reads are completed by the event thread (not possible from a callback) */
+    if (!WaitForPendingTransfers(asyncPipe)) {
+        MACCAN_DEBUG_ERROR("+++ Unable to abort async pipe #%d (%u transfer(s) pending)\n", asyncPipe->pipeRef, asyncPipe->buffer.pending);
+        if (!ret)
+            ret = CANUSB_ERROR_RESOURCE;
+    }
+    return ret;
+}
+
+Boolean CANUSB_IsPipeAsyncRunning(CANUSB_AsyncPipe_t asyncPipe) {
+    Boolean running = false;
+
+    /* must be initialized */
+    if (!fInitialized)
+        return false;
+    /* check for NULL pointer */
+    if (!asyncPipe)
+        return false;
+    /* must be a valid handle */
+    if (!IS_HANDLE_VALID(asyncPipe->handle))
+        return false;
+
+    /* return true if asynchronous operation is running, false otherwise */
+    MACCAN_DEBUG_FUNC("lock #%i (%u)\n", asyncPipe->handle, asyncPipe->pipeRef);
+    (void)pthread_mutex_lock(&asyncPipe->ptMutex);
+    running = asyncPipe->running;
+    (void)pthread_mutex_unlock(&asyncPipe->ptMutex);
+    MACCAN_DEBUG_FUNC("unlocked\n");
+    return running;
+}
+
+CANUSB_Return_t CANUSB_GetPipeAsyncStats(CANUSB_AsyncPipe_t asyncPipe, CANUSB_PipeStats_t *stats) {
+
+    /* must be initialized */
+    if (!fInitialized)
+        return CANUSB_ERROR_NOTINIT;
+    /* check for NULL pointer */
+    if (!asyncPipe || !stats)
+        return CANUSB_ERROR_NULLPTR;
+    /* must be a valid handle */
+    if (!IS_HANDLE_VALID(asyncPipe->handle))
+        return CANUSB_ERROR_HANDLE;
+
+    /* note: the counters are updated by the event thread of the driver (w/o lock) */
+    stats->depth = asyncPipe->buffer.depth;
+    stats->size = asyncPipe->buffer.size;
+    stats->pending = asyncPipe->buffer.pending;
+    stats->transfers = asyncPipe->xferCounter;
+    stats->dryRuns = asyncPipe->dryCounter;
+    stats->errors = asyncPipe->errCounter;
+    return CANUSB_SUCCESS;
+}
+
+CANUSB_Index_t CANUSB_GetFirstDevice(void) {
+    CANUSB_Index_t index = CANUSB_INVALID_INDEX;
+
+    /* must be initialized */
+    if (!fInitialized)
+        return CANUSB_INVALID_INDEX;
+
+    /* get the first registered device, if any */
+    idxDevice = 0;
+    while (idxDevice < CANUSB_MAX_DEVICES) {
+        if (usbDevice[idxDevice].fPresent &&
+            (usbDevice[idxDevice].ioDevice != NULL)) {
+            index = idxDevice;
+            break;
+        }
+        idxDevice++;
+    }
+    return index;
+}
+
+CANUSB_Index_t CANUSB_GetNextDevice(void) {
+    CANUSB_Index_t index = CANUSB_INVALID_INDEX;
+
+    /* must be initialized */
+    if (!fInitialized)
+        return CANUSB_INVALID_INDEX;
+
+    /* get the next registered device, if any */
+    if (idxDevice < CANUSB_MAX_DEVICES)
+        idxDevice += 1;
+    while (idxDevice < CANUSB_MAX_DEVICES) {
+        if (usbDevice[idxDevice].fPresent &&
+            (usbDevice[idxDevice].ioDevice != NULL)) {
+            index = idxDevice;
+            break;
+        }
+        idxDevice++;
+    }
+    return index;
+}
+
+Boolean CANUSB_IsDevicePresent(CANUSB_Index_t index) {
+    Boolean ret = false;
+
+    /* must be initialized */
+    if (!fInitialized)
+        return false;
+    /* must be a valid index */
+    if (!IS_INDEX_VALID(index))
+        return false;
+
+    MACCAN_DEBUG_FUNC("lock #%i\n", index);
+    ENTER_CRITICAL_SECTION(index);
+    if (usbDevice[index].fPresent &&
+        (usbDevice[index].ioDevice != NULL))
+        ret = true;
+    LEAVE_CRITICAL_SECTION(index);
+    MACCAN_DEBUG_FUNC("unlocked\n");
+    return ret;
+}
+
+Boolean CANUSB_IsDeviceInUse(CANUSB_Index_t index) {
+    libusb_device_handle *ioHandle;
+    Boolean ret = false;
+    int rc;
+
+    /* must be initialized */
+    if (!fInitialized)
+        return false;
+    /* must be a valid index */
+    if (!IS_INDEX_VALID(index))
+        return false;
+
+    MACCAN_DEBUG_FUNC("lock #%i\n", index);
+    ENTER_CRITICAL_SECTION(index);
+    if (usbDevice[index].fPresent &&
+        (usbDevice[index].ioDevice != NULL)) {
+        if (usbDevice[index].usbInterface.fOpened &&
+            (usbDevice[index].ioHandle != NULL))
+            ret = true;
+        else {
+            /* check if the device is used by another process by trying to claim its interface */
+            if ((rc = libusb_open(usbDevice[index].ioDevice, &ioHandle)) == LIBUSB_SUCCESS) {
+                (void)libusb_set_auto_detach_kernel_driver(ioHandle, 1);
+                if ((rc = libusb_claim_interface(ioHandle, usbDevice[index].usbInterface.u8Number)) == LIBUSB_SUCCESS)
+                    (void)libusb_release_interface(ioHandle, usbDevice[index].usbInterface.u8Number);
+                libusb_close(ioHandle);  /* note: close the device immediately! */
+            }
+            ret = (rc != LIBUSB_SUCCESS) ? true : false;
+        }
+    }
+    LEAVE_CRITICAL_SECTION(index);
+    MACCAN_DEBUG_FUNC("unlocked\n");
+    return ret;
+}
+
+Boolean CANUSB_IsDeviceOpened(CANUSB_Index_t index) {
+    Boolean ret = false;
+
+    /* must be initialized */
+    if (!fInitialized)
+        return false;
+    /* must be a valid index */
+    if (!IS_INDEX_VALID(index))
+        return false;
+
+    MACCAN_DEBUG_FUNC("lock #%i\n", index);
+    ENTER_CRITICAL_SECTION(index);
+    if (usbDevice[index].fPresent &&
+        (usbDevice[index].ioDevice != NULL) &&
+        (usbDevice[index].usbInterface.fOpened) &&
+        (usbDevice[index].ioHandle != NULL))
+        ret = true;
+    LEAVE_CRITICAL_SECTION(index);
+    MACCAN_DEBUG_FUNC("unlocked\n");
+    return ret;
+}
+
+/* note: the device properties are read from a present device */
+#define GET_DEVICE_PROPERTY(index, expr)  do { \
+    int ret = 0; \
+    if (!fInitialized) \
+        return CANUSB_ERROR_NOTINIT; \
+    if (!IS_INDEX_VALID(index)) \
+        return CANUSB_ERROR_HANDLE; \
+    if (!value) \
+        return CANUSB_ERROR_NULLPTR; \
+    ENTER_CRITICAL_SECTION(index); \
+    if (usbDevice[index].fPresent && (usbDevice[index].ioDevice != NULL)) \
+        expr; \
+    else \
+        ret = CANUSB_ERROR_HANDLE; \
+    LEAVE_CRITICAL_SECTION(index); \
+    return ret; \
+} while (0)
+
+/* note: the interface properties are read from an opened device */
+#define GET_INTERFACE_PROPERTY(handle, expr)  do { \
+    int ret = 0; \
+    if (!fInitialized) \
+        return CANUSB_ERROR_NOTINIT; \
+    if (!IS_HANDLE_VALID(handle)) \
+        return CANUSB_ERROR_HANDLE; \
+    if (!value) \
+        return CANUSB_ERROR_NULLPTR; \
+    ENTER_CRITICAL_SECTION(handle); \
+    if (usbDevice[handle].fPresent && usbDevice[handle].usbInterface.fOpened) \
+        expr; \
+    else \
+        ret = !usbDevice[handle].fPresent ? CANUSB_ERROR_HANDLE : CANUSB_ERROR_NOTINIT; \
+    LEAVE_CRITICAL_SECTION(handle); \
+    return ret; \
+} while (0)
+
+/* note: the endpoint properties are read from an opened device (pipe #1 is the first endpoint) */
+#define GET_ENDPOINT_PROPERTY(handle, index, expr)  GET_INTERFACE_PROPERTY(handle, \
+    ((index < 1U) || (index > usbDevice[handle].usbInterface.u8NumEndpoints)) ? \
+        (void)(ret = CANUSB_ERROR_RESOURCE) : (void)(expr))
+
+CANUSB_Return_t CANUSB_GetDeviceUsbName(CANUSB_Index_t index, char *buffer, size_t n) {
+    char *value = buffer;
+
+    if (!n)
+        return CANUSB_ERROR_ILLPARA;
+    GET_DEVICE_PROPERTY(index, (void)snprintf(value, n, "%s", usbDevice[index].szName));
+}
+
+CANUSB_Return_t CANUSB_GetDeviceVendorId(CANUSB_Index_t index, UInt16 *value) {
+    GET_DEVICE_PROPERTY(index, *value = usbDevice[index].u16VendorId);
+}
+
+CANUSB_Return_t CANUSB_GetDeviceProductId(CANUSB_Index_t index, UInt16 *value) {
+    GET_DEVICE_PROPERTY(index, *value = usbDevice[index].u16ProductId);
+}
+
+CANUSB_Return_t CANUSB_GetDeviceReleaseNo(CANUSB_Index_t index, UInt16 *value) {
+    GET_DEVICE_PROPERTY(index, *value = usbDevice[index].u16ReleaseNo);
+}
+
+CANUSB_Return_t CANUSB_GetDeviceLocation(CANUSB_Index_t index, UInt32 *value) {
+    GET_DEVICE_PROPERTY(index, *value = usbDevice[index].u32Location);
+}
+
+CANUSB_Return_t CANUSB_GetDeviceAddress(CANUSB_Index_t index, UInt16 *value) {
+    GET_DEVICE_PROPERTY(index, *value = usbDevice[index].u16Address);
+}
+
+CANUSB_Return_t CANUSB_GetDeviceNumCanChannels(CANUSB_Index_t index, UInt8 *value) {
+    GET_DEVICE_PROPERTY(index, *value = usbDevice[index].nCanChannels);
+}
+
+CANUSB_Return_t CANUSB_GetDeviceCanChannelsOpened(CANUSB_Index_t index, UInt8 *value) {
+    GET_DEVICE_PROPERTY(index, *value = usbDevice[index].usbInterface.fOpened ? 1U : 0U);
+}
+
+CANUSB_Return_t CANUSB_GetInterfaceClass(CANUSB_Handle_t handle, UInt8 *value) {
+    GET_INTERFACE_PROPERTY(handle, *value = usbDevice[handle].usbInterface.u8Class);
+}
+
+CANUSB_Return_t CANUSB_GetInterfaceSubClass(CANUSB_Handle_t handle, UInt8 *value) {
+    GET_INTERFACE_PROPERTY(handle, *value = usbDevice[handle].usbInterface.u8SubClass);
+}
+
+CANUSB_Return_t CANUSB_GetInterfaceProtocol(CANUSB_Handle_t handle, UInt8 *value) {
+    GET_INTERFACE_PROPERTY(handle, *value = usbDevice[handle].usbInterface.u8Protocol);
+}
+
+CANUSB_Return_t CANUSB_GetInterfaceNumEndpoints(CANUSB_Handle_t handle, UInt8 *value) {
+    GET_INTERFACE_PROPERTY(handle, *value = usbDevice[handle].usbInterface.u8NumEndpoints);
+}
+
+CANUSB_Return_t CANUSB_GetInterfaceEndpointDirection(CANUSB_Handle_t handle, UInt8 index, UInt8 *value) {
+    /* 0 = out / 1 = in / 2 = none */
+    GET_ENDPOINT_PROPERTY(handle, index,
+        *value = (usbDevice[handle].usbInterface.endpoint[index - 1U].u8Address & LIBUSB_ENDPOINT_IN) ? USBPIPE_DIR_IN : USBPIPE_DIR_OUT);
+}
+
+CANUSB_Return_t CANUSB_GetInterfaceEndpointTransferType(CANUSB_Handle_t handle, UInt8 index, UInt8 *value) {
+    /* 0 = Control / 1 = ISOC / 2 = Bulk / 3 = Interrupt */
+    GET_ENDPOINT_PROPERTY(handle, index,
+        *value = usbDevice[handle].usbInterface.endpoint[index - 1U].u8Attributes & LIBUSB_TRANSFER_TYPE_MASK);
+}
+
+CANUSB_Return_t CANUSB_GetInterfaceEndpointMaxPacketSize(CANUSB_Handle_t handle, UInt8 index, UInt16 *value) {
+    /* as a 16-bit value */
+    GET_ENDPOINT_PROPERTY(handle, index,
+        *value = usbDevice[handle].usbInterface.endpoint[index - 1U].u16MaxPacketSize);
+}
+
+UInt32 CANUSB_GetVersion(void) {
+    return ((UInt32)VERSION_MAJOR << 24) |
+           ((UInt32)VERSION_MINOR << 16) |
+           ((UInt32)VERSION_PATCH << 8);
+}
+
+UInt32 CANUSB_GetRevision(void) {
+    return 0U;
+}
+
+/*
+ *  libusb-1.0 API reference
+ *  See https://libusb.sourceforge.io/api-1.0/
+ */
+static int LIBUSB_CALL HotplugCallback(libusb_context *ctx, libusb_device *device, libusb_hotplug_event event, void *user_data)
+{
+    struct libusb_device_descriptor desc;
+
+    /* note: the device descriptor is cached (no I/O in the callback) */
+    if ((libusb_get_device_descriptor(device, &desc) != LIBUSB_SUCCESS) ||
+        (CANDEV_GetDeviceById(desc.idVendor, desc.idProduct) == NULL))
+        return 0;
+    /* queue the event, it is processed by the event thread */
+    (void)pthread_mutex_lock(&usbDriver.ptMutex);
+    if (usbDriver.hotplugCount < HOTPLUG_QUEUE_SIZE) {
+        UInt32 tail = (usbDriver.hotplugHead + usbDriver.hotplugCount) % HOTPLUG_QUEUE_SIZE;
+        usbDriver.hotplugQueue[tail].device = libusb_ref_device(device);
+        usbDriver.hotplugQueue[tail].event = event;
+        usbDriver.hotplugCount++;
+    } else {
+        MACCAN_DEBUG_ERROR("+++ Hotplug event lost (vendor = %03x, product = %03x)\n", desc.idVendor, desc.idProduct);
+    }
+    (void)pthread_mutex_unlock(&usbDriver.ptMutex);
+    (void)ctx;
+    (void)user_data;
+    return 0;  /* note: 1 would deregister the callback */
+}
+
+static void ProcessHotplugEvents(void)
+{
+    USBHotplug_t hotplug;
+
+    for (;;) {
+        (void)pthread_mutex_lock(&usbDriver.ptMutex);
+        if (usbDriver.hotplugCount == 0U) {
+            (void)pthread_mutex_unlock(&usbDriver.ptMutex);
+            break;
+        }
+        hotplug = usbDriver.hotplugQueue[usbDriver.hotplugHead];
+        usbDriver.hotplugHead = (usbDriver.hotplugHead + 1U) % HOTPLUG_QUEUE_SIZE;
+        usbDriver.hotplugCount--;
+        (void)pthread_mutex_unlock(&usbDriver.ptMutex);
+
+        if (hotplug.event == LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED)
+            DeviceAdded(hotplug.device);
+        else
+            DeviceRemoved(hotplug.device);
+        libusb_unref_device(hotplug.device);
+    }
+}
+
+static void EnumerateDevices(void)
+{
+    libusb_device **list;
+    ssize_t count, i;
+
+    if ((count = libusb_get_device_list(usbDriver.ioContext, &list)) < 0) {
+        MACCAN_DEBUG_ERROR("+++ Unable to get device list (%s)\n", libusb_error_name((int)count));
+        return;
+    }
+    for (i = 0; i < count; i++)
+        DeviceAdded(list[i]);
+    libusb_free_device_list(list, 1);
+}
+
+static void DeviceAdded(libusb_device *device)
+{
+    struct libusb_device_descriptor desc;
+    UInt8 ports[7];
+    UInt32 location;
+    UInt16 address;
+    int index, found, n, i;
+    const CANDEV_Device_t * canDevice;
+
+    /* Check the vendor and product values to confirm we've got the right device */
+    if (libusb_get_device_descriptor(device, &desc) != LIBUSB_SUCCESS)
+        return;
+    if ((canDevice = CANDEV_GetDeviceById(desc.idVendor, desc.idProduct)) == NULL)
+        return;
+    /* The location ID as on macOS: bus number and a nibble per port number */
+    location = (UInt32)libusb_get_bus_number(device) << 24;
+    n = libusb_get_port_numbers(device, ports, (int)sizeof(ports));
+    for (i = 0; (i < n) && (i < 6); i++)
+        location |= (UInt32)(ports[i] & 0xFU) << (20 - (4 * i));
+    address = (UInt16)libusb_get_device_address(device);
+    MACCAN_DEBUG_CORE("    - One device added at location %08x\n", location);
+
+    /* look for a free entry in the device list (an entry of a removed device is free when it is closed) */
+    for (index = 0, found = 0; (index < CANUSB_MAX_DEVICES) && !found; index++) {
+        ENTER_CRITICAL_SECTION(index);
+        if (usbDevice[index].ioDevice == device) {
+            /* already registered (enumerated and notified) */
+            found = 1;
+        } else if (!usbDevice[index].fPresent && (usbDevice[index].ioDevice == NULL)) {
+            MACCAN_DEBUG_CORE("      - Device #%i: vendor = %03x, product = %03x, release = %04x\n", index,
+                                         desc.idVendor, desc.idProduct, desc.bcdDevice);
+            /* store the properties of the added device */
+            memset(&usbDevice[index].usbInterface, 0, sizeof(USBInterface_t));
+            usbDevice[index].usbInterface.fOpened = false;
+            /* note: the product string is read when the device is opened */
+            (void)snprintf(usbDevice[index].szName, MAX_STRING_LENGTH, "USB device %04x:%04x", desc.idVendor, desc.idProduct);
+            usbDevice[index].u16VendorId = desc.idVendor;
+            usbDevice[index].u16ProductId = desc.idProduct;
+            usbDevice[index].u16ReleaseNo = desc.bcdDevice;
+            usbDevice[index].u32Location = location;
+            usbDevice[index].u16Address = address;
+            usbDevice[index].ioDevice = libusb_ref_device(device);
+            usbDevice[index].ioHandle = NULL;
+            usbDevice[index].fPresent = true;
+            found = 1;
+            /* get number of CAN channels from device list */
+            usbDevice[index].nCanChannels = canDevice->numChannels;
+        }
+        LEAVE_CRITICAL_SECTION(index);
+    }
+    if (!found) {
+        /* no free entry available */
+        MACCAN_DEBUG_ERROR("+++ No free entry available for new device (vendor = %03x, product = %03x)\n", desc.idVendor, desc.idProduct);
+    }
+}
+
+static void DeviceRemoved(libusb_device *device)
+{
+    int index;
+
+    /* remove the device from the device list */
+    for (index = 0; index < CANUSB_MAX_DEVICES; index++) {
+        ENTER_CRITICAL_SECTION(index);
+        if (usbDevice[index].ioDevice == device) {
+            MACCAN_DEBUG_CORE("    - One device removed from location %08x\n", usbDevice[index].u32Location);
+            MACCAN_DEBUG_CORE("      - Device #%i is %s available (vendor = %03x, product = %03x)\n", index,
+                         usbDevice[index].fPresent? "not longer" : "not", usbDevice[index].u16VendorId, usbDevice[index].u16ProductId);
+            usbDevice[index].fPresent = false;
+            /* note: an opened device is released when it is closed (its handle is still in use) */
+            if (usbDevice[index].ioHandle == NULL) {
+                libusb_unref_device(usbDevice[index].ioDevice);
+                usbDevice[index].ioDevice = NULL;
+            }
+        }
+        LEAVE_CRITICAL_SECTION(index);
+    }
+}
+
+static int OpenInterface(CANUSB_Index_t index)
+{
+    struct libusb_config_descriptor *config = NULL;
+    const struct libusb_interface_descriptor *interface;
+    libusb_device_handle *ioHandle = NULL;
+    USBInterface_t *usbInterface = &usbDevice[index].usbInterface;
+    unsigned char name[MAX_STRING_LENGTH];
+    struct libusb_device_descriptor desc;
+    int configuration = 0;
+    int rc, i;
+
+    /* Open the device */
+    if ((rc = libusb_open(usbDevice[index].ioDevice, &ioHandle)) != LIBUSB_SUCCESS)
+        return rc;
+    (void)libusb_set_auto_detach_kernel_driver(ioHandle, 1);
+    /* Configure the device (first configuration, if not configured) */
+    if ((rc = libusb_get_configuration(ioHandle, &configuration)) != LIBUSB_SUCCESS)
+        goto error_open;
+    if ((configuration == 0) &&
+        ((rc = libusb_set_configuration(ioHandle, 1)) != LIBUSB_SUCCESS))
+        goto error_open;
+    /* Get the first interface (first alternate setting) and its endpoints */
+    if ((rc = libusb_get_active_config_descriptor(usbDevice[index].ioDevice, &config)) != LIBUSB_SUCCESS)
+        goto error_open;
+    if ((config->bNumInterfaces < 1U) || (config->interface[0].num_altsetting < 1)) {
+        rc = LIBUSB_ERROR_NOT_FOUND;
+        goto error_config;
+    }
+    interface = &config->interface[0].altsetting[0];
+    memset(usbInterface, 0, sizeof(USBInterface_t));
+    usbInterface->u8Number = interface->bInterfaceNumber;
+    usbInterface->u8Class = interface->bInterfaceClass;
+    usbInterface->u8SubClass = interface->bInterfaceSubClass;
+    usbInterface->u8Protocol = interface->bInterfaceProtocol;
+    usbInterface->u8NumEndpoints = (interface->bNumEndpoints <= MAX_ENDPOINTS) ? interface->bNumEndpoints : MAX_ENDPOINTS;
+    for (i = 0; i < (int)usbInterface->u8NumEndpoints; i++) {
+        usbInterface->endpoint[i].u8Address = interface->endpoint[i].bEndpointAddress;
+        usbInterface->endpoint[i].u8Attributes = interface->endpoint[i].bmAttributes;
+        usbInterface->endpoint[i].u16MaxPacketSize = interface->endpoint[i].wMaxPacketSize;
+        MACCAN_DEBUG_CORE("        - Pipe #%i: endpoint %02x, attributes %02x, max. packet size %u\n", i + 1,
+                          interface->endpoint[i].bEndpointAddress, interface->endpoint[i].bmAttributes, interface->endpoint[i].wMaxPacketSize);
+    }
+    libusb_free_config_descriptor(config);
+    /* Claim the interface for exclusive access */
+    if ((rc = libusb_claim_interface(ioHandle, usbInterface->u8Number)) != LIBUSB_SUCCESS)
+        goto error_open;
+    /* Get the USB device's name (from its product string) */
+    if ((libusb_get_device_descriptor(usbDevice[index].ioDevice, &desc) == LIBUSB_SUCCESS) && desc.iProduct &&
+        (libusb_get_string_descriptor_ascii(ioHandle, desc.iProduct, name, (int)sizeof(name)) > 0))
+        (void)snprintf(usbDevice[index].szName, MAX_STRING_LENGTH, "%s", (char*)name);
+    usbDevice[index].ioHandle = ioHandle;
+    usbInterface->fOpened = true;
+    return LIBUSB_SUCCESS;
+
+error_config:
+    libusb_free_config_descriptor(config);
+error_open:
+    libusb_close(ioHandle);
+    memset(usbInterface, 0, sizeof(USBInterface_t));
+    return rc;
+}
+
+static void CloseInterface(CANUSB_Index_t index)
+{
+    /* note: the interface cannot be released from a removed device */
+    if (usbDevice[index].usbInterface.fOpened)
+        (void)libusb_release_interface(usbDevice[index].ioHandle, usbDevice[index].usbInterface.u8Number);
+    libusb_close(usbDevice[index].ioHandle);
+    usbDevice[index].ioHandle = NULL;
+    usbDevice[index].usbInterface.fOpened = false;
+}
+
+static Boolean WaitForPendingTransfers(CANUSB_AsyncPipe_t asyncPipe)
+{
+    int timeout = ABORT_TIMEOUT;
+
+    /* note: the event thread cannot wait for itself (e.g. when called from a callback) */
+    if (usbDriver.fRunning && pthread_equal(pthread_self(), usbDriver.ptThread))
+        return (__atomic_load_n(&asyncPipe->buffer.pending, __ATOMIC_ACQUIRE) == 0U) ? true : false;
+    while ((__atomic_load_n(&asyncPipe->buffer.pending, __ATOMIC_ACQUIRE) > 0U) && (timeout-- > 0))
+        usleep(1000);
+    return (__atomic_load_n(&asyncPipe->buffer.pending, __ATOMIC_ACQUIRE) == 0U) ? true : false;
+}
+
+static int MapError(int rc)
+{
+    switch (rc) {
+    case LIBUSB_SUCCESS: return CANUSB_SUCCESS;
+    case LIBUSB_ERROR_TIMEOUT: return CANUSB_ERROR_TIMEOUT;
+    case LIBUSB_ERROR_PIPE: return CANUSB_ERROR_STALLED;
+    case LIBUSB_ERROR_NO_DEVICE: return CANUSB_ERROR_HANDLE;
+    default: return CANUSB_ERROR_RESOURCE;
+    }
+}
+
+static void* EventThread(void* arg)
+{
+    struct timeval tv;
+
+    MACCAN_DEBUG_CORE("    - Event thread started\n");
+    while (__atomic_load_n(&usbDriver.fRunning, __ATOMIC_SEQ_CST)) {
+        /* complete the transfers (and notify the hotplug events) */
+        tv.tv_sec = 0;
+        tv.tv_usec = EVENT_TIMEOUT;
+        (void)libusb_handle_events_timeout_completed(usbDriver.ioContext, &tv, NULL);
+        /* register or unregister the notified devices (w/o holding the event lock) */
+        ProcessHotplugEvents();
+    }
+    MACCAN_DEBUG_CORE("    - Event thread stopped\n");
+    (void)arg;
+    return NULL;
+}
@@ -53,61 +53,166 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
 #include <pthread.h>
+#include <stdatomic.h>
 
-#define GET_TIME(ts)  do{ clock_gettime(CLOCK_REALTIME, &ts); } while(0)
+#ifndef CANQUE_CACHE_LINE_SIZE
+#if defined(__arm64__) || defined(__aarch64__)
+#define CANQUE_CACHE_LINE_SIZE  128
+#else
+#define CANQUE_CACHE_LINE_SIZE  64
+#endif
+#endif
+#define CACHE_ALIGNED  __attribute__((aligned(CANQUE_CACHE_LINE_SIZE)))
+
+/* note: all deadlines are taken from the monotonic clock (not affected by NTP steps) */
+#define GET_TIME(ts)  do{ clock_gettime(CLOCK_MONOTONIC, &ts); } while(0)
 #define ADD_TIME(ts,to)  do{ ts.tv_sec += (time_t)(to / 1000U); \
                              ts.tv_nsec += (long)(to % 1000U) * (long)1000000; \
                              if (ts.tv_nsec >= (long)1000000000) { \
                                  ts.tv_nsec %= (long)1000000000; \
                                  ts.tv_sec += (time_t)1; \
                              } } while(0)
+#define ADD_TIME_USEC(ts,to)  do{ ts.tv_sec += (time_t)(to / 1000000U); \
+                                  ts.tv_nsec += (long)(to % 1000000U) * (long)1000; \
+                                  if (ts.tv_nsec >= (long)1000000000) { \
+                                      ts.tv_nsec %= (long)1000000000; \
+                                      ts.tv_sec += (time_t)1; \
+                                  } } while(0)
 
 #define SIGNAL_WAIT_CONDITION(queue,flg)  do{ queue->wait.flag = flg; \
+                                               queue->wait.signals += 1U; \
                                                assert(0 == pthread_cond_signal(&queue->wait.cond)); } while(0)
 #define WAIT_CONDITION_INFINITE(queue,res)  do{ queue->wait.flag = false; \
                                                 res = pthread_cond_wait(&queue->wait.cond, &queue->wait.mutex); } while(0)
 #define WAIT_CONDITION_TIMEOUT(queue,abstime,res)  do{ queue->wait.flag = false; \
-                                                       res = pthread_cond_timedwait(&queue->wait.cond, &queue->wait.mutex, &abstime); } while(0)
+                                                       res = MacCAN_TimedWait(&queue->wait.cond, &queue->wait.mutex, &abstime); } while(0)
+#define SIGNAL_SPACE_CONDITION(queue)  do{ if (queue->wait.blocked) \
+                                               assert(0 == pthread_cond_broadcast(&queue->wait.space)); } while(0)
 #define ENTER_CRITICAL_SECTION(queue)  assert(0 == pthread_mutex_lock(&queue->wait.mutex))
 #define LEAVE_CRITICAL_SECTION(queue)  assert(0 == pthread_mutex_unlock(&queue->wait.mutex))
 
+#define ENTER_PARKING(queue)  do{ atomic_store_explicit(&queue->wait.parked, true, memory_order_relaxed); \
+                                  atomic_thread_fence(memory_order_seq_cst); } while(0)
+#define LEAVE_PARKING(queue)  atomic_store_explicit(&queue->wait.parked, false, memory_order_relaxed)
+#define READER_PARKED(queue)  (atomic_thread_fence(memory_order_seq_cst), \
+                               atomic_load_explicit(&queue->wait.parked, memory_order_relaxed))
+
+/* note: the lock-free paths are only taken with the default overflow policy,
+ *       because the other policies require that the producer can move the
+ *       read position or wait for the consumer */
+#define IS_LOCKFREE(queue)  ((queue->mode == CANQUE_MODE_LOCKFREE) && \
+                             (queue->policy == CANQUE_OVFL_DROP_NEWEST))
+
 struct msg_queue_tag {                  /* Message Queue (w/ elements of user-defined size): */
-    UInt32 size;                        /* - total number of ring-buffer elements */
-    UInt32 used;                        /* - number of used ring-buffer elements */
-    UInt32 high;                        /* - highest level of the ring-buffer */
-    UInt32 head;                        /* - read position of the ring-buffer */
-    UInt32 tail;                        /* - write position of the ring-buffer */
+    UInt32 size;                        /* - total number of ring-buffer elements (power of two) */
+    UInt32 mask;                        /* - index mask of the ring-buffer (size - 1) */
     UInt8 *queueElem;                   /* - the ring-buffer itself */
     size_t elemSize;                    /* - size of one element */
+    CANQUE_Mode_t mode;                 /* - mutex-protected or lock-free */
+    CANQUE_Policy_t policy;             /* - overflow policy */
+    UInt16 timeout;                     /* - deadline of a blocked producer (in [ms]) */
     struct cond_wait_t {                /* - blocking operation: */
         pthread_mutex_t mutex;          /*   - a Posix mutex */
         pthread_cond_t cond;            /*   - a Posix condition */
         Boolean flag;                   /*   - and a flag */
+        atomic_bool parked;             /*   - reader is waiting (lock-free mode) */
+        UInt64 signals;                 /*   - number of wake-up signals */
+        pthread_cond_t space;           /*   - a Posix condition (for the producer) */
+        UInt32 blocked;                 /*   - number of waiting writers (no room) */
+        UInt32 released;                /*   - number of releases of the waiting writers */
     } wait;
-    struct overflow_t {                 /* - overflow events: */
-        Boolean flag;                   /*   - to indicate an overflow */
-        UInt64 counter;                 /*   - overflow counter */
-    } ovfl;
+    struct watermark_t {                /* - watermark notification: */
+        UInt32 high;                    /*   - high watermark (number of elements) */
+        UInt32 low;                     /*   - low watermark (number of elements) */
+        CANQUE_WatermarkCbk_t callback; /*   - callback function (or NULL) */
+        void *context;                  /*   - context for the callback function */
+        atomic_bool reached;            /*   - high watermark reached (until low) */
+    } wm;
+    struct event_fd_t {                 /* - pollable file descriptor (self-pipe): */
+        atomic_int fd[2];               /*   - read and write end (or -1) */
+        atomic_bool armed;              /*   - a byte is in the pipe */
+        atomic_bool kicked;             /*   - wake-up signal (CANQUE_Signal) */
+        pthread_mutex_t mutex;          /*   - to write or read the byte */
+    } event;
+    struct producer_t {                 /* - producer side (own cache line): */
+        atomic_uint tail CACHE_ALIGNED; /*   - write position (free-running) */
+        UInt32 head;                    /*   - cached read position */
+        atomic_uint high;               /*   - highest level of the ring-buffer */
+        struct overflow_t {             /*   - overflow events: */
+            atomic_bool flag;           /*     - to indicate an overflow */
+            atomic_ullong counter;      /*     - overflow counter */
+        } ovfl;
+    } prod;
+    struct consumer_t {                 /* - consumer side (own cache line): */
+        atomic_uint head CACHE_ALIGNED; /*   - read position (free-running) */
+        UInt32 tail;                    /*   - cached write position */
+        UInt32 borrowed;                /*   - number of borrowed elements (peek) */
+    } cons;
 };
 static Boolean EnqueueElement(CANQUE_MsgQueue_t queue, const void *element);
+static UInt32 EnqueueElements(CANQUE_MsgQueue_t queue, const void *buffer, UInt32 numElem, Boolean overflow);
 static Boolean DequeueElement(CANQUE_MsgQueue_t queue, void *element);
+static UInt32 DequeueElements(CANQUE_MsgQueue_t queue, void *buffer, UInt32 maxElem);
+static UInt32 PeekElements(CANQUE_MsgQueue_t queue, const void **elements);
+static Boolean CommitElements(CANQUE_MsgQueue_t queue, UInt32 numElem);
+static void DiscardElements(CANQUE_MsgQueue_t queue);
+static void UpdateHighLevel(CANQUE_MsgQueue_t queue, UInt32 used);
+static void CountOverflow(CANQUE_MsgQueue_t queue, UInt64 count);
+static void MakeRoom(CANQUE_MsgQueue_t queue, UInt32 numElem);
+static UInt32 WaitForRoom(CANQUE_MsgQueue_t queue, UInt32 numElem, UInt16 timeout);
+static void CheckHighWatermark(CANQUE_MsgQueue_t queue);
+static void CheckLowWatermark(CANQUE_MsgQueue_t queue);
+static void RaiseEvent(CANQUE_MsgQueue_t queue);
+static void ClearEvent(CANQUE_MsgQueue_t queue);
+static Boolean IsNotEmpty(CANQUE_MsgQueue_t queue);
 
 CANQUE_MsgQueue_t CANQUE_Create(size_t numElem, size_t elemSize) {
+    /* the good old mutex-protected message queue */
+    return CANQUE_CreateEx(numElem, elemSize, CANQUE_MODE_MUTEX);
+}
+
+CANQUE_MsgQueue_t CANQUE_CreateEx(size_t numElem, size_t elemSize, CANQUE_Mode_t mode) {
     CANQUE_MsgQueue_t msgQueue = NULL;
+    UInt32 size = 1U;
 
-    MACCAN_DEBUG_CORE("        - Message queue for %u elements of size %u bytes\n", numElem, elemSize);
-    if ((msgQueue = (CANQUE_MsgQueue_t)malloc(sizeof(struct msg_queue_tag))) == NULL) {
+    /* note: the ring-buffer size is rounded up to a power of two */
+    while ((size < numElem) && (size < 0x80000000U))
+        size <<= 1;
+    MACCAN_DEBUG_CORE("        - Message queue for %u elements of size %u bytes (%s)\n", size, elemSize,
+                      (mode == CANQUE_MODE_LOCKFREE) ? "lock-free" : "mutex");
+    if (posix_memalign((void**)&msgQueue, CANQUE_CACHE_LINE_SIZE, sizeof(struct msg_queue_tag)) != 0) {
         MACCAN_DEBUG_ERROR("+++ Unable to create message queue (NULL pointer)\n");
         return NULL;
     }
     bzero(msgQueue, sizeof(struct msg_queue_tag));
-    if ((msgQueue->queueElem = calloc(numElem, elemSize))) {
+    if ((msgQueue->queueElem = calloc(size, elemSize))) {
         if ((pthread_mutex_init(&msgQueue->wait.mutex, NULL) == 0) &&
-            (pthread_cond_init(&msgQueue->wait.cond, NULL) == 0)) {
+            (pthread_mutex_init(&msgQueue->event.mutex, NULL) == 0) &&
+            (MacCAN_InitCondition(&msgQueue->wait.cond) == 0) &&
+            (MacCAN_InitCondition(&msgQueue->wait.space) == 0)) {
             msgQueue->elemSize = (size_t)elemSize;
-            msgQueue->size = (UInt32)numElem;
+            msgQueue->size = size;
+            msgQueue->mask = size - 1U;
+            msgQueue->mode = (mode == CANQUE_MODE_LOCKFREE) ? CANQUE_MODE_LOCKFREE : CANQUE_MODE_MUTEX;
+            msgQueue->policy = CANQUE_OVFL_DROP_NEWEST;
             msgQueue->wait.flag = false;
+            msgQueue->wait.blocked = 0U;
+            msgQueue->wait.released = 0U;
+            atomic_init(&msgQueue->wait.parked, false);
+            atomic_init(&msgQueue->wm.reached, false);
+            atomic_init(&msgQueue->event.fd[0], -1);
+            atomic_init(&msgQueue->event.fd[1], -1);
+            atomic_init(&msgQueue->event.armed, false);
+            atomic_init(&msgQueue->event.kicked, false);
+            atomic_init(&msgQueue->prod.tail, 0U);
+            atomic_init(&msgQueue->prod.high, 0U);
+            atomic_init(&msgQueue->prod.ovfl.flag, false);
+            atomic_init(&msgQueue->prod.ovfl.counter, 0U);
+            atomic_init(&msgQueue->cons.head, 0U);
         } else {
             MACCAN_DEBUG_ERROR("+++ Unable to create message queue (wait condition)\n");
             free(msgQueue->queueElem);
@@ -115,7 +220,7 @@ CANQUE_MsgQueue_t CANQUE_Create(size_t numElem, size_t elemSize) {
             msgQueue = NULL;
         }
     } else {
-        MACCAN_DEBUG_ERROR("+++ Unable to create message queue (%u * %u bytes)\n", numElem, elemSize);
+        MACCAN_DEBUG_ERROR("+++ Unable to create message queue (%u * %u bytes)\n", size, elemSize);
         free(msgQueue);
         msgQueue = NULL;
     }
@@ -126,7 +231,13 @@ CANQUE_Return_t CANQUE_Destroy(CANQUE_MsgQueue_t msgQueue) {
     CANQUE_Return_t retVal = CANUSB_ERROR_RESOURCE;
 
     if (msgQueue) {
+        if (atomic_load(&msgQueue->event.fd[0]) >= 0)
+            (void)close(atomic_load(&msgQueue->event.fd[0]));
+        if (atomic_load(&msgQueue->event.fd[1]) >= 0)
+            (void)close(atomic_load(&msgQueue->event.fd[1]));
+        pthread_cond_destroy(&msgQueue->wait.space);
         pthread_cond_destroy(&msgQueue->wait.cond);
+        pthread_mutex_destroy(&msgQueue->event.mutex);
         pthread_mutex_destroy(&msgQueue->wait.mutex);
         if (msgQueue->queueElem)
             free(msgQueue->queueElem);
@@ -144,7 +255,13 @@ CANQUE_Return_t CANQUE_Signal(CANQUE_MsgQueue_t msgQueue) {
     if (msgQueue) {
         ENTER_CRITICAL_SECTION(msgQueue);
         SIGNAL_WAIT_CONDITION(msgQueue, false);
+        /* note: a blocked writer is released as well (it returns w/o room) */
+        msgQueue->wait.released += 1U;
+        SIGNAL_SPACE_CONDITION(msgQueue);
         LEAVE_CRITICAL_SECTION(msgQueue);
+        /* note: a poller is woken up as well (the next read returns empty) */
+        atomic_store(&msgQueue->event.kicked, true);
+        RaiseEvent(msgQueue);
         retVal = CANUSB_SUCCESS;
     } else {
         MACCAN_DEBUG_ERROR("+++ Unable to signal message queue (NULL pointer)\n");
@@ -156,35 +273,150 @@ CANQUE_Return_t CANQUE_Enqueue(CANQUE_MsgQueue_t msgQueue, void const *message)
     CANQUE_Return_t retVal = CANUSB_ERROR_RESOURCE;
 
     if (message && msgQueue) {
+        if (IS_LOCKFREE(msgQueue)) {
+            if (EnqueueElement(msgQueue, message)) {
+                /* note: the mutex is only taken when the reader is parked */
+                if (READER_PARKED(msgQueue)) {
+                    ENTER_CRITICAL_SECTION(msgQueue);
+                    SIGNAL_WAIT_CONDITION(msgQueue, true);
+                    LEAVE_CRITICAL_SECTION(msgQueue);
+                }
+                retVal = CANUSB_SUCCESS;
+            } else {
+                retVal = CANUSB_ERROR_OVERRUN;
+            }
+        } else {
+            ENTER_CRITICAL_SECTION(msgQueue);
+            if (msgQueue->policy != CANQUE_OVFL_DROP_NEWEST)
+                MakeRoom(msgQueue, 1U);
+            if (EnqueueElement(msgQueue, message)) {
+                SIGNAL_WAIT_CONDITION(msgQueue, true);
+                retVal = CANUSB_SUCCESS;
+            } else {
+                retVal = CANUSB_ERROR_OVERRUN;
+            }
+            LEAVE_CRITICAL_SECTION(msgQueue);
+        }
+        if (retVal == CANUSB_SUCCESS) {
+            RaiseEvent(msgQueue);
+            CheckHighWatermark(msgQueue);
+        }
+    } else {
+        MACCAN_DEBUG_ERROR("+++ Unable to enqueue message (NULL pointer)\n");
+    }
+    return retVal;
+}
+
+CANQUE_Return_t CANQUE_EnqueueWait(CANQUE_MsgQueue_t msgQueue, void const *message, UInt16 timeout) {
+    /* note: the same as a batch of one element */
+    return CANQUE_EnqueueManyWait(msgQueue, message, 1U, NULL, timeout);
+}
+
+CANQUE_Return_t CANQUE_EnqueueManyWait(CANQUE_MsgQueue_t msgQueue, void const *buffer, UInt32 numElem, UInt32 *enqueued, UInt16 timeout) {
+    CANQUE_Return_t retVal = CANUSB_ERROR_RESOURCE;
+    UInt32 count = 0U;
+    UInt32 room;
+
+    if (enqueued)
+        *enqueued = 0U;
+    if (buffer && msgQueue) {
+        /* note: the consumer signals free room only under the mutex */
+        if (msgQueue->mode != CANQUE_MODE_MUTEX)
+            return CANUSB_ERROR_NOTSUPP;
+        if (numElem == 0U)
+            return CANUSB_ERROR_ILLPARA;
+        /* note: a full queue is not counted as overrun, the producer waits for room or gives up */
         ENTER_CRITICAL_SECTION(msgQueue);
-        if (EnqueueElement(msgQueue, message)) {
+        /* note: only as many elements as there is room for (w/o overrun) */
+        if ((room = WaitForRoom(msgQueue, numElem, timeout)) != 0U) {
+            count = EnqueueElements(msgQueue, buffer, (numElem < room) ? numElem : room, false);
             SIGNAL_WAIT_CONDITION(msgQueue, true);
-            retVal = CANUSB_SUCCESS;
-        } else {
-            retVal = CANUSB_ERROR_OVERRUN;
         }
         LEAVE_CRITICAL_SECTION(msgQueue);
+        if (count != 0U) {
+            RaiseEvent(msgQueue);
+            CheckHighWatermark(msgQueue);
+        }
+        if (enqueued)
+            *enqueued = count;
+        /* note: the batch is committed at once, or as much of it as fits into the queue */
+        retVal = (count == numElem) ? CANUSB_SUCCESS : CANUSB_ERROR_BUSY;
     } else {
-        MACCAN_DEBUG_ERROR("+++ Unable to enqueue message (NULL pointer)\n");
+        MACCAN_DEBUG_ERROR("+++ Unable to enqueue messages (NULL pointer)\n");
+    }
+    return retVal;
+}
+
+CANQUE_Return_t CANQUE_EnqueueMany(CANQUE_MsgQueue_t msgQueue, void const *buffer, UInt32 numElem, UInt32 *enqueued) {
+    CANQUE_Return_t retVal = CANUSB_ERROR_RESOURCE;
+    UInt32 count = 0U;
+
+    if (buffer && msgQueue) {
+        /* note: all elements are committed at once and the reader is signaled only once */
+        if (IS_LOCKFREE(msgQueue)) {
+            if ((count = EnqueueElements(msgQueue, buffer, numElem, true)) != 0U) {
+                if (READER_PARKED(msgQueue)) {
+                    ENTER_CRITICAL_SECTION(msgQueue);
+                    SIGNAL_WAIT_CONDITION(msgQueue, true);
+                    LEAVE_CRITICAL_SECTION(msgQueue);
+                }
+            }
+        } else {
+            ENTER_CRITICAL_SECTION(msgQueue);
+            if (msgQueue->policy != CANQUE_OVFL_DROP_NEWEST)
+                MakeRoom(msgQueue, numElem);
+            if ((count = EnqueueElements(msgQueue, buffer, numElem, true)) != 0U)
+                SIGNAL_WAIT_CONDITION(msgQueue, true);
+            LEAVE_CRITICAL_SECTION(msgQueue);
+        }
+        if (count != 0U) {
+            RaiseEvent(msgQueue);
+            CheckHighWatermark(msgQueue);
+        }
+        retVal = (count == numElem) ? CANUSB_SUCCESS : CANUSB_ERROR_OVERRUN;
+    } else {
+        MACCAN_DEBUG_ERROR("+++ Unable to enqueue messages (NULL pointer)\n");
     }
+    if (enqueued)
+        *enqueued = count;
     return retVal;
 }
 
 CANQUE_Return_t CANQUE_Dequeue(CANQUE_MsgQueue_t msgQueue, void *message, UInt16 timeout) {
+    /* note: the time-out is converted from [ms] to [usec] (65535 means blocking read) */
+    return CANQUE_DequeueUs(msgQueue, message, (timeout != CANUSB_INFINITE) ? ((UInt32)timeout * 1000U) : CANQUE_INFINITE_USEC);
+}
+
+CANQUE_Return_t CANQUE_DequeueUs(CANQUE_MsgQueue_t msgQueue, void *message, UInt32 timeout) {
     CANQUE_Return_t retVal = CANUSB_ERROR_RESOURCE;
     struct timespec absTime;
     int waitCond = 0;
 
-    GET_TIME(absTime);
-    ADD_TIME(absTime, timeout);
-
     if (message && msgQueue) {
+        /* lock-free mode: try it w/o the mutex first */
+        if (IS_LOCKFREE(msgQueue)) {
+            if (DequeueElement(msgQueue, message)) {
+                ClearEvent(msgQueue);
+                CheckLowWatermark(msgQueue);
+                return CANUSB_SUCCESS;
+            }
+            if (timeout == 0U) {
+                ClearEvent(msgQueue);
+                return CANUSB_ERROR_EMPTY;
+            }
+        }
+        GET_TIME(absTime);
+        ADD_TIME_USEC(absTime, timeout);
+
         ENTER_CRITICAL_SECTION(msgQueue);
 dequeue:
+        if (IS_LOCKFREE(msgQueue))
+            ENTER_PARKING(msgQueue);
         if (DequeueElement(msgQueue, message)) {
+            SIGNAL_SPACE_CONDITION(msgQueue);
             retVal = CANUSB_SUCCESS;
         } else {
-            if (timeout == CANUSB_INFINITE) {  /* blocking read */
+            if (timeout == CANQUE_INFINITE_USEC) {  /* blocking read */
                 WAIT_CONDITION_INFINITE(msgQueue, waitCond);
                 if ((waitCond == 0) && msgQueue->wait.flag)
                     goto dequeue;
@@ -195,26 +427,175 @@ dequeue:
             }
             retVal = CANUSB_ERROR_EMPTY;
         }
+        if (IS_LOCKFREE(msgQueue))
+            LEAVE_PARKING(msgQueue);
         LEAVE_CRITICAL_SECTION(msgQueue);
+        ClearEvent(msgQueue);
+        if (retVal == CANUSB_SUCCESS)
+            CheckLowWatermark(msgQueue);
     } else {
         MACCAN_DEBUG_ERROR("+++ Unable to dequeue message (NULL pointer)\n");
     }
     return retVal;
 }
 
+CANQUE_Return_t CANQUE_DequeueMany(CANQUE_MsgQueue_t msgQueue, void *buffer, UInt32 maxElem, UInt32 *numElem, UInt16 timeout) {
+    CANQUE_Return_t retVal = CANUSB_ERROR_RESOURCE;
+    struct timespec absTime;
+    int waitCond = 0;
+    UInt32 count = 0U;
+
+    if (buffer && msgQueue) {
+        if (numElem)
+            *numElem = 0U;
+        if (maxElem == 0U)
+            return CANUSB_ERROR_ILLPARA;
+        /* lock-free mode: try it w/o the mutex first */
+        if (IS_LOCKFREE(msgQueue)) {
+            if ((count = DequeueElements(msgQueue, buffer, maxElem)) != 0U) {
+                if (numElem)
+                    *numElem = count;
+                ClearEvent(msgQueue);
+                CheckLowWatermark(msgQueue);
+                return CANUSB_SUCCESS;
+            }
+            if (timeout == 0U) {
+                ClearEvent(msgQueue);
+                return CANUSB_ERROR_EMPTY;
+            }
+        }
+        GET_TIME(absTime);
+        ADD_TIME(absTime, timeout);
+
+        ENTER_CRITICAL_SECTION(msgQueue);
+dequeue:
+        if (IS_LOCKFREE(msgQueue))
+            ENTER_PARKING(msgQueue);
+        /* note: wait only for the first element, then take what is there */
+        if ((count = DequeueElements(msgQueue, buffer, maxElem)) != 0U) {
+            SIGNAL_SPACE_CONDITION(msgQueue);
+            retVal = CANUSB_SUCCESS;
+        } else {
+            if (timeout == CANUSB_INFINITE) {  /* blocking read */
+                WAIT_CONDITION_INFINITE(msgQueue, waitCond);
+                if ((waitCond == 0) && msgQueue->wait.flag)
+                    goto dequeue;
+            } else if (timeout != 0U) {  /* timed blocking read */
+                WAIT_CONDITION_TIMEOUT(msgQueue, absTime, waitCond);
+                if ((waitCond == 0) && msgQueue->wait.flag)
+                    goto dequeue;
+            }
+            retVal = CANUSB_ERROR_EMPTY;
+        }
+        if (IS_LOCKFREE(msgQueue))
+            LEAVE_PARKING(msgQueue);
+        LEAVE_CRITICAL_SECTION(msgQueue);
+        if (numElem)
+            *numElem = count;
+        ClearEvent(msgQueue);
+        if (retVal == CANUSB_SUCCESS)
+            CheckLowWatermark(msgQueue);
+    } else {
+        MACCAN_DEBUG_ERROR("+++ Unable to dequeue messages (NULL pointer)\n");
+    }
+    return retVal;
+}
+
+CANQUE_Return_t CANQUE_Peek(CANQUE_MsgQueue_t msgQueue, const void **elements, UInt32 *numElem, UInt16 timeout) {
+    CANQUE_Return_t retVal = CANUSB_ERROR_RESOURCE;
+    struct timespec absTime;
+    int waitCond = 0;
+    UInt32 count = 0U;
+
+    /* note: the elements stay in the queue until they are released by CANQUE_Commit */
+    if (elements && numElem && msgQueue) {
+        *elements = NULL;
+        *numElem = 0U;
+        /* lock-free mode: try it w/o the mutex first */
+        if (IS_LOCKFREE(msgQueue)) {
+            if ((count = PeekElements(msgQueue, elements)) != 0U) {
+                *numElem = count;
+                return CANUSB_SUCCESS;
+            }
+            if (timeout == 0U) {
+                ClearEvent(msgQueue);
+                return CANUSB_ERROR_EMPTY;
+            }
+        }
+        GET_TIME(absTime);
+        ADD_TIME(absTime, timeout);
+
+        ENTER_CRITICAL_SECTION(msgQueue);
+peek:
+        if (IS_LOCKFREE(msgQueue))
+            ENTER_PARKING(msgQueue);
+        if ((count = PeekElements(msgQueue, elements)) != 0U) {
+            retVal = CANUSB_SUCCESS;
+        } else {
+            if (timeout == CANUSB_INFINITE) {  /* blocking read */
+                WAIT_CONDITION_INFINITE(msgQueue, waitCond);
+                if ((waitCond == 0) && msgQueue->wait.flag)
+                    goto peek;
+            } else if (timeout != 0U) {  /* timed blocking read */
+                WAIT_CONDITION_TIMEOUT(msgQueue, absTime, waitCond);
+                if ((waitCond == 0) && msgQueue->wait.flag)
+                    goto peek;
+            }
+            retVal = CANUSB_ERROR_EMPTY;
+        }
+        if (IS_LOCKFREE(msgQueue))
+            LEAVE_PARKING(msgQueue);
+        LEAVE_CRITICAL_SECTION(msgQueue);
+        if (retVal == CANUSB_ERROR_EMPTY)
+            ClearEvent(msgQueue);
+        *numElem = count;
+    } else {
+        MACCAN_DEBUG_ERROR("+++ Unable to peek messages (NULL pointer)\n");
+    }
+    return retVal;
+}
+
+CANQUE_Return_t CANQUE_Commit(CANQUE_MsgQueue_t msgQueue, UInt32 numElem) {
+    CANQUE_Return_t retVal = CANUSB_ERROR_RESOURCE;
+
+    if (msgQueue) {
+        if (IS_LOCKFREE(msgQueue)) {
+            retVal = CommitElements(msgQueue, numElem) ? CANUSB_SUCCESS : CANUSB_ERROR_ILLPARA;
+        } else {
+            ENTER_CRITICAL_SECTION(msgQueue);
+            retVal = CommitElements(msgQueue, numElem) ? CANUSB_SUCCESS : CANUSB_ERROR_ILLPARA;
+            if (retVal == CANUSB_SUCCESS)
+                SIGNAL_SPACE_CONDITION(msgQueue);
+            LEAVE_CRITICAL_SECTION(msgQueue);
+        }
+        if ((retVal == CANUSB_SUCCESS) && (numElem != 0U)) {
+            ClearEvent(msgQueue);
+            CheckLowWatermark(msgQueue);
+        }
+    } else {
+        MACCAN_DEBUG_ERROR("+++ Unable to commit messages (NULL pointer)\n");
+    }
+    return retVal;
+}
+
 CANQUE_Return_t CANQUE_Reset(CANQUE_MsgQueue_t msgQueue) {
     CANQUE_Return_t retVal = CANUSB_ERROR_RESOURCE;
 
     if (msgQueue) {
+        /* note: in lock-free mode this must be called by the consumer, and the
+         *       producer may still be active (e.g. the USB reception callback);
+         *       therefore its level and overflow counters are atomics as well */
         ENTER_CRITICAL_SECTION(msgQueue);
-        msgQueue->used = 0U;
-        msgQueue->head = 0U;
-        msgQueue->tail = 0U;
-        msgQueue->high = 0U;
+        DiscardElements(msgQueue);
+        atomic_store_explicit(&msgQueue->prod.high, 0U, memory_order_relaxed);
         msgQueue->wait.flag = false;
-        msgQueue->ovfl.flag = false;
-        msgQueue->ovfl.counter = 0U;
+        msgQueue->wait.signals = 0U;
+        atomic_store_explicit(&msgQueue->prod.ovfl.flag, false, memory_order_relaxed);
+        atomic_store_explicit(&msgQueue->prod.ovfl.counter, 0U, memory_order_relaxed);
+        atomic_store(&msgQueue->wm.reached, false);
+        SIGNAL_SPACE_CONDITION(msgQueue);
         LEAVE_CRITICAL_SECTION(msgQueue);
+        ClearEvent(msgQueue);
         retVal = CANUSB_SUCCESS;
     } else {
         MACCAN_DEBUG_ERROR("+++ Unable to reset message queue (NULL pointer)\n");
@@ -222,16 +603,173 @@ CANQUE_Return_t CANQUE_Reset(CANQUE_MsgQueue_t msgQueue) {
     return retVal;
 }
 
+CANQUE_Return_t CANQUE_SetOverflowPolicy(CANQUE_MsgQueue_t msgQueue, CANQUE_Policy_t policy, UInt16 timeout) {
+    CANQUE_Return_t retVal = CANUSB_ERROR_RESOURCE;
+
+    if (msgQueue) {
+        /* note: a producer must not be blocked forever, and never in the USB callback */
+        if ((policy > CANQUE_OVFL_BLOCK) ||
+            ((policy == CANQUE_OVFL_BLOCK) && (timeout == CANUSB_INFINITE)))
+            return CANUSB_ERROR_ILLPARA;
+        /* note: the policy shall only be changed when producer and consumer are idle */
+        ENTER_CRITICAL_SECTION(msgQueue);
+        msgQueue->policy = policy;
+        msgQueue->timeout = timeout;
+        LEAVE_CRITICAL_SECTION(msgQueue);
+        retVal = CANUSB_SUCCESS;
+    } else {
+        MACCAN_DEBUG_ERROR("+++ Unable to set overflow policy (NULL pointer)\n");
+    }
+    return retVal;
+}
+
+CANQUE_Return_t CANQUE_GetOverflowPolicy(CANQUE_MsgQueue_t msgQueue, CANQUE_Policy_t *policy, UInt16 *timeout) {
+    CANQUE_Return_t retVal = CANUSB_ERROR_RESOURCE;
+
+    if (msgQueue) {
+        if (policy)
+            *policy = msgQueue->policy;
+        if (timeout)
+            *timeout = msgQueue->timeout;
+        retVal = CANUSB_SUCCESS;
+    } else {
+        MACCAN_DEBUG_ERROR("+++ Unable to get overflow policy (NULL pointer)\n");
+    }
+    return retVal;
+}
+
+CANQUE_Return_t CANQUE_SetWatermarks(CANQUE_MsgQueue_t msgQueue, UInt32 high, UInt32 low, CANQUE_WatermarkCbk_t callback, void *context) {
+    CANQUE_Return_t retVal = CANUSB_ERROR_RESOURCE;
+
+    if (msgQueue) {
+        /* note: a NULL pointer as callback function disables the notification */
+        if (callback && ((high == 0U) || (high > msgQueue->size) || (low >= high)))
+            return CANUSB_ERROR_ILLPARA;
+        ENTER_CRITICAL_SECTION(msgQueue);
+        msgQueue->wm.high = callback ? high : 0U;
+        msgQueue->wm.low = callback ? low : 0U;
+        msgQueue->wm.callback = callback;
+        msgQueue->wm.context = callback ? context : NULL;
+        atomic_store(&msgQueue->wm.reached, false);
+        LEAVE_CRITICAL_SECTION(msgQueue);
+        retVal = CANUSB_SUCCESS;
+    } else {
+        MACCAN_DEBUG_ERROR("+++ Unable to set watermarks (NULL pointer)\n");
+    }
+    return retVal;
+}
+
+CANQUE_Return_t CANQUE_GetEventFd(CANQUE_MsgQueue_t msgQueue, int *fd) {
+    CANQUE_Return_t retVal = CANUSB_ERROR_RESOURCE;
+    int pipefd[2];
+
+    if (fd && msgQueue) {
+        /* note: the self-pipe is created on first demand and lives as long as the queue */
+        ENTER_CRITICAL_SECTION(msgQueue);
+        if (atomic_load(&msgQueue->event.fd[0]) < 0) {
+            if ((pipe(pipefd) == 0) &&
+                (fcntl(pipefd[0], F_SETFL, O_NONBLOCK) == 0) && (fcntl(pipefd[1], F_SETFL, O_NONBLOCK) == 0) &&
+                (fcntl(pipefd[0], F_SETFD, FD_CLOEXEC) == 0) && (fcntl(pipefd[1], F_SETFD, FD_CLOEXEC) == 0)) {
+                atomic_store(&msgQueue->event.armed, false);
+                atomic_store(&msgQueue->event.fd[0], pipefd[0]);
+                atomic_store(&msgQueue->event.fd[1], pipefd[1]);
+            } else {
+                MACCAN_DEBUG_ERROR("+++ Unable to create event pipe (errno=%i)\n", errno);
+                LEAVE_CRITICAL_SECTION(msgQueue);
+                return CANUSB_ERROR_RESOURCE;
+            }
+        }
+        *fd = atomic_load(&msgQueue->event.fd[0]);
+        LEAVE_CRITICAL_SECTION(msgQueue);
+        /* note: elements could have been queued before the pipe was there */
+        if (IsNotEmpty(msgQueue))
+            RaiseEvent(msgQueue);
+        retVal = CANUSB_SUCCESS;
+    } else {
+        MACCAN_DEBUG_ERROR("+++ Unable to get event file descriptor (NULL pointer)\n");
+    }
+    return retVal;
+}
+
+CANQUE_Return_t CANQUE_Select(CANQUE_MsgQueue_t msgQueues[], UInt32 numQueues, UInt16 timeout, UInt32 *ready) {
+    struct pollfd fds[CANQUE_MAX_SELECT];
+    struct timespec now, absTime;
+    Boolean aborted = false;
+    UInt32 mask = 0U;
+    UInt32 i;
+    int msec, res;
+
+    if (!msgQueues || !ready) {
+        MACCAN_DEBUG_ERROR("+++ Unable to select message queues (NULL pointer)\n");
+        return CANUSB_ERROR_RESOURCE;
+    }
+    *ready = 0U;
+    if ((numQueues == 0U) || (numQueues > CANQUE_MAX_SELECT))
+        return CANUSB_ERROR_ILLPARA;
+    /* note: all queues are waited for at once through their self-pipes (no polling) */
+    for (i = 0U; i < numQueues; i++) {
+        if (!msgQueues[i] || (CANQUE_GetEventFd(msgQueues[i], &fds[i].fd) != CANUSB_SUCCESS))
+            return CANUSB_ERROR_RESOURCE;
+        fds[i].events = POLLIN;
+        fds[i].revents = 0;
+        /* note: only a wake-up signal during the wait aborts it (as for a blocking read) */
+        atomic_store(&msgQueues[i]->event.kicked, false);
+    }
+    GET_TIME(absTime);
+    ADD_TIME(absTime, timeout);
+    for (;;) {
+        for (i = 0U; i < numQueues; i++) {
+            if (IsNotEmpty(msgQueues[i]))
+                mask |= (UInt32)1U << i;
+        }
+        if (mask != 0U) {
+            *ready = mask;
+            return CANUSB_SUCCESS;
+        }
+        if (timeout == CANUSB_INFINITE) {
+            msec = -1;
+        } else {
+            GET_TIME(now);
+            msec = (int)((absTime.tv_sec - now.tv_sec) * 1000) + (int)((absTime.tv_nsec - now.tv_nsec) / 1000000);
+            if ((msec < 0) || (timeout == 0U))
+                msec = 0;
+        }
+        if ((res = poll(fds, (nfds_t)numQueues, msec)) < 0) {
+            if (errno == EINTR)
+                continue;
+            MACCAN_DEBUG_ERROR("+++ Unable to select message queues (errno=%i)\n", errno);
+            return CANUSB_ERROR_RESOURCE;
+        }
+        if (res == 0)
+            return CANUSB_ERROR_EMPTY;
+        /* note: a readable pipe w/o elements is either a wake-up signal (CANQUE_Signal)
+         *       or a late event of an element that has already been dequeued */
+        for (i = 0U; i < numQueues; i++) {
+            if (fds[i].revents == 0)
+                continue;
+            if (IsNotEmpty(msgQueues[i])) {
+                mask |= (UInt32)1U << i;
+            } else {
+                if (atomic_exchange(&msgQueues[i]->event.kicked, false))
+                    aborted = true;
+                ClearEvent(msgQueues[i]);
+            }
+        }
+        if ((mask == 0U) && aborted)
+            return CANUSB_ERROR_EMPTY;
+    }
+}
+
 Boolean CANQUE_OverflowFlag(CANQUE_MsgQueue_t msgQueue) {
     if (msgQueue)
-        return msgQueue->ovfl.flag;
+        return atomic_load_explicit(&msgQueue->prod.ovfl.flag, memory_order_relaxed);
     else
         return false;
 }
 
 UInt64 CANQUE_OverflowCounter(CANQUE_MsgQueue_t msgQueue) {
     if (msgQueue)
-        return msgQueue->ovfl.counter;
+        return (UInt64)atomic_load_explicit(&msgQueue->prod.ovfl.counter, memory_order_relaxed);
     else
         return 0U;
 }
@@ -245,21 +783,32 @@ UInt32 CANQUE_QueueSize(CANQUE_MsgQueue_t msgQueue) {
 
 UInt32 CANQUE_QueueHigh(CANQUE_MsgQueue_t msgQueue) {
     if (msgQueue)
-        return msgQueue->high;
+        return atomic_load_explicit(&msgQueue->prod.high, memory_order_relaxed);
     else
         return 0U;;
 }
 
+UInt64 CANQUE_WakeupCounter(CANQUE_MsgQueue_t msgQueue) {
+    if (msgQueue)
+        return msgQueue->wait.signals;
+    else
+        return 0U;
+}
+
 /*  ---  FIFO  ---
  *
- *  size :  total number of elements
- *  head :  read position of the queue
- *  tail :  write position of the queue
- *  used :  actual number of queued elements
+ *  size :  total number of elements (power of two)
+ *  mask :  index mask (size - 1)
+ *  head :  read position of the queue (free-running, written by the consumer only)
+ *  tail :  write position of the queue (free-running, written by the producer only)
+ *  used :  actual number of queued elements (tail - head)
  *  high :  highest number of queued elements
  *
- *  (§1) empty :  used == 0
- *  (§2) full  :  used == size  &&  size > 0
+ *  (§1) empty :  tail == head
+ *  (§2) full  :  tail - head == size
+ *
+ *  Both sides keep a cached copy of the other side's position and only
+ *  reload it when the queue looks full (producer) or empty (consumer).
  */
 static Boolean EnqueueElement(CANQUE_MsgQueue_t queue, const void *element) {
     assert(queue);
@@ -267,36 +816,334 @@ static Boolean EnqueueElement(CANQUE_MsgQueue_t queue, const void *element) {
     assert(queue->size);
     assert(queue->queueElem);
 
-    if (queue->used < queue->size) {
-        if (queue->used != 0U)
-            queue->tail = (queue->tail + 1U) % queue->size;
-        else
-            queue->head = queue->tail;  /* to make sure */
-        (void)memcpy(&queue->queueElem[(queue->tail * queue->elemSize)], element, queue->elemSize);
-        queue->used += 1U;
-        if (queue->high < queue->used)
-            queue->high = queue->used;
+    UInt32 tail = atomic_load_explicit(&queue->prod.tail, memory_order_relaxed);
+    UInt32 used = tail - queue->prod.head;
+
+    /* note: the cached read position is only refreshed when the queue looks full,
+     *       or when it would raise the high-water mark (to keep the mark exact) */
+    if ((used >= queue->size) || (used >= atomic_load_explicit(&queue->prod.high, memory_order_relaxed))) {
+        queue->prod.head = atomic_load_explicit(&queue->cons.head, memory_order_acquire);
+        used = tail - queue->prod.head;
+    }
+    if (used < queue->size) {
+        (void)memcpy(&queue->queueElem[((tail & queue->mask) * queue->elemSize)], element, queue->elemSize);
+        atomic_store_explicit(&queue->prod.tail, tail + 1U, memory_order_release);
+        used += 1U;
+        UpdateHighLevel(queue, used);
         return true;
     } else {
-        queue->ovfl.counter += 1U;
-        queue->ovfl.flag = true;
+        CountOverflow(queue, 1U);
         return false;
     }
 }
 
+static UInt32 EnqueueElements(CANQUE_MsgQueue_t queue, const void *buffer, UInt32 numElem, Boolean overflow) {
+    assert(queue);
+    assert(buffer);
+    assert(queue->size);
+    assert(queue->queueElem);
+
+    UInt32 tail = atomic_load_explicit(&queue->prod.tail, memory_order_relaxed);
+    UInt32 used = tail - queue->prod.head;
+    UInt32 count, first;
+
+    /* note: the cached read position is refreshed as in EnqueueElement */
+    if (((queue->size - used) < numElem) || ((used + numElem) > atomic_load_explicit(&queue->prod.high, memory_order_relaxed))) {
+        queue->prod.head = atomic_load_explicit(&queue->cons.head, memory_order_acquire);
+        used = tail - queue->prod.head;
+    }
+    if ((count = queue->size - used) > numElem)
+        count = numElem;
+    if (count != 0U) {
+        /* note: at most two copies (when the elements wrap around the end of the ring-buffer) */
+        first = queue->size - (tail & queue->mask);
+        if (first > count)
+            first = count;
+        (void)memcpy(&queue->queueElem[((tail & queue->mask) * queue->elemSize)], buffer, first * queue->elemSize);
+        if (first < count)
+            (void)memcpy(&queue->queueElem[0], (const UInt8*)buffer + (first * queue->elemSize), (count - first) * queue->elemSize);
+        atomic_store_explicit(&queue->prod.tail, tail + count, memory_order_release);
+        used += count;
+        UpdateHighLevel(queue, used);
+    }
+    /* note: elements not written by a blocking enqueue are not dropped, the caller gets them back */
+    if (overflow && (count < numElem)) {
+        CountOverflow(queue, (UInt64)(numElem - count));
+    }
+    return count;
+}
+
 static Boolean DequeueElement(CANQUE_MsgQueue_t queue, void *element) {
     assert(queue);
     assert(element);
     assert(queue->size);
     assert(queue->queueElem);
 
-    if (queue->used > 0U) {
-        (void)memcpy(element, &queue->queueElem[(queue->head * queue->elemSize)], queue->elemSize);
-        queue->head = (queue->head + 1U) % queue->size;
-        queue->used -= 1U;
-        return true;
-    } else
+    UInt32 head = atomic_load_explicit(&queue->cons.head, memory_order_relaxed);
+
+    if (head == queue->cons.tail) {
+        queue->cons.tail = atomic_load_explicit(&queue->prod.tail, memory_order_acquire);
+        if (head == queue->cons.tail)
+            return false;
+    }
+    (void)memcpy(element, &queue->queueElem[((head & queue->mask) * queue->elemSize)], queue->elemSize);
+    atomic_store_explicit(&queue->cons.head, head + 1U, memory_order_release);
+    /* note: a read ends the borrowing of the last peek (nothing left to commit) */
+    queue->cons.borrowed = 0U;
+    return true;
+}
+
+static UInt32 DequeueElements(CANQUE_MsgQueue_t queue, void *buffer, UInt32 maxElem) {
+    assert(queue);
+    assert(buffer);
+    assert(queue->size);
+    assert(queue->queueElem);
+
+    UInt32 head = atomic_load_explicit(&queue->cons.head, memory_order_relaxed);
+    UInt32 count, first;
+
+    if ((queue->cons.tail - head) < maxElem)
+        queue->cons.tail = atomic_load_explicit(&queue->prod.tail, memory_order_acquire);
+    if ((count = queue->cons.tail - head) > maxElem)
+        count = maxElem;
+    if (count == 0U)
+        return 0U;
+    /* note: at most two copies (when the elements wrap around the end of the ring-buffer) */
+    first = queue->size - (head & queue->mask);
+    if (first > count)
+        first = count;
+    (void)memcpy(buffer, &queue->queueElem[((head & queue->mask) * queue->elemSize)], first * queue->elemSize);
+    if (first < count)
+        (void)memcpy((UInt8*)buffer + (first * queue->elemSize), &queue->queueElem[0], (count - first) * queue->elemSize);
+    atomic_store_explicit(&queue->cons.head, head + count, memory_order_release);
+    queue->cons.borrowed = 0U;
+    return count;
+}
+
+static UInt32 PeekElements(CANQUE_MsgQueue_t queue, const void **elements) {
+    assert(queue);
+    assert(elements);
+    assert(queue->size);
+    assert(queue->queueElem);
+
+    UInt32 head = atomic_load_explicit(&queue->cons.head, memory_order_relaxed);
+    UInt32 count, first;
+
+    /* note: always get all elements written by the producer so far */
+    queue->cons.tail = atomic_load_explicit(&queue->prod.tail, memory_order_acquire);
+    if ((count = queue->cons.tail - head) == 0U)
+        return 0U;
+    /* note: only the contiguous part up to the end of the ring-buffer */
+    first = queue->size - (head & queue->mask);
+    if (count > first)
+        count = first;
+    *elements = (const void*)&queue->queueElem[((head & queue->mask) * queue->elemSize)];
+    queue->cons.borrowed = count;
+    return count;
+}
+
+static Boolean CommitElements(CANQUE_MsgQueue_t queue, UInt32 numElem) {
+    assert(queue);
+
+    UInt32 head = atomic_load_explicit(&queue->cons.head, memory_order_relaxed);
+
+    /* note: only elements that have been borrowed by the last peek can be released */
+    if (numElem > queue->cons.borrowed)
         return false;
+    assert((queue->cons.tail - head) >= numElem);
+    atomic_store_explicit(&queue->cons.head, head + numElem, memory_order_release);
+    queue->cons.borrowed = 0U;
+    return true;
+}
+
+static void DiscardElements(CANQUE_MsgQueue_t queue) {
+    assert(queue);
+
+    /* note: only the read position is moved (the producer may still be active) */
+    UInt32 tail = atomic_load_explicit(&queue->prod.tail, memory_order_acquire);
+    atomic_store_explicit(&queue->cons.head, tail, memory_order_release);
+    queue->cons.tail = tail;
+    queue->cons.borrowed = 0U;
+}
+
+static void UpdateHighLevel(CANQUE_MsgQueue_t queue, UInt32 used) {
+    assert(queue);
+
+    UInt32 high = atomic_load_explicit(&queue->prod.high, memory_order_relaxed);
+
+    /* note: the consumer may reset the level concurrently (CANQUE_Reset) */
+    while ((high < used) &&
+           !atomic_compare_exchange_weak_explicit(&queue->prod.high, &high, used,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+static void CountOverflow(CANQUE_MsgQueue_t queue, UInt64 count) {
+    assert(queue);
+
+    /* note: the consumer may reset the counter concurrently (CANQUE_Reset) */
+    (void)atomic_fetch_add_explicit(&queue->prod.ovfl.counter, count, memory_order_relaxed);
+    atomic_store_explicit(&queue->prod.ovfl.flag, true, memory_order_relaxed);
+}
+
+/*  ---  overflow policies and watermarks  ---
+ *
+ *  drop-newest :  the elements to be enqueued are dropped (lock-free or mutex)
+ *  drop-oldest :  the oldest elements are dropped to make room (mutex only)
+ *  block       :  the producer waits for room until a deadline (mutex only),
+ *                 or until it is released by CANQUE_Signal; this policy is
+ *                 meant for application producers (e.g. the transmit queue),
+ *                 never for a queue fed from the USB completion context
+ *
+ *  Dropped elements are counted as overflow in any case. The watermark
+ *  callback is called (w/o the mutex) when the queue level rises to the
+ *  high watermark, and again when it has fallen to the low watermark.
+ */
+static void MakeRoom(CANQUE_MsgQueue_t queue, UInt32 numElem) {
+    assert(queue);
+    assert(queue->size);
+
+    UInt32 tail = atomic_load_explicit(&queue->prod.tail, memory_order_relaxed);
+    UInt32 head = atomic_load_explicit(&queue->cons.head, memory_order_acquire);
+    UInt32 used = tail - head;
+    UInt32 count;
+
+    /* note: this must be called by the producer with the mutex locked */
+    if (numElem > queue->size)
+        numElem = queue->size;
+    if ((queue->size - used) >= numElem)
+        return;
+    switch (queue->policy) {
+        case CANQUE_OVFL_DROP_OLDEST:
+            /* note: borrowed elements (peek) cannot be dropped */
+            if (queue->cons.borrowed != 0U)
+                break;
+            count = numElem - (queue->size - used);
+            atomic_store_explicit(&queue->cons.head, head + count, memory_order_release);
+            queue->cons.tail = tail;
+            queue->prod.head = head + count;
+            CountOverflow(queue, (UInt64)count);
+            break;
+        case CANQUE_OVFL_BLOCK:
+            (void)WaitForRoom(queue, numElem, queue->timeout);
+            break;
+        default:
+            break;
+    }
+}
+
+static UInt32 WaitForRoom(CANQUE_MsgQueue_t queue, UInt32 numElem, UInt16 timeout) {
+    assert(queue);
+    assert(queue->size);
+
+    UInt32 tail = atomic_load_explicit(&queue->prod.tail, memory_order_relaxed);
+    UInt32 head = atomic_load_explicit(&queue->cons.head, memory_order_acquire);
+    UInt32 released = queue->wait.released;
+    struct timespec absTime;
+    int res = 0;
+
+    /* note: this must be called by the producer with the mutex locked */
+    if (numElem > queue->size)
+        numElem = queue->size;
+    if (((queue->size - (tail - head)) >= numElem) || (timeout == 0U))
+        return (queue->size - (tail - head));
+    GET_TIME(absTime);
+    ADD_TIME(absTime, timeout);
+    queue->wait.blocked += 1U;
+    while ((queue->size - (tail - head)) < numElem) {
+        if (timeout == CANUSB_INFINITE)
+            res = pthread_cond_wait(&queue->wait.space, &queue->wait.mutex);
+        else
+            res = MacCAN_TimedWait(&queue->wait.space, &queue->wait.mutex, &absTime);
+        /* note: another producer may have taken the room while we were waiting */
+        tail = atomic_load_explicit(&queue->prod.tail, memory_order_relaxed);
+        head = atomic_load_explicit(&queue->cons.head, memory_order_acquire);
+        if ((res != 0) || (queue->wait.released != released))
+            break;
+    }
+    queue->wait.blocked -= 1U;
+    queue->prod.head = head;
+    return (queue->size - (tail - head));
+}
+
+static void CheckHighWatermark(CANQUE_MsgQueue_t queue) {
+    assert(queue);
+
+    if (!queue->wm.callback)
+        return;
+    UInt32 used = atomic_load_explicit(&queue->prod.tail, memory_order_relaxed)
+                - atomic_load_explicit(&queue->cons.head, memory_order_acquire);
+    if ((used >= queue->wm.high) && !atomic_exchange(&queue->wm.reached, true))
+        queue->wm.callback(queue->wm.context, CANQUE_WATERMARK_HIGH, used);
+}
+
+static void CheckLowWatermark(CANQUE_MsgQueue_t queue) {
+    assert(queue);
+
+    if (!queue->wm.callback || !atomic_load_explicit(&queue->wm.reached, memory_order_relaxed))
+        return;
+    UInt32 used = atomic_load_explicit(&queue->prod.tail, memory_order_acquire)
+                - atomic_load_explicit(&queue->cons.head, memory_order_relaxed);
+    if ((used <= queue->wm.low) && atomic_exchange(&queue->wm.reached, false))
+        queue->wm.callback(queue->wm.context, CANQUE_WATERMARK_LOW, used);
+}
+
+/*  ---  pollable file descriptor  ---
+ *
+ *  The read end of the self-pipe is readable as long as the queue is not
+ *  empty (level-triggered, one byte in the pipe when armed). The producer
+ *  arms the event after an enqueue; the consumer disarms it when it sees
+ *  the queue empty, and re-arms it if the producer has queued another
+ *  element in the meantime. Writing or reading the byte is serialized by
+ *  a mutex, so that the flag always tells the content of the pipe. The
+ *  mutex is only taken on a transition (empty / not empty).
+ */
+static void RaiseEvent(CANQUE_MsgQueue_t queue) {
+    assert(queue);
+
+    int fd = atomic_load_explicit(&queue->event.fd[1], memory_order_acquire);
+    char byte = 0;
+
+    if (fd < 0)
+        return;
+    /* note: the write position must be visible before the flag is tested */
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&queue->event.armed, memory_order_relaxed))
+        return;
+    assert(0 == pthread_mutex_lock(&queue->event.mutex));
+    if (!atomic_load_explicit(&queue->event.armed, memory_order_relaxed)) {
+        (void)write(fd, &byte, 1);
+        atomic_store(&queue->event.armed, true);
+    }
+    assert(0 == pthread_mutex_unlock(&queue->event.mutex));
+}
+
+static void ClearEvent(CANQUE_MsgQueue_t queue) {
+    assert(queue);
+
+    int fd = atomic_load_explicit(&queue->event.fd[0], memory_order_acquire);
+    char byte;
+
+    if ((fd < 0) || !atomic_load_explicit(&queue->event.armed, memory_order_relaxed))
+        return;
+    if (IsNotEmpty(queue))
+        return;
+    assert(0 == pthread_mutex_lock(&queue->event.mutex));
+    if (atomic_load_explicit(&queue->event.armed, memory_order_relaxed) && !IsNotEmpty(queue)) {
+        (void)read(fd, &byte, 1);
+        atomic_store(&queue->event.armed, false);
+    }
+    assert(0 == pthread_mutex_unlock(&queue->event.mutex));
+    /* note: the flag must be visible before the write position is tested again */
+    atomic_thread_fence(memory_order_seq_cst);
+    if (IsNotEmpty(queue))
+        RaiseEvent(queue);
+}
+
+static Boolean IsNotEmpty(CANQUE_MsgQueue_t queue) {
+    assert(queue);
+
+    return (atomic_load(&queue->prod.tail) != atomic_load(&queue->cons.head)) ? true : false;
 }
 
 /* * $Id: MacCAN_MsgQueue.c 1752 2023-07-06 19:40:46Z makemake $ *** (c) UV Software, Berlin ***
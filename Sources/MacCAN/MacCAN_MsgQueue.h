@@ -54,22 +54,73 @@ typedef struct msg_queue_tag *CANQUE_MsgQueue_t;
 
 typedef int CANQUE_Return_t;
 
+typedef UInt8 CANQUE_Mode_t;
+
+/* message queue modes */
+#define CANQUE_MODE_MUTEX     0x00U     /* mutex-protected (any number of producers and consumers) */
+#define CANQUE_MODE_LOCKFREE  0x01U     /* lock-free (single producer, single consumer) */
+
+/* time-out in [usec] for a blocking read */
+#define CANQUE_INFINITE_USEC  (0xFFFFFFFFU)
+
+/* maximum number of message queues to wait for at once */
+#define CANQUE_MAX_SELECT  32U
+
+typedef UInt8 CANQUE_Policy_t;
+
+/* overflow policies */
+#define CANQUE_OVFL_DROP_NEWEST  0x00U  /* drop the element to be enqueued (default) */
+#define CANQUE_OVFL_DROP_OLDEST  0x01U  /* drop the oldest element(s) in the queue */
+#define CANQUE_OVFL_BLOCK        0x02U  /* block the producer (until a deadline, not for the USB callback) */
+
+/* watermark events */
+#define CANQUE_WATERMARK_LOW   0x00U    /* queue level has fallen to the low watermark */
+#define CANQUE_WATERMARK_HIGH  0x01U    /* queue level has risen to the high watermark */
+
+typedef void (*CANQUE_WatermarkCbk_t)(void *context, UInt8 event, UInt32 level);
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 extern CANQUE_MsgQueue_t CANQUE_Create(size_t numElem, size_t elemSize);
 
+extern CANQUE_MsgQueue_t CANQUE_CreateEx(size_t numElem, size_t elemSize, CANQUE_Mode_t mode);
+
 extern CANQUE_Return_t CANQUE_Destroy(CANQUE_MsgQueue_t msgQueue);
 
 extern CANQUE_Return_t CANQUE_Signal(CANQUE_MsgQueue_t msgQueue);
 
 extern CANQUE_Return_t CANQUE_Enqueue(CANQUE_MsgQueue_t msgQueue, void const *message);
 
+extern CANQUE_Return_t CANQUE_EnqueueWait(CANQUE_MsgQueue_t msgQueue, void const *message, UInt16 timeout);
+
+extern CANQUE_Return_t CANQUE_EnqueueMany(CANQUE_MsgQueue_t msgQueue, void const *buffer, UInt32 numElem, UInt32 *enqueued);
+
+extern CANQUE_Return_t CANQUE_EnqueueManyWait(CANQUE_MsgQueue_t msgQueue, void const *buffer, UInt32 numElem, UInt32 *enqueued, UInt16 timeout);
+
 extern CANQUE_Return_t CANQUE_Dequeue(CANQUE_MsgQueue_t msgQueue, void *message, UInt16 timeout);
 
+extern CANQUE_Return_t CANQUE_DequeueUs(CANQUE_MsgQueue_t msgQueue, void *message, UInt32 timeout);
+
+extern CANQUE_Return_t CANQUE_DequeueMany(CANQUE_MsgQueue_t msgQueue, void *buffer, UInt32 maxElem, UInt32 *numElem, UInt16 timeout);
+
+extern CANQUE_Return_t CANQUE_Peek(CANQUE_MsgQueue_t msgQueue, const void **elements, UInt32 *numElem, UInt16 timeout);
+
+extern CANQUE_Return_t CANQUE_Commit(CANQUE_MsgQueue_t msgQueue, UInt32 numElem);
+
 extern CANQUE_Return_t CANQUE_Reset(CANQUE_MsgQueue_t msgQueue);
 
+extern CANQUE_Return_t CANQUE_SetOverflowPolicy(CANQUE_MsgQueue_t msgQueue, CANQUE_Policy_t policy, UInt16 timeout);
+
+extern CANQUE_Return_t CANQUE_GetOverflowPolicy(CANQUE_MsgQueue_t msgQueue, CANQUE_Policy_t *policy, UInt16 *timeout);
+
+extern CANQUE_Return_t CANQUE_SetWatermarks(CANQUE_MsgQueue_t msgQueue, UInt32 high, UInt32 low, CANQUE_WatermarkCbk_t callback, void *context);
+
+extern CANQUE_Return_t CANQUE_GetEventFd(CANQUE_MsgQueue_t msgQueue, int *fd);
+
+extern CANQUE_Return_t CANQUE_Select(CANQUE_MsgQueue_t msgQueues[], UInt32 numQueues, UInt16 timeout, UInt32 *ready);
+
 extern Boolean CANQUE_OverflowFlag(CANQUE_MsgQueue_t msgQueue);
 
 extern UInt64 CANQUE_OverflowCounter(CANQUE_MsgQueue_t msgQueue);
@@ -78,6 +129,8 @@ extern UInt32 CANQUE_QueueSize(CANQUE_MsgQueue_t msgQueue);
 
 extern UInt32 CANQUE_QueueHigh(CANQUE_MsgQueue_t msgQueue);
 
+extern UInt64 CANQUE_WakeupCounter(CANQUE_MsgQueue_t msgQueue);
+
 #ifdef __cplusplus
 }
 #endif
@@ -27,6 +27,8 @@
 #define VERSION_STRING   TOSTRING(VERSION_MAJOR) "." TOSTRING(VERSION_MINOR) "." TOSTRING(VERSION_PATCH) " (" TOSTRING(BUILD_NO) ")"
 #if defined(__APPLE__)
 #define PLATFORM        "macOS"
+#elif defined(__linux__)
+#define PLATFORM        "Linux"
 #else
 #error Unsupported architecture
 #endif
@@ -35,6 +37,7 @@ static const char version[] = "CAN API V3 for Rusoku TouCAN USB Interfaces, Vers
 #include "TouCAN.h"
 #include "can_defs.h"
 #include "can_api.h"
+#include "can_ext.h"
 #include "can_btr.h"
 
 #include <string.h>
@@ -74,6 +77,8 @@ static void _finalizer() {
 EXPORT
 CTouCAN::CTouCAN() {
     m_Handle = (-1);
+    m_RxCallback.pFunction = NULL;
+    m_RxCallback.pContext = NULL;
     m_OpMode.byte = CANMODE_DEFAULT;
     m_Bitrate.btr.frequency = TOUCAN_USB_CLOCK_DOMAIN;
     m_Bitrate.btr.nominal.brp = 10;
@@ -233,6 +238,227 @@ CANAPI_Return_t CTouCAN::ReadMessage(CANAPI_Message_t &message, uint16_t timeout
     return rc;
 }
 
+EXPORT
+CANAPI_Return_t CTouCAN::ReadMessageUs(CANAPI_Message_t &message, uint32_t timeout) {
+    // read one message from the message queue of the CAN interface, if any (time-out in [usec])
+    CANAPI_Return_t rc = can_read_us(m_Handle, &message, timeout);
+    if (CANERR_NOERROR == rc) {
+        m_Counter.u64RxMessages += !message.sts ? 1U : 0U;
+        m_Counter.u64ErrorFrames += message.sts ? 1U : 0U;
+    }
+    return rc;
+}
+
+EXPORT
+CANAPI_Return_t CTouCAN::WriteMessageTagged(CANAPI_Message_t message, uint32_t &tag, uint16_t timeout) {
+    // transmit a message over the CAN bus and return its sequence tag (cf. TX echo)
+    CANAPI_Return_t rc = can_write_tagged(m_Handle, &message, timeout, &tag);
+    if (CANERR_NOERROR == rc) {
+        m_Counter.u64TxMessages++;
+    }
+    return rc;
+}
+
+EXPORT
+CANAPI_Return_t CTouCAN::ReadMessageTagged(CANAPI_Message_t &message, uint32_t &tag, uint16_t timeout) {
+    // read one message from the message queue of the CAN interface, if any (a TX echo has a sequence tag)
+    CANAPI_Return_t rc = can_read_tagged(m_Handle, &message, timeout, &tag);
+    if (CANERR_NOERROR == rc) {
+        m_Counter.u64RxMessages += (!message.sts && !tag) ? 1U : 0U;
+        m_Counter.u64ErrorFrames += message.sts ? 1U : 0U;
+    }
+    return rc;
+}
+
+EXPORT
+CANAPI_Return_t CTouCAN::ReadMessages(CANAPI_Message_t messages[], uint32_t max, uint32_t &count, uint16_t timeout) {
+    // read up to 'max' messages from the message queue of the CAN interface, if any
+    CANAPI_Return_t rc = can_read_multi(m_Handle, messages, max, &count, timeout);
+    if (CANERR_NOERROR == rc) {
+        for (uint32_t i = 0U; i < count; i++) {
+            m_Counter.u64RxMessages += !messages[i].sts ? 1U : 0U;
+            m_Counter.u64ErrorFrames += messages[i].sts ? 1U : 0U;
+        }
+    }
+    return rc;
+}
+
+EXPORT
+CANAPI_Return_t CTouCAN::PeekMessages(SMessageView &view, uint16_t timeout) {
+    // borrow the messages in the message queue of the CAN interface, if any
+    CANAPI_Return_t rc = can_read_peek(m_Handle, &view.m_pMessages, &view.m_u32Count, timeout);
+    return rc;
+}
+
+EXPORT
+CANAPI_Return_t CTouCAN::CommitMessages(SMessageView &view) {
+    // release all borrowed messages to the message queue of the CAN interface
+    return CommitMessages(view, view.m_u32Count);
+}
+
+EXPORT
+CANAPI_Return_t CTouCAN::CommitMessages(SMessageView &view, uint32_t count) {
+    // release the first 'count' borrowed messages to the message queue of the CAN interface
+    // note: the messages must be counted before they are released
+    uint64_t u64RxMessages = 0U, u64ErrorFrames = 0U;
+    for (uint32_t i = 0U; (i < count) && (i < view.m_u32Count); i++) {
+        u64RxMessages += !view.m_pMessages[i].sts ? 1U : 0U;
+        u64ErrorFrames += view.m_pMessages[i].sts ? 1U : 0U;
+    }
+    CANAPI_Return_t rc = can_read_commit(m_Handle, count);
+    if (CANERR_NOERROR == rc) {
+        m_Counter.u64RxMessages += u64RxMessages;
+        m_Counter.u64ErrorFrames += u64ErrorFrames;
+    }
+    // note: the view is invalid after the commit (even on error)
+    view.m_pMessages = NULL;
+    view.m_u32Count = 0U;
+    return rc;
+}
+
+EXPORT
+CANAPI_Return_t CTouCAN::SelectChannels(CTouCAN *channels[], uint32_t count, uint16_t timeout, uint32_t &ready) {
+    // wait until at least one of the CAN interfaces has received a message (bit i for channels[i])
+    int handles[TOUCAN_BOARDS];
+    ready = 0U;
+    if (!channels)
+        return CCanApi::NullPointer;
+    if ((count == 0U) || (count > TOUCAN_BOARDS))
+        return CCanApi::IllegalParameter;
+    for (uint32_t i = 0U; i < count; i++) {
+        if (!channels[i])
+            return CCanApi::NullPointer;
+        handles[i] = channels[i]->m_Handle;
+    }
+    return can_select(handles, count, timeout, &ready);
+}
+
+EXPORT
+CANAPI_Return_t CTouCAN::WriteMessages(const CANAPI_Message_t messages[], uint32_t count, uint32_t &written, uint16_t timeout) {
+    // transmit a batch of messages over the CAN bus (up to three per USB packet)
+    CANAPI_Return_t rc = can_write_multi(m_Handle, messages, count, &written, timeout);
+    m_Counter.u64TxMessages += (uint64_t)written;
+    return rc;
+}
+
+EXPORT
+CANAPI_Return_t CTouCAN::AddCyclicMessage(CANAPI_Message_t message, uint32_t period_us, uint32_t phase_us, int &entry) {
+    // add a message to the transmit scheduler of the CAN interface (sent every 'period_us')
+    return can_tx_schedule_add(m_Handle, &message, period_us, phase_us, &entry);
+}
+
+EXPORT
+CANAPI_Return_t CTouCAN::RemoveCyclicMessage(int entry) {
+    // remove a message from the transmit scheduler of the CAN interface
+    return can_tx_schedule_remove(m_Handle, entry);
+}
+
+EXPORT
+CANAPI_Return_t CTouCAN::UpdateCyclicPayload(int entry, const uint8_t *data, uint8_t dlc) {
+    // replace the payload of a message in the transmit scheduler of the CAN interface
+    return can_tx_schedule_update_payload(m_Handle, entry, data, dlc);
+}
+
+EXPORT
+CANAPI_Return_t CTouCAN::SetFilter(bool xtd, uint32_t code, uint32_t mask) {
+    // set the acceptance filter of the CAN interface (code and mask)
+    if (!xtd)
+        return can_filter_11bit(m_Handle, code, mask);
+    else
+        return can_filter_29bit(m_Handle, code, mask);
+}
+
+EXPORT
+CANAPI_Return_t CTouCAN::SetFilterList(bool xtd, const uint32_t ids[], uint32_t count) {
+    // set the acceptance filter of the CAN interface (list of identifiers)
+    if (!xtd)
+        return can_filter_11bit_list(m_Handle, ids, count);
+    else
+        return can_filter_29bit_list(m_Handle, ids, count);
+}
+
+EXPORT
+CANAPI_Return_t CTouCAN::SetFilterRules(const toucan_filter_rule_t rules[], uint32_t count) {
+    // set the filter rules of the CAN interface (applied by the library)
+    return can_filter_rules(m_Handle, rules, count);
+}
+
+EXPORT
+CANAPI_Return_t CTouCAN::SetReceiveCallback(void (*callback)(const CANAPI_Message_t messages[], uint32_t count, void *context), void *context) {
+    // deliver received CAN messages by callback function (or by the receive queue)
+    CANAPI_Return_t retVal = can_set_rx_callback(m_Handle, callback ? CTouCAN::ReceiveCallback : NULL, (void*)this);
+    if (CCanApi::NoError == retVal) {
+        // note: the CAN controller is stopped, so the callback is not running
+        m_RxCallback.pFunction = callback;
+        m_RxCallback.pContext = context;
+        m_RxCallback.fnHandler = nullptr;
+    }
+    return retVal;
+}
+
+EXPORT
+CANAPI_Return_t CTouCAN::SetReceiveCallback(std::function<void(const CANAPI_Message_t messages[], uint32_t count)> callback) {
+    // deliver received CAN messages by callable object (or by the receive queue)
+    CANAPI_Return_t retVal = can_set_rx_callback(m_Handle, callback ? CTouCAN::ReceiveCallback : NULL, (void*)this);
+    if (CCanApi::NoError == retVal) {
+        // note: the CAN controller is stopped, so the callback is not running
+        m_RxCallback.pFunction = NULL;
+        m_RxCallback.pContext = NULL;
+        m_RxCallback.fnHandler = std::move(callback);
+    }
+    return retVal;
+}
+
+EXPORT
+CANAPI_Return_t CTouCAN::ReadLatest(uint32_t id, bool xtd, CANAPI_Message_t &message, uint64_t &counter) {
+    // read the latest CAN message of the identifier from the snapshot table
+    can_latest_t latest;
+    CANAPI_Return_t retVal = can_read_latest(m_Handle, id, xtd ? 1 : 0, &latest);
+    if (CCanApi::NoError == retVal) {
+        message = latest.message;
+        counter = latest.counter;
+    }
+    return retVal;
+}
+
+EXPORT
+CANAPI_Return_t CTouCAN::ReadSnapshot(CANAPI_Message_t messages[], uint64_t counters[], uint32_t max, uint32_t &count) {
+    // read all entries of the snapshot table
+    can_latest_t *table = NULL;
+    CANAPI_Return_t retVal;
+
+    if (!messages && max)
+        return CCanApi::NullPointer;
+    if (max && ((table = (can_latest_t*)calloc(max, sizeof(can_latest_t))) == NULL))
+        return CCanApi::ResourceError;
+    if ((retVal = can_read_snapshot(m_Handle, table, max, &count)) == CCanApi::NoError) {
+        for (uint32_t i = 0U; i < count; i++) {
+            messages[i] = table[i].message;
+            if (counters)
+                counters[i] = table[i].counter;
+        }
+    }
+    if (table)
+        free(table);
+    return retVal;
+}
+
+void CTouCAN::ReceiveCallback(int handle, const CANAPI_Message_t messages[], uint32_t count, void *context) {
+    CTouCAN *channel = (CTouCAN*)context;
+    (void)handle;
+
+    assert(channel);
+    for (uint32_t i = 0U; i < count; i++) {
+        channel->m_Counter.u64RxMessages += !messages[i].sts ? 1U : 0U;
+        channel->m_Counter.u64ErrorFrames += messages[i].sts ? 1U : 0U;
+    }
+    if (channel->m_RxCallback.fnHandler)
+        channel->m_RxCallback.fnHandler(messages, count);
+    else
+    if (channel->m_RxCallback.pFunction)
+        channel->m_RxCallback.pFunction(messages, count, channel->m_RxCallback.pContext);
+}
+
 EXPORT
 CANAPI_Return_t CTouCAN::GetStatus(CANAPI_Status_t &status) {
     // retrieve the status register of the CAN interface
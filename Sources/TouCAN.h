@@ -24,6 +24,12 @@
 #include "TouCAN_Defines.h"
 #include "TouCAN_Defaults.h"
 #include "CANAPI.h"
+// note: the class layout depends on std::function, so it is the same for all users
+#if (__cplusplus < 201103L)
+#error "CTouCAN requires C++11 or later"
+#endif
+#include <chrono>
+#include <functional>
 
 /// \name   TouCAN
 /// \brief  TouCAN dynamic library
@@ -55,6 +61,12 @@ private:
         uint64_t u64RxMessages;  ///< number of received CAN messages
         uint64_t u64ErrorFrames;  ///< number of received status messages
     } m_Counter;
+    struct {
+        void (*pFunction)(const CANAPI_Message_t messages[], uint32_t count, void *context);  ///< callback function (or NULL)
+        void *pContext;  ///< context for the callback function
+        std::function<void(const CANAPI_Message_t messages[], uint32_t count)> fnHandler;  ///< callable object (or empty)
+    } m_RxCallback;
+    static void ReceiveCallback(int handle, const CANAPI_Message_t messages[], uint32_t count, void *context);
 public:
     // constructor / destructor
     CTouCAN();
@@ -64,6 +76,19 @@ public:
         // note: range 0...-99 is reserved by CAN API V3
         GeneralError = VendorSpecific
     };
+    /// \brief  borrowed view of received CAN messages
+    /// \note   The view is a per-device copy of at most 64 messages, the messages
+    ///         stay in the message queue until they are released by CommitMessages.
+    ///         The view stays valid until the next call of PeekMessages.
+    struct SMessageView {
+        const CANAPI_Message_t *m_pMessages;  ///< first borrowed message (read-only)
+        uint32_t m_u32Count;  ///< number of borrowed messages
+        SMessageView() : m_pMessages(NULL), m_u32Count(0U) {}
+        const CANAPI_Message_t *begin() const { return m_pMessages; }
+        const CANAPI_Message_t *end() const { return m_pMessages + m_u32Count; }
+        const CANAPI_Message_t &operator[](uint32_t index) const { return m_pMessages[index]; }
+        uint32_t size() const { return m_u32Count; }
+    };
     // CCanApi overrides
     static bool GetFirstChannel(SChannelInfo &info, void *param = NULL);
     static bool GetNextChannel(SChannelInfo &info, void *param = NULL);
@@ -81,6 +106,41 @@ public:
     CANAPI_Return_t WriteMessage(CANAPI_Message_t message, uint16_t timeout = 0U);
     CANAPI_Return_t ReadMessage(CANAPI_Message_t &message, uint16_t timeout = CANREAD_INFINITE);
 
+    // CTouCAN-specific methods (CAN API V3 extension)
+    CANAPI_Return_t ReadMessageUs(CANAPI_Message_t &message, uint32_t timeout = TOUCAN_READ_INFINITE_USEC);
+    CANAPI_Return_t WriteMessageTagged(CANAPI_Message_t message, uint32_t &tag, uint16_t timeout = 0U);
+    CANAPI_Return_t ReadMessageTagged(CANAPI_Message_t &message, uint32_t &tag, uint16_t timeout = CANREAD_INFINITE);
+    template<class Rep, class Period>
+    CANAPI_Return_t ReadMessage(CANAPI_Message_t &message, const std::chrono::duration<Rep, Period> &timeout) {
+        // note: a negative duration means polling, a duration beyond 32-bit microseconds means blocking read
+        std::chrono::microseconds usec = std::chrono::duration_cast<std::chrono::microseconds>(timeout);
+        if (usec.count() <= 0)
+            return ReadMessageUs(message, 0U);
+        if (usec.count() >= (std::chrono::microseconds::rep)TOUCAN_READ_INFINITE_USEC)
+            return ReadMessageUs(message, TOUCAN_READ_INFINITE_USEC);
+        return ReadMessageUs(message, (uint32_t)usec.count());
+    }
+    CANAPI_Return_t ReadMessages(CANAPI_Message_t messages[], uint32_t max, uint32_t &count, uint16_t timeout = CANREAD_INFINITE);
+    CANAPI_Return_t PeekMessages(SMessageView &view, uint16_t timeout = CANREAD_INFINITE);
+    CANAPI_Return_t CommitMessages(SMessageView &view);
+    CANAPI_Return_t CommitMessages(SMessageView &view, uint32_t count);
+    static CANAPI_Return_t SelectChannels(CTouCAN *channels[], uint32_t count, uint16_t timeout, uint32_t &ready);
+    CANAPI_Return_t WriteMessages(const CANAPI_Message_t messages[], uint32_t count, uint32_t &written, uint16_t timeout = 0U);
+    CANAPI_Return_t AddCyclicMessage(CANAPI_Message_t message, uint32_t period_us, uint32_t phase_us, int &entry);
+    CANAPI_Return_t RemoveCyclicMessage(int entry);
+    CANAPI_Return_t UpdateCyclicPayload(int entry, const uint8_t *data, uint8_t dlc);
+    CANAPI_Return_t SetFilter(bool xtd, uint32_t code, uint32_t mask);
+    CANAPI_Return_t SetFilterList(bool xtd, const uint32_t ids[], uint32_t count);
+    CANAPI_Return_t SetFilterRules(const toucan_filter_rule_t rules[], uint32_t count);
+    /// \note  The callback is called in the USB completion context (see can_set_rx_callback),
+    ///         a NULL pointer or an empty function restores the delivery by the receive queue.
+    CANAPI_Return_t SetReceiveCallback(void (*callback)(const CANAPI_Message_t messages[], uint32_t count, void *context), void *context);
+    CANAPI_Return_t SetReceiveCallback(std::function<void(const CANAPI_Message_t messages[], uint32_t count)> callback);
+    /// \note  The snapshot table must be enabled by property TOUCAN_PROPERTY_SET_SNAPSHOT (see can_read_latest),
+    ///         it can be read from any thread without taking a lock. The counters can be NULL.
+    CANAPI_Return_t ReadLatest(uint32_t id, bool xtd, CANAPI_Message_t &message, uint64_t &counter);
+    CANAPI_Return_t ReadSnapshot(CANAPI_Message_t messages[], uint64_t counters[], uint32_t max, uint32_t &count);
+
     CANAPI_Return_t GetStatus(CANAPI_Status_t &status);
     CANAPI_Return_t GetBusLoad(uint8_t &load);
 
@@ -137,6 +197,30 @@ public:
 #define TOUCAN_PROPERTY_VID_PID             (TOUCAN_GET_VID_PID)
 #define TOUCAN_PROPERTY_DEVICE_ID           (TOUCAN_GET_DEVICE_ID)
 #define TOUCAN_PROPERTY_VENDOR_URL          (TOUCAN_GET_VENDOR_URL)
+#define TOUCAN_PROPERTY_RCV_XFER_COUNTER    (TOUCAN_GET_RCV_XFER_COUNTER)
+#define TOUCAN_PROPERTY_RCV_WAKEUP_COUNTER  (TOUCAN_GET_RCV_WAKEUP_COUNTER)
+#define TOUCAN_PROPERTY_RCV_QUEUE_POLICY    (TOUCAN_GET_RCV_QUEUE_POLICY)
+#define TOUCAN_PROPERTY_RCV_QUEUE_WATERMARK (TOUCAN_GET_RCV_QUEUE_WATERMARK)
+#define TOUCAN_PROPERTY_RCV_EVENT_FD        (TOUCAN_GET_RCV_EVENT_FD)
+#define TOUCAN_PROPERTY_TX_QUEUE_ORDER      (TOUCAN_GET_TX_QUEUE_ORDER)
+#define TOUCAN_PROPERTY_TX_ECHO             (TOUCAN_GET_TX_ECHO)
+#define TOUCAN_PROPERTY_TX_ECHO_COUNTER     (TOUCAN_GET_TX_ECHO_COUNTER)
+#define TOUCAN_PROPERTY_CLOCK_SYNC          (TOUCAN_GET_CLOCK_SYNC)
+#define TOUCAN_PROPERTY_FILTER_DEVICE       (TOUCAN_GET_FILTER_DEVICE)
+#define TOUCAN_PROPERTY_FILTER_REJECTED     (TOUCAN_GET_FILTER_REJECTED)
+#define TOUCAN_PROPERTY_RCV_PIPE_STATS      (TOUCAN_GET_RCV_PIPE_STATS)
+#define TOUCAN_PROPERTY_SNAPSHOT            (TOUCAN_GET_SNAPSHOT)
+#define TOUCAN_PROPERTY_ID_STATS            (TOUCAN_GET_ID_STATS)
+#define TOUCAN_PROPERTY_ID_STATS_LIST       (TOUCAN_GET_ID_STATS_LIST)
+#define TOUCAN_PROPERTY_STS_REFRESH_COUNTER (TOUCAN_GET_STS_REFRESH_COUNTER)
+#define TOUCAN_PROPERTY_TX_SCHEDULE_ENTRIES (TOUCAN_GET_TX_SCHEDULE_ENTRIES)
+#define TOUCAN_PROPERTY_TX_SCHEDULE_STATS   (TOUCAN_GET_TX_SCHEDULE_STATS)
+#define TOUCAN_PROPERTY_SET_RCV_QUEUE_POLICY    (TOUCAN_SET_RCV_QUEUE_POLICY)
+#define TOUCAN_PROPERTY_SET_RCV_QUEUE_WATERMARK (TOUCAN_SET_RCV_QUEUE_WATERMARK)
+#define TOUCAN_PROPERTY_SET_TX_QUEUE_ORDER      (TOUCAN_SET_TX_QUEUE_ORDER)
+#define TOUCAN_PROPERTY_SET_TX_ECHO             (TOUCAN_SET_TX_ECHO)
+#define TOUCAN_PROPERTY_SET_SNAPSHOT            (TOUCAN_SET_SNAPSHOT)
+#define TOUCAN_PROPERTY_SET_ID_STATS            (TOUCAN_SET_ID_STATS)
 /// \}
 
 #endif // TOUCAN_H_INCLUDED
@@ -83,6 +83,30 @@ extern "C" {
 #define TOUCAN_GET_VID_PID             (CANPROP_GET_VENDOR_PROP + 0x16U)  /**< VID & PID (uint23_t) */
 #define TOUCAN_GET_DEVICE_ID           (CANPROP_GET_VENDOR_PROP + 0x17U)  /**< device id. (uint23_t) */
 #define TOUCAN_GET_VENDOR_URL          (CANPROP_GET_VENDOR_PROP + 0x18U)  /**< URL of Rusoku's website (uint23_t) */
+#define TOUCAN_GET_RCV_XFER_COUNTER    (CANPROP_GET_VENDOR_PROP + 0x20U)  /**< number of received USB transfers (uint64_t) */
+#define TOUCAN_GET_RCV_WAKEUP_COUNTER  (CANPROP_GET_VENDOR_PROP + 0x21U)  /**< number of wake-ups of the reader (uint64_t) */
+#define TOUCAN_GET_RCV_QUEUE_POLICY    (CANPROP_GET_VENDOR_PROP + 0x22U)  /**< overflow policy of the receive queue (uint8_t) */
+#define TOUCAN_GET_RCV_QUEUE_WATERMARK (CANPROP_GET_VENDOR_PROP + 0x24U)  /**< watermarks of the receive queue (toucan_watermark_t) */
+#define TOUCAN_GET_RCV_EVENT_FD        (CANPROP_GET_VENDOR_PROP + 0x25U)  /**< pollable file descriptor of the receive queue (int) */
+#define TOUCAN_GET_TX_SCHEDULE_ENTRIES (CANPROP_GET_VENDOR_PROP + 0x26U)  /**< number of cyclic CAN messages (uint32_t) */
+#define TOUCAN_GET_TX_SCHEDULE_STATS   (CANPROP_GET_VENDOR_PROP + 0x27U)  /**< statistics of a cyclic CAN message (toucan_schedule_stats_t) */
+#define TOUCAN_GET_TX_QUEUE_ORDER      (CANPROP_GET_VENDOR_PROP + 0x28U)  /**< order of the transmit queue (uint8_t) */
+#define TOUCAN_GET_TX_ECHO             (CANPROP_GET_VENDOR_PROP + 0x29U)  /**< echo of transmitted CAN messages, time-stamped on OUT completion (uint8_t) */
+#define TOUCAN_GET_TX_ECHO_COUNTER     (CANPROP_GET_VENDOR_PROP + 0x2AU)  /**< number of received TX echoes (uint64_t) */
+#define TOUCAN_GET_CLOCK_SYNC          (CANPROP_GET_VENDOR_PROP + 0x2BU)  /**< quality of the time synchronization (toucan_clock_sync_t) */
+#define TOUCAN_GET_FILTER_DEVICE       (CANPROP_GET_VENDOR_PROP + 0x2CU)  /**< acceptance filters applied by the device (uint8_t) */
+#define TOUCAN_GET_FILTER_REJECTED     (CANPROP_GET_VENDOR_PROP + 0x2DU)  /**< number of CAN messages rejected by the filters (uint64_t) */
+#define TOUCAN_GET_RCV_PIPE_STATS      (CANPROP_GET_VENDOR_PROP + 0x2EU)  /**< statistics of the USB reception pipeline (toucan_pipe_stats_t) */
+#define TOUCAN_GET_SNAPSHOT            (CANPROP_GET_VENDOR_PROP + 0x2FU)  /**< table of the latest CAN message per identifier (toucan_snapshot_t) */
+#define TOUCAN_GET_ID_STATS            (CANPROP_GET_VENDOR_PROP + 0x30U)  /**< traffic statistics per identifier (toucan_id_stats_setup_t) */
+#define TOUCAN_GET_ID_STATS_LIST       (CANPROP_GET_VENDOR_PROP + 0x31U)  /**< snapshot of the traffic statistics (toucan_id_stats_list_t) */
+#define TOUCAN_GET_STS_REFRESH_COUNTER (CANPROP_GET_VENDOR_PROP + 0x32U)  /**< number of reads of the interface error code (uint64_t) */
+#define TOUCAN_SET_RCV_QUEUE_POLICY    (CANPROP_SET_VENDOR_PROP + 0x22U)  /**< overflow policy of the receive queue (uint8_t) */
+#define TOUCAN_SET_RCV_QUEUE_WATERMARK (CANPROP_SET_VENDOR_PROP + 0x24U)  /**< watermarks of the receive queue (toucan_watermark_t) */
+#define TOUCAN_SET_TX_QUEUE_ORDER      (CANPROP_SET_VENDOR_PROP + 0x28U)  /**< order of the transmit queue (uint8_t) */
+#define TOUCAN_SET_TX_ECHO             (CANPROP_SET_VENDOR_PROP + 0x29U)  /**< echo of transmitted CAN messages, time-stamped on OUT completion (uint8_t) */
+#define TOUCAN_SET_SNAPSHOT            (CANPROP_SET_VENDOR_PROP + 0x2FU)  /**< table of the latest CAN message per identifier (toucan_snapshot_t) */
+#define TOUCAN_SET_ID_STATS            (CANPROP_SET_VENDOR_PROP + 0x30U)  /**< traffic statistics per identifier (toucan_id_stats_setup_t) */
 #if (OPTION_TOUCAN_CANAL != 0)
 #define TOUCAN_GET_CANAL_ERROR_STATUS  (CANPROP_GET_VENDOR_PROP + 0xF0U)  // CANAL API (r?)
 #define TOUCAN_GET_CANAL_STATISTICS    (CANPROP_GET_VENDOR_PROP + 0xF1U)  // CANAL API (rw)
@@ -90,6 +114,56 @@ extern "C" {
 #define TOUCAN_MAX_BUFFER_SIZE   256U   /**< max. buffer size for CAN_GetValue/CAN_SetValue */
 /** @} */
 
+/** @name  CAN API Time-out
+ *  @brief Time-out in microseconds (cf. can_read_us)
+ *  @{ */
+#define TOUCAN_READ_INFINITE_USEC  0xFFFFFFFFU  /**< blocking read (time-out in [usec]) */
+/** @} */
+
+/** @name  Receive Queue Overflow Policies
+ *  @brief What happens when the receive queue is full (the reception is
+ *         never blocked, it runs in the USB completion context)
+ *  @{ */
+#define TOUCAN_QUEUE_DROP_NEWEST  0x00U /**< drop the newest CAN message (default) */
+#define TOUCAN_QUEUE_DROP_OLDEST  0x01U /**< drop the oldest CAN message(s) */
+/** @} */
+
+/** @name  Receive Queue Watermark Events
+ *  @brief Reason for calling the watermark callback function
+ *  @{ */
+#define TOUCAN_WATERMARK_LOW      0x00U /**< queue level has fallen to the low watermark */
+#define TOUCAN_WATERMARK_HIGH     0x01U /**< queue level has risen to the high watermark */
+/** @} */
+
+/** @name  Transmit Queue Order
+ *  @brief In which order pending CAN messages are sent
+ *  @{ */
+#define TOUCAN_TX_ORDER_FIFO      0x00U /**< first in, first out (default) */
+#define TOUCAN_TX_ORDER_PRIORITY  0x01U /**< by CAN identifier (FIFO per identifier) */
+/** @} */
+
+/** @name  Cyclic Transmit Scheduler
+ *  @brief Limits of the cyclic CAN messages (cf. can_tx_schedule_add)
+ *  @{ */
+#define TOUCAN_TX_SCHEDULE_MAX_ENTRIES  512U  /**< max. number of cyclic CAN messages per channel */
+#define TOUCAN_TX_SCHEDULE_MIN_PERIOD   100U  /**< shortest cycle time (in [usec]) */
+/** @} */
+
+/** @name  Acceptance Filter
+ *  @brief Limits of the acceptance filter lists (cf. can_filter_11bit_list)
+ *  @{ */
+#define TOUCAN_FILTER_MAX_IDS     64U   /**< max. number of identifiers per list */
+#define TOUCAN_FILTER_MAX_RULES   65536U  /**< max. number of filter rules (cf. can_filter_rules) */
+/** @} */
+
+/** @name  Snapshot Table
+ *  @brief Latest CAN message per identifier (cf. can_read_latest)
+ *  @{ */
+#define TOUCAN_SNAPSHOT_STD_IDS   2048U   /**< number of 11-bit identifiers (always in the table) */
+#define TOUCAN_SNAPSHOT_XTD_IDS   65536U  /**< max. number of 29-bit identifiers in the table */
+#define TOUCAN_ID_STATS_XTD_IDS   65536U  /**< max. number of 29-bit identifiers in the traffic statistics */
+/** @} */
+
 /** @name  CAN API Library ID
  *  @brief Library ID and dynamic library names
  *  @{ */
@@ -100,6 +174,9 @@ extern "C" {
 #elif defined(__APPLE__)
  #define TOUCAN_LIB_CANLIB      "(none)"
  #define TOUCAN_LIB_WRAPPER     "libUVCANTOU.dylib"
+#elif defined(__linux__)
+ #define TOUCAN_LIB_CANLIB      "(none)"
+ #define TOUCAN_LIB_WRAPPER     "libuvcantou.so.1"
 #else
 #error Platform not supported
 #endif
@@ -114,6 +191,150 @@ extern "C" {
                                 "This can damage your application."
 /** @} */
 
+
+/*  -----------  types  --------------------------------------------------
+ */
+
+/** @brief       TouCAN channel parameter (optional argument 'param' of can_init):
+ *               The receive queue size is rounded up to a power of two.
+ */
+typedef struct toucan_param_t_ {
+    uint32_t rcv_queue_size;            /**< receive queue size in CAN messages (0 = default) */
+} toucan_param_t;
+
+/** @brief       TouCAN watermark callback function:
+ *               Called from the reception thread (high watermark) or from
+ *               the reading thread (low watermark), so keep it short.
+ */
+typedef void (*toucan_watermark_cbk_t)(int handle, uint8_t event, uint32_t level, void *context);
+
+/** @brief       TouCAN receive queue watermarks (property value):
+ *               A NULL pointer as callback function disables the notification.
+ */
+typedef struct toucan_watermark_t_ {
+    uint32_t high;                      /**< high watermark (number of CAN messages) */
+    uint32_t low;                       /**< low watermark (less than high watermark) */
+    toucan_watermark_cbk_t callback;    /**< callback function (or NULL) */
+    void *context;                      /**< context for the callback function */
+} toucan_watermark_t;
+
+/** @brief       TouCAN statistics of a cyclic CAN message (property value):
+ *               The entry must be set by the caller. The release delay is
+ *               the time from the deadline until the CAN message is put into
+ *               the transmit queue. A deadline is missed when a whole period
+ *               has passed or when the transmit queue was full.
+ *               The statistics of a removed cyclic CAN message can be read
+ *               until its entry is reused by another one.
+ */
+typedef struct toucan_schedule_stats_t_ {
+    int32_t entry;                      /**< entry of the cyclic CAN message (in) */
+    uint64_t sent;                      /**< number of CAN messages put into the transmit queue */
+    uint64_t missed;                    /**< number of deadline misses */
+    uint32_t jitter_min;                /**< shortest release delay (in [usec]) */
+    uint32_t jitter_max;                /**< longest release delay (in [usec]) */
+    uint32_t jitter_avg;                /**< average release delay (in [usec]) */
+} toucan_schedule_stats_t;
+
+/** @brief       TouCAN quality of the time synchronization (property value):
+ *               The time-stamps of received CAN messages are converted from
+ *               the microsecond counter of the device to the monotonic clock
+ *               of the system by offset and drift. They are estimated by a
+ *               linear regression over a window of samples (one per 500ms).
+ *               The drift is zero until the window spans at least 5 seconds.
+ */
+typedef struct toucan_clock_sync_t_ {
+    uint32_t samples;                   /**< number of samples in the window (0 = not synchronized) */
+    uint32_t span;                      /**< time span of the window (in [ms]) */
+    int32_t drift;                      /**< drift of the device clock (in [ppb]) */
+    uint32_t residual;                  /**< largest deviation of a sample from the estimate (in [ns]) */
+    uint32_t resyncs;                   /**< number of restarts (when the device clock was reset) */
+} toucan_clock_sync_t;
+
+/** @brief       TouCAN statistics of the USB reception pipeline (property value):
+ *               Several reads are submitted to the IN endpoint at once, so that
+ *               the device can send while a completed transfer is processed.
+ *               The pipeline ran dry when a read was completed and no other
+ *               one was submitted; CAN messages may have been lost then.
+ */
+typedef struct toucan_pipe_stats_t_ {
+    uint32_t depth;                     /**< number of reads submitted at once */
+    uint32_t xfer_size;                 /**< size of each read (in [byte]) */
+    uint64_t transfers;                 /**< number of completed reads */
+    uint64_t dry_runs;                  /**< number of times no read was submitted */
+    uint64_t errors;                    /**< number of failed submissions */
+} toucan_pipe_stats_t;
+
+/** @brief       TouCAN snapshot table (property value):
+ *               When enabled, the latest CAN message of each identifier is
+ *               kept in a table that can be read from any thread while the
+ *               reception continues (cf. can_read_latest). All 11-bit ids.
+ *               are in the table; 29-bit ids. take a free entry when they
+ *               are received first, until the given number is reached.
+ */
+typedef struct toucan_snapshot_t_ {
+    uint8_t enabled;                    /**< table enabled (0 = off) */
+    uint32_t xtd_ids;                   /**< max. number of 29-bit identifiers (0..TOUCAN_SNAPSHOT_XTD_IDS) */
+    uint64_t dropped;                   /**< number of CAN messages not stored, table full (only get) */
+} toucan_snapshot_t;
+
+/** @brief       TouCAN traffic statistics per identifier (property value):
+ *               When enabled, the reception callback accounts each received
+ *               CAN message to its identifier (w/o allocation). All 11-bit
+ *               ids. are accounted; 29-bit ids. take a free entry when they
+ *               are received first, until the given number is reached.
+ *               Enabling the statistics again resets them.
+ */
+typedef struct toucan_id_stats_setup_t_ {
+    uint8_t enabled;                    /**< statistics enabled (0 = off) */
+    uint32_t xtd_ids;                   /**< max. number of 29-bit identifiers (0..TOUCAN_ID_STATS_XTD_IDS) */
+    uint32_t identifiers;               /**< number of received identifiers (only get) */
+    uint64_t dropped;                   /**< number of CAN messages not accounted, table full (only get) */
+} toucan_id_stats_setup_t;
+
+/** @brief       TouCAN traffic statistics of an identifier (cf. toucan_id_stats_list_t):
+ *               The rate is averaged from the first to the latest CAN message.
+ *               The jitter is the standard deviation of the inter-arrival time.
+ */
+typedef struct toucan_id_stats_t_ {
+    uint32_t id;                        /**< CAN identifier */
+    uint8_t xtd;                        /**< 29-bit identifier */
+    uint8_t dlc;                        /**< data length code of the latest CAN message */
+    uint64_t frames;                    /**< number of received CAN messages */
+    uint64_t dlc_changes;               /**< number of changes of the data length code */
+    uint32_t rate;                      /**< average rate (in [mHz], i.e. CAN messages per 1000s) */
+    uint32_t gap_min;                   /**< shortest inter-arrival time (in [usec]) */
+    uint32_t gap_max;                   /**< longest inter-arrival time (in [usec]) */
+    uint32_t gap_avg;                   /**< average inter-arrival time (in [usec]) */
+    uint32_t jitter;                    /**< jitter of the inter-arrival time (in [usec]) */
+} toucan_id_stats_t;
+
+/** @brief       TouCAN snapshot of the traffic statistics (property value):
+ *               The caller provides an array for the entries; 11-bit ids.
+ *               come first in ascending order, 29-bit ids. follow in no
+ *               particular order. Each entry is consistent in itself.
+ */
+typedef struct toucan_id_stats_list_t_ {
+    toucan_id_stats_t *entries;         /**< array for the entries (in) */
+    uint32_t max;                       /**< size of the array (in) */
+    uint32_t count;                     /**< number of entries copied into the array (out) */
+} toucan_id_stats_list_t;
+
+/** @brief       TouCAN filter rule (cf. can_filter_rules):
+ *               A rule accepts CAN messages with an identifier in the range
+ *               from first to last. Optionally, the payload of the message
+ *               can be checked: at least dlc data bytes and the data bytes
+ *               masked by mask equal code (only the first 8 data bytes).
+ *               A rule with a payload predicate never accepts remote frames.
+ */
+typedef struct toucan_filter_rule_t_ {
+    uint32_t first;                     /**< first identifier of the range */
+    uint32_t last;                      /**< last identifier of the range (inclusive) */
+    uint8_t xtd;                        /**< 29-bit identifiers (otherwise 11-bit identifiers) */
+    uint8_t dlc;                        /**< minimal data length code (0 = any) */
+    uint8_t code[8];                    /**< data bytes to be matched */
+    uint8_t mask[8];                    /**< bits of the data bytes to be compared (all zero = none) */
+} toucan_filter_rule_t;
+
 #ifdef __cplusplus
 }
 #endif
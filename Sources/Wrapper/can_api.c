@@ -30,6 +30,8 @@
 #define VERSION_STRING   TOSTRING(VERSION_MAJOR) "." TOSTRING(VERSION_MINOR) "." TOSTRING(VERSION_PATCH) " (" TOSTRING(BUILD_NO) ")"
 #if defined(__APPLE__)
 #define PLATFORM        "macOS"
+#elif defined(__linux__)
+#define PLATFORM        "Linux"
 #else
 #error Unsupported architecture
 #endif
@@ -39,11 +41,14 @@ static const char version[] = "CAN API V3 for Rusoku TouCAN USB Interfaces, Vers
  */
 #include "can_defs.h"
 #include "can_api.h"
+#include "can_ext.h"
 #include "can_btr.h"
 
 #include "TouCAN_Driver.h"
+#include "TouCAN_Scheduler.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <assert.h>
 
@@ -85,21 +90,38 @@ static void _finalizer() {
  */
 typedef struct {                        // frame counters:
     uint64_t tx;                        //   number of transmitted CAN frames
+    uint64_t cyclic;                    //   number of transmitted cyclic CAN frames (scheduler thread)
     uint64_t rx;                        //   number of received CAN frames
     uint64_t err;                       //   number of receiced error frames
 }   can_counter_t;
 
+typedef struct {                        // borrowed messages:
+    const can_message_t *messages;      //   pointer into the receive queue
+    uint32_t count;                     //   number of borrowed messages
+}   can_view_t;
+
 typedef struct {                        // TouCAN interface:
     TouCAN_Device_t device;             //   USB device descriptor
     can_mode_t mode;                    //   CAN operation mode
     can_status_t status;                //   8-bit status register
     can_counter_t counters;             //   statistical counters
+    can_view_t view;                    //   borrowed receive messages
+    toucan_watermark_t watermark;       //   receive queue watermarks
+    can_rx_callback_t rx_callback;      //   receive callback (or NULL)
+    void *rx_context;                   //   context for the receive callback
+    TouCAN_Scheduler_t scheduler;       //   cyclic transmit scheduler
 }   can_interface_t;
 
 /*  -----------  prototypes  ---------------------------------------------
  */
 static int lib_parameter(uint16_t param, void *value, size_t nbyte);
 static int drv_parameter(int handle, uint16_t param, void *value, size_t nbyte);
+static int check_message(int handle, const can_message_t *message);
+static void watermark_callback(void *context, UInt8 event, UInt32 level);
+static void receive_callback(void *context, const can_message_t *messages, uint32_t count);
+static int id_stats_list(TouCAN_IdStats_t stats, toucan_id_stats_list_t *list);
+static CANUSB_Return_t schedule_callback(void *context, const can_message_t *messages, uint32_t count, uint32_t *written);
+static void schedule_release(int handle);
 
 /*  -----------  variables  ----------------------------------------------
  */
@@ -166,6 +188,7 @@ EXPORT
 int can_init(int32_t channel, uint8_t mode, const void *param)
 {
     int rc = CANERR_FATAL;              // return value
+    uint32_t queueSize = 0U;            // receive queue size (0 = default)
     int i;
 
     if (!init) {                        // when not initialized:
@@ -190,12 +213,17 @@ int can_init(int32_t channel, uint8_t mode, const void *param)
         //       CANERR_NOTINIT in this case
         return CANERR_NOTINIT;
 #endif
+    // note: the receive queue size can be given by the optional parameter
+    if (param)
+        queueSize = ((const toucan_param_t*)param)->rcv_queue_size;
     // initialize CAN channel with selected operation mode
-    if ((rc = TouCAN_InitializeChannel(channel, mode, &can[channel].device)) < CANERR_NOERROR)
+    if ((rc = TouCAN_InitializeChannel(channel, mode, queueSize, &can[channel].device)) < CANERR_NOERROR)
         return rc;
     can[channel].mode.byte = mode;      // store selected operation mode
     can[channel].status.byte = CANSTAT_RESET; // CAN not started yet
-    (void)param;
+    memset(&can[channel].watermark, 0, sizeof(toucan_watermark_t));
+    can[channel].rx_callback = NULL;    // message queue by default
+    can[channel].rx_context = NULL;
     return (int)channel;                // return the handle (channel)
 }
 
@@ -211,6 +239,7 @@ int can_exit(int handle)
             return CANERR_HANDLE;
         if (!can[handle].device.configured) // must be an opened handle
             return CANERR_HANDLE;
+        schedule_release(handle);       // stop sending cyclic messages
         /*if (!can[handle].status.can_stopped) // go to CAN INIT mode (bus off)*/
             (void)TouCAN_StopCan(&can[handle].device);
         if ((rc = TouCAN_TeardownChannel(&can[handle].device)) < CANERR_NOERROR)
@@ -222,6 +251,7 @@ int can_exit(int handle)
         for (i = 0; i < CAN_MAX_HANDLES; i++) {
             if (can[i].device.configured) // must be an opened handle
             {
+                schedule_release(i);    // stop sending cyclic messages
                 /*if (!can[handle].status.can_stopped) // go to CAN INIT mode (bus off)*/
                     (void)TouCAN_StopCan(&can[i].device);
                 (void)TouCAN_TeardownChannel(&can[i].device);
@@ -316,8 +346,11 @@ int can_start(int handle, const can_bitrate_t *bitrate)
     // clear status, counters, and the receive queue
     can[handle].status.byte = CANSTAT_RESET;
     can[handle].counters.tx = 0U;
+    can[handle].counters.cyclic = 0U;
     can[handle].counters.rx = 0U;
     can[handle].counters.err = 0U;
+    can[handle].view.messages = NULL;
+    can[handle].view.count = 0U;
     (void)CANQUE_Reset(can[handle].device.recvData.msgQueue);
     // start the CAN controller with the selected operation mode
     rc = TouCAN_StartCan(&can[handle].device);
@@ -365,26 +398,8 @@ int can_write(int handle, const can_message_t *message, uint16_t timeout)
         return CANERR_NULLPTR;
     if (can[handle].status.can_stopped) // must be running
         return CANERR_OFFLINE;
-
-    if (message->id > (uint32_t)(message->xtd ? CAN_MAX_XTD_ID : CAN_MAX_STD_ID))
-        return CANERR_ILLPARA;          // invalid identifier
-    if (message->xtd && can[handle].mode.nxtd)
-        return CANERR_ILLPARA;          // suppress extended frames
-    if (message->rtr && can[handle].mode.nrtr)
-        return CANERR_ILLPARA;          // suppress remote frames
-#if (OPTION_CAN_2_0_ONLY == 0)
-    if (message->fdf && !can[handle].mode.fdoe)
-        return CANERR_ILLPARA;          // long frames only with CAN FD
-    if (message->brs && !can[handle].mode.brse)
-        return CANERR_ILLPARA;          // fast frames only with CAN FD
-    if (message->brs && !message->fdf)
-        return CANERR_ILLPARA;          // bit-rate switching only with CAN FD
-#endif
-    if (message->sts)
-        return CANERR_ILLPARA;          // error frames cannot be sent
-
-    if (message->dlc > CAN_MAX_LEN)     //   data length 0 .. 8!
-        return CANERR_ILLPARA;
+    if (check_message(handle, message) != CANERR_NOERROR)
+        return CANERR_ILLPARA;          // message cannot be sent
 
     // transmit the given CAN message (w/ or w/o acknowledgment)
     rc = TouCAN_WriteMessage(&can[handle].device, message, timeout);
@@ -393,6 +408,344 @@ int can_write(int handle, const can_message_t *message, uint16_t timeout)
     return rc;
 }
 
+EXPORT
+int can_write_tagged(int handle, const can_message_t *message, uint16_t timeout, uint32_t *tag)
+{
+    int rc = CANERR_FATAL;              // return value
+
+    if (!init)                          // must be initialized
+        return CANERR_NOTINIT;
+    if (!IS_HANDLE_VALID(handle))       // must be a valid handle
+        return CANERR_HANDLE;
+    if (!can[handle].device.configured) // must be an opened handle
+        return CANERR_HANDLE;
+    if ((message == NULL) || (tag == NULL)) // check for null-pointer
+        return CANERR_NULLPTR;
+    if (can[handle].status.can_stopped) // must be running
+        return CANERR_OFFLINE;
+    if (check_message(handle, message) != CANERR_NOERROR)
+        return CANERR_ILLPARA;          // message cannot be sent
+
+    // transmit the given CAN message and return its sequence tag
+    rc = TouCAN_WriteMessageTagged(&can[handle].device, message, timeout, tag);
+    can[handle].status.transmitter_busy = (rc != CANUSB_SUCCESS) ? 1 : 0;
+    can[handle].counters.tx += (rc == CANUSB_SUCCESS) ? 1U : 0U;
+    return rc;
+}
+
+EXPORT
+int can_write_multi(int handle, const can_message_t *messages, uint32_t count, uint32_t *written, uint16_t timeout)
+{
+    int rc = CANERR_FATAL;              // return value
+    uint32_t n = 0U;                    // number of messages
+    uint32_t i;
+
+    if (written)
+        *written = 0U;
+    if (!init)                          // must be initialized
+        return CANERR_NOTINIT;
+    if (!IS_HANDLE_VALID(handle))       // must be a valid handle
+        return CANERR_HANDLE;
+    if (!can[handle].device.configured) // must be an opened handle
+        return CANERR_HANDLE;
+    if ((messages == NULL) || (written == NULL)) // check for null-pointer
+        return CANERR_NULLPTR;
+    if (count == 0U)                    // at least one message
+        return CANERR_ILLPARA;
+    if (can[handle].status.can_stopped) // must be running
+        return CANERR_OFFLINE;
+    for (i = 0U; i < count; i++) {      // all or none
+        if (check_message(handle, &messages[i]) != CANERR_NOERROR)
+            return CANERR_ILLPARA;      // message cannot be sent
+    }
+    // transmit the given CAN messages (up to three per USB packet)
+    rc = TouCAN_WriteMessages(&can[handle].device, messages, count, &n, timeout);
+    can[handle].status.transmitter_busy = (rc != CANUSB_SUCCESS) ? 1 : 0;
+    can[handle].counters.tx += (uint64_t)n;
+    *written = n;
+    return rc;
+}
+
+EXPORT
+int can_tx_schedule_add(int handle, const can_message_t *message, uint32_t period_us, uint32_t phase_us, int *entry)
+{
+    int rc = CANERR_FATAL;              // return value
+    int32_t index = -1;                 // schedule entry
+
+    if (!init)                          // must be initialized
+        return CANERR_NOTINIT;
+    if (!IS_HANDLE_VALID(handle))       // must be a valid handle
+        return CANERR_HANDLE;
+    if (!can[handle].device.configured) // must be an opened handle
+        return CANERR_HANDLE;
+    if ((message == NULL) || (entry == NULL)) // check for null-pointer
+        return CANERR_NULLPTR;
+    if (check_message(handle, message) != CANERR_NOERROR)
+        return CANERR_ILLPARA;          // message cannot be sent
+    if (period_us < TOUCAN_SCHED_MIN_PERIOD)
+        return CANERR_ILLPARA;          // cycle time too short
+
+    // the scheduler thread is started with the first cyclic message
+    if (can[handle].scheduler == NULL) {
+        if ((can[handle].scheduler = TouCAN_CreateScheduler(schedule_callback, (void*)&can[handle])) == NULL)
+            return CANERR_RESOURCE;
+    }
+    // add the CAN message to the schedule (first release after 'phase_us')
+    rc = TouCAN_ScheduleAdd(can[handle].scheduler, message, period_us, phase_us, &index);
+    if (rc == CANUSB_SUCCESS)
+        *entry = (int)index;
+    return rc;
+}
+
+EXPORT
+int can_tx_schedule_remove(int handle, int entry)
+{
+    if (!init)                          // must be initialized
+        return CANERR_NOTINIT;
+    if (!IS_HANDLE_VALID(handle))       // must be a valid handle
+        return CANERR_HANDLE;
+    if (!can[handle].device.configured) // must be an opened handle
+        return CANERR_HANDLE;
+    if (can[handle].scheduler == NULL)  // no cyclic messages
+        return CANERR_ILLPARA;
+
+    // remove the CAN message from the schedule
+    return TouCAN_ScheduleRemove(can[handle].scheduler, (int32_t)entry);
+}
+
+EXPORT
+int can_tx_schedule_update_payload(int handle, int entry, const uint8_t *data, uint8_t dlc)
+{
+    if (!init)                          // must be initialized
+        return CANERR_NOTINIT;
+    if (!IS_HANDLE_VALID(handle))       // must be a valid handle
+        return CANERR_HANDLE;
+    if (!can[handle].device.configured) // must be an opened handle
+        return CANERR_HANDLE;
+    if ((data == NULL) && (dlc != 0U))  // check for null-pointer
+        return CANERR_NULLPTR;
+    if (dlc > CAN_MAX_LEN)              //   data length 0 .. 8!
+        return CANERR_ILLPARA;
+    if (can[handle].scheduler == NULL)  // no cyclic messages
+        return CANERR_ILLPARA;
+
+    // replace the payload of the CAN message (sent with the next release)
+    return TouCAN_ScheduleUpdate(can[handle].scheduler, (int32_t)entry, data, dlc);
+}
+
+EXPORT
+int can_filter_11bit(int handle, uint32_t code, uint32_t mask)
+{
+    if (!init)                          // must be initialized
+        return CANERR_NOTINIT;
+    if (!IS_HANDLE_VALID(handle))       // must be a valid handle
+        return CANERR_HANDLE;
+    if (!can[handle].device.configured) // must be an opened handle
+        return CANERR_HANDLE;
+    if (!can[handle].status.can_stopped) // must be stopped
+        return CANERR_ONLINE;
+
+    // set acceptance code and mask (programmed into the device on start)
+    return TouCAN_SetFilter(&can[handle].device, false, code, mask);
+}
+
+EXPORT
+int can_filter_11bit_list(int handle, const uint32_t *ids, uint32_t count)
+{
+    if (!init)                          // must be initialized
+        return CANERR_NOTINIT;
+    if (!IS_HANDLE_VALID(handle))       // must be a valid handle
+        return CANERR_HANDLE;
+    if (!can[handle].device.configured) // must be an opened handle
+        return CANERR_HANDLE;
+    if ((ids == NULL) && (count != 0U)) // check for null-pointer
+        return CANERR_NULLPTR;
+    if (!can[handle].status.can_stopped) // must be stopped
+        return CANERR_ONLINE;
+
+    // set a list of acceptable identifiers (programmed into the device on start)
+    return TouCAN_SetFilterList(&can[handle].device, false, ids, count);
+}
+
+EXPORT
+int can_filter_29bit(int handle, uint32_t code, uint32_t mask)
+{
+    if (!init)                          // must be initialized
+        return CANERR_NOTINIT;
+    if (!IS_HANDLE_VALID(handle))       // must be a valid handle
+        return CANERR_HANDLE;
+    if (!can[handle].device.configured) // must be an opened handle
+        return CANERR_HANDLE;
+    if (!can[handle].status.can_stopped) // must be stopped
+        return CANERR_ONLINE;
+    if (can[handle].device.opMode & CANMODE_NXTD) // no 29-bit identifiers
+        return CANERR_ILLPARA;
+
+    // set acceptance code and mask (programmed into the device on start)
+    return TouCAN_SetFilter(&can[handle].device, true, code, mask);
+}
+
+EXPORT
+int can_filter_29bit_list(int handle, const uint32_t *ids, uint32_t count)
+{
+    if (!init)                          // must be initialized
+        return CANERR_NOTINIT;
+    if (!IS_HANDLE_VALID(handle))       // must be a valid handle
+        return CANERR_HANDLE;
+    if (!can[handle].device.configured) // must be an opened handle
+        return CANERR_HANDLE;
+    if ((ids == NULL) && (count != 0U)) // check for null-pointer
+        return CANERR_NULLPTR;
+    if (!can[handle].status.can_stopped) // must be stopped
+        return CANERR_ONLINE;
+    if (can[handle].device.opMode & CANMODE_NXTD) // no 29-bit identifiers
+        return CANERR_ILLPARA;
+
+    // set a list of acceptable identifiers (programmed into the device on start)
+    return TouCAN_SetFilterList(&can[handle].device, true, ids, count);
+}
+
+EXPORT
+int can_filter_rules(int handle, const toucan_filter_rule_t *rules, uint32_t count)
+{
+    TouCAN_RxFilterRule_t *list = NULL;
+    TouCAN_RxFilter_t filter = NULL;
+    int rc = CANERR_FATAL;              // return value
+
+    if (!init)                          // must be initialized
+        return CANERR_NOTINIT;
+    if (!IS_HANDLE_VALID(handle))       // must be a valid handle
+        return CANERR_HANDLE;
+    if (!can[handle].device.configured) // must be an opened handle
+        return CANERR_HANDLE;
+    if ((rules == NULL) && (count != 0U)) // check for null-pointer
+        return CANERR_NULLPTR;
+    if (!can[handle].status.can_stopped) // must be stopped
+        return CANERR_ONLINE;
+    if (count > TOUCAN_FILTER_MAX_RULES) // too many rules
+        return CANERR_ILLPARA;
+
+    // compile the filter rules (no rules: remove them)
+    if (count != 0U) {
+        if ((list = (TouCAN_RxFilterRule_t*)calloc(count, sizeof(TouCAN_RxFilterRule_t))) == NULL)
+            return CANERR_RESOURCE;
+        for (uint32_t i = 0U; i < count; i++) {
+            if (rules[i].xtd && (can[handle].device.opMode & CANMODE_NXTD)) {
+                free(list);             // no 29-bit identifiers
+                return CANERR_ILLPARA;
+            }
+            list[i].first = rules[i].first;
+            list[i].last = rules[i].last;
+            list[i].xtd = rules[i].xtd ? true : false;
+            list[i].dlc = rules[i].dlc;
+            memcpy(list[i].code, rules[i].code, sizeof(list[i].code));
+            memcpy(list[i].mask, rules[i].mask, sizeof(list[i].mask));
+        }
+        rc = TouCAN_CompileRxFilter(list, count, &filter);
+        free(list);
+        if (rc != CANUSB_SUCCESS)
+            return rc;
+    }
+    // replace the filter rules (applied in the reception callback)
+    if ((rc = TouCAN_SetRxFilter(&can[handle].device, filter)) != CANUSB_SUCCESS)
+        TouCAN_ReleaseRxFilter(filter);
+    return rc;
+}
+
+EXPORT
+int can_set_rx_callback(int handle, can_rx_callback_t callback, void *context)
+{
+    int rc = CANERR_FATAL;              // return value
+
+    if (!init)                          // must be initialized
+        return CANERR_NOTINIT;
+    if (!IS_HANDLE_VALID(handle))       // must be a valid handle
+        return CANERR_HANDLE;
+    if (!can[handle].device.configured) // must be an opened handle
+        return CANERR_HANDLE;
+    if (!can[handle].status.can_stopped) // must be stopped
+        return CANERR_ONLINE;
+
+    // deliver received messages by callback (or by the message queue if NULL)
+    if ((rc = TouCAN_SetRxCallback(&can[handle].device, callback ? receive_callback : NULL,
+                                   callback ? (void*)&can[handle] : NULL)) == CANUSB_SUCCESS) {
+        can[handle].rx_callback = callback;
+        can[handle].rx_context = context;
+    }
+    return rc;
+}
+
+EXPORT
+int can_read_latest(int handle, uint32_t id, int xtd, can_latest_t *latest)
+{
+    TouCAN_Snapshot_t snapshot = NULL;
+    TouCAN_SnapshotValue_t value;
+    int rc = CANERR_FATAL;              // return value
+
+    if (!init)                          // must be initialized
+        return CANERR_NOTINIT;
+    if (!IS_HANDLE_VALID(handle))       // must be a valid handle
+        return CANERR_HANDLE;
+    if (!can[handle].device.configured) // must be an opened handle
+        return CANERR_HANDLE;
+    if (latest == NULL)                 // check for null-pointer
+        return CANERR_NULLPTR;
+
+    // note: the table is not destroyed while it is in use
+    TouCAN_EnterTables(&can[handle].device);
+    if ((snapshot = __atomic_load_n(&can[handle].device.recvData.snapshot, __ATOMIC_ACQUIRE)) == NULL) {
+        rc = CANERR_NOTSUPP;            // snapshot table not enabled
+    }
+    // read the latest CAN message of the identifier (lock-free)
+    else if ((rc = TouCAN_SnapshotRead(snapshot, id, xtd ? true : false, &value)) == CANUSB_SUCCESS) {
+        latest->message = value.message;
+        latest->counter = value.counter;
+    }
+    TouCAN_LeaveTables(&can[handle].device);
+    return rc;
+}
+
+EXPORT
+int can_read_snapshot(int handle, can_latest_t *table, uint32_t max, uint32_t *count)
+{
+    TouCAN_Snapshot_t snapshot = NULL;
+    TouCAN_SnapshotValue_t *values = NULL;
+    int rc = CANERR_FATAL;              // return value
+
+    if (!init)                          // must be initialized
+        return CANERR_NOTINIT;
+    if (!IS_HANDLE_VALID(handle))       // must be a valid handle
+        return CANERR_HANDLE;
+    if (!can[handle].device.configured) // must be an opened handle
+        return CANERR_HANDLE;
+    if ((count == NULL) || ((table == NULL) && (max != 0U))) // check for null-pointer
+        return CANERR_NULLPTR;
+    if ((sizeof(can_latest_t) != sizeof(TouCAN_SnapshotValue_t)) && (max != 0U) &&
+        ((values = (TouCAN_SnapshotValue_t*)calloc(max, sizeof(TouCAN_SnapshotValue_t))) == NULL))
+        return CANERR_RESOURCE;
+
+    // note: the table is not destroyed while it is in use
+    TouCAN_EnterTables(&can[handle].device);
+    if ((snapshot = __atomic_load_n(&can[handle].device.recvData.snapshot, __ATOMIC_ACQUIRE)) == NULL) {
+        rc = CANERR_NOTSUPP;            // snapshot table not enabled
+    }
+    // copy all entries of the table (each of them consistent)
+    else if (sizeof(can_latest_t) == sizeof(TouCAN_SnapshotValue_t)) {
+        // note: same layout (a CAN message followed by a 64-bit counter)
+        rc = TouCAN_SnapshotReadAll(snapshot, (TouCAN_SnapshotValue_t*)table, max, count);
+    } else {
+        if ((rc = TouCAN_SnapshotReadAll(snapshot, values, max, count)) == CANUSB_SUCCESS) {
+            for (uint32_t i = 0U; i < *count; i++) {
+                table[i].message = values[i].message;
+                table[i].counter = values[i].counter;
+            }
+        }
+    }
+    TouCAN_LeaveTables(&can[handle].device);
+    free(values);
+    return rc;
+}
+
 EXPORT
 int can_read(int handle, can_message_t *message, uint16_t timeout)
 {
@@ -418,6 +771,187 @@ int can_read(int handle, can_message_t *message, uint16_t timeout)
     return rc;
 }
 
+EXPORT
+int can_read_tagged(int handle, can_message_t *message, uint16_t timeout, uint32_t *tag)
+{
+    int rc = CANERR_FATAL;              // return value
+
+    if (!init)                          // must be initialized
+        return CANERR_NOTINIT;
+    if (!IS_HANDLE_VALID(handle))       // must be a valid handle
+        return CANERR_HANDLE;
+    if (!can[handle].device.configured) // must be an opened handle
+        return CANERR_HANDLE;
+    if ((message == NULL) || (tag == NULL)) // check for null-pointer
+        return CANERR_NULLPTR;
+    if (can[handle].status.can_stopped) // must be running
+        return CANERR_OFFLINE;
+
+    // read one CAN message from the message queue, if any (TX echo with sequence tag)
+    rc = TouCAN_ReadMessageTagged(&can[handle].device, message, tag, timeout);
+    can[handle].status.receiver_empty = (rc != CANUSB_SUCCESS) ? 1 : 0;
+    can[handle].status.queue_overrun = CANQUE_OverflowFlag(can[handle].device.recvData.msgQueue) ? 1 : 0;
+    can[handle].counters.rx += ((rc == CANUSB_SUCCESS) && !message->sts && !*tag) ? 1U : 0U;
+    can[handle].counters.err += ((rc == CANUSB_SUCCESS) && message->sts) ? 1U : 0U;
+    return rc;
+}
+
+EXPORT
+int can_read_us(int handle, can_message_t *message, uint32_t timeout)
+{
+    int rc = CANERR_FATAL;              // return value
+
+    if (!init)                          // must be initialized
+        return CANERR_NOTINIT;
+    if (!IS_HANDLE_VALID(handle))       // must be a valid handle
+        return CANERR_HANDLE;
+    if (!can[handle].device.configured) // must be an opened handle
+        return CANERR_HANDLE;
+    if (message == NULL)                // check for null-pointer
+        return CANERR_NULLPTR;
+    if (can[handle].status.can_stopped) // must be running
+        return CANERR_OFFLINE;
+
+    // read one CAN message from the message queue, if any (time-out in [usec])
+    rc = TouCAN_ReadMessageUs(&can[handle].device, message, timeout);
+    can[handle].status.receiver_empty = (rc != CANUSB_SUCCESS) ? 1 : 0;
+    can[handle].status.queue_overrun = CANQUE_OverflowFlag(can[handle].device.recvData.msgQueue) ? 1 : 0;
+    can[handle].counters.rx += ((rc == CANUSB_SUCCESS) && !message->sts) ? 1U : 0U;
+    can[handle].counters.err += ((rc == CANUSB_SUCCESS) && message->sts) ? 1U : 0U;
+    return rc;
+}
+
+EXPORT
+int can_read_multi(int handle, can_message_t *messages, uint32_t max, uint32_t *count, uint16_t timeout)
+{
+    int rc = CANERR_FATAL;              // return value
+    uint32_t n = 0U;                    // number of messages
+    uint32_t i;
+
+    if (count)
+        *count = 0U;
+    if (!init)                          // must be initialized
+        return CANERR_NOTINIT;
+    if (!IS_HANDLE_VALID(handle))       // must be a valid handle
+        return CANERR_HANDLE;
+    if (!can[handle].device.configured) // must be an opened handle
+        return CANERR_HANDLE;
+    if ((messages == NULL) || (count == NULL)) // check for null-pointer
+        return CANERR_NULLPTR;
+    if (max == 0U)                      // at least one message buffer
+        return CANERR_ILLPARA;
+    if (can[handle].status.can_stopped) // must be running
+        return CANERR_OFFLINE;
+
+    // read up to 'max' CAN messages from the message queue, if any
+    rc = TouCAN_ReadMessages(&can[handle].device, messages, max, &n, timeout);
+    can[handle].status.receiver_empty = (rc != CANUSB_SUCCESS) ? 1 : 0;
+    can[handle].status.queue_overrun = CANQUE_OverflowFlag(can[handle].device.recvData.msgQueue) ? 1 : 0;
+    if (rc == CANUSB_SUCCESS) {
+        for (i = 0U; i < n; i++) {
+            can[handle].counters.rx += !messages[i].sts ? 1U : 0U;
+            can[handle].counters.err += messages[i].sts ? 1U : 0U;
+        }
+        *count = n;
+    }
+    return rc;
+}
+
+EXPORT
+int can_read_peek(int handle, const can_message_t **messages, uint32_t *count, uint16_t timeout)
+{
+    int rc = CANERR_FATAL;              // return value
+    uint32_t n = 0U;                    // number of messages
+
+    if (messages)
+        *messages = NULL;
+    if (count)
+        *count = 0U;
+    if (!init)                          // must be initialized
+        return CANERR_NOTINIT;
+    if (!IS_HANDLE_VALID(handle))       // must be a valid handle
+        return CANERR_HANDLE;
+    if (!can[handle].device.configured) // must be an opened handle
+        return CANERR_HANDLE;
+    if ((messages == NULL) || (count == NULL)) // check for null-pointer
+        return CANERR_NULLPTR;
+    if (can[handle].status.can_stopped) // must be running
+        return CANERR_OFFLINE;
+
+    // borrow the CAN messages in the message queue, if any
+    rc = TouCAN_PeekMessages(&can[handle].device, messages, &n, timeout);
+    can[handle].status.receiver_empty = (rc != CANUSB_SUCCESS) ? 1 : 0;
+    can[handle].status.queue_overrun = CANQUE_OverflowFlag(can[handle].device.recvData.msgQueue) ? 1 : 0;
+    if (rc == CANUSB_SUCCESS) {
+        can[handle].view.messages = *messages;
+        can[handle].view.count = n;
+        *count = n;
+    } else {
+        *messages = NULL;
+        can[handle].view.messages = NULL;
+        can[handle].view.count = 0U;
+    }
+    return rc;
+}
+
+EXPORT
+int can_read_commit(int handle, uint32_t count)
+{
+    int rc = CANERR_FATAL;              // return value
+    uint32_t i;
+
+    if (!init)                          // must be initialized
+        return CANERR_NOTINIT;
+    if (!IS_HANDLE_VALID(handle))       // must be a valid handle
+        return CANERR_HANDLE;
+    if (!can[handle].device.configured) // must be an opened handle
+        return CANERR_HANDLE;
+    if (count > can[handle].view.count) // not more than borrowed
+        return CANERR_ILLPARA;
+
+    // note: the counters are updated for the released messages only
+    for (i = 0U; i < count; i++) {
+        can[handle].counters.rx += !can[handle].view.messages[i].sts ? 1U : 0U;
+        can[handle].counters.err += can[handle].view.messages[i].sts ? 1U : 0U;
+    }
+    // release the borrowed CAN messages to the message queue
+    rc = TouCAN_CommitMessages(&can[handle].device, count);
+    can[handle].view.messages = NULL;
+    can[handle].view.count = 0U;
+    return rc;
+}
+
+EXPORT
+int can_select(const int *handles, uint32_t count, uint16_t timeout, uint32_t *ready)
+{
+    CANQUE_MsgQueue_t queues[CAN_MAX_HANDLES];
+    int rc = CANERR_FATAL;              // return value
+    uint32_t i;
+
+    if (ready)
+        *ready = 0U;
+    if (!init)                          // must be initialized
+        return CANERR_NOTINIT;
+    if ((handles == NULL) || (ready == NULL)) // check for null-pointer
+        return CANERR_NULLPTR;
+    if ((count == 0U) || (count > CAN_MAX_HANDLES)) // 1 to CAN_MAX_HANDLES
+        return CANERR_ILLPARA;
+    for (i = 0U; i < count; i++) {
+        if (!IS_HANDLE_VALID(handles[i]))  // must be a valid handle
+            return CANERR_HANDLE;
+        if (!can[handles[i]].device.configured) // must be an opened handle
+            return CANERR_HANDLE;
+        if (can[handles[i]].status.can_stopped) // must be running
+            return CANERR_OFFLINE;
+        queues[i] = can[handles[i]].device.recvData.msgQueue;
+    }
+    // wait until at least one message queue is not empty
+    rc = CANQUE_Select(queues, count, timeout, ready);
+    for (i = 0U; i < count; i++)
+        can[handles[i]].status.receiver_empty = (*ready & ((uint32_t)1U << i)) ? 0 : 1;
+    return rc;
+}
+
 EXPORT
 int can_status(int handle, uint8_t *status)
 {
@@ -449,7 +983,7 @@ int can_busload(int handle, uint8_t *load, uint8_t *status)
 {
     int rc = CANERR_FATAL;              // return value
 
-    uint8_t busLoad = 0U;
+    uint16_t busLoad = 0U;
 
     if (!init)                          // must be initialized
         return CANERR_NOTINIT;
@@ -458,18 +992,14 @@ int can_busload(int handle, uint8_t *load, uint8_t *status)
     if (!can[handle].device.configured) // must be an opened handle
         return CANERR_HANDLE;
 
-#if (0)
-    // get bus load from device (0..10000 ==> 0%..100%)
+    // get bus load (0..10000 ==> 0%..100%)
+    // note: calculated from the received and transmitted CAN frames
     if ((rc = TouCAN_GetBusLoad(&can[handle].device, &busLoad)) == CANUSB_SUCCESS) {
         // get status-register from device
         rc = can_status(handle, status);
     }
     else
         busLoad = 0U;
-    // TODO: realize bus-load measurement
-#else
-    rc = can_status(handle, status);
-#endif
     if (load)
         *load = (uint8_t)((busLoad + 50U) / 100U);
     return rc;
@@ -738,6 +1268,10 @@ static int lib_parameter(uint16_t param, void *value, size_t nbyte)
     case CANPROP_GET_RCV_QUEUE_SIZE:    // maximum number of message the receive queue can hold (uint32_t)
     case CANPROP_GET_RCV_QUEUE_HIGH:    // maximum number of message the receive queue has hold (uint32_t)
     case CANPROP_GET_RCV_QUEUE_OVFL:    // overflow counter of the receive queue (uint64_t)
+    case CANPROP_GET_FLT_11BIT_CODE:    // acceptance filter code of 11-bit identifier (int32_t)
+    case CANPROP_GET_FLT_11BIT_MASK:    // acceptance filter mask of 11-bit identifier (int32_t)
+    case CANPROP_GET_FLT_29BIT_CODE:    // acceptance filter code of 29-bit identifier (int32_t)
+    case CANPROP_GET_FLT_29BIT_MASK:    // acceptance filter mask of 29-bit identifier (int32_t)
         // note: a device parameter requires a valid handle.
         if (!init)
             rc = CANERR_NOTINIT;
@@ -757,7 +1291,8 @@ static int drv_parameter(int handle, uint16_t param, void *value, size_t nbyte)
     can_bitrate_t bitrate;
     can_speed_t speed;
     uint8_t status;
-    uint8_t load;
+    uint16_t busLoad;
+    CANQUE_Policy_t policy;
 
     assert(IS_HANDLE_VALID(handle));    // just to make sure
 
@@ -830,11 +1365,11 @@ static int drv_parameter(int handle, uint16_t param, void *value, size_t nbyte)
         break;
     case CANPROP_GET_BUSLOAD:           // current bus load of the CAN controller (uint8_t)
         if (nbyte >= sizeof(uint8_t)) {
-            if ((rc = can_busload(handle, &load, NULL)) == CANERR_NOERROR) {  // FIXME: legacy resolution
+            if ((rc = TouCAN_GetBusLoad(&can[handle].device, &busLoad)) == CANUSB_SUCCESS) {
                 if (nbyte >= sizeof(uint16_t))
-                    *(uint16_t*)value = (uint16_t)load * 100U;  // 0 - 10000 ==> 0.00% - 100.00%
+                    *(uint16_t*)value = (uint16_t)busLoad;  // 0 - 10000 ==> 0.00% - 100.00%
                 else
-                    *(uint8_t*)value = (uint8_t)load;           // 0  -  100 ==> 0.00% - 100.00%
+                    *(uint8_t*)value = (uint8_t)((busLoad + 50U) / 100U);  // 0  -  100 ==> 0.00% - 100.00%
                 rc = CANERR_NOERROR;
             }
         }
@@ -859,7 +1394,8 @@ static int drv_parameter(int handle, uint16_t param, void *value, size_t nbyte)
         break;
     case CANPROP_GET_TX_COUNTER:        // total number of sent messages (uint64_t)
         if (nbyte >= sizeof(uint64_t)) {
-            *(uint64_t*)value = (uint64_t)can[handle].counters.tx;
+            *(uint64_t*)value = (uint64_t)can[handle].counters.tx
+                              + (uint64_t)__atomic_load_n(&can[handle].counters.cyclic, __ATOMIC_RELAXED);
             rc = CANERR_NOERROR;
         }
         break;
@@ -893,6 +1429,17 @@ static int drv_parameter(int handle, uint16_t param, void *value, size_t nbyte)
             rc = CANERR_NOERROR;
         }
         break;
+    case CANPROP_GET_FLT_11BIT_CODE:    // acceptance filter code of 11-bit identifier (int32_t)
+    case CANPROP_GET_FLT_11BIT_MASK:    // acceptance filter mask of 11-bit identifier (int32_t)
+    case CANPROP_GET_FLT_29BIT_CODE:    // acceptance filter code of 29-bit identifier (int32_t)
+    case CANPROP_GET_FLT_29BIT_MASK:    // acceptance filter mask of 29-bit identifier (int32_t)
+        if (nbyte >= sizeof(int32_t)) {
+            uint32_t code = 0U, mask = 0U;
+            bool xtd = ((param == CANPROP_GET_FLT_29BIT_CODE) || (param == CANPROP_GET_FLT_29BIT_MASK)) ? true : false;
+            if ((rc = TouCAN_GetFilter(&can[handle].device, xtd, &code, &mask)) == CANUSB_SUCCESS)
+                *(int32_t*)value = (int32_t)(((param == CANPROP_GET_FLT_11BIT_CODE) || (param == CANPROP_GET_FLT_29BIT_CODE)) ? code : mask);
+        }
+        break;
     /* TouCAN specific properties */
     case TOUCAN_GET_HARDWARE_VERSION:   // TouCAN USB: hardware version as "0xggrrss00" (uint32_t)
         if ((size_t)nbyte >= sizeof(uint32_t)) {
@@ -936,6 +1483,237 @@ static int drv_parameter(int handle, uint16_t param, void *value, size_t nbyte)
                 rc = CANERR_NOERROR;
             }
         break;
+    case TOUCAN_GET_RCV_XFER_COUNTER:   // TouCAN USB: number of received USB transfers (uint64_t)
+        if ((size_t)nbyte >= sizeof(uint64_t)) {
+            *(uint64_t*)value = (uint64_t)can[handle].device.recvData.xferCounter;
+            rc = CANERR_NOERROR;
+        }
+        break;
+    case TOUCAN_GET_RCV_WAKEUP_COUNTER: // TouCAN USB: number of wake-ups of the reader (uint64_t)
+        if ((size_t)nbyte >= sizeof(uint64_t)) {
+            *(uint64_t*)value = (uint64_t)CANQUE_WakeupCounter(can[handle].device.recvData.msgQueue);
+            rc = CANERR_NOERROR;
+        }
+        break;
+    case TOUCAN_GET_RCV_QUEUE_POLICY:   // TouCAN USB: overflow policy of the receive queue (uint8_t)
+        if ((size_t)nbyte >= sizeof(uint8_t)) {
+            if ((rc = CANQUE_GetOverflowPolicy(can[handle].device.recvData.msgQueue, &policy, NULL)) == CANUSB_SUCCESS)
+                *(uint8_t*)value = (uint8_t)policy;
+        }
+        break;
+    case TOUCAN_GET_RCV_QUEUE_WATERMARK: // TouCAN USB: watermarks of the receive queue (toucan_watermark_t)
+        if ((size_t)nbyte >= sizeof(toucan_watermark_t)) {
+            memcpy(value, &can[handle].watermark, sizeof(toucan_watermark_t));
+            rc = CANERR_NOERROR;
+        }
+        break;
+    case TOUCAN_GET_RCV_EVENT_FD:       // TouCAN USB: pollable file descriptor of the receive queue (int)
+        if ((size_t)nbyte >= sizeof(int)) {
+            // note: the descriptor is readable as long as the receive queue is not empty
+            rc = CANQUE_GetEventFd(can[handle].device.recvData.msgQueue, (int*)value);
+        }
+        break;
+    case TOUCAN_GET_TX_QUEUE_ORDER:     // TouCAN USB: order of the transmit queue (uint8_t)
+        if ((size_t)nbyte >= sizeof(uint8_t)) {
+            *(uint8_t*)value = can[handle].device.sendData.prioMode ? TOUCAN_TX_ORDER_PRIORITY : TOUCAN_TX_ORDER_FIFO;
+            rc = CANERR_NOERROR;
+        }
+        break;
+    case TOUCAN_GET_TX_ECHO:            // TouCAN USB: echo of transmitted CAN messages (uint8_t)
+        if ((size_t)nbyte >= sizeof(uint8_t)) {
+            *(uint8_t*)value = can[handle].device.recvData.msgParam.txEcho ? 1U : 0U;
+            rc = CANERR_NOERROR;
+        }
+        break;
+    case TOUCAN_GET_TX_ECHO_COUNTER:    // TouCAN USB: number of received TX echoes (uint64_t)
+        if ((size_t)nbyte >= sizeof(uint64_t)) {
+            *(uint64_t*)value = (uint64_t)can[handle].device.recvData.echoCounter;
+            rc = CANERR_NOERROR;
+        }
+        break;
+    case TOUCAN_GET_FILTER_DEVICE:      // TouCAN USB: acceptance filters applied by the device (uint8_t)
+        if ((size_t)nbyte >= sizeof(uint8_t)) {
+            *(uint8_t*)value = can[handle].device.deviceFilter ? 1U : 0U;
+            rc = CANERR_NOERROR;
+        }
+        break;
+    case TOUCAN_GET_FILTER_REJECTED:    // TouCAN USB: number of CAN messages rejected by the filters (uint64_t)
+        if ((size_t)nbyte >= sizeof(uint64_t)) {
+            *(uint64_t*)value = (uint64_t)can[handle].device.recvData.fltCounter;
+            rc = CANERR_NOERROR;
+        }
+        break;
+    case TOUCAN_GET_SNAPSHOT:           // TouCAN USB: table of the latest CAN message per identifier (toucan_snapshot_t)
+        if ((size_t)nbyte >= sizeof(toucan_snapshot_t)) {
+            toucan_snapshot_t *table = (toucan_snapshot_t*)value;
+            TouCAN_EnterTables(&can[handle].device);
+            TouCAN_Snapshot_t snapshot = __atomic_load_n(&can[handle].device.recvData.snapshot, __ATOMIC_ACQUIRE);
+            table->enabled = snapshot ? 1U : 0U;
+            table->xtd_ids = snapshot ? (TouCAN_SnapshotCapacity(snapshot) - TOUCAN_SNAPSHOT_STD_IDS) : 0U;
+            table->dropped = TouCAN_SnapshotDropped(snapshot);
+            TouCAN_LeaveTables(&can[handle].device);
+            rc = CANERR_NOERROR;
+        }
+        break;
+    case TOUCAN_GET_STS_REFRESH_COUNTER: // TouCAN USB: number of reads of the interface error code (uint64_t)
+        if ((size_t)nbyte >= sizeof(uint64_t)) {
+            *(uint64_t*)value = (uint64_t)can[handle].device.sendData.stsCounter;
+            rc = CANERR_NOERROR;
+        }
+        break;
+    case TOUCAN_GET_ID_STATS:           // TouCAN USB: traffic statistics per identifier (toucan_id_stats_setup_t)
+        if ((size_t)nbyte >= sizeof(toucan_id_stats_setup_t)) {
+            toucan_id_stats_setup_t *setup = (toucan_id_stats_setup_t*)value;
+            TouCAN_EnterTables(&can[handle].device);
+            TouCAN_IdStats_t stats = __atomic_load_n(&can[handle].device.recvData.idStats, __ATOMIC_ACQUIRE);
+            setup->enabled = stats ? 1U : 0U;
+            setup->xtd_ids = stats ? (TouCAN_IdStatsCapacity(stats) - (CAN_MAX_STD_ID + 1U)) : 0U;
+            setup->identifiers = TouCAN_IdStatsIdentifiers(stats);
+            setup->dropped = TouCAN_IdStatsDropped(stats);
+            TouCAN_LeaveTables(&can[handle].device);
+            rc = CANERR_NOERROR;
+        }
+        break;
+    case TOUCAN_GET_ID_STATS_LIST:      // TouCAN USB: snapshot of the traffic statistics (toucan_id_stats_list_t)
+        if ((size_t)nbyte >= sizeof(toucan_id_stats_list_t)) {
+            toucan_id_stats_list_t *list = (toucan_id_stats_list_t*)value;
+            if (!list->entries && list->max)
+                return CANERR_NULLPTR;
+            TouCAN_EnterTables(&can[handle].device);
+            TouCAN_IdStats_t stats = __atomic_load_n(&can[handle].device.recvData.idStats, __ATOMIC_ACQUIRE);
+            rc = stats ? id_stats_list(stats, list) : CANERR_NOTSUPP;
+            TouCAN_LeaveTables(&can[handle].device);
+        }
+        break;
+    case TOUCAN_GET_RCV_PIPE_STATS:     // TouCAN USB: statistics of the USB reception pipeline (toucan_pipe_stats_t)
+        if ((size_t)nbyte >= sizeof(toucan_pipe_stats_t)) {
+            toucan_pipe_stats_t *stats = (toucan_pipe_stats_t*)value;
+            CANUSB_PipeStats_t pipe;
+            if ((rc = CANUSB_GetPipeAsyncStats(can[handle].device.recvPipe, &pipe)) == CANUSB_SUCCESS) {
+                stats->depth = (uint32_t)pipe.depth;
+                stats->xfer_size = (uint32_t)pipe.size;
+                stats->transfers = (uint64_t)pipe.transfers;
+                stats->dry_runs = (uint64_t)pipe.dryRuns;
+                stats->errors = (uint64_t)pipe.errors;
+            }
+        }
+        break;
+    case TOUCAN_GET_CLOCK_SYNC:         // TouCAN USB: quality of the time synchronization (toucan_clock_sync_t)
+        if ((size_t)nbyte >= sizeof(toucan_clock_sync_t)) {
+            toucan_clock_sync_t *sync = (toucan_clock_sync_t*)value;
+            TouCAN_SyncQuality_t quality;
+            TouCAN_ClockSyncQuality(&can[handle].device.recvData.msgParam.clockSync, &quality);
+            sync->samples = quality.samples;
+            sync->span = quality.span;
+            sync->drift = quality.drift;
+            sync->residual = quality.residual;
+            sync->resyncs = quality.resyncs;
+            rc = CANERR_NOERROR;
+        }
+        break;
+    case TOUCAN_GET_TX_SCHEDULE_ENTRIES: // TouCAN USB: number of cyclic CAN messages (uint32_t)
+        if ((size_t)nbyte >= sizeof(uint32_t)) {
+            *(uint32_t*)value = TouCAN_ScheduleEntries(can[handle].scheduler);
+            rc = CANERR_NOERROR;
+        }
+        break;
+    case TOUCAN_GET_TX_SCHEDULE_STATS:  // TouCAN USB: statistics of a cyclic CAN message (toucan_schedule_stats_t)
+        if ((size_t)nbyte >= sizeof(toucan_schedule_stats_t)) {
+            // note: the entry is given by the caller in the property value
+            toucan_schedule_stats_t *stats = (toucan_schedule_stats_t*)value;
+            TouCAN_ScheduleStats_t entryStats;
+            if (can[handle].scheduler == NULL)
+                return CANERR_ILLPARA;
+            if ((rc = TouCAN_ScheduleStatistics(can[handle].scheduler, (int32_t)stats->entry, &entryStats)) == CANUSB_SUCCESS) {
+                stats->sent = entryStats.sent;
+                stats->missed = entryStats.missed;
+                stats->jitter_min = entryStats.jitterMin;
+                stats->jitter_max = entryStats.jitterMax;
+                stats->jitter_avg = entryStats.jitterAvg;
+            }
+        }
+        break;
+    case TOUCAN_SET_RCV_QUEUE_POLICY:   // TouCAN USB: overflow policy of the receive queue (uint8_t)
+        if ((size_t)nbyte >= sizeof(uint8_t)) {
+            // note: the policy can only be changed when the CAN controller is stopped
+            if (!can[handle].status.can_stopped)
+                return CANERR_ONLINE;
+            // note: the receive queue is fed from the USB completion context, which must never block
+            if (*(uint8_t*)value > TOUCAN_QUEUE_DROP_OLDEST)
+                return CANERR_ILLPARA;
+            rc = CANQUE_SetOverflowPolicy(can[handle].device.recvData.msgQueue, (CANQUE_Policy_t)*(uint8_t*)value, 0U);
+        }
+        break;
+    case TOUCAN_SET_RCV_QUEUE_WATERMARK: // TouCAN USB: watermarks of the receive queue (toucan_watermark_t)
+        if ((size_t)nbyte >= sizeof(toucan_watermark_t)) {
+            // note: the watermarks can only be changed when the CAN controller is stopped
+            if (!can[handle].status.can_stopped)
+                return CANERR_ONLINE;
+            const toucan_watermark_t *watermark = (const toucan_watermark_t*)value;
+            if ((rc = CANQUE_SetWatermarks(can[handle].device.recvData.msgQueue, watermark->high, watermark->low,
+                                           watermark->callback ? watermark_callback : NULL,
+                                           (void*)&can[handle])) == CANUSB_SUCCESS) {
+                memcpy(&can[handle].watermark, watermark, sizeof(toucan_watermark_t));
+            }
+        }
+        break;
+    case TOUCAN_SET_TX_QUEUE_ORDER:     // TouCAN USB: order of the transmit queue (uint8_t)
+        if ((size_t)nbyte >= sizeof(uint8_t)) {
+            // note: the order can only be changed when the CAN controller is stopped
+            //       (the device is initialized with the matching FIFO mode on start)
+            if (!can[handle].status.can_stopped)
+                return CANERR_ONLINE;
+            if (*(uint8_t*)value > TOUCAN_TX_ORDER_PRIORITY)
+                return CANERR_ILLPARA;
+            can[handle].device.sendData.prioMode = (*(uint8_t*)value == TOUCAN_TX_ORDER_PRIORITY) ? true : false;
+            rc = CANERR_NOERROR;
+        }
+        break;
+    case TOUCAN_SET_TX_ECHO:            // TouCAN USB: echo of transmitted CAN messages (uint8_t)
+        if ((size_t)nbyte >= sizeof(uint8_t)) {
+            // note: the echo can only be switched on or off when the CAN controller is stopped
+            if (!can[handle].status.can_stopped)
+                return CANERR_ONLINE;
+            if (*(uint8_t*)value > 1U)
+                return CANERR_ILLPARA;
+            can[handle].device.recvData.msgParam.txEcho = (*(uint8_t*)value) ? true : false;
+            rc = CANERR_NOERROR;
+        }
+        break;
+    case TOUCAN_SET_ID_STATS:           // TouCAN USB: traffic statistics per identifier (toucan_id_stats_setup_t)
+        if ((size_t)nbyte >= sizeof(toucan_id_stats_setup_t)) {
+            toucan_id_stats_setup_t *setup = (toucan_id_stats_setup_t*)value;
+            TouCAN_IdStats_t stats = NULL;
+            // note: the statistics can only be enabled or disabled when the CAN controller is stopped
+            if (!can[handle].status.can_stopped)
+                return CANERR_ONLINE;
+            if ((setup->enabled > 1U) || (setup->xtd_ids > TOUCAN_ID_STATS_XTD_IDS))
+                return CANERR_ILLPARA;
+            if ((setup->xtd_ids != 0U) && (can[handle].device.opMode & CANMODE_NXTD))
+                return CANERR_ILLPARA;
+            if (setup->enabled && ((rc = TouCAN_CreateIdStats(setup->xtd_ids, &stats)) != CANUSB_SUCCESS))
+                return rc;
+            if ((rc = TouCAN_SetIdStats(&can[handle].device, stats)) != CANUSB_SUCCESS)
+                TouCAN_DestroyIdStats(stats);
+        }
+        break;
+    case TOUCAN_SET_SNAPSHOT:           // TouCAN USB: table of the latest CAN message per identifier (toucan_snapshot_t)
+        if ((size_t)nbyte >= sizeof(toucan_snapshot_t)) {
+            toucan_snapshot_t *table = (toucan_snapshot_t*)value;
+            TouCAN_Snapshot_t snapshot = NULL;
+            // note: the table can only be enabled or disabled when the CAN controller is stopped
+            if (!can[handle].status.can_stopped)
+                return CANERR_ONLINE;
+            if ((table->enabled > 1U) || (table->xtd_ids > TOUCAN_SNAPSHOT_XTD_IDS))
+                return CANERR_ILLPARA;
+            if ((table->xtd_ids != 0U) && (can[handle].device.opMode & CANMODE_NXTD))
+                return CANERR_ILLPARA;
+            if (table->enabled && ((rc = TouCAN_CreateSnapshot(table->xtd_ids, &snapshot)) != CANUSB_SUCCESS))
+                return rc;
+            if ((rc = TouCAN_SetSnapshot(&can[handle].device, snapshot)) != CANUSB_SUCCESS)
+                TouCAN_DestroySnapshot(snapshot);
+        }
+        break;
     default:
 //        if ((CANPROP_GET_VENDOR_PROP <= param) &&  // get a vendor-specific property value (void*)
 //           (param < (CANPROP_GET_VENDOR_PROP + CANPROP_VENDOR_PROP_RANGE))) {
@@ -960,6 +1738,122 @@ static int drv_parameter(int handle, uint16_t param, void *value, size_t nbyte)
     return rc;
 }
 
+static int check_message(int handle, const can_message_t *message)
+{
+    if (message->id > (uint32_t)(message->xtd ? CAN_MAX_XTD_ID : CAN_MAX_STD_ID))
+        return CANERR_ILLPARA;          // invalid identifier
+    if (message->xtd && can[handle].mode.nxtd)
+        return CANERR_ILLPARA;          // suppress extended frames
+    if (message->rtr && can[handle].mode.nrtr)
+        return CANERR_ILLPARA;          // suppress remote frames
+#if (OPTION_CAN_2_0_ONLY == 0)
+    if (message->fdf && !can[handle].mode.fdoe)
+        return CANERR_ILLPARA;          // long frames only with CAN FD
+    if (message->brs && !can[handle].mode.brse)
+        return CANERR_ILLPARA;          // fast frames only with CAN FD
+    if (message->brs && !message->fdf)
+        return CANERR_ILLPARA;          // bit-rate switching only with CAN FD
+#endif
+    if (message->sts)
+        return CANERR_ILLPARA;          // error frames cannot be sent
+
+    if (message->dlc > CAN_MAX_LEN)     //   data length 0 .. 8!
+        return CANERR_ILLPARA;
+    return CANERR_NOERROR;
+}
+
+static CANUSB_Return_t schedule_callback(void *context, const can_message_t *messages, uint32_t count, uint32_t *written)
+{
+    can_interface_t *interface = (can_interface_t*)context;
+    CANUSB_Return_t rc;
+
+    assert(interface);
+    assert(written);
+
+    // note: cyclic messages are only sent when the CAN controller is running
+    if (interface->status.can_stopped)
+        return CANERR_OFFLINE;
+    // note: the scheduler thread must not wait for room in the transmit queue
+    rc = TouCAN_WriteMessages(&interface->device, messages, count, written, 0U);
+    // note: the scheduler thread has its own counter (can_write updates counters.tx)
+    (void)__atomic_add_fetch(&interface->counters.cyclic, (uint64_t)*written, __ATOMIC_RELAXED);
+    return rc;
+}
+
+static void schedule_release(int handle)
+{
+    if (can[handle].scheduler != NULL) {
+        (void)TouCAN_DestroyScheduler(can[handle].scheduler);
+        can[handle].scheduler = NULL;
+    }
+}
+
+static void watermark_callback(void *context, UInt8 event, UInt32 level)
+{
+    can_interface_t *interface = (can_interface_t*)context;
+
+    assert(interface);                  // just to make sure
+
+    // note: the handle is the index of the interface descriptor
+    if (interface->watermark.callback)
+        interface->watermark.callback((int)(interface - can), (uint8_t)event, (uint32_t)level,
+                                      interface->watermark.context);
+}
+
+static void receive_callback(void *context, const can_message_t *messages, uint32_t count)
+{
+    can_interface_t *interface = (can_interface_t*)context;
+
+    assert(interface);                  // just to make sure
+    assert(messages);
+
+    // note: the receive callback is called in the USB completion context
+    for (uint32_t i = 0U; i < count; i++) {
+        interface->counters.rx += !messages[i].sts ? 1U : 0U;
+        interface->counters.err += messages[i].sts ? 1U : 0U;
+    }
+    if (interface->rx_callback)
+        interface->rx_callback((int)(interface - can), messages, count, interface->rx_context);
+}
+
+#define ID_STATS_USEC(ns)  (((ns) / 1000U) < UINT32_MAX ? (uint32_t)((ns) / 1000U) : UINT32_MAX)
+
+static int id_stats_list(TouCAN_IdStats_t stats, toucan_id_stats_list_t *list)
+{
+    TouCAN_IdStatsValue_t *values = NULL;
+    uint64_t span;
+    double rate;
+    int rc;
+
+    assert(stats);                      // just to make sure
+    assert(list);
+
+    // copy the entries of the statistics table (each of them consistent)
+    if ((list->max != 0U) && ((values = (TouCAN_IdStatsValue_t*)calloc(list->max, sizeof(TouCAN_IdStatsValue_t))) == NULL))
+        return CANERR_RESOURCE;
+    if ((rc = TouCAN_IdStatsReadAll(stats, values, list->max, &list->count)) != CANUSB_SUCCESS) {
+        free(values);
+        return rc;
+    }
+    // convert them into the exported units (rate in [mHz], times in [usec])
+    for (uint32_t i = 0U; i < list->count; i++) {
+        toucan_id_stats_t *entry = &list->entries[i];
+        entry->id = values[i].id;
+        entry->xtd = values[i].xtd ? 1U : 0U;
+        entry->dlc = values[i].dlc;
+        entry->frames = values[i].frames;
+        entry->dlc_changes = values[i].dlcChanges;
+        span = values[i].last - values[i].first;
+        rate = ((values[i].frames > 1U) && span) ? ((double)(values[i].frames - 1U) * 1.0e12) / (double)span : 0.0;
+        entry->rate = (rate < (double)UINT32_MAX) ? (uint32_t)(rate + 0.5) : UINT32_MAX;
+        entry->gap_min = ID_STATS_USEC(values[i].gapMin);
+        entry->gap_max = ID_STATS_USEC(values[i].gapMax);
+        entry->gap_avg = ID_STATS_USEC(values[i].gapMean);
+        entry->jitter = ID_STATS_USEC(values[i].jitter);
+    }
+    free(values);
+    return CANERR_NOERROR;
+}
 
 /*  -----------  revision control  ---------------------------------------
  */
@@ -0,0 +1,583 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later */
+/*
+ *  CAN Interface API, Version 3 (for Rusoku TouCAN Interface)
+ *
+ *  Copyright (C) 2020-2022  Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+ *
+ *  This file is part of MacCAN-TouCAN.
+ *
+ *  MacCAN-TouCAN is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  MacCAN-TouCAN is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with MacCAN-TouCAN.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/** @addtogroup  can_api
+ *  @{
+ */
+#ifndef CAN_EXT_H_INCLUDED
+#define CAN_EXT_H_INCLUDED
+
+/*  -----------  includes  ------------------------------------------------
+ */
+
+#include "can_api.h"                    /* CAN API V3 functions and types */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*  -----------  prototypes  ---------------------------------------------
+ */
+
+/** @brief       read one message from the message queue of the CAN interface,
+ *               if any message was received. The CAN controller must be in
+ *               operation state 'running'.
+ *
+ *  @note        Same as can_read, but with a time-out in microseconds. The
+ *               deadline is taken from the monotonic clock.
+ *
+ *  @param[in]   handle  - handle of the CAN interface
+ *  @param[out]  message - the message read from the message queue, if any
+ *  @param[in]   timeout - time to wait for the reception of a message:
+ *                              0 means the function returns immediately,
+ *                              TOUCAN_READ_INFINITE_USEC means blocking read,
+ *                              and any other value means the time to wait
+ *                              in microseconds
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      CANERR_NOTINIT   - library not initialized
+ *  @retval      CANERR_HANDLE    - invalid interface handle
+ *  @retval      CANERR_NULLPTR   - null-pointer assignment
+ *  @retval      CANERR_OFFLINE   - interface not started
+ *  @retval      CANERR_RX_EMPTY  - message queue empty
+ *  @retval      others           - vendor-specific
+ */
+CANAPI int can_read_us(int handle, can_message_t *message, uint32_t timeout);
+
+
+/** @brief       transmits a message over the CAN bus and returns its sequence
+ *               tag. The CAN controller must be in operation state 'running'.
+ *
+ *  @note        When the TX echo is switched on (property TOUCAN_SET_TX_ECHO),
+ *               the transmitted message comes back through the message queue
+ *               of the CAN interface with the same sequence tag and with its
+ *               OUT-completion time as time-stamp (cf. can_read_tagged). Only
+ *               can_read_tagged returns TX echoes, the other read functions
+ *               drop them (a CAN message has no flag for an echo).
+ *
+ *  @param[in]   handle  - handle of the CAN interface
+ *  @param[in]   message - pointer to the message to send
+ *  @param[in]   timeout - time to wait for the transmission of a message:
+ *                              0 means the function returns immediately,
+ *                              65535 means blocking write, and any other
+ *                              value means the time to wait in milliseconds
+ *  @param[out]  tag     - sequence tag of the message (never 0)
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      CANERR_NOTINIT   - library not initialized
+ *  @retval      CANERR_HANDLE    - invalid interface handle
+ *  @retval      CANERR_NULLPTR   - null-pointer assignment
+ *  @retval      CANERR_ILLPARA   - illegal data length code
+ *  @retval      CANERR_OFFLINE   - interface not started
+ *  @retval      CANERR_TX_BUSY   - transmitter busy
+ *  @retval      others           - vendor-specific
+ */
+CANAPI int can_write_tagged(int handle, const can_message_t *message, uint16_t timeout, uint32_t *tag);
+
+
+/** @brief       read one message from the message queue of the CAN interface,
+ *               if any message was received, together with the sequence tag
+ *               of a TX echo. The CAN controller must be in operation state
+ *               'running'.
+ *
+ *  @note        A TX echo is a transmitted message that comes back when the
+ *               TX echo is switched on (property TOUCAN_SET_TX_ECHO). Its
+ *               sequence tag is the one returned by can_write_tagged, and its
+ *               time-stamp is the OUT-completion time: the time when the USB
+ *               transfer to the device was completed, taken from the host
+ *               clock and mapped to device time (the time base of received
+ *               messages). The device does not report when the message was
+ *               sent on the bus, so this is not a measure of the transmit
+ *               latency. Messages received from the bus have sequence tag 0.
+ *               can_read, can_read_us, can_read_multi and can_read_peek drop
+ *               the TX echoes (the time spent on them counts to the time-out).
+ *
+ *  @param[in]   handle  - handle of the CAN interface
+ *  @param[out]  message - the message read from the message queue, if any
+ *  @param[in]   timeout - time to wait for the reception of a message:
+ *                              0 means the function returns immediately,
+ *                              65535 means blocking read, and any other
+ *                              value means the time to wait in milliseconds
+ *  @param[out]  tag     - sequence tag of a TX echo, or 0
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      CANERR_NOTINIT   - library not initialized
+ *  @retval      CANERR_HANDLE    - invalid interface handle
+ *  @retval      CANERR_NULLPTR   - null-pointer assignment
+ *  @retval      CANERR_OFFLINE   - interface not started
+ *  @retval      CANERR_RX_EMPTY  - message queue empty
+ *  @retval      others           - vendor-specific
+ */
+CANAPI int can_read_tagged(int handle, can_message_t *message, uint16_t timeout, uint32_t *tag);
+
+
+/** @brief       read up to 'max' messages from the message queue of the CAN
+ *               interface, if any message was received. The CAN controller must
+ *               be in operation state 'running'.
+ *
+ *  @note        The function waits only for the first message. Then it returns
+ *               as many messages as are in the message queue (up to 'max').
+ *
+ *  @param[in]   handle  - handle of the CAN interface
+ *  @param[out]  messages - pointer to an array of 'max' message buffers
+ *  @param[in]   max     - number of message buffers (at least 1)
+ *  @param[out]  count   - number of messages read from the message queue
+ *  @param[in]   timeout - time to wait for the reception of a message:
+ *                              0 means the function returns immediately,
+ *                              65535 means blocking read, and any other
+ *                              value means the time to wait in milliseconds
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      CANERR_NOTINIT   - library not initialized
+ *  @retval      CANERR_HANDLE    - invalid interface handle
+ *  @retval      CANERR_NULLPTR   - null-pointer assignment
+ *  @retval      CANERR_ILLPARA   - illegal number of message buffers
+ *  @retval      CANERR_OFFLINE   - interface not started
+ *  @retval      CANERR_RX_EMPTY  - message queue empty
+ *  @retval      others           - vendor-specific
+ */
+CANAPI int can_read_multi(int handle, can_message_t *messages, uint32_t max, uint32_t *count, uint16_t timeout);
+
+
+/** @brief       borrow the received messages in the message queue of the CAN
+ *               interface, if any message was received. The CAN controller
+ *               must be in operation state 'running'.
+ *
+ *  @note        The messages are not removed from the message queue. They are
+ *               returned in a view, a per-device copy of at most 64 messages
+ *               that stays valid until the next call of can_read_peek or a
+ *               restart of the controller. They stay in the message queue
+ *               until they are released by a call of can_read_commit.
+ *
+ *  @note        Only the messages that are stored contiguously in the message
+ *               queue are returned (i.e. up to the end of the ring-buffer), and
+ *               at most 64 of them (the size of the view).
+ *
+ *  @param[in]   handle  - handle of the CAN interface
+ *  @param[out]  messages - pointer to the first borrowed message (read-only)
+ *  @param[out]  count   - number of borrowed messages
+ *  @param[in]   timeout - time to wait for the reception of a message:
+ *                              0 means the function returns immediately,
+ *                              65535 means blocking read, and any other
+ *                              value means the time to wait in milliseconds
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      CANERR_NOTINIT   - library not initialized
+ *  @retval      CANERR_HANDLE    - invalid interface handle
+ *  @retval      CANERR_NULLPTR   - null-pointer assignment
+ *  @retval      CANERR_OFFLINE   - interface not started
+ *  @retval      CANERR_RX_EMPTY  - message queue empty
+ *  @retval      others           - vendor-specific
+ */
+CANAPI int can_read_peek(int handle, const can_message_t **messages, uint32_t *count, uint16_t timeout);
+
+
+/** @brief       release the first 'count' messages borrowed by can_read_peek
+ *               to the message queue of the CAN interface.
+ *
+ *  @note        The remaining borrowed messages (if any) stay in the message
+ *               queue and are returned again by the next call of can_read_peek.
+ *
+ *  @param[in]   handle  - handle of the CAN interface
+ *  @param[in]   count   - number of messages to be released (0 to 'count'
+ *                         returned by the previous call of can_read_peek)
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      CANERR_NOTINIT   - library not initialized
+ *  @retval      CANERR_HANDLE    - invalid interface handle
+ *  @retval      CANERR_ILLPARA   - more messages than borrowed
+ *  @retval      others           - vendor-specific
+ */
+CANAPI int can_read_commit(int handle, uint32_t count);
+
+
+/** @brief       wait until at least one of the given CAN interfaces has received
+ *               a message. The CAN controllers must be in operation state
+ *               'running'.
+ *
+ *  @note        The messages are not read from the message queues. Bit i of
+ *               'ready' is set when the message queue of handles[i] is not
+ *               empty. A call of can_kill wakes up a waiting caller.
+ *
+ *  @param[in]   handles - array of 'count' handles of CAN interfaces
+ *  @param[in]   count   - number of handles (1 to 8)
+ *  @param[in]   timeout - time to wait for the reception of a message:
+ *                              0 means the function returns immediately,
+ *                              65535 means blocking wait, and any other
+ *                              value means the time to wait in milliseconds
+ *  @param[out]  ready   - bit mask of the interfaces with received messages
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      CANERR_NOTINIT   - library not initialized
+ *  @retval      CANERR_HANDLE    - invalid interface handle
+ *  @retval      CANERR_NULLPTR   - null-pointer assignment
+ *  @retval      CANERR_ILLPARA   - illegal number of handles
+ *  @retval      CANERR_OFFLINE   - interface not started
+ *  @retval      CANERR_RX_EMPTY  - all message queues empty
+ *  @retval      others           - vendor-specific
+ */
+CANAPI int can_select(const int *handles, uint32_t count, uint16_t timeout, uint32_t *ready);
+
+
+/** @brief       transmits a batch of messages over the CAN bus. The CAN controller
+ *               must be in operation state 'running'.
+ *
+ *  @note        The messages are put into the transmit queue of the CAN interface
+ *               in chunks. Up to three of them are sent in one USB packet, and
+ *               consecutive packets are sent in one USB transfer.
+ *
+ *  @note        The batch is refused as a whole if one of the messages cannot be
+ *               sent. When the transmit queue is full, the function waits up to
+ *               'timeout' milliseconds for free room (per chunk).
+ *
+ *  @param[in]   handle  - handle of the CAN interface
+ *  @param[in]   messages - pointer to an array of 'count' messages to be sent
+ *  @param[in]   count   - number of messages to be sent (at least 1)
+ *  @param[out]  written - number of messages put into the transmit queue
+ *  @param[in]   timeout - time to wait for free room in the transmit queue:
+ *                              0 means the function returns immediately,
+ *                              65535 means blocking write, and any other
+ *                              value means the time to wait in milliseconds
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      CANERR_NOTINIT   - library not initialized
+ *  @retval      CANERR_HANDLE    - invalid interface handle
+ *  @retval      CANERR_NULLPTR   - null-pointer assignment
+ *  @retval      CANERR_ILLPARA   - illegal number of messages or illegal message
+ *  @retval      CANERR_OFFLINE   - interface not started
+ *  @retval      CANERR_TX_BUSY   - transmit queue full ('written' messages sent)
+ *  @retval      others           - vendor-specific
+ */
+CANAPI int can_write_multi(int handle, const can_message_t *messages, uint32_t count, uint32_t *written, uint16_t timeout);
+
+
+/** @brief       adds a cyclic message to the transmit scheduler of the CAN
+ *               interface. The message is sent every 'period_us' microseconds,
+ *               the first time 'phase_us' microseconds from now on.
+ *
+ *  @note        The scheduler runs in the library on absolute deadlines taken
+ *               from the monotonic clock, so the cycle does not drift. The
+ *               messages are only sent when the CAN controller is in operation
+ *               state 'running'. Deadline misses and the release delay (jitter)
+ *               can be read with property TOUCAN_GET_TX_SCHEDULE_STATS.
+ *
+ *  @param[in]   handle  - handle of the CAN interface
+ *  @param[in]   message - the message to be sent cyclically
+ *  @param[in]   period_us - cycle time in microseconds (at least
+ *                           TOUCAN_TX_SCHEDULE_MIN_PERIOD)
+ *  @param[in]   phase_us - delay of the first transmission in microseconds
+ *  @param[out]  entry   - entry of the cyclic message in the schedule
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      CANERR_NOTINIT   - library not initialized
+ *  @retval      CANERR_HANDLE    - invalid interface handle
+ *  @retval      CANERR_NULLPTR   - null-pointer assignment
+ *  @retval      CANERR_ILLPARA   - illegal message or cycle time
+ *  @retval      CANERR_RESOURCE  - schedule full (TOUCAN_TX_SCHEDULE_MAX_ENTRIES)
+ *  @retval      others           - vendor-specific
+ */
+CANAPI int can_tx_schedule_add(int handle, const can_message_t *message, uint32_t period_us, uint32_t phase_us, int *entry);
+
+
+/** @brief       removes a cyclic message from the transmit scheduler of the
+ *               CAN interface.
+ *
+ *  @note        The statistics of the removed message can still be read with
+ *               property TOUCAN_GET_TX_SCHEDULE_STATS until its entry is reused.
+ *
+ *  @param[in]   handle  - handle of the CAN interface
+ *  @param[in]   entry   - entry of the cyclic message in the schedule
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      CANERR_NOTINIT   - library not initialized
+ *  @retval      CANERR_HANDLE    - invalid interface handle
+ *  @retval      CANERR_ILLPARA   - invalid entry
+ *  @retval      others           - vendor-specific
+ */
+CANAPI int can_tx_schedule_remove(int handle, int entry);
+
+
+/** @brief       replaces the payload of a cyclic message in the transmit
+ *               scheduler of the CAN interface.
+ *
+ *  @note        The new payload is sent with the next release of the message,
+ *               its cycle is not affected.
+ *
+ *  @param[in]   handle  - handle of the CAN interface
+ *  @param[in]   entry   - entry of the cyclic message in the schedule
+ *  @param[in]   data    - the new payload (can be NULL if 'dlc' is 0)
+ *  @param[in]   dlc     - data length code of the new payload (0 .. 8)
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      CANERR_NOTINIT   - library not initialized
+ *  @retval      CANERR_HANDLE    - invalid interface handle
+ *  @retval      CANERR_NULLPTR   - null-pointer assignment
+ *  @retval      CANERR_ILLPARA   - invalid entry or data length code
+ *  @retval      others           - vendor-specific
+ */
+CANAPI int can_tx_schedule_update_payload(int handle, int entry, const uint8_t *data, uint8_t dlc);
+
+
+/** @brief       sets the acceptance filter for 11-bit identifiers of the CAN
+ *               interface (acceptance code and mask).
+ *
+ *  @note        A message is accepted when the bits of its identifier that
+ *               are set in the mask are equal to the acceptance code. A mask
+ *               of zero accepts all messages (default). The filter is applied
+ *               by the device when the CAN controller is started, and by the
+ *               library if the device refuses it.
+ *
+ *  @param[in]   handle  - handle of the CAN interface
+ *  @param[in]   code    - acceptance code (11-bit identifier)
+ *  @param[in]   mask    - acceptance mask (11-bit identifier)
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      CANERR_NOTINIT   - library not initialized
+ *  @retval      CANERR_HANDLE    - invalid interface handle
+ *  @retval      CANERR_ONLINE    - interface already started
+ *  @retval      CANERR_ILLPARA   - illegal code or mask
+ *  @retval      others           - vendor-specific
+ */
+CANAPI int can_filter_11bit(int handle, uint32_t code, uint32_t mask);
+
+
+/** @brief       sets the acceptance filter for 11-bit identifiers of the CAN
+ *               interface (list of identifiers).
+ *
+ *  @note        Only messages with an identifier from the list are accepted,
+ *               an empty list rejects all messages with a 11-bit identifier.
+ *               The device is programmed with the acceptance code and mask
+ *               that cover all identifiers of the list, the remainder is
+ *               filtered by the library.
+ *
+ *  @param[in]   handle  - handle of the CAN interface
+ *  @param[in]   ids     - list of 11-bit identifiers (can be NULL if 'count' is 0)
+ *  @param[in]   count   - number of identifiers (at most TOUCAN_FILTER_MAX_IDS)
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      CANERR_NOTINIT   - library not initialized
+ *  @retval      CANERR_HANDLE    - invalid interface handle
+ *  @retval      CANERR_NULLPTR   - null-pointer assignment
+ *  @retval      CANERR_ONLINE    - interface already started
+ *  @retval      CANERR_ILLPARA   - illegal identifier or too many identifiers
+ *  @retval      others           - vendor-specific
+ */
+CANAPI int can_filter_11bit_list(int handle, const uint32_t *ids, uint32_t count);
+
+
+/** @brief       sets the acceptance filter for 29-bit identifiers of the CAN
+ *               interface (acceptance code and mask).
+ *
+ *  @note        A message is accepted when the bits of its identifier that
+ *               are set in the mask are equal to the acceptance code. A mask
+ *               of zero accepts all messages (default). The filter is applied
+ *               by the device when the CAN controller is started, and by the
+ *               library if the device refuses it.
+ *
+ *  @param[in]   handle  - handle of the CAN interface
+ *  @param[in]   code    - acceptance code (29-bit identifier)
+ *  @param[in]   mask    - acceptance mask (29-bit identifier)
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      CANERR_NOTINIT   - library not initialized
+ *  @retval      CANERR_HANDLE    - invalid interface handle
+ *  @retval      CANERR_ONLINE    - interface already started
+ *  @retval      CANERR_ILLPARA   - illegal code or mask (or mode NXTD)
+ *  @retval      others           - vendor-specific
+ */
+CANAPI int can_filter_29bit(int handle, uint32_t code, uint32_t mask);
+
+
+/** @brief       sets the acceptance filter for 29-bit identifiers of the CAN
+ *               interface (list of identifiers).
+ *
+ *  @note        Only messages with an identifier from the list are accepted,
+ *               an empty list rejects all messages with a 29-bit identifier.
+ *               The device is programmed with the acceptance code and mask
+ *               that cover all identifiers of the list, the remainder is
+ *               filtered by the library.
+ *
+ *  @param[in]   handle  - handle of the CAN interface
+ *  @param[in]   ids     - list of 29-bit identifiers (can be NULL if 'count' is 0)
+ *  @param[in]   count   - number of identifiers (at most TOUCAN_FILTER_MAX_IDS)
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      CANERR_NOTINIT   - library not initialized
+ *  @retval      CANERR_HANDLE    - invalid interface handle
+ *  @retval      CANERR_NULLPTR   - null-pointer assignment
+ *  @retval      CANERR_ONLINE    - interface already started
+ *  @retval      CANERR_ILLPARA   - illegal identifier or too many identifiers (or mode NXTD)
+ *  @retval      others           - vendor-specific
+ */
+CANAPI int can_filter_29bit_list(int handle, const uint32_t *ids, uint32_t count);
+
+
+/** @brief       sets filter rules for received CAN messages of the CAN
+ *               interface (identifier ranges and payload predicates).
+ *
+ *  @note        The rules are compiled once and applied in the reception
+ *               callback, after the acceptance filters and before a message
+ *               is put into the receive queue. A message is accepted when at
+ *               least one rule matches; a list without rules removes them
+ *               (all messages passing the acceptance filters are accepted).
+ *               Error frames (status messages) are never filtered.
+ *
+ *  @param[in]   handle  - handle of the CAN interface
+ *  @param[in]   rules   - list of filter rules (can be NULL if 'count' is 0)
+ *  @param[in]   count   - number of rules (at most TOUCAN_FILTER_MAX_RULES)
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      CANERR_NOTINIT   - library not initialized
+ *  @retval      CANERR_HANDLE    - invalid interface handle
+ *  @retval      CANERR_NULLPTR   - null-pointer assignment
+ *  @retval      CANERR_ONLINE    - interface already started
+ *  @retval      CANERR_ILLPARA   - illegal rule or too many rules (or 29-bit rule in mode NXTD)
+ *  @retval      CANERR_RESOURCE  - out of memory
+ *  @retval      others           - vendor-specific
+ */
+CANAPI int can_filter_rules(int handle, const toucan_filter_rule_t *rules, uint32_t count);
+
+
+/** @brief       receive callback function (cf. can_set_rx_callback):
+ *               Called in the USB completion context with a batch of received
+ *               messages (CAN messages and status messages, in order). The
+ *               messages are only valid during the call, so keep it short.
+ */
+typedef void (*can_rx_callback_t)(int handle, const can_message_t *messages, uint32_t count, void *context);
+
+
+/** @brief       sets a callback function for received messages of the CAN
+ *               interface (alternative to reading them from the receive
+ *               queue, e.g. by can_read).
+ *
+ *  @note        The callback function is called directly from the reception
+ *               callback of the USB device with all messages of a USB transfer
+ *               that pass the filters; they are not put into the receive queue.
+ *               It must not block and must not call can_exit for the interface.
+ *               Echoes of transmitted messages are still put into the receive
+ *               queue (cf. can_read_tagged). A NULL pointer as callback function
+ *               restores the delivery by the receive queue.
+ *
+ *  @param[in]   handle   - handle of the CAN interface
+ *  @param[in]   callback - callback function (or NULL)
+ *  @param[in]   context  - context for the callback function (can be NULL)
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      CANERR_NOTINIT   - library not initialized
+ *  @retval      CANERR_HANDLE    - invalid interface handle
+ *  @retval      CANERR_ONLINE    - interface already started
+ *  @retval      others           - vendor-specific
+ */
+CANAPI int can_set_rx_callback(int handle, can_rx_callback_t callback, void *context);
+
+
+/** @brief       latest CAN message of an identifier (cf. can_read_latest):
+ *               The counter is the number of CAN messages received with this
+ *               identifier since the snapshot table was enabled.
+ */
+typedef struct can_latest_t_ {
+    can_message_t message;              /**< the latest CAN message (with time-stamp) */
+    uint64_t counter;                   /**< number of received CAN messages */
+} can_latest_t;
+
+
+/** @brief       reads the latest CAN message of the given identifier from
+ *               the snapshot table of the CAN interface (non-blocking).
+ *
+ *  @note        The snapshot table must be enabled by the property value
+ *               TOUCAN_SET_SNAPSHOT (when the CAN controller is stopped). It
+ *               is updated in the reception callback and can be read from any
+ *               thread without taking a lock, also while CAN messages are read
+ *               from the receive queue; echoes of transmitted messages and
+ *               error frames (status messages) are not in the table.
+ *
+ *  @param[in]   handle  - handle of the CAN interface
+ *  @param[in]   id      - CAN identifier (11-bit or 29-bit)
+ *  @param[in]   xtd     - 29-bit identifier (0 = 11-bit identifier)
+ *  @param[out]  latest  - the latest CAN message and its counter
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      CANERR_NOTINIT   - library not initialized
+ *  @retval      CANERR_HANDLE    - invalid interface handle
+ *  @retval      CANERR_NULLPTR   - null-pointer assignment
+ *  @retval      CANERR_ILLPARA   - illegal identifier
+ *  @retval      CANERR_RX_EMPTY  - no CAN message received with this identifier
+ *  @retval      CANERR_NOTSUPP   - snapshot table not enabled
+ *  @retval      others           - vendor-specific
+ */
+CANAPI int can_read_latest(int handle, uint32_t id, int xtd, can_latest_t *latest);
+
+
+/** @brief       reads all entries of the snapshot table of the CAN interface
+ *               (the latest CAN message of each received identifier).
+ *
+ *  @note        The entries are copied one by one, each of them consistent;
+ *               11-bit identifiers come first in ascending order, 29-bit
+ *               identifiers follow in no particular order. The table has at
+ *               most TOUCAN_SNAPSHOT_STD_IDS plus the configured number of
+ *               29-bit identifiers entries.
+ *
+ *  @param[in]   handle  - handle of the CAN interface
+ *  @param[out]  table   - array for the entries
+ *  @param[in]   max     - size of the array (number of entries)
+ *  @param[out]  count   - number of entries copied into the array
+ *
+ *  @returns     0 if successful, or a negative value on error.
+ *
+ *  @retval      CANERR_NOTINIT   - library not initialized
+ *  @retval      CANERR_HANDLE    - invalid interface handle
+ *  @retval      CANERR_NULLPTR   - null-pointer assignment
+ *  @retval      CANERR_NOTSUPP   - snapshot table not enabled
+ *  @retval      others           - vendor-specific
+ */
+CANAPI int can_read_snapshot(int handle, can_latest_t *table, uint32_t max, uint32_t *count);
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* CAN_EXT_H_INCLUDED */
+/** @}
+ */
+/*  ----------------------------------------------------------------------
+ *  Uwe Vogt,  UV Software,  Chausseestrasse 33 A,  10115 Berlin,  Germany
+ *  Tel.: +49-30-46799872,  Fax: +49-30-46799873,  Mobile: +49-170-3801903
+ *  E-Mail: uwe.vogt@uv-software.de,  Homepage: http://www.uv-software.de/
+ */
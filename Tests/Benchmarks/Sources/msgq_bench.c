@@ -0,0 +1,147 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later */
+/*
+ *  TouCAN - macOS User-Space Driver for Rusoku TouCAN USB Adapters
+ *
+ *  Copyright (C) 2023  Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+ *
+ *  This file is part of MacCAN-TouCAN.
+ *
+ *  MacCAN-TouCAN is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  MacCAN-TouCAN is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with MacCAN-TouCAN.  If not, see <https://www.gnu.org/licenses/>.
+ */
+/*  Micro-benchmark of the MacCAN message queue (no hardware required):
+ *  a producer thread (USB callback) enqueues CAN frames in bursts of three
+ *  (one 64-byte USB packet) and a consumer thread (application) dequeues
+ *  them with a blocking read, once with the mutex-protected queue and once
+ *  with the lock-free queue.
+ */
+#include "MacCAN_MsgQueue.h"
+#include "CANAPI_Types.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+
+#define DEFAULT_FRAMES  2000000U
+#define DEFAULT_QUEUE   65536U
+#define BURST_SIZE      3U
+
+typedef struct bench_context_t_ {
+    CANQUE_MsgQueue_t queue;
+    UInt32 frames;
+    UInt64 retries;
+    UInt64 enqueueTime;
+    UInt64 errors;
+} bench_context_t;
+
+static UInt64 now_nsec(void) {
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((UInt64)ts.tv_sec * 1000000000U) + (UInt64)ts.tv_nsec;
+}
+
+static void *producer(void *arg) {
+    bench_context_t *ctx = (bench_context_t*)arg;
+    can_message_t message;
+    UInt64 start, stop;
+    UInt32 i = 0U;
+
+    memset(&message, 0, sizeof(can_message_t));
+    message.dlc = CAN_MAX_DLC;
+    while (i < ctx->frames) {
+        start = now_nsec();
+        for (UInt32 n = 0U; (n < BURST_SIZE) && (i < ctx->frames); n++) {
+            message.id = i & CAN_MAX_STD_ID;
+            memcpy(message.data, &i, sizeof(UInt32));
+            if (CANQUE_Enqueue(ctx->queue, &message) == CANUSB_SUCCESS)
+                i++;
+            else
+                ctx->retries++;
+        }
+        stop = now_nsec();
+        ctx->enqueueTime += (stop - start);
+        sched_yield();  /* let the reader park from time to time */
+    }
+    return NULL;
+}
+
+static void *consumer(void *arg) {
+    bench_context_t *ctx = (bench_context_t*)arg;
+    can_message_t message;
+    UInt32 expected = 0U, number;
+
+    while (expected < ctx->frames) {
+        if (CANQUE_Dequeue(ctx->queue, &message, CANUSB_INFINITE) == CANUSB_SUCCESS) {
+            memcpy(&number, message.data, sizeof(UInt32));
+            if (number != expected)
+                ctx->errors++;
+            expected = number + 1U;
+        }
+    }
+    return NULL;
+}
+
+static int run(const char *name, CANQUE_Mode_t mode, UInt32 frames, UInt32 size) {
+    bench_context_t ctx;
+    pthread_t prod, cons;
+    UInt64 start, stop;
+
+    memset(&ctx, 0, sizeof(bench_context_t));
+    if ((ctx.queue = CANQUE_CreateEx(size, sizeof(can_message_t), mode)) == NULL) {
+        fprintf(stderr, "+++ error: message queue could not be created\n");
+        return -1;
+    }
+    ctx.frames = frames;
+
+    start = now_nsec();
+    if ((pthread_create(&cons, NULL, consumer, &ctx) != 0) ||
+        (pthread_create(&prod, NULL, producer, &ctx) != 0)) {
+        fprintf(stderr, "+++ error: threads could not be created\n");
+        (void)CANQUE_Destroy(ctx.queue);
+        return -1;
+    }
+    (void)pthread_join(prod, NULL);
+    (void)pthread_join(cons, NULL);
+    stop = now_nsec();
+
+    fprintf(stdout, "%-10s %10u frames in %8.3f ms: %10.0f frames/s, %6.1f ns/enqueue, %8llu retries, %llu error(s), high=%u\n",
+            name, frames, (double)(stop - start) / 1000000.0,
+            (double)frames * 1000000000.0 / (double)(stop - start),
+            (double)ctx.enqueueTime / (double)frames,
+            (unsigned long long)ctx.retries, (unsigned long long)ctx.errors,
+            CANQUE_QueueHigh(ctx.queue));
+    (void)CANQUE_Destroy(ctx.queue);
+    return (ctx.errors == 0U) ? 0 : -1;
+}
+
+int main(int argc, const char * argv[]) {
+    UInt32 frames = DEFAULT_FRAMES;
+    UInt32 size = DEFAULT_QUEUE;
+    int rc = 0;
+
+    if (argc > 1)
+        frames = (UInt32)strtoul(argv[1], NULL, 10);
+    if (argc > 2)
+        size = (UInt32)strtoul(argv[2], NULL, 10);
+    if (!frames || !size) {
+        fprintf(stderr, "Usage: %s [<frames> [<queue-size>]]\n", argv[0]);
+        return 1;
+    }
+    fprintf(stdout, "MacCAN message queue: %u frames of %zu bytes, queue size %u\n", frames, sizeof(can_message_t), size);
+    rc |= run("mutex", CANQUE_MODE_MUTEX, frames, size);
+    rc |= run("lock-free", CANQUE_MODE_LOCKFREE, frames, size);
+    return (rc == 0) ? 0 : 1;
+}
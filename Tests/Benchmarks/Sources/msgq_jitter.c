@@ -0,0 +1,179 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later */
+/*
+ *  TouCAN - macOS User-Space Driver for Rusoku TouCAN USB Adapters
+ *
+ *  Copyright (C) 2023  Uwe Vogt, UV Software, Berlin (info@mac-can.com)
+ *
+ *  This file is part of MacCAN-TouCAN.
+ *
+ *  MacCAN-TouCAN is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  MacCAN-TouCAN is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with MacCAN-TouCAN.  If not, see <https://www.gnu.org/licenses/>.
+ */
+/*  Wake-up jitter of the MacCAN message queue (no hardware required):
+ *  1. time-out: a timed read (in [usec]) on an empty queue must not return
+ *     before its deadline; the overshoot is the wake-up jitter.
+ *  2. latency: a producer thread enqueues a time-stamped CAN frame every
+ *     cycle and a blocked reader measures the time until it is woken up.
+ *  The program fails when a timed read returns before its deadline or when
+ *  the 99th percentile of the wake-up latency exceeds the given limit
+ *  (default 1000 usec). The time-out overshoot is reported only, because
+ *  it depends on the timer slack of the host.
+ */
+#include "MacCAN_MsgQueue.h"
+#include "CANAPI_Types.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#define DEFAULT_LOOPS   1000U
+#define DEFAULT_LIMIT   1000U
+#define READ_TIMEOUT    500U    /* [usec] */
+#define CYCLE_TIME      500U    /* [usec] */
+
+typedef struct jitter_context_t_ {
+    CANQUE_MsgQueue_t queue;
+    UInt32 loops;
+} jitter_context_t;
+
+static UInt64 now_nsec(void) {
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((UInt64)ts.tv_sec * 1000000000U) + (UInt64)ts.tv_nsec;
+}
+
+static void sleep_usec(UInt32 usec) {
+    struct timespec ts;
+    ts.tv_sec = (time_t)(usec / 1000000U);
+    ts.tv_nsec = (long)(usec % 1000000U) * (long)1000;
+    (void)nanosleep(&ts, NULL);
+}
+
+static int compare(const void *a, const void *b) {
+    UInt64 x = *(const UInt64*)a, y = *(const UInt64*)b;
+    return (x > y) - (x < y);
+}
+
+static UInt64 report(const char *name, const char *what, UInt64 *samples, UInt32 count) {
+    UInt64 sum = 0U;
+
+    qsort(samples, count, sizeof(UInt64), compare);
+    for (UInt32 i = 0U; i < count; i++)
+        sum += samples[i];
+    fprintf(stdout, "%-10s %-9s min=%7.1f  avg=%7.1f  p50=%7.1f  p99=%7.1f  max=%8.1f usec\n",
+            name, what, (double)samples[0] / 1000.0, (double)sum / (double)count / 1000.0,
+            (double)samples[count / 2U] / 1000.0, (double)samples[(count * 99U) / 100U] / 1000.0,
+            (double)samples[count - 1U] / 1000.0);
+    return samples[(count * 99U) / 100U];
+}
+
+static void *producer(void *arg) {
+    jitter_context_t *ctx = (jitter_context_t*)arg;
+    can_message_t message;
+    UInt64 stamp;
+
+    memset(&message, 0, sizeof(can_message_t));
+    message.dlc = CAN_MAX_DLC;
+    for (UInt32 i = 0U; i < ctx->loops; i++) {
+        sleep_usec(CYCLE_TIME);
+        stamp = now_nsec();
+        memcpy(message.data, &stamp, sizeof(UInt64));
+        (void)CANQUE_Enqueue(ctx->queue, &message);
+    }
+    return NULL;
+}
+
+static int run(const char *name, CANQUE_Mode_t mode, UInt32 loops, UInt32 limit) {
+    jitter_context_t ctx;
+    can_message_t message;
+    pthread_t prod;
+    UInt64 *samples;
+    UInt64 start, stop, stamp;
+    UInt32 early = 0U, lost = 0U, n = 0U;
+    int rc = 0;
+
+    if ((samples = (UInt64*)calloc(loops, sizeof(UInt64))) == NULL) {
+        fprintf(stderr, "+++ error: out of memory\n");
+        return -1;
+    }
+    memset(&ctx, 0, sizeof(jitter_context_t));
+    if ((ctx.queue = CANQUE_CreateEx(64U, sizeof(can_message_t), mode)) == NULL) {
+        fprintf(stderr, "+++ error: message queue could not be created\n");
+        free(samples);
+        return -1;
+    }
+    ctx.loops = loops;
+    /* 1. time-out on an empty queue */
+    for (UInt32 i = 0U; i < loops; i++) {
+        start = now_nsec();
+        if (CANQUE_DequeueUs(ctx.queue, &message, READ_TIMEOUT) != CANUSB_ERROR_EMPTY)
+            lost++;
+        stop = now_nsec();
+        if ((stop - start) < ((UInt64)READ_TIMEOUT * 1000U))
+            early++;
+        else
+            samples[n++] = (stop - start) - ((UInt64)READ_TIMEOUT * 1000U);
+    }
+    if (n)
+        (void)report(name, "time-out", samples, n);
+    /* 2. wake-up latency of a blocked reader */
+    n = 0U;
+    if (pthread_create(&prod, NULL, producer, &ctx) != 0) {
+        fprintf(stderr, "+++ error: thread could not be created\n");
+        (void)CANQUE_Destroy(ctx.queue);
+        free(samples);
+        return -1;
+    }
+    for (UInt32 i = 0U; i < loops; i++) {
+        if (CANQUE_DequeueUs(ctx.queue, &message, 1000000U) == CANUSB_SUCCESS) {
+            stop = now_nsec();
+            memcpy(&stamp, message.data, sizeof(UInt64));
+            samples[n++] = stop - stamp;
+        } else {
+            lost++;
+        }
+    }
+    (void)pthread_join(prod, NULL);
+    if (n && (report(name, "wake-up", samples, n) > ((UInt64)limit * 1000U)))
+        rc = -1;
+    if (early || lost) {
+        fprintf(stdout, "%-10s +++ %u read(s) returned before the deadline, %u unexpected result(s)\n", name, early, lost);
+        rc = -1;
+    }
+    (void)CANQUE_Destroy(ctx.queue);
+    free(samples);
+    return rc;
+}
+
+int main(int argc, const char * argv[]) {
+    UInt32 loops = DEFAULT_LOOPS;
+    UInt32 limit = DEFAULT_LIMIT;
+    int rc = 0;
+
+    if (argc > 1)
+        loops = (UInt32)strtoul(argv[1], NULL, 10);
+    if (argc > 2)
+        limit = (UInt32)strtoul(argv[2], NULL, 10);
+    if (!loops || !limit) {
+        fprintf(stderr, "Usage: %s [<loops> [<p99-limit-usec>]]\n", argv[0]);
+        return 1;
+    }
+    fprintf(stdout, "MacCAN message queue: %u timed reads of %u usec, %u wake-ups every %u usec (p99 limit %u usec)\n",
+            loops, READ_TIMEOUT, loops, CYCLE_TIME, limit);
+    rc |= run("mutex", CANQUE_MODE_MUTEX, loops, limit);
+    rc |= run("lock-free", CANQUE_MODE_LOCKFREE, loops, limit);
+    fprintf(stdout, "%s\n", (rc == 0) ? "PASSED" : "FAILED");
+    return (rc == 0) ? 0 : 1;
+}
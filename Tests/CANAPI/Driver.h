@@ -71,9 +71,9 @@ typedef CTouCAN  CCanDriver;
 #define FEATURE_ERROR_FRAMES        FEATURE_UNSUPPORTED
 #define FEATURE_ERROR_CODE_CAPTURE  FEATURE_UNSUPPORTED
 #define FEATURE_BLOCKING_READ       FEATURE_SUPPORTED
-#define FEATURE_BLOCKING_WRITE      FEATURE_UNSUPPORTED
+#define FEATURE_BLOCKING_WRITE      FEATURE_SUPPORTED
 #define FEATURE_SIZE_RECEIVE_QUEUE  65536
-#define FEATURE_SIZE_TRANSMIT_QUEUE 0
+#define FEATURE_SIZE_TRANSMIT_QUEUE 256
 
 //  (§5) define macros for CAN 2.0 bit-rate settings
 //       at least BITRATE_1M, BITRATE_500K, BITRATE_250K, BITRATE_125K, 
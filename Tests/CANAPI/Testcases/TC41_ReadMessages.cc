@@ -0,0 +1,239 @@
+//  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later
+//
+//  CAN Interface API, Version 3 (Testing)
+//
+//  Copyright (c) 2004-2023 Uwe Vogt, UV Software, Berlin (info@uv-software.com)
+//  All rights reserved.
+//
+//  This file is part of CAN API V3.
+//
+//  CAN API V3 is dual-licensed under the BSD 2-Clause "Simplified" License and
+//  under the GNU General Public License v3.0 (or any later version).
+//  You can choose between one of them if you use this file.
+//
+//  BSD 2-Clause "Simplified" License:
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are met:
+//  1. Redistributions of source code must retain the above copyright notice, this
+//     list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  CAN API V3 IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+//  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+//  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+//  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//  OF CAN API V3, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  GNU General Public License v3.0 or later:
+//  CAN API V3 is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  CAN API V3 is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with CAN API V3.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include "pch.h"
+
+#define TC41_BUFFER_SIZE  64U
+
+class ReadMessages : public testing::Test {
+    virtual void SetUp() {}
+    virtual void TearDown() {}
+protected:
+    // ...
+};
+
+// @gtest TC41.0: Read CAN messages in batches (sunnyday scenario)
+//
+// @expected: CANERR_NOERROR
+//
+TEST_F(ReadMessages, GTEST_TESTCASE(SunnydayScenario, GTEST_SUNNYDAY)) {
+    CCanDevice dut1 = CCanDevice(TEST_DEVICE(DUT1));
+    CCanDevice dut2 = CCanDevice(TEST_DEVICE(DUT2));
+    CANAPI_Message_t trmMsg = {};
+    CANAPI_Message_t rcvMsg[TC41_BUFFER_SIZE] = {};
+    CANAPI_Status_t status = {};
+    CANAPI_Return_t retVal;
+    uint32_t count = 0U;
+    // CAN message
+    trmMsg.id = 0x410U;
+    trmMsg.xtd = 0;
+    trmMsg.rtr = 0;
+    trmMsg.sts = 0;
+    trmMsg.dlc = CAN_MAX_DLC;
+    memset(trmMsg.data, 0, CAN_MAX_LEN);
+    // @pre:
+    // @- initialize DUT1 with configured settings
+    retVal = dut1.InitializeChannel();
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.InitializeChannel() failed with error code " << retVal;
+    // @- start DUT1 with configured bit-rate settings
+    retVal = dut1.StartController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- initialize DUT2 with configured settings
+    retVal = dut2.InitializeChannel();
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut2.InitializeChannel() failed with error code " << retVal;
+    // @- start DUT2 with configured bit-rate settings
+    retVal = dut2.StartController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- issue(PeakCAN): why do we need a delay here?
+    PCBUSB_INIT_DELAY();
+    // @test:
+    CCounter counter = CCounter(true);
+    // @- DUT2 send out some messages (with a sequence number in byte 0 to 3)
+    int32_t frames = g_Options.GetNumberOfTestFrames();
+    for (int32_t i = 0; i < frames; i++) {
+        trmMsg.data[0] = (uint8_t)(i >> 24);
+        trmMsg.data[1] = (uint8_t)(i >> 16);
+        trmMsg.data[2] = (uint8_t)(i >> 8);
+        trmMsg.data[3] = (uint8_t)i;
+        do {
+            retVal = dut2.WriteMessage(trmMsg);
+        } while (CCanApi::TransmitterBusy == retVal);
+        ASSERT_EQ(CCanApi::NoError, retVal);
+    }
+    // @- DUT1 read the messages in batches (with time-out) and check the sequence
+    int32_t received = 0;
+    while (received < frames) {
+        retVal = dut1.ReadMessages(rcvMsg, TC41_BUFFER_SIZE, count, TEST_READ_TIMEOUT);
+        if (CCanApi::NoError != retVal)
+            break;
+        EXPECT_LT(0U, count);
+        EXPECT_GE(TC41_BUFFER_SIZE, count);
+        for (uint32_t j = 0U; j < count; j++, received++) {
+            int32_t seqNo = ((int32_t)rcvMsg[j].data[0] << 24) | ((int32_t)rcvMsg[j].data[1] << 16)
+                          | ((int32_t)rcvMsg[j].data[2] << 8) | (int32_t)rcvMsg[j].data[3];
+            EXPECT_EQ(received, seqNo);
+            EXPECT_EQ(trmMsg.id, rcvMsg[j].id);
+            EXPECT_FALSE(rcvMsg[j].sts);
+        }
+    }
+    EXPECT_EQ(frames, received);
+    // @- get status of DUT1 and check to be in RUNNING state
+    retVal = dut1.GetStatus(status);
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    EXPECT_FALSE(status.can_stopped);
+    // @post:
+    counter.Clear();
+    // @- stop/reset DUT1
+    retVal = dut1.ResetController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- tear down DUT1
+    retVal = dut1.TeardownChannel();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- tear down DUT2
+    retVal = dut2.TeardownChannel();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @end.
+}
+
+// @gtest TC41.1: Read CAN messages in batches if receive queue is empty
+//
+// @expected: CANERR_RX_EMPTY, no message read and status bit 'receiver_empty' is set
+//
+TEST_F(ReadMessages, GTEST_TESTCASE(IfReceiveQueueEmpty, GTEST_ENABLED)) {
+    CCanDevice dut1 = CCanDevice(TEST_DEVICE(DUT1));
+    CANAPI_Message_t rcvMsg[TC41_BUFFER_SIZE] = {};
+    CANAPI_Status_t status = {};
+    CANAPI_Return_t retVal;
+    uint32_t count = 1U;
+    // @pre:
+    // @- initialize DUT1 with configured settings
+    retVal = dut1.InitializeChannel();
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.InitializeChannel() failed with error code " << retVal;
+    // @- start DUT1 with configured bit-rate settings
+    retVal = dut1.StartController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @test:
+    // @- DUT1 try to read messages from empty queue (polling)
+    retVal = dut1.ReadMessages(rcvMsg, TC41_BUFFER_SIZE, count, 0U);
+    EXPECT_EQ(CCanApi::ReceiverEmpty, retVal);
+    EXPECT_EQ(0U, count);
+    // @- DUT1 try to read messages from empty queue (with time-out)
+    count = 1U;
+    retVal = dut1.ReadMessages(rcvMsg, TC41_BUFFER_SIZE, count, TEST_READ_TIMEOUT);
+    EXPECT_EQ(CCanApi::ReceiverEmpty, retVal);
+    EXPECT_EQ(0U, count);
+    // @- get status of DUT1 and check if bit 'receiver_empty' is set
+    retVal = dut1.GetStatus(status);
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    EXPECT_TRUE(status.receiver_empty);
+    // @post:
+    // @- stop/reset DUT1
+    retVal = dut1.ResetController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- tear down DUT1
+    retVal = dut1.TeardownChannel();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @end.
+}
+
+// @gtest TC41.2: Read CAN messages in batches with zero buffer size
+//
+// @expected: CANERR_ILLPARA
+//
+TEST_F(ReadMessages, GTEST_TESTCASE(WithZeroBufferSize, GTEST_ENABLED)) {
+    CCanDevice dut1 = CCanDevice(TEST_DEVICE(DUT1));
+    CANAPI_Message_t rcvMsg[TC41_BUFFER_SIZE] = {};
+    CANAPI_Return_t retVal;
+    uint32_t count = 1U;
+    // @pre:
+    // @- initialize DUT1 with configured settings
+    retVal = dut1.InitializeChannel();
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.InitializeChannel() failed with error code " << retVal;
+    // @- start DUT1 with configured bit-rate settings
+    retVal = dut1.StartController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @test:
+    // @- DUT1 try to read messages into a buffer of size 0
+    retVal = dut1.ReadMessages(rcvMsg, 0U, count, 0U);
+    EXPECT_EQ(CCanApi::IllegalParameter, retVal);
+    EXPECT_EQ(0U, count);
+    // @post:
+    // @- stop/reset DUT1
+    retVal = dut1.ResetController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- tear down DUT1
+    retVal = dut1.TeardownChannel();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @end.
+}
+
+// @gtest TC41.3: Read CAN messages in batches if CAN controller is not started
+//
+// @expected: CANERR_OFFLINE
+//
+TEST_F(ReadMessages, GTEST_TESTCASE(IfControllerNotStarted, GTEST_ENABLED)) {
+    CCanDevice dut1 = CCanDevice(TEST_DEVICE(DUT1));
+    CANAPI_Message_t rcvMsg[TC41_BUFFER_SIZE] = {};
+    CANAPI_Return_t retVal;
+    uint32_t count = 1U;
+    // @pre:
+    // @- initialize DUT1 with configured settings
+    retVal = dut1.InitializeChannel();
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.InitializeChannel() failed with error code " << retVal;
+    // @test:
+    // @- DUT1 try to read messages (controller not started)
+    retVal = dut1.ReadMessages(rcvMsg, TC41_BUFFER_SIZE, count, 0U);
+    EXPECT_EQ(CCanApi::ControllerOffline, retVal);
+    EXPECT_EQ(0U, count);
+    // @post:
+    // @- tear down DUT1
+    retVal = dut1.TeardownChannel();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @end.
+}
+
+//  $Id$  Copyright (c) UV Software, Berlin.
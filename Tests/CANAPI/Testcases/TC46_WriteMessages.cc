@@ -0,0 +1,236 @@
+//  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later
+//
+//  CAN Interface API, Version 3 (Testing)
+//
+//  Copyright (c) 2004-2023 Uwe Vogt, UV Software, Berlin (info@uv-software.com)
+//  All rights reserved.
+//
+//  This file is part of CAN API V3.
+//
+//  CAN API V3 is dual-licensed under the BSD 2-Clause "Simplified" License and
+//  under the GNU General Public License v3.0 (or any later version).
+//  You can choose between one of them if you use this file.
+//
+//  BSD 2-Clause "Simplified" License:
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are met:
+//  1. Redistributions of source code must retain the above copyright notice, this
+//     list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  CAN API V3 IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+//  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+//  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+//  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//  OF CAN API V3, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  GNU General Public License v3.0 or later:
+//  CAN API V3 is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  CAN API V3 is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with CAN API V3.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include "pch.h"
+
+#define TEST_BATCH_SIZE  7U  // note: not a multiple of three frames per USB packet
+
+class WriteMessages : public testing::Test {
+    virtual void SetUp() {}
+    virtual void TearDown() {}
+protected:
+    // ...
+};
+
+// @gtest TC46.0: Send a batch of CAN messages (sunnyday scenario)
+//
+// @expected: CANERR_NOERROR
+//
+TEST_F(WriteMessages, GTEST_TESTCASE(SunnydayScenario, GTEST_SUNNYDAY)) {
+    CCanDevice dut1 = CCanDevice(TEST_DEVICE(DUT1));
+    CCanDevice dut2 = CCanDevice(TEST_DEVICE(DUT2));
+    CANAPI_Message_t trmMsg[TEST_BATCH_SIZE] = {};
+    CANAPI_Message_t rcvMsg = {};
+    CANAPI_Return_t retVal;
+    uint32_t written = 0U;
+    // @pre:
+    // @- initialize DUT1 with configured settings
+    retVal = dut1.InitializeChannel();
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.InitializeChannel() failed with error code " << retVal;
+    // @- start DUT1 with configured bit-rate settings
+    retVal = dut1.StartController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- initialize DUT2 with configured settings
+    retVal = dut2.InitializeChannel();
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut2.InitializeChannel() failed with error code " << retVal;
+    // @- start DUT2 with configured bit-rate settings
+    retVal = dut2.StartController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- issue(PeakCAN): why do we need a delay here?
+    PCBUSB_INIT_DELAY();
+    // @test:
+    CCounter counter = CCounter(true);
+    // @- DUT1 send out the test frames in batches (resume after transmitter busy)
+    int32_t frames = g_Options.GetNumberOfTestFrames();
+    int32_t sent = 0;
+    int32_t received = 0;
+    while (sent < frames) {
+        uint32_t count = 0U;
+        for (; (count < TEST_BATCH_SIZE) && ((sent + (int32_t)count) < frames); count++) {
+            int32_t seqNo = sent + (int32_t)count;
+            trmMsg[count].id = 0x460U;
+            trmMsg[count].dlc = CAN_MAX_DLC;
+            trmMsg[count].data[0] = (uint8_t)(seqNo >> 24);
+            trmMsg[count].data[1] = (uint8_t)(seqNo >> 16);
+            trmMsg[count].data[2] = (uint8_t)(seqNo >> 8);
+            trmMsg[count].data[3] = (uint8_t)seqNo;
+        }
+        retVal = dut1.WriteMessages(trmMsg, count, written, TEST_WRITE_TIMEOUT);
+        ASSERT_TRUE((CCanApi::NoError == retVal) || (CCanApi::TransmitterBusy == retVal)) << "[  ERROR!  ] dut1.WriteMessages() failed with error code " << retVal;
+        ASSERT_LE(written, count);
+        if (CCanApi::NoError == retVal) {
+            EXPECT_EQ(count, written);
+        }
+        sent += (int32_t)written;
+        // @- DUT2 read the messages received so far and check the sequence
+        while (dut2.ReadMessage(rcvMsg, 0U) == CCanApi::NoError) {
+            int32_t seqNo = ((int32_t)rcvMsg.data[0] << 24) | ((int32_t)rcvMsg.data[1] << 16)
+                          | ((int32_t)rcvMsg.data[2] << 8) | (int32_t)rcvMsg.data[3];
+            EXPECT_EQ(0x460U, rcvMsg.id);
+            EXPECT_EQ(received, seqNo);
+            received += 1;
+        }
+    }
+    // @- DUT2 read the remaining messages
+    while ((received < frames) && (dut2.ReadMessage(rcvMsg, TEST_READ_TIMEOUT) == CCanApi::NoError)) {
+        int32_t seqNo = ((int32_t)rcvMsg.data[0] << 24) | ((int32_t)rcvMsg.data[1] << 16)
+                      | ((int32_t)rcvMsg.data[2] << 8) | (int32_t)rcvMsg.data[3];
+        EXPECT_EQ(received, seqNo);
+        received += 1;
+    }
+    EXPECT_EQ(frames, received);
+    // @post:
+    counter.Clear();
+    // @- stop/reset DUT1
+    retVal = dut1.ResetController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- tear down DUT1
+    retVal = dut1.TeardownChannel();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- tear down DUT2
+    retVal = dut2.TeardownChannel();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @end.
+}
+
+// @gtest TC46.1: Send a batch of CAN messages with an illegal number of messages
+//
+// @expected: CANERR_ILLPARA
+//
+TEST_F(WriteMessages, GTEST_TESTCASE(WithIllegalNumberOfMessages, GTEST_ENABLED)) {
+    CCanDevice dut1 = CCanDevice(TEST_DEVICE(DUT1));
+    CANAPI_Message_t trmMsg[1] = {};
+    CANAPI_Return_t retVal;
+    uint32_t written = 0U;
+    // @pre:
+    // @- initialize DUT1 with configured settings
+    retVal = dut1.InitializeChannel();
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.InitializeChannel() failed with error code " << retVal;
+    // @- start DUT1 with configured bit-rate settings
+    retVal = dut1.StartController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @test:
+    // @- send a batch of zero messages
+    retVal = dut1.WriteMessages(trmMsg, 0U, written);
+    EXPECT_EQ(CCanApi::IllegalParameter, retVal);
+    EXPECT_EQ(0U, written);
+    // @post:
+    // @- stop/reset DUT1
+    retVal = dut1.ResetController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- tear down DUT1
+    retVal = dut1.TeardownChannel();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @end.
+}
+
+// @gtest TC46.2: Send a batch of CAN messages with one illegal message in it
+//
+// @expected: CANERR_ILLPARA and no message sent
+//
+TEST_F(WriteMessages, GTEST_TESTCASE(WithIllegalMessage, GTEST_ENABLED)) {
+    CCanDevice dut1 = CCanDevice(TEST_DEVICE(DUT1));
+    CANAPI_Message_t trmMsg[TEST_BATCH_SIZE] = {};
+    CANAPI_Return_t retVal;
+    uint32_t written = 0U;
+    // @pre:
+    // @- initialize DUT1 with configured settings
+    retVal = dut1.InitializeChannel();
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.InitializeChannel() failed with error code " << retVal;
+    // @- start DUT1 with configured bit-rate settings
+    retVal = dut1.StartController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @test:
+    // @- send a batch with an invalid 11-bit identifier in the middle of it
+    for (uint32_t i = 0U; i < TEST_BATCH_SIZE; i++)
+        trmMsg[i].id = 0x461U;
+    trmMsg[TEST_BATCH_SIZE / 2U].id = CAN_MAX_STD_ID + 1U;
+    retVal = dut1.WriteMessages(trmMsg, TEST_BATCH_SIZE, written);
+    EXPECT_EQ(CCanApi::IllegalParameter, retVal);
+    EXPECT_EQ(0U, written);
+    // @- send a batch with an error frame at the end of it
+    trmMsg[TEST_BATCH_SIZE / 2U].id = 0x461U;
+    trmMsg[TEST_BATCH_SIZE - 1U].sts = 1;
+    retVal = dut1.WriteMessages(trmMsg, TEST_BATCH_SIZE, written);
+    EXPECT_EQ(CCanApi::IllegalParameter, retVal);
+    EXPECT_EQ(0U, written);
+    // @post:
+    // @- stop/reset DUT1
+    retVal = dut1.ResetController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- tear down DUT1
+    retVal = dut1.TeardownChannel();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @end.
+}
+
+// @gtest TC46.3: Send a batch of CAN messages if CAN controller is not started
+//
+// @expected: CANERR_OFFLINE
+//
+TEST_F(WriteMessages, GTEST_TESTCASE(IfControllerNotStarted, GTEST_ENABLED)) {
+    CCanDevice dut1 = CCanDevice(TEST_DEVICE(DUT1));
+    CANAPI_Message_t trmMsg[TEST_BATCH_SIZE] = {};
+    CANAPI_Return_t retVal;
+    uint32_t written = 0U;
+    // @pre:
+    // @- initialize DUT1 with configured settings
+    retVal = dut1.InitializeChannel();
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.InitializeChannel() failed with error code " << retVal;
+    // @test:
+    // @- send a batch (controller not started)
+    retVal = dut1.WriteMessages(trmMsg, TEST_BATCH_SIZE, written);
+    EXPECT_EQ(CCanApi::ControllerOffline, retVal);
+    EXPECT_EQ(0U, written);
+    // @post:
+    // @- tear down DUT1
+    retVal = dut1.TeardownChannel();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @end.
+}
+
+//  $Id$  Copyright (c) UV Software, Berlin.
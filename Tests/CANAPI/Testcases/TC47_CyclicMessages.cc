@@ -0,0 +1,272 @@
+//  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later
+//
+//  CAN Interface API, Version 3 (Testing)
+//
+//  Copyright (c) 2004-2023 Uwe Vogt, UV Software, Berlin (info@uv-software.com)
+//  All rights reserved.
+//
+//  This file is part of CAN API V3.
+//
+//  CAN API V3 is dual-licensed under the BSD 2-Clause "Simplified" License and
+//  under the GNU General Public License v3.0 (or any later version).
+//  You can choose between one of them if you use this file.
+//
+//  BSD 2-Clause "Simplified" License:
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are met:
+//  1. Redistributions of source code must retain the above copyright notice, this
+//     list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  CAN API V3 IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+//  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+//  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+//  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//  OF CAN API V3, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  GNU General Public License v3.0 or later:
+//  CAN API V3 is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  CAN API V3 is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with CAN API V3.  If not, see <http://www.gnu.org/licenses/>.
+//
+//
+#include "pch.h"
+
+#define TEST_CYCLE_TIME   10000U  // 10ms
+#define TEST_CYCLE_COUNT  100     // i.e. 1s
+
+class CyclicMessages : public testing::Test {
+    virtual void SetUp() {}
+    virtual void TearDown() {}
+protected:
+    // ...
+};
+
+// @gtest TC47.0: Send a cyclic CAN message (sunnyday scenario)
+//
+// @expected: CANERR_NOERROR
+//
+TEST_F(CyclicMessages, GTEST_TESTCASE(SunnydayScenario, GTEST_SUNNYDAY)) {
+    CCanDevice dut1 = CCanDevice(TEST_DEVICE(DUT1));
+    CCanDevice dut2 = CCanDevice(TEST_DEVICE(DUT2));
+    CANAPI_Message_t trmMsg = {};
+    CANAPI_Message_t rcvMsg = {};
+    CANAPI_Return_t retVal;
+    toucan_schedule_stats_t stats = {};
+    uint32_t entries = 0U;
+    int entry = -1;
+    // @pre:
+    // @- initialize DUT1 with configured settings
+    retVal = dut1.InitializeChannel();
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.InitializeChannel() failed with error code " << retVal;
+    // @- start DUT1 with configured bit-rate settings
+    retVal = dut1.StartController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- initialize DUT2 with configured settings
+    retVal = dut2.InitializeChannel();
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut2.InitializeChannel() failed with error code " << retVal;
+    // @- start DUT2 with configured bit-rate settings
+    retVal = dut2.StartController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- issue(PeakCAN): why do we need a delay here?
+    PCBUSB_INIT_DELAY();
+    // @test:
+    // @- DUT1 add a cyclic message with a cycle time of 10ms
+    trmMsg.id = 0x470U;
+    trmMsg.dlc = CAN_MAX_DLC;
+    retVal = dut1.AddCyclicMessage(trmMsg, TEST_CYCLE_TIME, 0U, entry);
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.AddCyclicMessage() failed with error code " << retVal;
+    EXPECT_LE(0, entry);
+    retVal = dut1.GetProperty(TOUCAN_PROPERTY_TX_SCHEDULE_ENTRIES, (void*)&entries, sizeof(uint32_t));
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    EXPECT_EQ(1U, entries);
+    // @- wait for 100 cycles
+    CTimer::Delay((uint32_t)TEST_CYCLE_COUNT * TEST_CYCLE_TIME);
+    // @- DUT1 remove the cyclic message
+    retVal = dut1.RemoveCyclicMessage(entry);
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- DUT1 get the statistics of the cyclic message
+    stats.entry = (int32_t)entry;
+    retVal = dut1.GetProperty(TOUCAN_PROPERTY_TX_SCHEDULE_STATS, (void*)&stats, sizeof(toucan_schedule_stats_t));
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    EXPECT_GE((uint64_t)TEST_CYCLE_COUNT + 1U, stats.sent + stats.missed);
+    EXPECT_LE((uint64_t)TEST_CYCLE_COUNT - 1U, stats.sent + stats.missed);
+    EXPECT_LE(stats.jitter_min, stats.jitter_max);
+    // @- DUT2 read all cyclic messages sent
+    uint64_t received = 0U;
+    while (dut2.ReadMessage(rcvMsg, TEST_READ_TIMEOUT) == CCanApi::NoError) {
+        EXPECT_EQ(0x470U, rcvMsg.id);
+        received += 1U;
+    }
+    EXPECT_EQ(stats.sent, received);
+    // @post:
+    // @- stop/reset DUT1
+    retVal = dut1.ResetController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- tear down DUT1
+    retVal = dut1.TeardownChannel();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- tear down DUT2
+    retVal = dut2.TeardownChannel();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @end.
+}
+
+// @gtest TC47.1: Add a cyclic CAN message with an illegal cycle time
+//
+// @expected: CANERR_ILLPARA
+//
+TEST_F(CyclicMessages, GTEST_TESTCASE(WithIllegalCycleTime, GTEST_ENABLED)) {
+    CCanDevice dut1 = CCanDevice(TEST_DEVICE(DUT1));
+    CANAPI_Message_t trmMsg = {};
+    CANAPI_Return_t retVal;
+    int entry = -1;
+    // @pre:
+    // @- initialize DUT1 with configured settings
+    retVal = dut1.InitializeChannel();
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.InitializeChannel() failed with error code " << retVal;
+    // @- start DUT1 with configured bit-rate settings
+    retVal = dut1.StartController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @test:
+    // @- add a cyclic message with a cycle time of 0us
+    trmMsg.id = 0x471U;
+    retVal = dut1.AddCyclicMessage(trmMsg, 0U, 0U, entry);
+    EXPECT_EQ(CCanApi::IllegalParameter, retVal);
+    // @- add a cyclic message with a cycle time below the minimum
+    retVal = dut1.AddCyclicMessage(trmMsg, TOUCAN_TX_SCHEDULE_MIN_PERIOD - 1U, 0U, entry);
+    EXPECT_EQ(CCanApi::IllegalParameter, retVal);
+    // @post:
+    // @- stop/reset DUT1
+    retVal = dut1.ResetController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- tear down DUT1
+    retVal = dut1.TeardownChannel();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @end.
+}
+
+// @gtest TC47.2: Update the payload of a cyclic CAN message
+//
+// @expected: CANERR_NOERROR
+//
+TEST_F(CyclicMessages, GTEST_TESTCASE(UpdatePayload, GTEST_ENABLED)) {
+    CCanDevice dut1 = CCanDevice(TEST_DEVICE(DUT1));
+    CCanDevice dut2 = CCanDevice(TEST_DEVICE(DUT2));
+    CANAPI_Message_t trmMsg = {};
+    CANAPI_Message_t rcvMsg = {};
+    CANAPI_Return_t retVal;
+    uint8_t data[CAN_MAX_LEN] = { 0x11U, 0x22U, 0x33U, 0x44U, 0x55U, 0x66U, 0x77U, 0x88U };
+    int entry = -1;
+    // @pre:
+    // @- initialize DUT1 with configured settings
+    retVal = dut1.InitializeChannel();
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.InitializeChannel() failed with error code " << retVal;
+    // @- start DUT1 with configured bit-rate settings
+    retVal = dut1.StartController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- initialize DUT2 with configured settings
+    retVal = dut2.InitializeChannel();
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut2.InitializeChannel() failed with error code " << retVal;
+    // @- start DUT2 with configured bit-rate settings
+    retVal = dut2.StartController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- issue(PeakCAN): why do we need a delay here?
+    PCBUSB_INIT_DELAY();
+    // @test:
+    // @- DUT1 add a cyclic message with an empty payload
+    trmMsg.id = 0x472U;
+    trmMsg.dlc = 0U;
+    retVal = dut1.AddCyclicMessage(trmMsg, TEST_CYCLE_TIME, 0U, entry);
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.AddCyclicMessage() failed with error code " << retVal;
+    // @- DUT2 wait for the first message with an empty payload
+    retVal = dut2.ReadMessage(rcvMsg, TEST_READ_TIMEOUT);
+    ASSERT_EQ(CCanApi::NoError, retVal);
+    EXPECT_EQ(0x472U, rcvMsg.id);
+    EXPECT_EQ(0U, rcvMsg.dlc);
+    // @- DUT1 replace the payload of the cyclic message
+    retVal = dut1.UpdateCyclicPayload(entry, data, CAN_MAX_DLC);
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- DUT2 wait for a message with the new payload
+    bool updated = false;
+    CTimer timer = CTimer(TEST_READ_TIMEOUT * CTimer::MSEC);
+    while (!updated && !timer.Timeout()) {
+        if (dut2.ReadMessage(rcvMsg, TEST_READ_TIMEOUT) == CCanApi::NoError)
+            updated = (rcvMsg.dlc == CAN_MAX_DLC) && !memcmp(rcvMsg.data, data, CAN_MAX_LEN);
+    }
+    EXPECT_TRUE(updated);
+    // @- DUT1 replace the payload with an illegal data length code
+    retVal = dut1.UpdateCyclicPayload(entry, data, CAN_MAX_DLC + 1U);
+    EXPECT_EQ(CCanApi::IllegalParameter, retVal);
+    // @- DUT1 remove the cyclic message
+    retVal = dut1.RemoveCyclicMessage(entry);
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @post:
+    // @- stop/reset DUT1
+    retVal = dut1.ResetController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- tear down DUT1
+    retVal = dut1.TeardownChannel();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- tear down DUT2
+    retVal = dut2.TeardownChannel();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @end.
+}
+
+// @gtest TC47.3: Remove a cyclic CAN message with an invalid entry
+//
+// @expected: CANERR_ILLPARA
+//
+TEST_F(CyclicMessages, GTEST_TESTCASE(WithInvalidEntry, GTEST_ENABLED)) {
+    CCanDevice dut1 = CCanDevice(TEST_DEVICE(DUT1));
+    CANAPI_Message_t trmMsg = {};
+    CANAPI_Return_t retVal;
+    int entry = -1;
+    // @pre:
+    // @- initialize DUT1 with configured settings
+    retVal = dut1.InitializeChannel();
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.InitializeChannel() failed with error code " << retVal;
+    // @test:
+    // @- remove a cyclic message (schedule empty)
+    retVal = dut1.RemoveCyclicMessage(0);
+    EXPECT_EQ(CCanApi::IllegalParameter, retVal);
+    // @- add a cyclic message (controller not started)
+    trmMsg.id = 0x473U;
+    retVal = dut1.AddCyclicMessage(trmMsg, TEST_CYCLE_TIME, 0U, entry);
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.AddCyclicMessage() failed with error code " << retVal;
+    // @- remove the cyclic message twice
+    retVal = dut1.RemoveCyclicMessage(entry);
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    retVal = dut1.RemoveCyclicMessage(entry);
+    EXPECT_EQ(CCanApi::IllegalParameter, retVal);
+    // @- remove a cyclic message with a negative entry
+    retVal = dut1.RemoveCyclicMessage(-1);
+    EXPECT_EQ(CCanApi::IllegalParameter, retVal);
+    // @- remove a cyclic message with an entry beyond the schedule
+    retVal = dut1.RemoveCyclicMessage((int)TOUCAN_TX_SCHEDULE_MAX_ENTRIES);
+    EXPECT_EQ(CCanApi::IllegalParameter, retVal);
+    // @post:
+    // @- tear down DUT1
+    retVal = dut1.TeardownChannel();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @end.
+}
+
+//  $Id$  Copyright (c) UV Software, Berlin.
@@ -0,0 +1,205 @@
+//  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later
+//
+//  CAN Interface API, Version 3 (Testing)
+//
+//  Copyright (c) 2004-2023 Uwe Vogt, UV Software, Berlin (info@uv-software.com)
+//  All rights reserved.
+//
+//  This file is part of CAN API V3.
+//
+//  CAN API V3 is dual-licensed under the BSD 2-Clause "Simplified" License and
+//  under the GNU General Public License v3.0 (or any later version).
+//  You can choose between one of them if you use this file.
+//
+//  BSD 2-Clause "Simplified" License:
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are met:
+//  1. Redistributions of source code must retain the above copyright notice, this
+//     list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  CAN API V3 IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+//  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+//  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+//  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//  OF CAN API V3, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  GNU General Public License v3.0 or later:
+//  CAN API V3 is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  CAN API V3 is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with CAN API V3.  If not, see <http://www.gnu.org/licenses/>.
+//
+//
+#include "pch.h"
+
+#define TEST_BATCH_SIZE  12U  // note: four USB packets with three frames each
+#define TEST_IDENTIFIERS  4U
+
+class TransmitOrder : public testing::Test {
+    virtual void SetUp() {}
+    virtual void TearDown() {}
+protected:
+    // ...
+};
+
+// @gtest TC48.0: Send CAN messages in CAN identifier order (sunnyday scenario)
+//
+// @expected: CANERR_NOERROR and FIFO order per CAN identifier
+//
+TEST_F(TransmitOrder, GTEST_TESTCASE(SunnydayScenario, GTEST_SUNNYDAY)) {
+    CCanDevice dut1 = CCanDevice(TEST_DEVICE(DUT1));
+    CCanDevice dut2 = CCanDevice(TEST_DEVICE(DUT2));
+    CANAPI_Message_t trmMsg[TEST_BATCH_SIZE] = {};
+    CANAPI_Message_t rcvMsg = {};
+    CANAPI_Return_t retVal;
+    uint32_t written = 0U;
+    uint8_t order = TOUCAN_TX_ORDER_PRIORITY;
+    int32_t seqNo[TEST_IDENTIFIERS] = {};
+    // @pre:
+    // @- initialize DUT1 with configured settings
+    retVal = dut1.InitializeChannel();
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.InitializeChannel() failed with error code " << retVal;
+    // @- set transmit order of DUT1 to CAN identifier order
+    retVal = dut1.SetProperty(TOUCAN_PROPERTY_SET_TX_QUEUE_ORDER, (void*)&order, sizeof(uint8_t));
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- start DUT1 with configured bit-rate settings
+    retVal = dut1.StartController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- initialize DUT2 with configured settings
+    retVal = dut2.InitializeChannel();
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut2.InitializeChannel() failed with error code " << retVal;
+    // @- start DUT2 with configured bit-rate settings
+    retVal = dut2.StartController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- issue(PeakCAN): why do we need a delay here?
+    PCBUSB_INIT_DELAY();
+    // @test:
+    // @- DUT1 send out the test frames in batches with descending CAN identifiers
+    int32_t frames = g_Options.GetNumberOfTestFrames();
+    int32_t sent = 0;
+    while (sent < frames) {
+        uint32_t count = 0U;
+        for (; (count < TEST_BATCH_SIZE) && ((sent + (int32_t)count) < frames); count++) {
+            int32_t n = sent + (int32_t)count;
+            trmMsg[count].id = 0x480U + (TEST_IDENTIFIERS - 1U) - ((uint32_t)n % TEST_IDENTIFIERS);
+            trmMsg[count].dlc = CAN_MAX_DLC;
+            trmMsg[count].data[0] = (uint8_t)(n >> 24);
+            trmMsg[count].data[1] = (uint8_t)(n >> 16);
+            trmMsg[count].data[2] = (uint8_t)(n >> 8);
+            trmMsg[count].data[3] = (uint8_t)n;
+        }
+        retVal = dut1.WriteMessages(trmMsg, count, written, TEST_WRITE_TIMEOUT);
+        ASSERT_TRUE((CCanApi::NoError == retVal) || (CCanApi::TransmitterBusy == retVal)) << "[  ERROR!  ] dut1.WriteMessages() failed with error code " << retVal;
+        sent += (int32_t)written;
+    }
+    // @- DUT2 read all messages and check the sequence per CAN identifier
+    int32_t received = 0;
+    for (uint32_t i = 0U; i < TEST_IDENTIFIERS; i++)
+        seqNo[i] = -1;
+    while ((received < frames) && (dut2.ReadMessage(rcvMsg, TEST_READ_TIMEOUT) == CCanApi::NoError)) {
+        int32_t n = ((int32_t)rcvMsg.data[0] << 24) | ((int32_t)rcvMsg.data[1] << 16)
+                  | ((int32_t)rcvMsg.data[2] << 8) | (int32_t)rcvMsg.data[3];
+        ASSERT_LE(0x480U, rcvMsg.id);
+        ASSERT_GT(0x480U + TEST_IDENTIFIERS, rcvMsg.id);
+        EXPECT_LT(seqNo[rcvMsg.id - 0x480U], n);
+        seqNo[rcvMsg.id - 0x480U] = n;
+        received += 1;
+    }
+    EXPECT_EQ(frames, received);
+    // @post:
+    // @- stop/reset DUT1
+    retVal = dut1.ResetController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- tear down DUT1
+    retVal = dut1.TeardownChannel();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- tear down DUT2
+    retVal = dut2.TeardownChannel();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @end.
+}
+
+// @gtest TC48.1: Set the transmit order with an illegal value
+//
+// @expected: CANERR_ILLPARA
+//
+TEST_F(TransmitOrder, GTEST_TESTCASE(WithIllegalValue, GTEST_ENABLED)) {
+    CCanDevice dut1 = CCanDevice(TEST_DEVICE(DUT1));
+    CANAPI_Return_t retVal;
+    uint8_t order = 0xFFU;
+    // @pre:
+    // @- initialize DUT1 with configured settings
+    retVal = dut1.InitializeChannel();
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.InitializeChannel() failed with error code " << retVal;
+    // @test:
+    // @- get the transmit order (default: FIFO)
+    retVal = dut1.GetProperty(TOUCAN_PROPERTY_TX_QUEUE_ORDER, (void*)&order, sizeof(uint8_t));
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    EXPECT_EQ(TOUCAN_TX_ORDER_FIFO, order);
+    // @- set the transmit order to an illegal value
+    order = TOUCAN_TX_ORDER_PRIORITY + 1U;
+    retVal = dut1.SetProperty(TOUCAN_PROPERTY_SET_TX_QUEUE_ORDER, (void*)&order, sizeof(uint8_t));
+    EXPECT_EQ(CCanApi::IllegalParameter, retVal);
+    // @- the transmit order is unchanged
+    retVal = dut1.GetProperty(TOUCAN_PROPERTY_TX_QUEUE_ORDER, (void*)&order, sizeof(uint8_t));
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    EXPECT_EQ(TOUCAN_TX_ORDER_FIFO, order);
+    // @post:
+    // @- tear down DUT1
+    retVal = dut1.TeardownChannel();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @end.
+}
+
+// @gtest TC48.2: Set the transmit order if CAN controller is started
+//
+// @expected: CANERR_ONLINE
+//
+TEST_F(TransmitOrder, GTEST_TESTCASE(IfControllerStarted, GTEST_ENABLED)) {
+    CCanDevice dut1 = CCanDevice(TEST_DEVICE(DUT1));
+    CANAPI_Return_t retVal;
+    uint8_t order = TOUCAN_TX_ORDER_PRIORITY;
+    // @pre:
+    // @- initialize DUT1 with configured settings
+    retVal = dut1.InitializeChannel();
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.InitializeChannel() failed with error code " << retVal;
+    // @- start DUT1 with configured bit-rate settings
+    retVal = dut1.StartController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @test:
+    // @- set the transmit order (controller started)
+    retVal = dut1.SetProperty(TOUCAN_PROPERTY_SET_TX_QUEUE_ORDER, (void*)&order, sizeof(uint8_t));
+    EXPECT_EQ(CCanApi::ControllerOnline, retVal);
+    // @- stop/reset DUT1
+    retVal = dut1.ResetController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- set the transmit order (controller stopped)
+    retVal = dut1.SetProperty(TOUCAN_PROPERTY_SET_TX_QUEUE_ORDER, (void*)&order, sizeof(uint8_t));
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    retVal = dut1.GetProperty(TOUCAN_PROPERTY_TX_QUEUE_ORDER, (void*)&order, sizeof(uint8_t));
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    EXPECT_EQ(TOUCAN_TX_ORDER_PRIORITY, order);
+    // @post:
+    // @- tear down DUT1
+    retVal = dut1.TeardownChannel();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @end.
+}
+
+//  $Id$  Copyright (c) UV Software, Berlin.
@@ -0,0 +1,265 @@
+//  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later
+//
+//  CAN Interface API, Version 3 (Testing)
+//
+//  Copyright (c) 2004-2023 Uwe Vogt, UV Software, Berlin (info@uv-software.com)
+//  All rights reserved.
+//
+//  This file is part of CAN API V3.
+//
+//  CAN API V3 is dual-licensed under the BSD 2-Clause "Simplified" License and
+//  under the GNU General Public License v3.0 (or any later version).
+//  You can choose between one of them if you use this file.
+//
+//  BSD 2-Clause "Simplified" License:
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are met:
+//  1. Redistributions of source code must retain the above copyright notice, this
+//     list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  CAN API V3 IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+//  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+//  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+//  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//  OF CAN API V3, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  GNU General Public License v3.0 or later:
+//  CAN API V3 is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  CAN API V3 is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with CAN API V3.  If not, see <http://www.gnu.org/licenses/>.
+//
+//
+#include "pch.h"
+
+#define TEST_ECHO_FRAMES  100
+
+class TransmitEcho : public testing::Test {
+    virtual void SetUp() {}
+    virtual void TearDown() {}
+protected:
+    // ...
+};
+
+// @gtest TC49.0: Echo of transmitted CAN messages with sequence tag (sunnyday scenario)
+//
+// @expected: CANERR_NOERROR and one echo per CAN message with the same sequence tag
+//
+TEST_F(TransmitEcho, GTEST_TESTCASE(SunnydayScenario, GTEST_SUNNYDAY)) {
+    CCanDevice dut1 = CCanDevice(TEST_DEVICE(DUT1));
+    CCanDevice dut2 = CCanDevice(TEST_DEVICE(DUT2));
+    CANAPI_Message_t trmMsg = {};
+    CANAPI_Message_t rcvMsg = {};
+    CANAPI_Return_t retVal;
+    uint32_t tags[TEST_ECHO_FRAMES] = {};
+    uint32_t tag = 0U;
+    uint64_t echoes = 0U;
+    uint8_t echo = 1U;
+    // @pre:
+    // @- initialize DUT1 with configured settings
+    retVal = dut1.InitializeChannel();
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.InitializeChannel() failed with error code " << retVal;
+    // @- switch on the TX echo of DUT1
+    retVal = dut1.SetProperty(TOUCAN_PROPERTY_SET_TX_ECHO, (void*)&echo, sizeof(uint8_t));
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- start DUT1 with configured bit-rate settings
+    retVal = dut1.StartController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- initialize DUT2 with configured settings
+    retVal = dut2.InitializeChannel();
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut2.InitializeChannel() failed with error code " << retVal;
+    // @- start DUT2 with configured bit-rate settings
+    retVal = dut2.StartController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- issue(PeakCAN): why do we need a delay here?
+    PCBUSB_INIT_DELAY();
+    // @test:
+    // @- DUT1 send out the test frames and remember their sequence tags
+    for (int i = 0; i < TEST_ECHO_FRAMES; i++) {
+        trmMsg.id = 0x490U;
+        trmMsg.dlc = 1U;
+        trmMsg.data[0] = (uint8_t)i;
+        retVal = dut1.WriteMessageTagged(trmMsg, tags[i], TEST_WRITE_TIMEOUT);
+        ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.WriteMessageTagged() failed with error code " << retVal;
+        EXPECT_NE(0U, tags[i]);
+    }
+    // @- DUT1 read the echoes and match them by their sequence tag
+    struct timespec last = {};
+    for (int i = 0; i < TEST_ECHO_FRAMES; i++) {
+        retVal = dut1.ReadMessageTagged(rcvMsg, tag, TEST_READ_TIMEOUT);
+        ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.ReadMessageTagged() failed with error code " << retVal;
+        EXPECT_EQ(tags[i], tag);
+        EXPECT_EQ(0x490U, rcvMsg.id);
+        EXPECT_EQ((uint8_t)i, rcvMsg.data[0]);
+        // @- the time-stamps of the echoes (OUT-completion times) are in ascending order
+        EXPECT_TRUE((last.tv_sec < rcvMsg.timestamp.tv_sec) ||
+                   ((last.tv_sec == rcvMsg.timestamp.tv_sec) && (last.tv_nsec <= rcvMsg.timestamp.tv_nsec)));
+        last = rcvMsg.timestamp;
+    }
+    retVal = dut1.GetProperty(TOUCAN_PROPERTY_TX_ECHO_COUNTER, (void*)&echoes, sizeof(uint64_t));
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    EXPECT_EQ((uint64_t)TEST_ECHO_FRAMES, echoes);
+    // @- DUT2 received all test frames (w/o sequence tag)
+    for (int i = 0; i < TEST_ECHO_FRAMES; i++) {
+        retVal = dut2.ReadMessageTagged(rcvMsg, tag, TEST_READ_TIMEOUT);
+        ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut2.ReadMessageTagged() failed with error code " << retVal;
+        EXPECT_EQ(0U, tag);
+        EXPECT_EQ((uint8_t)i, rcvMsg.data[0]);
+    }
+    // @post:
+    // @- stop/reset DUT1
+    retVal = dut1.ResetController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- tear down DUT1
+    retVal = dut1.TeardownChannel();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- tear down DUT2
+    retVal = dut2.TeardownChannel();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @end.
+}
+
+// @gtest TC49.1: No echo of transmitted CAN messages by default
+//
+// @expected: CANERR_RX_EMPTY
+//
+TEST_F(TransmitEcho, GTEST_TESTCASE(NoEchoByDefault, GTEST_ENABLED)) {
+    CCanDevice dut1 = CCanDevice(TEST_DEVICE(DUT1));
+    CANAPI_Message_t trmMsg = {};
+    CANAPI_Message_t rcvMsg = {};
+    CANAPI_Return_t retVal;
+    uint32_t tag = 0U;
+    uint8_t echo = 0xFFU;
+    // @pre:
+    // @- initialize DUT1 with configured settings
+    retVal = dut1.InitializeChannel();
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.InitializeChannel() failed with error code " << retVal;
+    // @- the TX echo is switched off by default
+    retVal = dut1.GetProperty(TOUCAN_PROPERTY_TX_ECHO, (void*)&echo, sizeof(uint8_t));
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    EXPECT_EQ(0U, echo);
+    // @- start DUT1 with configured bit-rate settings
+    retVal = dut1.StartController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @test:
+    // @- DUT1 send a message (it gets a sequence tag anyway)
+    trmMsg.id = 0x491U;
+    retVal = dut1.WriteMessageTagged(trmMsg, tag, TEST_WRITE_TIMEOUT);
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    EXPECT_NE(0U, tag);
+    // @- DUT1 does not receive an echo
+    retVal = dut1.ReadMessageTagged(rcvMsg, tag, TEST_READ_TIMEOUT);
+    EXPECT_EQ(CCanApi::ReceiverEmpty, retVal);
+    // @- switch on the TX echo (controller started)
+    echo = 1U;
+    retVal = dut1.SetProperty(TOUCAN_PROPERTY_SET_TX_ECHO, (void*)&echo, sizeof(uint8_t));
+    EXPECT_EQ(CCanApi::ControllerOnline, retVal);
+    // @post:
+    // @- stop/reset DUT1
+    retVal = dut1.ResetController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- switch on the TX echo with an illegal value (controller stopped)
+    echo = 2U;
+    retVal = dut1.SetProperty(TOUCAN_PROPERTY_SET_TX_ECHO, (void*)&echo, sizeof(uint8_t));
+    EXPECT_EQ(CCanApi::IllegalParameter, retVal);
+    // @- tear down DUT1
+    retVal = dut1.TeardownChannel();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @end.
+}
+
+// @gtest TC49.2: TX echoes are dropped by the read functions w/o sequence tag
+//
+// @expected: CANERR_RX_EMPTY for the echoes, and the received messages in order
+//
+TEST_F(TransmitEcho, GTEST_TESTCASE(NoEchoInUntaggedRead, GTEST_ENABLED)) {
+    CCanDevice dut1 = CCanDevice(TEST_DEVICE(DUT1));
+    CCanDevice dut2 = CCanDevice(TEST_DEVICE(DUT2));
+    CANAPI_Message_t trmMsg = {};
+    CANAPI_Message_t rcvMsg = {};
+    CANAPI_Message_t rcvMsgs[4] = {};
+    CANAPI_Return_t retVal;
+    uint32_t count = 0U;
+    uint32_t tag = 0U;
+    uint64_t echoes = 0U;
+    uint8_t echo = 1U;
+    // @pre:
+    // @- initialize DUT1 with configured settings
+    retVal = dut1.InitializeChannel();
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.InitializeChannel() failed with error code " << retVal;
+    // @- switch on the TX echo of DUT1
+    retVal = dut1.SetProperty(TOUCAN_PROPERTY_SET_TX_ECHO, (void*)&echo, sizeof(uint8_t));
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- start DUT1 with configured bit-rate settings
+    retVal = dut1.StartController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- initialize DUT2 with configured settings
+    retVal = dut2.InitializeChannel();
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut2.InitializeChannel() failed with error code " << retVal;
+    // @- start DUT2 with configured bit-rate settings
+    retVal = dut2.StartController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- issue(PeakCAN): why do we need a delay here?
+    PCBUSB_INIT_DELAY();
+    // @test:
+    // @- DUT1 send a message, its echo is not returned by ReadMessage
+    trmMsg.id = 0x492U;
+    trmMsg.dlc = 1U;
+    trmMsg.data[0] = 0x01U;
+    retVal = dut1.WriteMessageTagged(trmMsg, tag, TEST_WRITE_TIMEOUT);
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.WriteMessageTagged() failed with error code " << retVal;
+    retVal = dut1.ReadMessage(rcvMsg, TEST_READ_TIMEOUT);
+    EXPECT_EQ(CCanApi::ReceiverEmpty, retVal);
+    // @- DUT1 send a message, its echo is not returned by ReadMessages
+    trmMsg.data[0] = 0x02U;
+    retVal = dut1.WriteMessageTagged(trmMsg, tag, TEST_WRITE_TIMEOUT);
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.WriteMessageTagged() failed with error code " << retVal;
+    retVal = dut1.ReadMessages(rcvMsgs, 4U, count, TEST_READ_TIMEOUT);
+    EXPECT_EQ(CCanApi::ReceiverEmpty, retVal);
+    EXPECT_EQ(0U, count);
+    // @- DUT2 send a message after an echo of DUT1, DUT1 reads only the former
+    trmMsg.data[0] = 0x03U;
+    retVal = dut1.WriteMessageTagged(trmMsg, tag, TEST_WRITE_TIMEOUT);
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.WriteMessageTagged() failed with error code " << retVal;
+    trmMsg.id = 0x493U;
+    trmMsg.data[0] = 0x04U;
+    retVal = dut2.WriteMessage(trmMsg, TEST_WRITE_TIMEOUT);
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut2.WriteMessage() failed with error code " << retVal;
+    retVal = dut1.ReadMessage(rcvMsg, TEST_READ_TIMEOUT);
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.ReadMessage() failed with error code " << retVal;
+    EXPECT_EQ(0x493U, rcvMsg.id);
+    EXPECT_EQ(0x04U, rcvMsg.data[0]);
+    // @- the echoes have been received (and dropped)
+    retVal = dut1.GetProperty(TOUCAN_PROPERTY_TX_ECHO_COUNTER, (void*)&echoes, sizeof(uint64_t));
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    EXPECT_EQ(3U, echoes);
+    // @post:
+    // @- stop/reset DUT1
+    retVal = dut1.ResetController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- tear down DUT1
+    retVal = dut1.TeardownChannel();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- tear down DUT2
+    retVal = dut2.TeardownChannel();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @end.
+}
+
+//  $Id$  Copyright (c) UV Software, Berlin.
@@ -0,0 +1,168 @@
+//  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later
+//
+//  CAN Interface API, Version 3 (Testing)
+//
+//  Copyright (c) 2004-2023 Uwe Vogt, UV Software, Berlin (info@uv-software.com)
+//  All rights reserved.
+//
+//  This file is part of CAN API V3.
+//
+//  CAN API V3 is dual-licensed under the BSD 2-Clause "Simplified" License and
+//  under the GNU General Public License v3.0 (or any later version).
+//  You can choose between one of them if you use this file.
+//
+//  BSD 2-Clause "Simplified" License:
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are met:
+//  1. Redistributions of source code must retain the above copyright notice, this
+//     list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  CAN API V3 IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+//  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+//  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+//  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//  OF CAN API V3, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  GNU General Public License v3.0 or later:
+//  CAN API V3 is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  CAN API V3 is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with CAN API V3.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include "pch.h"
+
+#include <time.h>
+
+#define TEST_SYNC_FRAMES  40
+#define TEST_SYNC_DELAY   50  // in [ms] (2 seconds in total)
+
+static uint64_t MonotonicTime(void) {
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000U) + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t Timestamp(const CANAPI_Message_t &msg) {
+    return ((uint64_t)msg.timestamp.tv_sec * 1000000000U) + (uint64_t)msg.timestamp.tv_nsec;
+}
+
+class ClockSync : public testing::Test {
+    virtual void SetUp() {}
+    virtual void TearDown() {}
+protected:
+    // ...
+};
+
+// @gtest TC50.0: Time-stamps of received CAN messages in system time (sunnyday scenario)
+//
+// @expected: CANERR_NOERROR and time-stamps between sending and reading (monotonic clock)
+//
+TEST_F(ClockSync, GTEST_TESTCASE(SunnydayScenario, GTEST_SUNNYDAY)) {
+    CCanDevice dut1 = CCanDevice(TEST_DEVICE(DUT1));
+    CCanDevice dut2 = CCanDevice(TEST_DEVICE(DUT2));
+    CANAPI_Message_t trmMsg = {};
+    CANAPI_Message_t rcvMsg = {};
+    CANAPI_Return_t retVal;
+    toucan_clock_sync_t sync = {};
+    uint64_t last = 0U;
+    // @pre:
+    // @- initialize DUT1 with configured settings
+    retVal = dut1.InitializeChannel();
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.InitializeChannel() failed with error code " << retVal;
+    // @- start DUT1 with configured bit-rate settings
+    retVal = dut1.StartController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- initialize DUT2 with configured settings
+    retVal = dut2.InitializeChannel();
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut2.InitializeChannel() failed with error code " << retVal;
+    // @- start DUT2 with configured bit-rate settings
+    retVal = dut2.StartController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- issue(PeakCAN): why do we need a delay here?
+    PCBUSB_INIT_DELAY();
+    // @test:
+    for (int i = 0; i < TEST_SYNC_FRAMES; i++) {
+        // @- DUT2 send a test frame (remember the system time)
+        trmMsg.id = 0x500U;
+        trmMsg.dlc = 1U;
+        trmMsg.data[0] = (uint8_t)i;
+        uint64_t sent = MonotonicTime();
+        retVal = dut2.WriteMessage(trmMsg, TEST_WRITE_TIMEOUT);
+        ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut2.WriteMessage() failed with error code " << retVal;
+        // @- DUT1 read the test frame
+        retVal = dut1.ReadMessage(rcvMsg, TEST_READ_TIMEOUT);
+        ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.ReadMessage() failed with error code " << retVal;
+        uint64_t read = MonotonicTime();
+        EXPECT_EQ((uint8_t)i, rcvMsg.data[0]);
+        // @- the time-stamp is between sending and reading (with a tolerance of 1ms)
+        EXPECT_LE(sent, Timestamp(rcvMsg) + 1000000U);
+        EXPECT_GE(read + 1000000U, Timestamp(rcvMsg));
+        // @- the time-stamps are in ascending order
+        EXPECT_LE(last, Timestamp(rcvMsg));
+        last = Timestamp(rcvMsg);
+        CTimer::Delay((uint64_t)TEST_SYNC_DELAY * CTimer::MSEC);
+    }
+    // @- DUT1 has got samples for the time synchronization
+    retVal = dut1.GetProperty(TOUCAN_PROPERTY_CLOCK_SYNC, (void*)&sync, sizeof(toucan_clock_sync_t));
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    EXPECT_LE(2U, sync.samples);
+    EXPECT_EQ(0U, sync.resyncs);
+    // @post:
+    // @- stop/reset DUT1
+    retVal = dut1.ResetController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- tear down DUT1
+    retVal = dut1.TeardownChannel();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- tear down DUT2
+    retVal = dut2.TeardownChannel();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @end.
+}
+
+// @gtest TC50.1: Quality of the time synchronization without CAN traffic
+//
+// @expected: CANERR_NOERROR and no samples
+//
+TEST_F(ClockSync, GTEST_TESTCASE(NotSynchronized, GTEST_ENABLED)) {
+    CCanDevice dut1 = CCanDevice(TEST_DEVICE(DUT1));
+    CANAPI_Return_t retVal;
+    toucan_clock_sync_t sync = {};
+    // @pre:
+    // @- initialize DUT1 with configured settings
+    retVal = dut1.InitializeChannel();
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.InitializeChannel() failed with error code " << retVal;
+    // @test:
+    // @- no samples before the first CAN message is received
+    sync.samples = 0xFFFFFFFFU;
+    retVal = dut1.GetProperty(TOUCAN_PROPERTY_CLOCK_SYNC, (void*)&sync, sizeof(toucan_clock_sync_t));
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    EXPECT_EQ(0U, sync.samples);
+    EXPECT_EQ(0, sync.drift);
+    // @- the property value must be large enough
+    retVal = dut1.GetProperty(TOUCAN_PROPERTY_CLOCK_SYNC, (void*)&sync, sizeof(uint32_t));
+    EXPECT_NE(CCanApi::NoError, retVal);
+    // @post:
+    // @- tear down DUT1
+    retVal = dut1.TeardownChannel();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @end.
+}
+
+//  $Id$  Copyright (c) UV Software, Berlin.
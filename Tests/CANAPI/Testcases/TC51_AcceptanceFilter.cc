@@ -0,0 +1,197 @@
+//  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later
+//
+//  CAN Interface API, Version 3 (Testing)
+//
+//  Copyright (c) 2004-2023 Uwe Vogt, UV Software, Berlin (info@uv-software.com)
+//  All rights reserved.
+//
+//  This file is part of CAN API V3.
+//
+//  CAN API V3 is dual-licensed under the BSD 2-Clause "Simplified" License and
+//  under the GNU General Public License v3.0 (or any later version).
+//  You can choose between one of them if you use this file.
+//
+//  BSD 2-Clause "Simplified" License:
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are met:
+//  1. Redistributions of source code must retain the above copyright notice, this
+//     list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  CAN API V3 IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+//  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+//  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+//  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//  OF CAN API V3, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  GNU General Public License v3.0 or later:
+//  CAN API V3 is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  CAN API V3 is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with CAN API V3.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include "pch.h"
+
+class AcceptanceFilter : public testing::Test {
+    virtual void SetUp() {}
+    virtual void TearDown() {}
+protected:
+    // ...
+};
+
+// @gtest TC51.0: Acceptance filter for 11-bit identifiers by code and mask (sunnyday scenario)
+//
+// @expected: CANERR_NOERROR and only CAN messages matching code and mask are received
+//
+TEST_F(AcceptanceFilter, GTEST_TESTCASE(SunnydayScenario, GTEST_SUNNYDAY)) {
+    CCanDevice dut1 = CCanDevice(TEST_DEVICE(DUT1));
+    CCanDevice dut2 = CCanDevice(TEST_DEVICE(DUT2));
+    CANAPI_Message_t trmMsg = {};
+    CANAPI_Message_t rcvMsg = {};
+    CANAPI_Return_t retVal;
+    int32_t code = -1, mask = -1;
+    // @pre:
+    // @- initialize DUT1 with configured settings
+    retVal = dut1.InitializeChannel();
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.InitializeChannel() failed with error code " << retVal;
+    // @- all CAN messages are accepted by default
+    retVal = dut1.GetProperty(CANPROP_GET_FLT_11BIT_MASK, (void*)&mask, sizeof(int32_t));
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    EXPECT_EQ(0, mask);
+    // @- DUT1 accept identifiers 0x510 to 0x51F only
+    retVal = dut1.SetFilter(false, 0x510U, 0x7F0U);
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    retVal = dut1.GetProperty(CANPROP_GET_FLT_11BIT_CODE, (void*)&code, sizeof(int32_t));
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    EXPECT_EQ(0x510, code);
+    retVal = dut1.GetProperty(CANPROP_GET_FLT_11BIT_MASK, (void*)&mask, sizeof(int32_t));
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    EXPECT_EQ(0x7F0, mask);
+    // @- start DUT1 with configured bit-rate settings
+    retVal = dut1.StartController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- initialize DUT2 with configured settings
+    retVal = dut2.InitializeChannel();
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut2.InitializeChannel() failed with error code " << retVal;
+    // @- start DUT2 with configured bit-rate settings
+    retVal = dut2.StartController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- issue(PeakCAN): why do we need a delay here?
+    PCBUSB_INIT_DELAY();
+    // @test:
+    // @- DUT2 send identifiers 0x500 to 0x52F
+    for (uint32_t id = 0x500U; id < 0x530U; id++) {
+        trmMsg.id = id;
+        trmMsg.dlc = 0U;
+        retVal = dut2.WriteMessage(trmMsg, TEST_WRITE_TIMEOUT);
+        ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut2.WriteMessage() failed with error code " << retVal;
+    }
+    // @- DUT1 receive identifiers 0x510 to 0x51F only
+    for (uint32_t id = 0x510U; id < 0x520U; id++) {
+        retVal = dut1.ReadMessage(rcvMsg, TEST_READ_TIMEOUT);
+        ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.ReadMessage() failed with error code " << retVal;
+        EXPECT_EQ(id, rcvMsg.id);
+    }
+    retVal = dut1.ReadMessage(rcvMsg, TEST_READ_TIMEOUT);
+    EXPECT_EQ(CCanApi::ReceiverEmpty, retVal);
+    // @- the filter cannot be changed when started
+    retVal = dut1.SetFilter(false, 0x000U, 0x000U);
+    EXPECT_EQ(CCanApi::ControllerOnline, retVal);
+    // @post:
+    // @- stop/reset DUT1
+    retVal = dut1.ResetController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- tear down DUT1
+    retVal = dut1.TeardownChannel();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- tear down DUT2
+    retVal = dut2.TeardownChannel();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @end.
+}
+
+// @gtest TC51.1: Acceptance filter by a list of identifiers
+//
+// @expected: CANERR_NOERROR and only CAN messages from the list are received
+//
+TEST_F(AcceptanceFilter, GTEST_TESTCASE(ListOfIdentifiers, GTEST_ENABLED)) {
+    CCanDevice dut1 = CCanDevice(TEST_DEVICE(DUT1));
+    CCanDevice dut2 = CCanDevice(TEST_DEVICE(DUT2));
+    CANAPI_Message_t trmMsg = {};
+    CANAPI_Message_t rcvMsg = {};
+    CANAPI_Return_t retVal;
+    const uint32_t ids[] = { 0x7E8U, 0x7DFU, 0x7E0U };
+    // @pre:
+    // @- initialize DUT1 with configured settings
+    retVal = dut1.InitializeChannel();
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.InitializeChannel() failed with error code " << retVal;
+    // @- DUT1 accept the listed 11-bit identifiers and no 29-bit identifier
+    retVal = dut1.SetFilterList(false, ids, 3U);
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    retVal = dut1.SetFilterList(true, NULL, 0U);
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- start DUT1 with configured bit-rate settings
+    retVal = dut1.StartController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- initialize DUT2 with configured settings
+    retVal = dut2.InitializeChannel();
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut2.InitializeChannel() failed with error code " << retVal;
+    // @- start DUT2 with configured bit-rate settings
+    retVal = dut2.StartController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- issue(PeakCAN): why do we need a delay here?
+    PCBUSB_INIT_DELAY();
+    // @test:
+    // @- DUT2 send identifiers 0x7C0 to 0x7FF (11-bit and 29-bit)
+    for (uint32_t id = 0x7C0U; id <= 0x7FFU; id++) {
+        trmMsg.id = id;
+        trmMsg.xtd = 0;
+        retVal = dut2.WriteMessage(trmMsg, TEST_WRITE_TIMEOUT);
+        ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut2.WriteMessage() failed with error code " << retVal;
+        trmMsg.xtd = 1;
+        retVal = dut2.WriteMessage(trmMsg, TEST_WRITE_TIMEOUT);
+        ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut2.WriteMessage() failed with error code " << retVal;
+    }
+    // @- DUT1 receive the listed 11-bit identifiers only
+    const uint32_t expected[] = { 0x7DFU, 0x7E0U, 0x7E8U };
+    for (int i = 0; i < 3; i++) {
+        retVal = dut1.ReadMessage(rcvMsg, TEST_READ_TIMEOUT);
+        ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.ReadMessage() failed with error code " << retVal;
+        EXPECT_EQ(expected[i], rcvMsg.id);
+        EXPECT_EQ(0, rcvMsg.xtd);
+    }
+    retVal = dut1.ReadMessage(rcvMsg, TEST_READ_TIMEOUT);
+    EXPECT_EQ(CCanApi::ReceiverEmpty, retVal);
+    // @post:
+    // @- stop/reset DUT1
+    retVal = dut1.ResetController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- illegal identifier in the list (controller stopped)
+    const uint32_t illegal[] = { 0x800U };
+    retVal = dut1.SetFilterList(false, illegal, 1U);
+    EXPECT_EQ(CCanApi::IllegalParameter, retVal);
+    // @- tear down DUT1
+    retVal = dut1.TeardownChannel();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- tear down DUT2
+    retVal = dut2.TeardownChannel();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @end.
+}
+
+//  $Id$  Copyright (c) UV Software, Berlin.
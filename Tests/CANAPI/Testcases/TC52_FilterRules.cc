@@ -0,0 +1,214 @@
+//  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later
+//
+//  CAN Interface API, Version 3 (Testing)
+//
+//  Copyright (c) 2004-2023 Uwe Vogt, UV Software, Berlin (info@uv-software.com)
+//  All rights reserved.
+//
+//  This file is part of CAN API V3.
+//
+//  CAN API V3 is dual-licensed under the BSD 2-Clause "Simplified" License and
+//  under the GNU General Public License v3.0 (or any later version).
+//  You can choose between one of them if you use this file.
+//
+//  BSD 2-Clause "Simplified" License:
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are met:
+//  1. Redistributions of source code must retain the above copyright notice, this
+//     list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  CAN API V3 IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+//  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+//  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+//  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//  OF CAN API V3, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  GNU General Public License v3.0 or later:
+//  CAN API V3 is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  CAN API V3 is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with CAN API V3.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include "pch.h"
+
+class FilterRules : public testing::Test {
+    virtual void SetUp() {}
+    virtual void TearDown() {}
+protected:
+    // ...
+};
+
+// @gtest TC52.0: Filter rules for identifier ranges (sunnyday scenario)
+//
+// @expected: CANERR_NOERROR and only CAN messages within the ranges are received
+//
+TEST_F(FilterRules, GTEST_TESTCASE(SunnydayScenario, GTEST_SUNNYDAY)) {
+    CCanDevice dut1 = CCanDevice(TEST_DEVICE(DUT1));
+    CCanDevice dut2 = CCanDevice(TEST_DEVICE(DUT2));
+    CANAPI_Message_t trmMsg = {};
+    CANAPI_Message_t rcvMsg = {};
+    CANAPI_Return_t retVal;
+    toucan_filter_rule_t rules[3] = {};
+    uint64_t before = 0U, after = 0U;
+    // @pre:
+    // @- initialize DUT1 with configured settings
+    retVal = dut1.InitializeChannel();
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.InitializeChannel() failed with error code " << retVal;
+    // @- DUT1 accept 11-bit identifiers 0x100 to 0x10F and 29-bit identifiers 0x100 to 0x103 and 0x120 to 0x12F
+    rules[0].first = 0x100U; rules[0].last = 0x10FU; rules[0].xtd = 0U;
+    rules[1].first = 0x120U; rules[1].last = 0x12FU; rules[1].xtd = 1U;
+    rules[2].first = 0x100U; rules[2].last = 0x103U; rules[2].xtd = 1U;
+    retVal = dut1.SetFilterRules(rules, 3U);
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- get the number of CAN messages rejected so far
+    retVal = dut1.GetProperty(TOUCAN_PROPERTY_FILTER_REJECTED, (void*)&before, sizeof(uint64_t));
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- start DUT1 with configured bit-rate settings
+    retVal = dut1.StartController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- initialize DUT2 with configured settings
+    retVal = dut2.InitializeChannel();
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut2.InitializeChannel() failed with error code " << retVal;
+    // @- start DUT2 with configured bit-rate settings
+    retVal = dut2.StartController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- issue(PeakCAN): why do we need a delay here?
+    PCBUSB_INIT_DELAY();
+    // @test:
+    // @- DUT2 send identifiers 0x100 to 0x13F (11-bit and 29-bit)
+    for (uint32_t id = 0x100U; id < 0x140U; id++) {
+        trmMsg.id = id;
+        trmMsg.xtd = 0;
+        retVal = dut2.WriteMessage(trmMsg, TEST_WRITE_TIMEOUT);
+        ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut2.WriteMessage() failed with error code " << retVal;
+        trmMsg.xtd = 1;
+        retVal = dut2.WriteMessage(trmMsg, TEST_WRITE_TIMEOUT);
+        ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut2.WriteMessage() failed with error code " << retVal;
+    }
+    // @- DUT1 receive the identifiers within the ranges only
+    for (uint32_t id = 0x100U; id < 0x140U; id++) {
+        if (id < 0x110U) {
+            retVal = dut1.ReadMessage(rcvMsg, TEST_READ_TIMEOUT);
+            ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.ReadMessage() failed with error code " << retVal;
+            EXPECT_EQ(id, rcvMsg.id);
+            EXPECT_EQ(0, rcvMsg.xtd);
+        }
+        if ((id < 0x104U) || ((0x120U <= id) && (id < 0x130U))) {
+            retVal = dut1.ReadMessage(rcvMsg, TEST_READ_TIMEOUT);
+            ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.ReadMessage() failed with error code " << retVal;
+            EXPECT_EQ(id, rcvMsg.id);
+            EXPECT_EQ(1, rcvMsg.xtd);
+        }
+    }
+    retVal = dut1.ReadMessage(rcvMsg, TEST_READ_TIMEOUT);
+    EXPECT_EQ(CCanApi::ReceiverEmpty, retVal);
+    // @- the rejected CAN messages are counted
+    retVal = dut1.GetProperty(TOUCAN_PROPERTY_FILTER_REJECTED, (void*)&after, sizeof(uint64_t));
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    EXPECT_EQ(128U - 36U, after - before);
+    // @- the rules cannot be changed when started
+    retVal = dut1.SetFilterRules(NULL, 0U);
+    EXPECT_EQ(CCanApi::ControllerOnline, retVal);
+    // @post:
+    // @- stop/reset DUT1
+    retVal = dut1.ResetController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- tear down DUT1
+    retVal = dut1.TeardownChannel();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- tear down DUT2
+    retVal = dut2.TeardownChannel();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @end.
+}
+
+// @gtest TC52.1: Filter rules with payload predicates
+//
+// @expected: CANERR_NOERROR and only CAN messages with a matching payload are received
+//
+TEST_F(FilterRules, GTEST_TESTCASE(PayloadPredicates, GTEST_ENABLED)) {
+    CCanDevice dut1 = CCanDevice(TEST_DEVICE(DUT1));
+    CCanDevice dut2 = CCanDevice(TEST_DEVICE(DUT2));
+    CANAPI_Message_t trmMsg = {};
+    CANAPI_Message_t rcvMsg = {};
+    CANAPI_Return_t retVal;
+    toucan_filter_rule_t rule = {};
+    // @pre:
+    // @- initialize DUT1 with configured settings
+    retVal = dut1.InitializeChannel();
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.InitializeChannel() failed with error code " << retVal;
+    // @- DUT1 accept identifier 0x7E8 with at least 2 data bytes and 0x41 in the 2nd data byte
+    rule.first = rule.last = 0x7E8U;
+    rule.dlc = 2U;
+    rule.code[1] = 0x41U;
+    rule.mask[1] = 0xFFU;
+    retVal = dut1.SetFilterRules(&rule, 1U);
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- start DUT1 with configured bit-rate settings
+    retVal = dut1.StartController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- initialize DUT2 with configured settings
+    retVal = dut2.InitializeChannel();
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut2.InitializeChannel() failed with error code " << retVal;
+    // @- start DUT2 with configured bit-rate settings
+    retVal = dut2.StartController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- issue(PeakCAN): why do we need a delay here?
+    PCBUSB_INIT_DELAY();
+    // @test:
+    // @- DUT2 send identifier 0x7E8 with 2nd data byte 0x40 to 0x42 and dlc 1 to 2
+    trmMsg.id = 0x7E8U;
+    for (uint8_t dlc = 1U; dlc <= 2U; dlc++) {
+        for (uint8_t data = 0x40U; data <= 0x42U; data++) {
+            trmMsg.dlc = dlc;
+            trmMsg.data[0] = dlc;
+            trmMsg.data[1] = data;
+            retVal = dut2.WriteMessage(trmMsg, TEST_WRITE_TIMEOUT);
+            ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut2.WriteMessage() failed with error code " << retVal;
+        }
+    }
+    // @- DUT1 receive the CAN message with dlc 2 and 2nd data byte 0x41 only
+    retVal = dut1.ReadMessage(rcvMsg, TEST_READ_TIMEOUT);
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.ReadMessage() failed with error code " << retVal;
+    EXPECT_EQ(0x7E8U, rcvMsg.id);
+    EXPECT_EQ(2U, rcvMsg.dlc);
+    EXPECT_EQ(0x41U, rcvMsg.data[1]);
+    retVal = dut1.ReadMessage(rcvMsg, TEST_READ_TIMEOUT);
+    EXPECT_EQ(CCanApi::ReceiverEmpty, retVal);
+    // @post:
+    // @- stop/reset DUT1
+    retVal = dut1.ResetController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- illegal rule (range reversed, controller stopped)
+    rule.first = 0x7E8U; rule.last = 0x7E0U;
+    retVal = dut1.SetFilterRules(&rule, 1U);
+    EXPECT_EQ(CCanApi::IllegalParameter, retVal);
+    // @- remove the rules
+    retVal = dut1.SetFilterRules(NULL, 0U);
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- tear down DUT1
+    retVal = dut1.TeardownChannel();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- tear down DUT2
+    retVal = dut2.TeardownChannel();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @end.
+}
+
+//  $Id$  Copyright (c) UV Software, Berlin.
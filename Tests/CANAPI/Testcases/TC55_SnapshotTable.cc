@@ -0,0 +1,153 @@
+//  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later
+//
+//  CAN Interface API, Version 3 (Testing)
+//
+//  Copyright (c) 2004-2023 Uwe Vogt, UV Software, Berlin (info@uv-software.com)
+//  All rights reserved.
+//
+//  This file is part of CAN API V3.
+//
+//  CAN API V3 is dual-licensed under the BSD 2-Clause "Simplified" License and
+//  under the GNU General Public License v3.0 (or any later version).
+//  You can choose between one of them if you use this file.
+//
+//  BSD 2-Clause "Simplified" License:
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are met:
+//  1. Redistributions of source code must retain the above copyright notice, this
+//     list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  CAN API V3 IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+//  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+//  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+//  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//  OF CAN API V3, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  GNU General Public License v3.0 or later:
+//  CAN API V3 is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  CAN API V3 is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with CAN API V3.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include "pch.h"
+
+class SnapshotTable : public testing::Test {
+    virtual void SetUp() {}
+    virtual void TearDown() {}
+protected:
+    // ...
+};
+
+// @gtest TC55.0: Latest CAN message per identifier (sunnyday scenario)
+//
+// @expected: CANERR_NOERROR and the latest CAN message of each identifier is in the table
+//
+TEST_F(SnapshotTable, GTEST_TESTCASE(SunnydayScenario, GTEST_SUNNYDAY)) {
+    CCanDevice dut1 = CCanDevice(TEST_DEVICE(DUT1));
+    CCanDevice dut2 = CCanDevice(TEST_DEVICE(DUT2));
+    CANAPI_Message_t trmMsg = {};
+    CANAPI_Message_t rcvMsg = {};
+    CANAPI_Message_t table[8] = {};
+    uint64_t counters[8] = {};
+    uint64_t counter = 0U;
+    uint32_t count = 0U;
+    CANAPI_Return_t retVal;
+    toucan_snapshot_t snapshot = {};
+    // @pre:
+    // @- initialize DUT1 with configured settings
+    retVal = dut1.InitializeChannel();
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.InitializeChannel() failed with error code " << retVal;
+    // @- DUT1 the snapshot table is disabled by default
+    retVal = dut1.ReadLatest(0x100U, false, rcvMsg, counter);
+    EXPECT_EQ(CCanApi::NotSupported, retVal);
+    // @- DUT1 enable the snapshot table (with up to 16 29-bit identifiers)
+    snapshot.enabled = 1U;
+    snapshot.xtd_ids = 16U;
+    retVal = dut1.SetProperty(TOUCAN_PROPERTY_SET_SNAPSHOT, (void*)&snapshot, sizeof(toucan_snapshot_t));
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.SetProperty() failed with error code " << retVal;
+    // @- start DUT1 with configured bit-rate settings
+    retVal = dut1.StartController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- initialize DUT2 with configured settings
+    retVal = dut2.InitializeChannel();
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut2.InitializeChannel() failed with error code " << retVal;
+    // @- start DUT2 with configured bit-rate settings
+    retVal = dut2.StartController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- issue(PeakCAN): why do we need a delay here?
+    PCBUSB_INIT_DELAY();
+    // @test:
+    // @- DUT2 send 10 CAN messages with 11-bit identifier 100h and 29-bit identifier 1000000h
+    for (uint32_t i = 0U; i < 10U; i++) {
+        trmMsg.id = 0x100U;
+        trmMsg.xtd = 0;
+        trmMsg.dlc = 1U;
+        trmMsg.data[0] = (uint8_t)i;
+        retVal = dut2.WriteMessage(trmMsg, TEST_WRITE_TIMEOUT);
+        ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut2.WriteMessage() failed with error code " << retVal;
+        trmMsg.id = 0x1000000U;
+        trmMsg.xtd = 1;
+        retVal = dut2.WriteMessage(trmMsg, TEST_WRITE_TIMEOUT);
+        ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut2.WriteMessage() failed with error code " << retVal;
+    }
+    // @- DUT1 receive them all (the receive queue is not affected by the table)
+    for (uint32_t i = 0U; i < 20U; i++) {
+        retVal = dut1.ReadMessage(rcvMsg, TEST_READ_TIMEOUT);
+        ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.ReadMessage() failed with error code " << retVal;
+    }
+    // @- DUT1 the latest CAN message of 11-bit identifier 100h
+    retVal = dut1.ReadLatest(0x100U, false, rcvMsg, counter);
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.ReadLatest() failed with error code " << retVal;
+    EXPECT_EQ(0x100U, rcvMsg.id);
+    EXPECT_EQ(9U, rcvMsg.data[0]);
+    EXPECT_EQ(10U, counter);
+    // @- DUT1 the latest CAN message of 29-bit identifier 1000000h
+    retVal = dut1.ReadLatest(0x1000000U, true, rcvMsg, counter);
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.ReadLatest() failed with error code " << retVal;
+    EXPECT_EQ(0x1000000U, rcvMsg.id);
+    EXPECT_TRUE(rcvMsg.xtd);
+    EXPECT_EQ(9U, rcvMsg.data[0]);
+    EXPECT_EQ(10U, counter);
+    // @- DUT1 nothing received with 11-bit identifier 101h
+    retVal = dut1.ReadLatest(0x101U, false, rcvMsg, counter);
+    EXPECT_EQ(CCanApi::ReceiverEmpty, retVal);
+    // @- DUT1 read the whole table (11-bit identifiers first)
+    retVal = dut1.ReadSnapshot(table, counters, 8U, count);
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.ReadSnapshot() failed with error code " << retVal;
+    EXPECT_EQ(2U, count);
+    EXPECT_EQ(0x100U, table[0].id);
+    EXPECT_EQ(0x1000000U, table[1].id);
+    EXPECT_EQ(10U, counters[1]);
+    // @- DUT1 the table cannot be changed while the CAN controller is running
+    retVal = dut1.SetProperty(TOUCAN_PROPERTY_SET_SNAPSHOT, (void*)&snapshot, sizeof(toucan_snapshot_t));
+    EXPECT_EQ(CCanApi::ControllerOnline, retVal);
+    // @post:
+    // @- stop/reset DUT1
+    retVal = dut1.ResetController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- tear down DUT1
+    retVal = dut1.TeardownChannel();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- tear down DUT2
+    retVal = dut2.TeardownChannel();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @end.
+}
+
+//  $Id$  Copyright (c) UV Software, Berlin.
@@ -0,0 +1,142 @@
+//  SPDX-License-Identifier: BSD-2-Clause OR GPL-3.0-or-later
+//
+//  CAN Interface API, Version 3 (Testing)
+//
+//  Copyright (c) 2004-2023 Uwe Vogt, UV Software, Berlin (info@uv-software.com)
+//  All rights reserved.
+//
+//  This file is part of CAN API V3.
+//
+//  CAN API V3 is dual-licensed under the BSD 2-Clause "Simplified" License and
+//  under the GNU General Public License v3.0 (or any later version).
+//  You can choose between one of them if you use this file.
+//
+//  BSD 2-Clause "Simplified" License:
+//  Redistribution and use in source and binary forms, with or without
+//  modification, are permitted provided that the following conditions are met:
+//  1. Redistributions of source code must retain the above copyright notice, this
+//     list of conditions and the following disclaimer.
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  CAN API V3 IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+//  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+//  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+//  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+//  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//  OF CAN API V3, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//  GNU General Public License v3.0 or later:
+//  CAN API V3 is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  CAN API V3 is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with CAN API V3.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include "pch.h"
+
+class TrafficStatistics : public testing::Test {
+    virtual void SetUp() {}
+    virtual void TearDown() {}
+protected:
+    // ...
+};
+
+// @gtest TC56.0: Traffic statistics per identifier (sunnyday scenario)
+//
+// @expected: CANERR_NOERROR and each received identifier is accounted with its frames and timing
+//
+TEST_F(TrafficStatistics, GTEST_TESTCASE(SunnydayScenario, GTEST_SUNNYDAY)) {
+    CCanDevice dut1 = CCanDevice(TEST_DEVICE(DUT1));
+    CCanDevice dut2 = CCanDevice(TEST_DEVICE(DUT2));
+    CANAPI_Message_t trmMsg = {};
+    CANAPI_Message_t rcvMsg = {};
+    CANAPI_Return_t retVal;
+    toucan_id_stats_setup_t setup = {};
+    toucan_id_stats_t entries[8] = {};
+    toucan_id_stats_list_t list = {};
+    // @pre:
+    // @- initialize DUT1 with configured settings
+    retVal = dut1.InitializeChannel();
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.InitializeChannel() failed with error code " << retVal;
+    // @- DUT1 enable the traffic statistics (with up to 8 29-bit identifiers)
+    setup.enabled = 1U;
+    setup.xtd_ids = 8U;
+    retVal = dut1.SetProperty(TOUCAN_PROPERTY_SET_ID_STATS, (void*)&setup, sizeof(toucan_id_stats_setup_t));
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.SetProperty() failed with error code " << retVal;
+    // @- start DUT1 with configured bit-rate settings
+    retVal = dut1.StartController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- initialize DUT2 with configured settings
+    retVal = dut2.InitializeChannel();
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut2.InitializeChannel() failed with error code " << retVal;
+    // @- start DUT2 with configured bit-rate settings
+    retVal = dut2.StartController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- issue(PeakCAN): why do we need a delay here?
+    PCBUSB_INIT_DELAY();
+    // @test:
+    // @- DUT2 send 20 CAN messages with identifier 200h every 10ms (DLC changes once)
+    for (uint32_t i = 0U; i < 20U; i++) {
+        trmMsg.id = 0x200U;
+        trmMsg.dlc = (i < 10U) ? 8U : 4U;
+        retVal = dut2.WriteMessage(trmMsg, TEST_WRITE_TIMEOUT);
+        ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut2.WriteMessage() failed with error code " << retVal;
+        CTimer::Delay((uint64_t)10 * CTimer::MSEC);
+    }
+    // @- DUT1 receive them all
+    for (uint32_t i = 0U; i < 20U; i++) {
+        retVal = dut1.ReadMessage(rcvMsg, TEST_READ_TIMEOUT);
+        ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.ReadMessage() failed with error code " << retVal;
+    }
+    // @- DUT1 one identifier has been received
+    retVal = dut1.GetProperty(TOUCAN_PROPERTY_ID_STATS, (void*)&setup, sizeof(toucan_id_stats_setup_t));
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    EXPECT_EQ(1U, setup.enabled);
+    EXPECT_EQ(1U, setup.identifiers);
+    EXPECT_EQ(0U, setup.dropped);
+    // @- DUT1 get the snapshot of the traffic statistics
+    list.entries = entries;
+    list.max = 8U;
+    retVal = dut1.GetProperty(TOUCAN_PROPERTY_ID_STATS_LIST, (void*)&list, sizeof(toucan_id_stats_list_t));
+    ASSERT_EQ(CCanApi::NoError, retVal) << "[  ERROR!  ] dut1.GetProperty() failed with error code " << retVal;
+    ASSERT_EQ(1U, list.count);
+    EXPECT_EQ(0x200U, entries[0].id);
+    EXPECT_EQ(0U, entries[0].xtd);
+    EXPECT_EQ(20U, entries[0].frames);
+    EXPECT_EQ(1U, entries[0].dlc_changes);
+    EXPECT_EQ(4U, entries[0].dlc);
+    EXPECT_LE(entries[0].gap_min, entries[0].gap_avg);
+    EXPECT_LE(entries[0].gap_avg, entries[0].gap_max);
+    EXPECT_LE(5000U, entries[0].gap_avg);   // about 10ms
+    EXPECT_GE(50000U, entries[0].gap_avg);
+    EXPECT_LT(0U, entries[0].rate);
+    // @- DUT1 the statistics cannot be changed while the CAN controller is running
+    retVal = dut1.SetProperty(TOUCAN_PROPERTY_SET_ID_STATS, (void*)&setup, sizeof(toucan_id_stats_setup_t));
+    EXPECT_EQ(CCanApi::ControllerOnline, retVal);
+    // @post:
+    // @- stop/reset DUT1
+    retVal = dut1.ResetController();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- tear down DUT1
+    retVal = dut1.TeardownChannel();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @- tear down DUT2
+    retVal = dut2.TeardownChannel();
+    EXPECT_EQ(CCanApi::NoError, retVal);
+    // @end.
+}
+
+//  $Id$  Copyright (c) UV Software, Berlin.
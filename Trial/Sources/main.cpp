@@ -625,6 +625,10 @@ retry_reply:
             (myDriver.GetProperty(CANPROP_GET_RCV_QUEUE_HIGH, (void *)&u32QueHigh, sizeof(uint32_t)) == CCanApi::NoError) &&
             (myDriver.GetProperty(CANPROP_GET_RCV_QUEUE_OVFL, (void *)&u64QueOvfl, sizeof(uint64_t)) == CCanApi::NoError))
             fprintf(stdout, ">>> myDriver.GetProperty(CANPROP_GET_QUEUE_*): SIZE = %" PRIu32 " HIGH = %" PRIu32 " OVFL = %" PRIu64 "\n", u32QueSize, u32QueHigh, u64QueOvfl);
+        uint64_t u64XferCnt, u64WakeupCnt;
+        if ((myDriver.GetProperty(TOUCAN_PROPERTY_RCV_XFER_COUNTER, (void *)&u64XferCnt, sizeof(uint64_t)) == CCanApi::NoError) &&
+            (myDriver.GetProperty(TOUCAN_PROPERTY_RCV_WAKEUP_COUNTER, (void *)&u64WakeupCnt, sizeof(uint64_t)) == CCanApi::NoError))
+            fprintf(stdout, ">>> myDriver.GetProperty(TOUCAN_PROPERTY_RCV_*_COUNTER): XFER = %" PRIu64 " WAKEUP = %" PRIu64 "\n", u64XferCnt, u64WakeupCnt);
     }
     /* version information */
     if (option_info) {